@@ -3,13 +3,7 @@
 
 #include "framework.h"
 #include "tool_queue.h"  // For QueuePolicy
-
-// Forward declarations
-typedef enum {
-    RESTART_NEVER = 0,
-    RESTART_ALWAYS = 1,
-    RESTART_ON_DEMAND = 2
-} RestartPolicy;
+#include "tool.h"        // For RestartPolicy
 
 // Tool configuration from config file
 typedef struct {
@@ -25,22 +19,23 @@ typedef struct {
     RestartPolicy restart_policy;
     int max_queue_size;
     QueuePolicy queue_policy;
+    int max_batch_size;
+    size_t max_queue_bytes;     // Inbox byte budget (0 = count limit only)
+    char conflate_key[MAX_EVENT_TYPE];  // Data field keying queue_policy = conflate
+    
+    // Deadlines (seconds; 0 disables)
+    int restart_max_delay_sec;
+    int heartbeat_timeout_sec;
+    int start_timeout_sec;
+    int idle_timeout_sec;
+    
+    int log_rate_limit;         // stderr lines logged per second (0 = no cap)
+    int dedup_window;           // Message ids remembered to drop repeats (0 = off)
+    bool sequence_numbers;      // Receive events as TYPE|sender@seq|data
 } ToolConfig;
 
-// Main config structure
-typedef struct {
-    char log_file[256];
-    LogLevel log_level;
-    char pid_file[256];
-    int max_tools;
-    int message_queue_size;
-    bool enable_debug;
-    bool enable_remote_control;
-    int control_port;
-} Config;
-
-// Global config
-extern Config g_config;
+// Main config structure (g_config is declared in framework.h)
+typedef FrameworkConfig Config;
 
 // Config functions
 int config_load(const char* config_file);
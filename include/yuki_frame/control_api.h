@@ -13,6 +13,7 @@
 #define YUKI_FRAME_CONTROL_API_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -31,6 +32,13 @@ typedef struct {
     uint64_t events_sent;        /**< Number of events sent */
     uint64_t events_received;    /**< Number of events received */
     int subscription_count;      /**< Number of subscriptions */
+    bool has_exited;             /**< The last_* fields describe the previous run */
+    int last_exit_code;          /**< Exit status, -1 if killed by a signal */
+    int last_exit_signal;        /**< Terminating signal, 0 if it exited */
+    uint64_t last_cpu_ms;        /**< User plus system CPU time of that run */
+    uint64_t last_max_rss_kb;    /**< Peak resident set size of that run */
+    uint64_t last_sequence;      /**< Sequence number of its last event published */
+    uint64_t duplicates;         /**< Events dropped as repeats of a message id */
 } ControlToolInfo;
 
 /**
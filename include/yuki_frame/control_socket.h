@@ -62,4 +62,14 @@ bool control_socket_is_running(void);
  */
 int control_socket_get_port(void);
 
+/**
+ * Execute a command the socket thread posted (WORK_SOCKET_COMMAND)
+ * 
+ * Main thread only. The response goes to the client that is waiting for
+ * it; a command left behind by a stopped server is ignored.
+ * 
+ * @param command Command line as the client sent it
+ */
+void control_socket_run_command(const char* command);
+
 #endif  // YUKI_FRAME_CONTROL_SOCKET_H
@@ -0,0 +1,33 @@
+#ifndef YUKI_FRAME_DEDUP_H
+#define YUKI_FRAME_DEDUP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Duplicate suppression for events published with a message id
+// (TYPE|sender@<id>|data). Each publisher remembers the ids of its last
+// dedup_window events; an event whose id is among them is dropped before
+// it is routed. The window outlives restarts of the tool, so a batch it
+// emits again after a crash is not delivered twice.
+#define DEDUP_MAX_ID 64                 // Longest message id, with the NUL
+#define DEDUP_DEFAULT_WINDOW 1024       // Ids remembered per publisher
+
+typedef struct DedupWindow DedupWindow;
+
+// NULL when out of memory or capacity is not positive
+DedupWindow* dedup_create(int capacity);
+void dedup_destroy(DedupWindow* window);
+
+// True when id is one of the last capacity ids seen; otherwise it is
+// remembered, forgetting the oldest once the window is full. Ids longer
+// than DEDUP_MAX_ID - 1 bytes are compared by their first bytes.
+bool dedup_seen(DedupWindow* window, const char* id, size_t length);
+
+// The two halves of dedup_seen(), for a caller that remembers an id only
+// once its event is published: whether id is in the window, and adding
+// one that is not
+bool dedup_contains(const DedupWindow* window, const char* id, size_t length);
+void dedup_remember(DedupWindow* window, const char* id, size_t length);
+int dedup_count(const DedupWindow* window);
+
+#endif // YUKI_FRAME_DEDUP_H
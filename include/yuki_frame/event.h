@@ -2,6 +2,10 @@
 #define YUKI_FRAME_EVENT_H
 
 #include "yuki_frame/framework.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/ring.h"
+#include "yuki_frame/slab.h"
+#include <stdatomic.h>
 
 // Event structure
 typedef struct {
@@ -11,20 +15,105 @@ typedef struct {
     time_t timestamp;
 } Event;
 
-// Message bus
+// Message bus: a bounded lock-free MPSC ring of queued events, which any
+// thread may publish to and the main thread routes. A queued event is a
+// variable-size record (the three strings packed after a small header)
+// from the publishing thread's own slab pool; the router hands each
+// record back to the pool it came from. Each priority has its own ring,
+// and the router always takes the most urgent event first.
+//
+// The bus grows past its rings ([core] message_queue_size) within the
+// memory budget of flow_control.h: while a lane's ring is full, its events
+// wait in order on an overflow list, and later ones join them until the
+// router has taken the list. A publish fails only when the budget is spent.
+struct BusEvent;
+struct BusPool;
+struct Tool;
+
 typedef struct {
-    Event* queue[MAX_EVENTS_QUEUE];
-    int head;
-    int tail;
-    int count;
+    Ring* rings[EVENT_PRIORITY_COUNT];  // BusEvent records, by EventPriority
+    struct BusEvent* overflow_head[EVENT_PRIORITY_COUNT];
+    struct BusEvent* overflow_tail[EVENT_PRIORITY_COUNT];
+    atomic_int overflow_count[EVENT_PRIORITY_COUNT];
+    PlatformMutex overflow_lock;
+    atomic_bool signalled;      // Router woken and not drained since
+    atomic_uint generation;     // Bumped by event_bus_init(); older thread pools are stale
+    struct BusPool* pools;      // Every publishing thread's pool
+    PlatformMutex pools_lock;   // Taken once per thread, to add its pool
 } MessageBus;
 
+// One event of a batch
+typedef struct {
+    const char* type;
+    const char* sender;
+    const char* data;
+} EventView;
+
+// Counters of the message bus (relaxed, read any time)
+typedef struct {
+    int ring_capacity;          // Events each lane's ring holds
+    int queued;                 // Events in the rings and overflow lists now
+    int overflowed;             // Of those, on overflow lists
+    int overflow_peak;
+    uint64_t overflow_total;    // Events that went to an overflow list
+} EventBusStats;
+
 // Event functions
 int event_bus_init(void);
+void event_bus_get_stats(EventBusStats* stats);
 void event_bus_shutdown(void);
 int event_publish(const char* type, const char* sender, const char* data);
+// event_publish() queues at the type's configured priority; this raises it
+// to priority when that is higher (the "!TYPE" protocol prefix)
+int event_publish_priority(const char* type, const char* sender, const char* data,
+                           EventPriority priority);
+// A tool's event, numbered seq in its publisher's stream (0 for none).
+// Subscribers with sequence numbers on receive it from sender@seq.
+int event_publish_sequenced(const char* type, const char* sender, const char* data,
+                            EventPriority priority, uint64_t seq);
+// Queue all of the events with one ring claim and one router wakeup, or
+// none of them (FW_ERROR_QUEUE_FULL: the memory budget is spent). A batch
+// of more than MAX_EVENTS_QUEUE events is queued in chunks of that many,
+// each all or none; an error leaves the chunks before it queued. On an
+// I/O shard each is logged and routed as event_publish() would, and the
+// first error is returned. A chunk waits in the bus lane of its most
+// urgent event.
+int event_publish_batch(const EventView* events, int count);
 int event_parse(const char* line, Event* event);
 int event_format(const Event* event, char* buffer, size_t size);
 void event_process_queue(void);
 
+// Routing. event_route() delivers one event to every subscriber, reading a
+// snapshot of the subscriptions that event_routes_changed() rebuilds after
+// tools or subscriptions change. I/O shards bracket each pass that may
+// route with enter/exit; the main thread frees old snapshots with reclaim.
+int event_route(const char* type, const char* sender, const char* data);
+int event_route_priority(const char* type, const char* sender, const char* data,
+                         EventPriority priority);
+// Route an event read back from the event log, only to the tools the log
+// has not seen it written to (event_log_replay). Returns how many tools it
+// was queued for, or an error.
+int event_replay(uint64_t lsn, EventPriority priority, const char* type, const char* sender,
+                 const char* data);
+// Pick the tool a request for type goes to (request.h): one of the tools
+// subscribed to it exactly or by a pattern whose filters pass data, taken
+// in turn. Tools subscribed to everything, skip, and tools that are
+// stopped and do not start on demand are passed over. NULL for none.
+struct Tool* event_route_one(const char* type, const char* data, const struct Tool* skip,
+                             unsigned int turn);
+void event_routes_changed(void);
+void event_routes_enter(int shard);
+void event_routes_exit(int shard);
+void event_routes_reclaim(void);
+// Epoch of the current snapshot, and whether every shard has moved past
+// the snapshots replaced before it (nothing it unlisted is reachable)
+uint64_t event_routes_epoch(void);
+bool event_routes_passed(uint64_t epoch);
+
+// Subscription patterns match dotted event types segment by segment: "*"
+// is any one segment and a final "#" any remaining segments, including
+// none ("SENSOR.#" matches "SENSOR" and "SENSOR.temp.zone3"). A bare "*"
+// or "#" matches every event. Wildcards must be whole segments.
+bool event_pattern_valid(const char* pattern);
+
 #endif  // YUKI_FRAME_EVENT_H
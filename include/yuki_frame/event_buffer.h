@@ -0,0 +1,34 @@
+#ifndef YUKI_FRAME_EVENT_BUFFER_H
+#define YUKI_FRAME_EVENT_BUFFER_H
+
+#include "framework.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Tool;
+
+// Immutable wire form of one event ("TYPE|sender|data\n"), shared by every
+// inbox it was delivered to. Each holder owns one reference; the last
+// release frees it. References may be released from any thread.
+typedef struct {
+    atomic_int refs;
+    EventPriority priority;     // Inbox lane (EVENT_PRIORITY_NORMAL unless routed higher)
+    uint64_t lsn;               // Event log sequence number, 0 if not logged
+    bool log_held;              // Each delivery holds lsn in flight (event_log.h)
+    struct FlowAccount* publisher;  // Charged for it (flow_control.h), NULL for none
+    size_t charged;             // Bytes charged, released with the last reference
+    size_t length;              // Bytes in data, without the trailing NUL
+    char data[];
+} EventBuffer;
+
+// New buffer holding one reference (NULL when out of memory). Formatting
+// writes data that holds a newline as a "#<length>|TYPE|sender" frame.
+EventBuffer* event_buffer_create(const char* data, size_t length);
+EventBuffer* event_buffer_format(const char* type, const char* sender, const char* data);
+
+// Take count more references at once (one per subscriber)
+void event_buffer_ref(EventBuffer* buffer, int count);
+void event_buffer_release(EventBuffer* buffer);
+
+#endif // YUKI_FRAME_EVENT_BUFFER_H
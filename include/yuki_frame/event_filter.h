@@ -0,0 +1,46 @@
+#ifndef YUKI_FRAME_EVENT_FILTER_H
+#define YUKI_FRAME_EVENT_FILTER_H
+
+#include "framework.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Content filter of a subscription ("SENSOR[zone=3 && temp>80]"). The text
+// between the brackets is compiled once into a short program, which the
+// router runs over an event's data before queueing it for the subscriber:
+//
+//   filter := and ("||" and)*
+//   and    := unary ("&&" unary)*
+//   unary  := "!" unary | "(" filter ")" | field [op value]
+//   op     := "=" | "==" | "!=" | "<" | "<=" | ">" | ">="
+//
+// Fields are read from "field=value" pairs or JSON "field": value members
+// of the data. A field on its own tests that it is present; a comparison
+// with a missing field is false. Values compare as numbers when both
+// sides are numbers and as strings otherwise, and may be quoted.
+//
+// A compiled filter is immutable and reference counted, so a routing
+// snapshot can keep using it after its tool's subscriptions change.
+typedef struct EventFilter EventFilter;
+
+#define EVENT_FILTER_MAX_SOURCE 256     // Including the NUL
+#define EVENT_FILTER_MAX_FIELDS 8       // Distinct fields per filter
+#define EVENT_FILTER_MAX_CODE 64        // Instructions per filter
+
+// Compile source, holding one reference. NULL on a syntax error or when
+// out of memory, with the reason in error if given.
+EventFilter* event_filter_compile(const char* source, char* error, size_t error_size);
+void event_filter_ref(EventFilter* filter);
+void event_filter_release(EventFilter* filter);
+
+// Text the filter was compiled from
+const char* event_filter_source(const EventFilter* filter);
+
+// Does the event data (length bytes, not necessarily NUL-terminated) pass?
+bool event_filter_match(const EventFilter* filter, const char* data, size_t length);
+
+// Value of "field=value" or "field": value in data, if the field is there
+bool event_field_find(const char* data, size_t length, const char* field,
+                      const char** value, size_t* value_len);
+
+#endif // YUKI_FRAME_EVENT_FILTER_H
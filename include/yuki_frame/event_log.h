@@ -0,0 +1,103 @@
+#ifndef YUKI_FRAME_EVENT_LOG_H
+#define YUKI_FRAME_EVENT_LOG_H
+
+#include "framework.h"
+#include <stdint.h>
+
+// Durable event log ([core] event_log = <directory>). Every event published
+// while the log is open is appended with a log sequence number (LSN) before
+// it is routed, and the LSN travels with it into each subscriber's inbox.
+// A background thread writes and syncs what was appended every sync_ms
+// (group commit), or each append syncs itself when sync_ms is 0.
+//
+// The log is a directory of numbered segment files plus a checkpoint of
+// how far each tool has been written: a tool's offset is the LSN below
+// which nothing logged is still waiting in its inbox. After a restart,
+// events past a tool's offset that it subscribes to are routed to it again
+// (at-least-once delivery). Segments every tool is done with are deleted
+// at checkpoints.
+//
+// Records carry the wall-clock time they were appended. Each segment keeps
+// a sparse index in memory (its first record, then one record per
+// EVENT_LOG_INDEX_INTERVAL bytes), so a cursor can seek to an LSN or a
+// time without reading the segments before it.
+#define EVENT_LOG_DEFAULT_SYNC_MS 10
+#define EVENT_LOG_DEFAULT_SEGMENT_SIZE ((size_t)64 << 20)
+#define EVENT_LOG_CHECKPOINT_MS 1000
+#define EVENT_LOG_INDEX_INTERVAL (64 * 1024)
+
+// Counters since the log was opened
+typedef struct {
+    uint64_t appended;          // Events appended
+    uint64_t synced_lsn;        // Highest LSN known to be on disk
+    uint64_t syncs;             // Group commits
+    uint64_t bytes;             // Bytes written to segments
+    uint64_t replayed;          // Events routed again by event_log_replay()
+    int segments;               // Segment files kept
+} EventLogStats;
+
+// Open (creating) the log in directory and recover its last LSN and the
+// checkpointed offsets of the registered tools; tools without one start at
+// the end of the log. Call after the tools are registered and subscribed.
+int event_log_open(const char* directory, int sync_ms, size_t segment_size);
+// Route the logged events each tool has not been written yet; returns how
+// many were queued for at least one tool
+uint64_t event_log_replay(void);
+// Write what is pending, checkpoint and stop; call before the tools go
+void event_log_close(void);
+bool event_log_is_open(void);
+
+// Append an event, returning its LSN (0 when the log is closed or the event
+// could not be appended)
+uint64_t event_log_append(EventPriority priority, const char* type, const char* sender,
+                          const char* data);
+uint64_t event_log_last_lsn(void);
+
+// In-flight events. An append holds its LSN until routing has taken one
+// hold per subscriber it hands the event to and released the append's;
+// each delivery releases its hold once the event is in the inbox (or
+// refused). Checkpoints record no tool at or past the floor, the lowest
+// LSN still held, since events reach an inbox out of LSN order.
+void event_log_hold(uint64_t lsn, int count);
+void event_log_release(uint64_t lsn);
+uint64_t event_log_floor(void);
+
+// Write and sync everything appended so far, and any checkpoint taken
+void event_log_flush(void);
+// Record every tool's offset for the next flush
+void event_log_checkpoint(void);
+// Main thread: checkpoint when one is due. Returns the milliseconds until
+// the next, or -1 with the log closed.
+int event_log_run(void);
+
+void event_log_get_stats(EventLogStats* stats);
+
+// One record read back by a cursor; the strings stay valid until the
+// cursor moves on
+typedef struct {
+    uint64_t lsn;
+    uint64_t timestamp_ms;      // Milliseconds since the epoch, never decreasing
+    EventPriority priority;
+    char type[MAX_EVENT_TYPE];
+    char sender[MAX_TOOL_NAME];
+    const char* data;
+    size_t data_len;
+} EventLogRecord;
+
+// Reads the log in LSN order from memory-mapped segments, on any thread.
+// It sees what was written before each call; a segment deleted under it
+// is skipped.
+typedef struct EventLogCursor EventLogCursor;
+
+// Cursor at the first record with an LSN of at least lsn, or appended at
+// or after timestamp_ms. NULL when the log is closed or out of memory.
+EventLogCursor* event_log_seek_lsn(uint64_t lsn);
+EventLogCursor* event_log_seek_time(uint64_t timestamp_ms);
+// Next record, or false when the cursor has read everything written so far
+bool event_log_cursor_next(EventLogCursor* cursor, EventLogRecord* record);
+void event_log_cursor_close(EventLogCursor* cursor);
+
+// Wall-clock milliseconds since the epoch, as recorded by appends
+uint64_t event_log_time_ms(void);
+
+#endif // YUKI_FRAME_EVENT_LOG_H
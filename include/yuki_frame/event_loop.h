@@ -0,0 +1,97 @@
+#ifndef YUKI_FRAME_EVENT_LOOP_H
+#define YUKI_FRAME_EVENT_LOOP_H
+
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+
+// Upper bound on ready notifications returned by one event_loop_wait()
+#define LOOP_MAX_EVENTS 256
+
+// Most I/O shards ([core] io_threads) and per-shard handoff ring size
+#define MAX_IO_THREADS 64
+#define LOOP_RING_SIZE 65536
+
+// Which pipe of a tool became ready
+typedef enum {
+    LOOP_SOURCE_STDOUT,
+    LOOP_SOURCE_STDERR,
+    LOOP_SOURCE_STDIN,
+    LOOP_SOURCE_EXIT            // The process exited (its exit fd)
+} LoopSource;
+
+// Ready notification. The fd is matched against the tool's pipes by
+// event_loop_source() once the shard lock is held.
+typedef struct {
+    Tool* tool;
+    int fd;
+    bool hangup;                // The other end closed the pipe
+} LoopEvent;
+
+// Event loop lifecycle. Each shard has its own poller, pending-delivery
+// list, lock and inbound ring; the control loop (shard_count > 1 only) has
+// no pipes and just wakes the main thread.
+int event_loop_init(int shard_count);
+void event_loop_shutdown(void);
+int event_loop_shard_count(void);
+int event_loop_control(void);           // Index of the main thread's loop
+int event_loop_assign_shard(void);      // Round-robin shard for a new tool
+
+// Shard lock: held by the shard's thread while it handles ready pipes and
+// by anyone else changing a tool's pipes or status. Tool functions below
+// must be called with the tool's shard lock held.
+void event_loop_lock(int shard);
+void event_loop_unlock(int shard);
+int event_loop_current_shard(void);     // Shard locked by this thread, or -1
+
+// Tool pipe registration (tool.c calls these on start/stop)
+int event_loop_add_tool(Tool* tool);
+void event_loop_remove_tool(Tool* tool);
+void event_loop_remove_source(Tool* tool, LoopSource source);
+// Stop and resume watching a tool's stdout (flow control): while paused,
+// its pipe fills and its writes block
+void event_loop_pause_stdout(Tool* tool);
+void event_loop_resume_stdout(Tool* tool);
+bool event_loop_source(const LoopEvent* event, LoopSource* source);
+
+// Delivery scheduling: tools with inbox work are delivered to on the next
+// pass; a tool whose stdin pipe is full waits for writability instead.
+void event_loop_schedule_delivery(Tool* tool);
+int event_loop_take_deliveries(int shard, Tool** tools, int max_tools);
+void event_loop_watch_writable(Tool* tool);
+
+// Cross-thread handoff: any thread may post, only the loop's thread takes.
+// Posting wakes the loop. Returns false if the ring is full.
+bool event_loop_post(int shard, void* item);
+void* event_loop_take_posted(int shard);
+
+// Block until a pipe is ready, something is posted, the loop is woken or
+// timeout_ms expires (< 0 = forever)
+int event_loop_wait(int shard, LoopEvent* events, int max_events, int timeout_ms);
+
+// Wake a blocked event_loop_wait()
+void event_loop_wakeup(int shard);
+
+// Waiting strategy of every loop (default blocking, set before the loops
+// run). Hybrid loops poll without sleeping for spin_us before each sleep;
+// busy-poll loops never sleep. With first_cpu >= 0, event_loop_pin() puts
+// the thread running loop i on CPU first_cpu + i.
+void event_loop_set_mode(LoopMode mode, int spin_us, int first_cpu);
+LoopMode event_loop_mode(void);
+void event_loop_pin(int shard);         // Called by the loop's own thread
+
+// Counters for weighing CPU against latency (relaxed, read any time)
+typedef struct {
+    uint64_t waits;             // event_loop_wait() calls
+    uint64_t spins;             // Non-blocking polls that found nothing
+    uint64_t sleeps;            // Blocking poller waits
+    uint64_t empty_sleeps;      // Blocking waits that ended by timeout
+    uint64_t wakeups;           // Wakeup syscalls made to interrupt a sleep
+} LoopStats;
+
+void event_loop_get_stats(int shard, LoopStats* stats);
+
+// Fallback exit notification: true once after the control loop saw some
+// child exit (platform_child_exit_fd()); the caller checks every tool
+bool event_loop_take_child_exits(void);
+
+#endif  // YUKI_FRAME_EVENT_LOOP_H
@@ -0,0 +1,48 @@
+#ifndef YUKI_FRAME_EVENT_TYPE_H
+#define YUKI_FRAME_EVENT_TYPE_H
+
+#include "framework.h"
+#include <stdint.h>
+
+// Event type intern table. Each type string (or subscription pattern) gets
+// a small integer ID on first sight, which routing, subscriptions and the
+// per-type counters use as their key; the string itself is only needed to
+// format the wire line. IDs are never reused while the process runs.
+// Lookups are lock-free from any thread; new types are added under a
+// spinlock.
+typedef uint32_t EventTypeId;
+
+#define EVENT_TYPE_NONE 0               // Not interned (too long, or table full)
+#define EVENT_TYPE_MAX_IDS 4096
+// Types seen only in published events stop being added past this many, so
+// a tool inventing types cannot use up the IDs subscriptions need
+#define EVENT_TYPE_MAX_UNSUBSCRIBED (EVENT_TYPE_MAX_IDS * 3 / 4)
+
+// ID of type, interning it if new; EVENT_TYPE_NONE for types of
+// MAX_EVENT_TYPE or more characters or when the table is full
+EventTypeId event_type_intern(const char* type);
+// ID of type if it has been interned, else EVENT_TYPE_NONE
+EventTypeId event_type_find(const char* type);
+// Interned string of id, or NULL
+const char* event_type_name(EventTypeId id);
+// Number of IDs handed out; they run from 1 to this
+uint32_t event_type_count(void);
+
+// Priority of the type's events ([priorities] section); EVENT_PRIORITY_NORMAL
+// until set, and for EVENT_TYPE_NONE
+void event_type_set_priority(EventTypeId id, EventPriority priority);
+EventPriority event_type_priority(EventTypeId id);
+
+// Per-type counters, updated by the router
+typedef struct {
+    uint64_t routed;            // Events of the type routed
+    uint64_t delivered;         // Inbox deliveries of those events
+} EventTypeStats;
+
+void event_type_count_routed(EventTypeId id, int deliveries);
+void event_type_get_stats(EventTypeId id, EventTypeStats* stats);
+
+// Free the table; every ID handed out becomes invalid
+void event_types_shutdown(void);
+
+#endif // YUKI_FRAME_EVENT_TYPE_H
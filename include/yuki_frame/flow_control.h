@@ -0,0 +1,74 @@
+#ifndef YUKI_FRAME_FLOW_CONTROL_H
+#define YUKI_FRAME_FLOW_CONTROL_H
+
+#include "framework.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Tool;
+
+// Memory budget for queued events ([core] bus_memory_limit): the bytes of
+// events waiting on the message bus plus those of routed events not yet
+// written to every subscriber, each charged to the tool that published it.
+// Once usage reaches the high watermark (a percentage of the budget) the
+// framework is under pressure until it falls back to the low watermark.
+// Under pressure, I/O shards stop reading stdout from the hottest
+// publishers, those holding at least their fair share of the publishers'
+// queued bytes, so their pipes fill and the kernel blocks them rather than
+// their events being dropped. Publishers that are not tools (off the
+// shards) cannot be paused and are refused only when the budget is spent.
+// Each tool is charged through its FlowAccount, which outlives the tool
+// until the last event it published is released.
+#define FLOW_DEFAULT_MEMORY_LIMIT ((size_t)256 << 20)
+#define FLOW_DEFAULT_HIGH_WATERMARK 80      // Percent of the budget
+#define FLOW_DEFAULT_LOW_WATERMARK 60
+
+#define FLOW_ACCOUNT_OWNED ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+typedef struct FlowAccount {
+    atomic_size_t held;         // Queued bytes, plus FLOW_ACCOUNT_OWNED while its tool lives
+} FlowAccount;
+
+typedef struct {
+    size_t limit;
+    size_t high_watermark;      // Bytes
+    size_t low_watermark;
+    size_t used;                // Bytes queued now
+    size_t peak;
+    bool pressure;
+    uint64_t pressure_count;    // Times usage reached the high watermark
+    uint64_t pauses;            // Times a publisher's stdout was paused
+    uint64_t rejected;          // Bus publishes refused over the budget
+} FlowStats;
+
+// Watermarks are clamped so that 0 < low <= high <= 100
+void flow_init(size_t limit, int high_percent, int low_percent);
+
+// A tool's account; closed when the tool is freed, and freed itself by
+// whichever of that and the release of its last queued byte comes later.
+// NULL when out of memory.
+FlowAccount* flow_account_create(void);
+void flow_account_close(FlowAccount* account);
+size_t flow_account_bytes(const FlowAccount* account);
+
+// Count bytes of a queued event, published by publisher (NULL when not a
+// tool). flow_reserve() instead refuses bytes that do not fit the budget.
+void flow_charge(FlowAccount* publisher, size_t bytes);
+bool flow_reserve(size_t bytes);
+void flow_release(FlowAccount* publisher, size_t bytes);
+
+// The tool whose stdout this thread is handling, charged for the events
+// routed meanwhile (set by the I/O shards)
+void flow_set_publisher(struct Tool* publisher);
+struct Tool* flow_publisher(void);
+
+bool flow_under_pressure(void);
+// Shard: whether to stop reading the tool's stdout until pressure ends
+bool flow_should_pause(const FlowAccount* publisher);
+void flow_count_pause(void);
+
+void flow_get_stats(FlowStats* stats);
+
+#endif // YUKI_FRAME_FLOW_CONTROL_H
@@ -12,17 +12,40 @@
 #define YUKI_FRAME_VERSION_STRING "2.0.0"
 #define YUKI_FRAME_NAME "Yuki-Frame"
 
-// Platform detection - Windows only
-#ifndef PLATFORM_WINDOWS
+// Platform detection
+#if defined(_WIN32) && !defined(PLATFORM_WINDOWS)
 #define PLATFORM_WINDOWS
+#elif !defined(_WIN32) && !defined(PLATFORM_LINUX)
+#define PLATFORM_LINUX
 #endif
 
+#ifdef PLATFORM_WINDOWS
 // Windows-specific includes and types
 // IMPORTANT: winsock2.h must be included before windows.h
 #include <winsock2.h>
 #include <windows.h>
 typedef HANDLE ProcessHandle;
 typedef DWORD ProcessID;
+#define INVALID_PROCESS_HANDLE INVALID_HANDLE_VALUE
+#define YUKI_FRAME_PLATFORM_NAME "Windows"
+#else
+// POSIX: a process is identified by its pid; the platform layer keeps
+// track of which pids are still unreaped children of the framework.
+#include <sys/types.h>
+typedef pid_t ProcessHandle;
+typedef pid_t ProcessID;
+#define INVALID_PROCESS_HANDLE ((ProcessHandle)-1)
+#define YUKI_FRAME_PLATFORM_NAME "Linux"
+#endif
+
+// Thread-local storage, and the padding unit that keeps the lock-free
+// structures' producer and consumer counters off each other's cache line
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+#define CACHE_LINE_SIZE 64
 
 // Error codes
 typedef enum {
@@ -50,6 +73,29 @@ typedef enum {
     LOG_FATAL = 5
 } LogLevel;
 
+// How loop threads wait for work ([core] loop_mode)
+typedef enum {
+    LOOP_MODE_BLOCKING = 0,    // Sleep in the poller until something happens
+    LOOP_MODE_HYBRID = 1,      // Poll without sleeping for spin_us, then sleep
+    LOOP_MODE_BUSY_POLL = 2    // Never sleep; pair with loop_cpu
+} LoopMode;
+
+// Readiness backend for tool pipes ([core] io_backend)
+typedef enum {
+    IO_BACKEND_DEFAULT = 0,    // epoll on Linux, pipe peeking on Windows
+    IO_BACKEND_IO_URING = 1,   // io_uring, falling back to the default
+    IO_BACKEND_AUTO = 2        // io_uring when the kernel supports it
+} IoBackend;
+
+// Event priority ([priorities] TYPE = high, or a "!" before the type).
+// Each has its own lane on the message bus and in every tool inbox.
+typedef enum {
+    EVENT_PRIORITY_LOW = 0,
+    EVENT_PRIORITY_NORMAL = 1,
+    EVENT_PRIORITY_HIGH = 2,
+    EVENT_PRIORITY_COUNT
+} EventPriority;
+
 // Constants
 #define MAX_TOOL_NAME 64
 #define MAX_COMMAND_LENGTH 512
@@ -70,6 +116,19 @@ typedef struct {
     bool enable_debug;
     bool enable_remote_control;
     int control_port;
+    int io_threads;            // I/O shards tool pipes are spread over
+    LoopMode loop_mode;
+    int spin_us;               // Hybrid mode: spin this long before sleeping
+    int loop_cpu;              // First CPU loop threads are pinned to (-1 = none)
+    IoBackend io_backend;
+    size_t max_frame_size;     // Largest framed payload read from a tool
+    char event_log[256];       // Event log directory ("" = no log)
+    int event_log_sync_ms;     // Group commit interval (0 = sync every event)
+    size_t event_log_segment_size;  // Start a new segment past this size
+    int request_timeout_ms;    // Unanswered requests fail after this long
+    size_t bus_memory_limit;   // Bytes of queued events before publishes fail
+    int bus_high_watermark;    // Percent of the limit that pauses publishers
+    int bus_low_watermark;     // Percent of the limit that resumes them
 } FrameworkConfig;
 
 // Global framework state
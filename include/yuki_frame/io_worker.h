@@ -0,0 +1,62 @@
+#ifndef YUKI_FRAME_IO_WORKER_H
+#define YUKI_FRAME_IO_WORKER_H
+
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/event_buffer.h"
+
+// Work handed between threads through the event loops' rings
+typedef enum {
+    WORK_DELIVER,               // Shard: queue `buffer` (one reference) for `tool`
+    WORK_CONTROL_LINE,          // Control: SUBSCRIBE/TOOL_READY/COMMAND line
+    WORK_CHECK_HEALTH,          // Control: a pipe of `tool` hung up
+    WORK_TOOL_EXITED,           // Control: the process of `tool` exited
+    WORK_START_TOOL,            // Control: start on-demand `tool`
+    WORK_SOCKET_COMMAND,        // Control: run a control socket command (`data`)
+    WORK_STOP,                  // Shard: the worker thread exits
+    WORK_RESUME,                // Shard: memory pressure ended, read paused tools
+    WORK_RETIRE                 // Shard, then control: unregistered `tool` is unreachable
+} WorkType;
+
+typedef struct WorkItem {
+    WorkType type;
+    Tool* tool;
+    char* type_name;            // WORK_CONTROL_LINE fields, pointing into `text`
+    char* sender;
+    char* data;
+    EventBuffer* buffer;        // WORK_DELIVER
+    struct WorkItem* next;      // Main thread's backlog (single shard only)
+    char text[];                // Owned payload
+} WorkItem;
+
+// Start/stop the worker threads ([core] io_threads > 1; with one shard the
+// main thread polls it itself through io_worker_poll())
+int io_worker_start(void);
+void io_worker_stop(void);
+
+// One pass of a shard: wait for readiness (or posted work) up to
+// timeout_ms, then read ready pipes, accept posted deliveries and flush
+// inboxes. Runs on the shard's worker, or on the main thread for shard 0
+// when there are no workers.
+void io_worker_poll(int shard, int timeout_ms);
+
+// Hand an event (one reference passes) to its tool: directly into the
+// inbox when called on the tool's shard, otherwise via its ring
+int io_worker_deliver(Tool* tool, EventBuffer* buffer);
+
+// Have every shard read the tools it paused under memory pressure again
+// (flow_control.h); posted, so a shard busy with a pass cannot miss it
+void io_worker_resume_publishers(void);
+
+// Start retiring an unregistered tool (tool_reclaim): its shard passes it
+// on to the control loop after the work queued ahead of it, and the main
+// thread frees it there. FW_ERROR_QUEUE_FULL to try again later.
+int io_worker_retire(Tool* tool);
+
+// Queue work for the main thread's control loop
+int io_worker_post_control(WorkType type, Tool* tool,
+                           const char* type_name, const char* sender, const char* data);
+WorkItem* io_worker_take_control(void);
+void io_worker_free(WorkItem* item);
+
+#endif // YUKI_FRAME_IO_WORKER_H
@@ -0,0 +1,61 @@
+#ifndef YUKI_FRAME_LINE_FRAMER_H
+#define YUKI_FRAME_LINE_FRAMER_H
+
+#include "framework.h"
+
+// Initial and maximum size of a tool's stdout buffer. A line that does not
+// fit in LINE_FRAMER_MAX_LINE bytes is dropped up to its newline.
+#define LINE_FRAMER_INITIAL_SIZE 4096
+#define LINE_FRAMER_MAX_LINE (64 * 1024)
+
+// Payloads too long for a line (or holding newlines) are sent as a frame:
+// a "#<length>|TYPE|sender" header line, then exactly length bytes of data
+// and a newline. The buffer grows to hold the whole frame, up to max_frame
+// bytes of data; larger frames are skipped.
+#define LINE_FRAMER_DEFAULT_MAX_FRAME ((size_t)64 * 1024 * 1024)
+
+// Per-tool stdout reassembly buffer
+typedef struct {
+    char* buffer;
+    size_t capacity;
+    size_t start;               // First byte of the current (partial) line
+    size_t end;                 // One past the last byte read
+    size_t scanned;             // Bytes of the current line already scanned
+    size_t pipes[2];            // Offsets of the first two '|' in the line
+    int pipe_count;
+    bool discarding;            // Dropping an oversized line
+    size_t max_frame;           // Largest frame payload accepted
+    size_t frame_header;        // Pending frame: header line bytes (0 = none)
+    size_t frame_length;        // Pending frame: payload bytes
+    size_t skipping;            // Bytes of an oversized frame still to drop
+    int oversized_lines;        // Statistics: lines dropped for length
+    int oversized_frames;       // Statistics: frames over max_frame
+    int malformed_lines;        // Statistics: lines without TYPE|sender|
+} LineFramer;
+
+// One complete "TYPE|sender|data" line or frame. The slices point into the
+// framer's buffer, are NUL-terminated in place and stay valid until the
+// next line_framer_prepare() call.
+typedef struct {
+    char* type;
+    size_t type_len;
+    char* sender;
+    size_t sender_len;
+    char* data;
+    size_t data_len;
+} LineFrame;
+
+// Lifecycle
+void line_framer_init(LineFramer* framer);
+void line_framer_free(LineFramer* framer);
+void line_framer_reset(LineFramer* framer);  // Drop any partial line
+
+// Reading: prepare() returns where to read to and how much room there is
+// (NULL on allocation failure), commit() records the bytes actually read.
+char* line_framer_prepare(LineFramer* framer, size_t* available);
+void line_framer_commit(LineFramer* framer, size_t bytes);
+
+// Take the next complete line; returns false when more input is needed
+bool line_framer_next(LineFramer* framer, LineFrame* frame);
+
+#endif // YUKI_FRAME_LINE_FRAMER_H
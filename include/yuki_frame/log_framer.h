@@ -0,0 +1,46 @@
+#ifndef YUKI_FRAME_LOG_FRAMER_H
+#define YUKI_FRAME_LOG_FRAMER_H
+
+#include "framework.h"
+#include "logger.h"
+#include <stdint.h>
+
+// Longest stderr line logged as one record; longer lines are split
+#define LOG_FRAMER_MAX_LINE MAX_LOG_MESSAGE
+
+// Records handed to the logger per call
+#define LOG_FRAMER_BATCH 64
+
+// Default cap on stderr lines logged per tool per second (0 = no cap)
+#define LOG_FRAMER_DEFAULT_RATE 1000
+
+// Per-tool stderr reassembly and rate limiting. A line may start with a
+// level tag such as "[WARN] " (TRACE, DEBUG, INFO, WARN/WARNING,
+// ERROR, FATAL/CRITICAL), which sets its log level; untagged lines are
+// logged at INFO.
+typedef struct {
+    char partial[LOG_FRAMER_MAX_LINE];  // Line still waiting for its '\n'
+    size_t partial_length;
+    int rate_limit;             // Lines per second, 0 = unlimited
+    uint64_t window_start_ms;   // Start of the current one-second window
+    int window_lines;           // Lines logged in the window
+    int suppressed;             // Lines dropped in the window
+    uint64_t suppressed_total;  // Statistics: lines dropped by the cap
+} LogFramer;
+
+void log_framer_init(LogFramer* framer, int rate_limit);
+void log_framer_reset(LogFramer* framer);  // Drop any partial line
+
+// Log every complete line in data; a trailing partial line is kept for
+// the next call. now_ms (monotonic) drives the rate cap.
+void log_framer_write(LogFramer* framer, const char* component,
+                      const char* data, size_t size, uint64_t now_ms);
+
+// Log the partial line and any pending suppression notice (pipe closed)
+void log_framer_flush(LogFramer* framer, const char* component);
+
+// Strip a leading "[LEVEL] " tag. Returns its level, or fallback if the
+// line has none (text and length are then unchanged).
+LogLevel log_framer_parse_level(const char** text, size_t* length, LogLevel fallback);
+
+#endif // YUKI_FRAME_LOG_FRAMER_H
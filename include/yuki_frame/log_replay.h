@@ -0,0 +1,55 @@
+#ifndef YUKI_FRAME_LOG_REPLAY_H
+#define YUKI_FRAME_LOG_REPLAY_H
+
+#include "framework.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Replays of the event log into one tool's inbox (the "replay" console
+// command), e.g. to backfill a tool that was restarted. A replay streams
+// the events logged from an LSN or a point in time up to when it started,
+// optionally only some types and at most rate events per second, whatever
+// the tool subscribes to. Replayed events go into the inbox's low-priority
+// lane so live events overtake them, and a replay waits while the inbox is
+// half full rather than crowd live events out. The main loop advances the
+// replays (log_replay_run).
+#define LOG_REPLAY_MAX 8                // Replays running at once
+#define LOG_REPLAY_MAX_TYPES 8
+#define LOG_REPLAY_BATCH 256            // Events queued per replay per pass
+#define LOG_REPLAY_RETRY_MS 1           // Wait while an inbox is half full
+
+typedef struct {
+    uint64_t from_lsn;          // First LSN...
+    uint64_t from_time_ms;      // ...or first wall-clock time (0 = use from_lsn)
+    char types[LOG_REPLAY_MAX_TYPES][MAX_EVENT_TYPE];
+    int type_count;             // 0 = every type
+    int rate;                   // Events per second, 0 = as fast as the inbox takes them
+} LogReplayOptions;
+
+typedef struct {
+    char tool[MAX_TOOL_NAME];
+    uint64_t until_lsn;         // Last LSN it will replay
+    uint64_t last_lsn;          // Last LSN queued so far
+    uint64_t sent;
+    int rate;
+} LogReplayStatus;
+
+int log_replay_init(void);
+// Stop every replay; call before the event log closes
+void log_replay_shutdown(void);
+
+// Parse "[--from <lsn|time>] [--types A,B] [--rate N]" into options. The
+// time is local "YYYY-MM-DDTHH:MM[:SS]" or relative to now ("-30s", "-5m",
+// "-2h", "-1d").
+int log_replay_parse(const char* args, LogReplayOptions* options, char* error, size_t error_size);
+
+// Start replaying to tool, replacing a replay already running to it
+int log_replay_start(const char* tool, const LogReplayOptions* options);
+int log_replay_stop(const char* tool);
+int log_replay_list(LogReplayStatus* status, int max_status);
+
+// Main thread: queue what the replays may send now. Returns the
+// milliseconds until one can send more, or -1 with none running.
+int log_replay_run(void);
+
+#endif // YUKI_FRAME_LOG_REPLAY_H
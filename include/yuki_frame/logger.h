@@ -11,6 +11,15 @@ void logger_shutdown(void);
 // Logging functions
 void logger_log(LogLevel level, const char* component, const char* format, ...);
 void logger_log_tool(const char* tool_name, LogLevel level, const char* message);
+
+// Several records from one component, written and flushed together
+typedef struct {
+    LogLevel level;
+    const char* text;           // Not NUL-terminated
+    size_t length;
+} LogLine;
+
+void logger_log_lines(const char* component, const LogLine* lines, int count);
 void logger_set_level(LogLevel level);
 LogLevel logger_get_level(void);
 
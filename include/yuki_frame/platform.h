@@ -2,6 +2,11 @@
 #define YUKI_FRAME_PLATFORM_H
 
 #include "yuki_frame/framework.h"
+#include <stdint.h>
+
+#ifndef PLATFORM_WINDOWS
+#include <pthread.h>
+#endif
 
 // Platform-specific process functions
 ProcessHandle platform_spawn_process(const char* command, int* stdin_fd, int* stdout_fd, int* stderr_fd);
@@ -10,14 +15,105 @@ bool platform_is_process_running(ProcessHandle handle);
 int platform_wait_process(ProcessHandle handle, int timeout_ms);
 ProcessID platform_get_process_id(ProcessHandle handle);
 
+// How a process ended, once it has exited
+typedef struct {
+    int exit_code;              // Exit status, -1 if killed by a signal
+    int signal;                 // Terminating signal, 0 if it exited
+    uint64_t user_cpu_ms;       // CPU time it used (with the children it reaped)
+    uint64_t system_cpu_ms;
+    uint64_t max_rss_kb;        // Peak resident set size, 0 if unknown
+} PlatformExitInfo;
+
+// Exit notification for the event loop. platform_process_exit_fd() is
+// readable once that process exits (pidfd on Linux); where it returns -1,
+// platform_child_exit_fd() is readable after any child exits (SIGCHLD
+// signalfd) and must be drained. Both are -1 when exits can only be found
+// by polling platform_is_process_running().
+int platform_process_exit_fd(ProcessHandle handle);
+int platform_child_exit_fd(void);
+void platform_child_exit_drain(void);
+// Reap the process if it exited and describe how; false while it runs
+bool platform_get_exit_info(ProcessHandle handle, PlatformExitInfo* info);
+
 // Platform-specific I/O
+// read/write_nonblocking return the byte count, 0 when the pipe has no
+// data (or no room), or a negative FrameworkError.
 int platform_read_nonblocking(int fd, char* buffer, size_t size);
 int platform_write_nonblocking(int fd, const char* data, size_t size);
+int platform_write_all(int fd, const char* data, size_t size);
+
+// Vectored non-blocking write (writev on Linux, coalesced on Windows).
+// Returns the byte count written across the buffers, 0 if the pipe is full,
+// or a negative FrameworkError. May stop part-way through a buffer.
+typedef struct {
+    const char* data;
+    size_t size;
+} PlatformIoVec;
+
+int platform_writev_nonblocking(int fd, const PlatformIoVec* iov, int count);
 int platform_set_nonblocking(int fd);
+void platform_close_fd(int fd);
+
+// Readiness polling (epoll or io_uring on Linux, pipe peeking on Windows)
+#define PLATFORM_POLL_READ   0x01
+#define PLATFORM_POLL_WRITE  0x02
+#define PLATFORM_POLL_HANGUP 0x04  // Peer closed the pipe or the fd errored
+
+typedef struct PlatformPoller PlatformPoller;
+
+typedef struct {
+    int fd;
+    unsigned int events;        // PLATFORM_POLL_* flags that are ready
+    void* user_data;            // Pointer given to platform_poller_add()
+} PlatformPollEvent;
+
+// Choose the backend for pollers created afterwards. Returns the backend
+// in use: io_uring needs Linux 5.11+, anything else gets the default.
+IoBackend platform_select_io_backend(IoBackend wanted);
+PlatformPoller* platform_poller_create(void);
+void platform_poller_destroy(PlatformPoller* poller);
+int platform_poller_add(PlatformPoller* poller, int fd, unsigned int events, void* user_data);
+int platform_poller_modify(PlatformPoller* poller, int fd, unsigned int events);
+int platform_poller_remove(PlatformPoller* poller, int fd);
+// Returns the number of ready fds, 0 on timeout or wakeup (timeout_ms < 0 = forever)
+int platform_poller_wait(PlatformPoller* poller, PlatformPollEvent* events, int max_events, int timeout_ms);
+// Interrupt a platform_poller_wait() in progress (safe from any thread)
+int platform_poller_wakeup(PlatformPoller* poller);
+
+// Threads and locks (I/O workers)
+#ifdef PLATFORM_WINDOWS
+typedef HANDLE PlatformThread;
+typedef CRITICAL_SECTION PlatformMutex;
+#else
+typedef pthread_t PlatformThread;
+typedef pthread_mutex_t PlatformMutex;
+#endif
+
+typedef void (*PlatformThreadFunc)(void* arg);
+
+int platform_thread_create(PlatformThread* thread, PlatformThreadFunc func, void* arg);
+void platform_thread_join(PlatformThread thread);
+void platform_mutex_init(PlatformMutex* mutex);
+void platform_mutex_destroy(PlatformMutex* mutex);
+void platform_mutex_lock(PlatformMutex* mutex);
+void platform_mutex_unlock(PlatformMutex* mutex);
+// Pin the calling thread to one CPU (busy-poll loops)
+int platform_pin_thread(int cpu);
+
+// Files (event log). Sync flushes a file's data to the disk; replace
+// renames from over to, which need not exist.
+int platform_file_sync(int fd);
+int platform_make_dir(const char* path);     // FW_OK if it already exists
+int platform_replace_file(const char* from, const char* to);
+// Map a whole file read-only; an empty file maps to NULL with size 0
+int platform_map_file(const char* path, const char** data, size_t* size);
+void platform_unmap_file(const char* data, size_t size);
 
 // Platform-specific utilities
 void platform_sleep_ms(int milliseconds);
 void platform_sleep(int seconds);
+uint64_t platform_monotonic_ms(void);
+uint64_t platform_monotonic_us(void);
 
 // Platform-specific initialization
 int platform_init(void);
@@ -0,0 +1,62 @@
+#ifndef YUKI_FRAME_REQUEST_H
+#define YUKI_FRAME_REQUEST_H
+
+#include "framework.h"
+#include "tool.h"
+#include <stdint.h>
+
+// Request/reply between tools, routed by the core. A tool asks with
+//     REQUEST|<sender>|<id>|<TYPE>|<payload>
+// and the core hands it to exactly one tool subscribed to TYPE (taken in
+// turn when several are), as REQUEST|<requester>|<ref>|<TYPE>|<payload>.
+// That tool answers with REPLY|<sender>|<ref>|<payload>, or REPLY_ERROR,
+// and only the requester gets it back, under its own id:
+//     REPLY|<responder>|<id>|<payload>
+// A request not answered within request_timeout_ms, or that no tool can
+// take, is answered with REPLY_ERROR|framework|<id>|<reason>. Requests for
+// REQUEST_COMMAND_TYPE are console commands the framework answers itself.
+// Requests and replies are not written to the event log.
+#define REQUEST_MAX_PENDING 1024        // Requests waiting for a reply at once
+#define REQUEST_MAX_ID 64               // Longest requester id, with the NUL
+#define REQUEST_DEFAULT_TIMEOUT_MS 5000
+#define REQUEST_COMMAND_TYPE "COMMAND"
+
+typedef struct {
+    uint64_t sent;              // Requests handed to a responder
+    uint64_t replied;           // Replies returned to their requester
+    uint64_t timed_out;
+    uint64_t failed;            // Malformed, no responder or no room
+    uint64_t late;              // Replies to requests that had timed out
+    int pending;
+} RequestStats;
+
+int request_init(int timeout_ms);
+void request_shutdown(void);
+
+// A REQUEST line from requester's stdout: data is "<id>|<TYPE>|<payload>".
+// Routed on the calling thread; console commands are posted to the main
+// thread. priority is the lane the responder gets it in.
+int request_send(Tool* requester, const char* data, EventPriority priority);
+// A REPLY (or REPLY_ERROR when error) line from responder's stdout: data
+// is "<ref>|<payload>"
+int request_reply(Tool* responder, const char* data, bool error, EventPriority priority);
+// Main thread: answer a console command request ("<id>|COMMAND|<command>")
+// with the command's output
+int request_answer(Tool* requester, const char* id, const char* payload);
+
+// Split "<id>|<TYPE>|<payload>" into id (REQUEST_MAX_ID bytes), type
+// (MAX_EVENT_TYPE bytes) and the payload after them; false when malformed
+bool request_parse(const char* data, char* id, char* type, const char** payload);
+
+// Main thread: answer requests that timed out. Returns the milliseconds
+// until the next one might, or -1 with none pending.
+int request_run(void);
+
+// Main thread: drop the requests tool sent or was asked, answering the
+// requesters of the latter with REPLY_ERROR "responder gone". Called when
+// a tool is unregistered and again before it is freed.
+void request_forget_tool(const Tool* tool);
+
+void request_get_stats(RequestStats* stats);
+
+#endif // YUKI_FRAME_REQUEST_H
@@ -0,0 +1,38 @@
+#ifndef YUKI_FRAME_RING_H
+#define YUKI_FRAME_RING_H
+
+#include "framework.h"
+#include <stdatomic.h>
+
+// Bounded lock-free queue of pointers (Vyukov's sequenced ring). Any number
+// of threads may push; a single thread pops. With one producer it is an
+// SPSC ring at no extra cost.
+typedef struct {
+    atomic_size_t sequence;
+    void* item;
+} RingCell;
+
+typedef struct {
+    RingCell* cells;
+    size_t mask;                // capacity - 1 (capacity is a power of two)
+    char pad0[CACHE_LINE_SIZE];
+    atomic_size_t head;         // Next slot producers claim
+    char pad1[CACHE_LINE_SIZE];
+    atomic_size_t tail;         // Next slot the consumer reads
+    char pad2[CACHE_LINE_SIZE];
+} Ring;
+
+// Create a ring holding at least `capacity` items
+Ring* ring_create(size_t capacity);
+void ring_destroy(Ring* ring);
+
+// Producer side (any thread): false when the ring is full
+bool ring_push(Ring* ring, void* item);
+// Push count items into consecutive slots with one claim; all or nothing
+bool ring_push_batch(Ring* ring, void* const* items, size_t count);
+
+// Consumer side (one thread): NULL when the ring is empty
+void* ring_pop(Ring* ring);
+bool ring_is_empty(Ring* ring);
+
+#endif // YUKI_FRAME_RING_H
@@ -0,0 +1,40 @@
+#ifndef YUKI_FRAME_SLAB_H
+#define YUKI_FRAME_SLAB_H
+
+#include "framework.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Size-class slab allocator for short-lived variable-size records. Requests
+// are rounded up to one of SLAB_CLASS_COUNT power-of-two classes, whose
+// blocks are carved from SLAB_SIZE slabs and recycled through a free list
+// per class, so allocating and freeing is a pointer pop or push with no
+// zeroing. Requests over SLAB_MAX_BLOCK go to malloc. Slabs are kept until
+// the pool is destroyed, so a pool's footprint follows its peak use.
+// A pool belongs to one thread; other threads hand blocks back with
+// slab_free_remote(), and the owner reclaims them on its next allocation.
+#define SLAB_MIN_SHIFT 5            // Smallest class: 32 bytes
+#define SLAB_CLASS_COUNT 8          // 32 B .. 4 KB
+#define SLAB_MAX_BLOCK ((size_t)1 << (SLAB_MIN_SHIFT + SLAB_CLASS_COUNT - 1))
+#define SLAB_SIZE (64 * 1024)
+
+typedef struct {
+    void* free_lists[SLAB_CLASS_COUNT];
+    void* slabs;                    // Chain of every slab, freed with the pool
+    size_t reserved;                // Bytes held in slabs and large blocks
+    size_t in_use;                  // Bytes handed out, rounded to class size
+    _Atomic(void*) remote_free;     // Blocks freed by other threads
+} SlabPool;
+
+void slab_pool_init(SlabPool* pool);
+// Frees every slab; large blocks still allocated are not tracked
+void slab_pool_destroy(SlabPool* pool);
+
+// Uninitialized block of at least size bytes, or NULL when out of memory
+void* slab_alloc(SlabPool* pool, size_t size);
+// size must be the one given to slab_alloc()
+void slab_free(SlabPool* pool, void* block, size_t size);
+// Same, from a thread that does not own the pool (lock-free)
+void slab_free_remote(SlabPool* pool, void* block, size_t size);
+
+#endif // YUKI_FRAME_SLAB_H
@@ -0,0 +1,55 @@
+#ifndef YUKI_FRAME_TIMER_WHEEL_H
+#define YUKI_FRAME_TIMER_WHEEL_H
+
+#include "framework.h"
+#include <stdint.h>
+
+// Hierarchical timer wheel: TIMER_WHEEL_LEVELS levels of 64 slots, each
+// level's slot spanning 64 of the level below. Arming and cancelling are
+// O(1); a timer is only touched again when its slot comes due (or is
+// cascaded to a finer level), so idle deadlines cost nothing per tick.
+#define TIMER_TICK_MS 10
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4        // 64^4 ticks of 10ms: about 46 hours
+
+struct Timer;
+typedef void (*TimerCallback)(struct Timer* timer, void* arg);
+
+// Embedded in the object that owns the deadline; no allocation
+typedef struct Timer {
+    struct Timer* next;
+    struct Timer* prev;
+    uint64_t expires;               // Deadline in ticks
+    TimerCallback callback;
+    void* arg;
+    int level;                      // -1 when not armed
+    int slot;
+} Timer;
+
+typedef struct {
+    Timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];  // Bit per non-empty slot
+    uint64_t now;                   // Last tick processed
+    int count;                      // Armed timers
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel* wheel, uint64_t now_ms);
+void timer_init(Timer* timer, TimerCallback callback, void* arg);
+bool timer_is_armed(const Timer* timer);
+
+// Arm (or re-arm) a timer to fire at deadline_ms (monotonic); deadlines in
+// the past fire on the next advance
+void timer_wheel_arm(TimerWheel* wheel, Timer* timer, uint64_t deadline_ms);
+void timer_wheel_cancel(TimerWheel* wheel, Timer* timer);
+
+// Run the callbacks of every timer due by now_ms; returns how many fired.
+// Callbacks may arm and cancel timers, including their own.
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms);
+
+// Milliseconds until the wheel next needs advancing (0 if overdue), or -1
+// with nothing armed. May be early for far deadlines, which are cascaded
+// to a finer level then.
+int timer_wheel_next_timeout(const TimerWheel* wheel, uint64_t now_ms);
+
+#endif // YUKI_FRAME_TIMER_WHEEL_H
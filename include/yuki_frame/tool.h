@@ -3,6 +3,29 @@
 
 #include "framework.h"
 #include "tool_queue.h"
+#include "line_framer.h"
+#include "log_framer.h"
+#include "timer_wheel.h"
+#include "event_type.h"
+#include "event_filter.h"
+#include "platform.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Events handed to the kernel per vectored write to a tool's stdin
+#define TOOL_DEFAULT_BATCH_SIZE 64
+#define TOOL_MAX_BATCH_SIZE 1024
+
+// First restart delay after a crash; doubles per restart up to the tool's
+// restart_max_delay_sec
+#define TOOL_RESTART_BASE_DELAY_MS 500
+
+// Liveness sweep for tools whose exit the event loop cannot report
+#define TOOL_HEALTH_SWEEP_INTERVAL_MS 5000
+
+// Without exit notification a pipe hangs up just before its process can be
+// reaped: look again after
+#define TOOL_EXIT_RECHECK_MS 50
 
 // Tool status
 typedef enum {
@@ -28,17 +51,17 @@ typedef struct Tool {
     char description[256];  // Your existing field
     
     // Process info (YOUR EXISTING FIELDS)
-    HANDLE process_handle;  // Your field name
+    ProcessHandle process_handle;  // Your field name
     ProcessID pid;
     ToolStatus status;
     
-    // Pipes (YOUR EXISTING FIELDS)
+    // Pipes (YOUR EXISTING FIELDS) - all I/O goes through the platform layer
     int stdin_fd;
     int stdout_fd;
     int stderr_fd;
-    HANDLE stdin_handle;
-    HANDLE stdout_handle;
-    HANDLE stderr_handle;
+    LineFramer stdout_framer;  // Reassembles stdout lines for this tool only
+    LogFramer stderr_framer;   // Splits stderr into log records, rate capped
+    int exit_fd;               // Readable once the process exits, -1 if none
     
     // Configuration (YOUR EXISTING FIELDS)
     bool autostart;
@@ -46,25 +69,75 @@ typedef struct Tool {
     RestartPolicy restart_policy;
     int restart_max_delay_sec;
     int max_restarts;  // Your existing field
+    int heartbeat_timeout_sec; // Config: restart if no HEARTBEAT for this long (0 = off)
+    int start_timeout_sec;     // Config: on-demand tool must send TOOL_READY in time
+    int idle_timeout_sec;      // Config: stop an on-demand tool idle this long
     
-    // Subscriptions (YOUR EXISTING FIELDS)
-    char subscriptions[MAX_SUBSCRIPTIONS][MAX_EVENT_TYPE];
+    // Subscriptions: interned types and patterns (event_type_name() for the text)
+    EventTypeId subscriptions[MAX_SUBSCRIPTIONS];
+    EventFilter* filters[MAX_SUBSCRIPTIONS];  // Content filter of each, NULL for none
     int subscription_count;
     
     // ============ NEW QUEUE FIELDS ============
     ToolQueue* inbox;          // Per-tool event queue
     int max_queue_size;        // Config: max queue size
     QueuePolicy queue_policy;  // Config: queue policy
+    int max_batch_size;        // Config: most events per vectored write
+    size_t max_queue_bytes;    // Config: inbox byte budget (0 = none)
+    char conflate_key[MAX_EVENT_TYPE];  // Config: data field keying conflation ("" = sender)
     
     // On-demand state
     bool is_on_demand;         // restart_policy == RESTART_ON_DEMAND
     bool is_starting;          // Tool is starting but not ready yet
     // ============ END NEW FIELDS ============
     
+    // Event loop state
+    int shard;                 // I/O shard that owns the pipes and inbox
+    bool delivery_pending;     // Listed for delivery on the next loop pass
+    bool stdin_watched;        // Waiting for stdin to drain before delivering
+    bool exit_watched;         // exit_fd is registered with the shard
+    
+    // Deadlines (main thread's timer wheel)
+    Timer restart_timer;       // Restart backoff after a crash
+    Timer heartbeat_timer;
+    Timer start_timer;
+    Timer idle_timer;
+    Timer exit_timer;          // Re-check after a pipe hung up
+    uint64_t heartbeat_ms;     // Monotonic time of the last HEARTBEAT
+    atomic_uint_fast64_t last_active_ms;  // Last event queued (shard writes)
+    
+    // Event log offsets (event_log.h). Nothing logged at or below log_acked
+    // is still waiting in the inbox; log_owed is the last LSN routed here.
+    atomic_uint_fast64_t log_acked;       // Shard writes, checkpoint reads
+    atomic_uint_fast64_t log_owed;        // Routers raise it
+    uint64_t log_queued;                  // Last LSN that reached the shard
+    
+    // Flow control (flow_control.h): the account charged for the events it
+    // published that are still queued, and whether its shard stopped
+    // reading its stdout
+    struct FlowAccount* flow;
+    bool stdout_paused;
+    atomic_uint_fast64_t stdout_pauses;
+    
+    // Publishing (dedup.h): its events are numbered 1, 2, ... across
+    // restarts; ids of the latest ones, kept once it sends an id
+    atomic_uint_fast64_t publish_seq;     // Shard writes
+    atomic_uint_fast64_t duplicates;      // Events dropped as repeats
+    int dedup_window;          // Config: ids remembered (0 = no suppression)
+    struct DedupWindow* dedup;
+    bool sequence_numbers;     // Config: receive events as TYPE|sender@seq|data
+    
+    // Unregistered: freed once no routing snapshot, ring or work item can
+    // still reach it (tool_reclaim)
+    bool retired;              // Set under the shard lock
+    uint64_t retired_epoch;    // Route epoch it left the routes in
+    
     // Statistics (YOUR EXISTING FIELDS)
     int events_sent;
     int events_received;
     int restart_count;
+    bool has_exited;           // last_exit describes the previous run
+    PlatformExitInfo last_exit;
     time_t start_time;
     time_t started_at;         // Your existing field
     time_t last_heartbeat;     // Your existing field
@@ -87,15 +160,27 @@ void tool_registry_shutdown(void);
 // Tool management
 int tool_register(const char* name, const char* command);
 int tool_unregister(const char* name);
+// Main loop: hand unregistered tools no shard can route to any more back
+// to their shard, which returns them as WORK_RETIRE behind whatever it
+// still had queued for them; tool_destroy() then frees them
+void tool_reclaim(void);
+void tool_destroy(Tool* tool);
 Tool* tool_find(const char* name);
 int tool_start(const char* name);
 int tool_stop(const char* name);
 int tool_restart(const char* name);
+// Quotes and surrounding spaces are stripped; subscribing twice to the
+// same type is a no-op. Wildcard patterns: see event_pattern_valid().
+// "TYPE[filter]" only delivers events whose data passes the filter (see
+// event_filter.h); filters of the same type are combined with "||", and
+// subscribing to the type without one removes them.
 int tool_subscribe(const char* name, const char* event_type);
 
 // Tool iteration
 Tool* tool_get_first(void);
 Tool* tool_get_next(void);
+int tool_get_count(void);
+Tool* tool_get_at(int index);  // Stateless, for building routing snapshots
 
 // Tool status
 const char* tool_status_string(ToolStatus status);
@@ -105,9 +190,32 @@ bool tool_is_running(const char* name);
 // Tool communication
 int tool_send_event(const char* name, const char* event_msg);
 int tool_send_event_nonblocking(const char* name, const char* event_msg);  // NEW!
+// Write as much of the inbox as the stdin pipe accepts. Returns FW_OK when
+// the inbox is empty, FW_ERROR_QUEUE_FULL when the pipe is full (a partial
+// event is resumed on the next call), or another error.
+int tool_flush_inbox(Tool* tool);
+// Recompute log_acked from the inbox (shard, after it changed)
+void tool_update_log_offset(Tool* tool);
+int tool_set_queue_config(const char* name, int max_queue_size, QueuePolicy policy, int max_batch_size);
+int tool_set_restart_config(const char* name, RestartPolicy policy, bool restart_on_crash,
+                            int max_restarts, int restart_max_delay_sec);
+int tool_set_timeouts(const char* name, int heartbeat_timeout_sec,
+                      int start_timeout_sec, int idle_timeout_sec);
+int tool_set_log_rate(const char* name, int lines_per_sec);  // 0 = no cap
+int tool_set_queue_bytes(const char* name, size_t max_queue_bytes);  // 0 = no budget
+int tool_set_conflate_key(const char* name, const char* field);     // NULL or "" = sender
+int tool_set_sequencing(const char* name, int dedup_window, bool sequence_numbers);
 
 // Tool health monitoring
 void tool_check_health(void);
+void tool_check_health_one(Tool* tool);
+void tool_check_hangup(Tool* tool);      // One of its pipes hung up
+void tool_check_exit(Tool* tool);        // Its exit fd became readable
 void tool_update_heartbeat(const char* name);
+void tool_mark_ready(const char* name);  // TOOL_READY received
+
+// Run restart, heartbeat, start and idle deadlines that are due. Returns
+// the milliseconds until the next one (the main loop's wait timeout).
+int tool_run_timers(void);
 
 #endif // YUKI_FRAME_TOOL_H
@@ -2,49 +2,98 @@
 #define YUKI_FRAME_TOOL_QUEUE_H
 
 #include "framework.h"
+#include "event_buffer.h"
+#include <stdint.h>
 
 // Queue policy when queue is full
 typedef enum {
     QUEUE_POLICY_DROP_OLDEST,   // Drop oldest event, add new one (default)
     QUEUE_POLICY_DROP_NEWEST,   // Reject new event, keep existing queue
-    QUEUE_POLICY_BLOCK          // Block until space available (use carefully!)
+    QUEUE_POLICY_BLOCK,         // Block until space available (use carefully!)
+    QUEUE_POLICY_CONFLATE       // Replace the queued event with the same key; drop oldest when full
 } QueuePolicy;
 
-// Per-tool event queue
+// Events of one priority, oldest first
 typedef struct {
-    char** messages;            // Array of event message strings
-    int capacity;               // Maximum queue size
+    EventBuffer** messages;     // Ring of capacity slots, one reference each
+    uint32_t* keys;             // Conflation key hash per slot (conflate policy only)
     int head;                   // Read position
     int tail;                   // Write position
+    int count;
+} ToolQueueLane;
+
+// Per-tool event queue. Each priority has its own lane; events are
+// delivered from the most urgent lane first, except that an event already
+// half written to the pipe is always finished first. The lanes share the
+// capacity and byte budget. When the queue is full, a queued event of
+// lower priority than the new one is dropped whatever the policy; the
+// policy only decides between events of the same priority, and the new
+// event is refused if everything queued is more urgent.
+//
+// With QUEUE_POLICY_CONFLATE a new event replaces, in its place in the
+// queue, a queued event of the same priority and key that is not half
+// written, so only the latest value per key waits. The key is the event's
+// type and sender, or its type and the value of conflate_field in the data
+// ("field=value" or JSON "field": value) when that field is present.
+typedef struct {
+    ToolQueueLane lanes[EVENT_PRIORITY_COUNT];  // Indexed by EventPriority
+    int capacity;               // Maximum queue size
     int count;                  // Current number of items
+    int head_lane;              // Lane of the next event to write
+    size_t head_offset;         // Bytes of the head message already written
+    size_t bytes;               // Bytes queued (each inbox counts a shared event)
+    size_t max_bytes;           // Byte budget, 0 for none
     QueuePolicy policy;         // What to do when full
+    char conflate_field[MAX_EVENT_TYPE];  // Data field keying conflation, "" = sender
     int dropped_count;          // Statistics: events dropped
     int delivered_count;        // Statistics: events delivered
+    int conflated_count;        // Statistics: events replaced by a newer one
 } ToolQueue;
 
 // Initialize tool queue
 int tool_queue_init(ToolQueue** queue, int capacity, QueuePolicy policy);
 
+// Also count the queue full once its events hold max_bytes (0 = no budget).
+// An event larger than the whole budget is still taken by an empty queue.
+void tool_queue_set_max_bytes(ToolQueue* queue, size_t max_bytes);
+
+// Key conflation by this data field instead of the sender (NULL or "" = sender)
+void tool_queue_set_conflate_field(ToolQueue* queue, const char* field);
+
 // Shutdown and free tool queue
 void tool_queue_shutdown(ToolQueue* queue);
 
 // Add event to queue (returns FW_OK or error)
 int tool_queue_add(ToolQueue* queue, const char* event_msg);
 
+// Add a shared event, taking over one reference (released on failure).
+// It goes in the lane of buffer->priority.
+int tool_queue_add_buffer(ToolQueue* queue, EventBuffer* buffer);
+
 // Peek at next event without removing (returns NULL if empty)
 const char* tool_queue_peek(ToolQueue* queue);
 
+// Peek at the index-th queued event in delivery order (0 = head), NULL if
+// out of range
+const char* tool_queue_peek_at(ToolQueue* queue, int index);
+const EventBuffer* tool_queue_peek_buffer_at(ToolQueue* queue, int index);
+
 // Remove event from queue (call after successful delivery)
 void tool_queue_remove(ToolQueue* queue);
 
 // Get queue statistics
 int tool_queue_count(ToolQueue* queue);
+int tool_queue_lane_count(ToolQueue* queue, EventPriority priority);
 int tool_queue_capacity(ToolQueue* queue);
+size_t tool_queue_bytes(ToolQueue* queue);
 int tool_queue_dropped(ToolQueue* queue);
 int tool_queue_delivered(ToolQueue* queue);
+int tool_queue_conflated(ToolQueue* queue);
 bool tool_queue_is_empty(ToolQueue* queue);
 bool tool_queue_is_full(ToolQueue* queue);
 
+// Lowest event log sequence number queued, 0 if no logged event is
+uint64_t tool_queue_oldest_lsn(const ToolQueue* queue);
 // Clear all events in queue
 void tool_queue_clear(ToolQueue* queue);
 
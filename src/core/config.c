@@ -2,6 +2,12 @@
 #include "yuki_frame/config.h"
 #include "yuki_frame/tool.h"
 #include "yuki_frame/logger.h"
+#include "yuki_frame/line_framer.h"
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/request.h"
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/dedup.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +41,39 @@ static char* trim(char* str) {
     return str;
 }
 
+// Byte counts accept a K, M or G suffix ("64M"); 0 if malformed
+static size_t parse_size(const char* value) {
+    char* end;
+    unsigned long long size = strtoull(value, &end, 10);
+    switch (toupper((unsigned char)*end)) {
+        case 'K': size <<= 10; break;
+        case 'M': size <<= 20; break;
+        case 'G': size <<= 30; break;
+        case '\0': break;
+        default: return 0;
+    }
+    return (size_t)size;
+}
+
+// "high", "normal" or "low"; false if it is none of them
+static bool parse_priority(const char* value, EventPriority* priority) {
+    if (strcmp(value, "high") == 0) {
+        *priority = EVENT_PRIORITY_HIGH;
+    } else if (strcmp(value, "normal") == 0) {
+        *priority = EVENT_PRIORITY_NORMAL;
+    } else if (strcmp(value, "low") == 0) {
+        *priority = EVENT_PRIORITY_LOW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Tool sections are written [tool:name] (or [tool.name])
+static bool is_tool_section(const char* section) {
+    return strncmp(section, "tool:", 5) == 0 || strncmp(section, "tool.", 5) == 0;
+}
+
 int config_load(const char* config_file) {
     if (!config_file) {
         return FW_ERROR_INVALID_ARG;
@@ -63,6 +102,19 @@ int config_load(const char* config_file) {
     g_config.enable_debug = false;
     g_config.enable_remote_control = false;
     g_config.control_port = 9999;
+    g_config.io_threads = 1;
+    g_config.loop_mode = LOOP_MODE_BLOCKING;
+    g_config.spin_us = 50;
+    g_config.loop_cpu = -1;
+    g_config.io_backend = IO_BACKEND_DEFAULT;
+    g_config.max_frame_size = LINE_FRAMER_DEFAULT_MAX_FRAME;
+    g_config.event_log[0] = '\0';
+    g_config.event_log_sync_ms = EVENT_LOG_DEFAULT_SYNC_MS;
+    g_config.event_log_segment_size = EVENT_LOG_DEFAULT_SEGMENT_SIZE;
+    g_config.request_timeout_ms = REQUEST_DEFAULT_TIMEOUT_MS;
+    g_config.bus_memory_limit = FLOW_DEFAULT_MEMORY_LIMIT;
+    g_config.bus_high_watermark = FLOW_DEFAULT_HIGH_WATERMARK;
+    g_config.bus_low_watermark = FLOW_DEFAULT_LOW_WATERMARK;
     
     char line[MAX_LINE];
     char section[MAX_SECTION] = "";
@@ -95,14 +147,10 @@ int config_load(const char* config_file) {
             
             // Store in generic config entries array
             if (config_entry_count < MAX_CONFIG_ENTRIES) {
-                strncpy(config_entries[config_entry_count].section, section, MAX_SECTION - 1);
-                config_entries[config_entry_count].section[MAX_SECTION - 1] = '\0';
-                
-                strncpy(config_entries[config_entry_count].key, key, MAX_KEY - 1);
-                config_entries[config_entry_count].key[MAX_KEY - 1] = '\0';
-                
-                strncpy(config_entries[config_entry_count].value, value, MAX_VALUE - 1);
-                config_entries[config_entry_count].value[MAX_VALUE - 1] = '\0';
+                ConfigEntry* entry = &config_entries[config_entry_count];
+                snprintf(entry->section, sizeof(entry->section), "%s", section);
+                snprintf(entry->key, sizeof(entry->key), "%s", key);
+                snprintf(entry->value, sizeof(entry->value), "%s", value);
                 
                 config_entry_count++;
             }
@@ -128,6 +176,74 @@ int config_load(const char* config_file) {
                     g_config.message_queue_size = atoi(value);
                 } else if (strcmp(key, "enable_debug") == 0) {
                     g_config.enable_debug = (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+                } else if (strcmp(key, "io_threads") == 0) {
+                    g_config.io_threads = atoi(value);
+                } else if (strcmp(key, "loop_mode") == 0) {
+                    if (strcmp(value, "hybrid") == 0) {
+                        g_config.loop_mode = LOOP_MODE_HYBRID;
+                    } else if (strcmp(value, "busy-poll") == 0 || strcmp(value, "busy_poll") == 0) {
+                        g_config.loop_mode = LOOP_MODE_BUSY_POLL;
+                    } else {
+                        g_config.loop_mode = LOOP_MODE_BLOCKING;
+                    }
+                } else if (strcmp(key, "spin_us") == 0) {
+                    g_config.spin_us = atoi(value);
+                    if (g_config.spin_us < 0) {
+                        g_config.spin_us = 0;
+                    }
+                } else if (strcmp(key, "loop_cpu") == 0) {
+                    g_config.loop_cpu = atoi(value);
+                } else if (strcmp(key, "io_backend") == 0) {
+                    if (strcmp(value, "io_uring") == 0 || strcmp(value, "io-uring") == 0) {
+                        g_config.io_backend = IO_BACKEND_IO_URING;
+                    } else if (strcmp(value, "auto") == 0) {
+                        g_config.io_backend = IO_BACKEND_AUTO;
+                    } else {
+                        g_config.io_backend = IO_BACKEND_DEFAULT;
+                    }
+                } else if (strcmp(key, "max_frame_size") == 0) {
+                    g_config.max_frame_size = parse_size(value);
+                    if (g_config.max_frame_size == 0) {
+                        g_config.max_frame_size = LINE_FRAMER_DEFAULT_MAX_FRAME;
+                    }
+                } else if (strcmp(key, "event_log") == 0) {
+                    strncpy(g_config.event_log, value, sizeof(g_config.event_log) - 1);
+                    g_config.event_log[sizeof(g_config.event_log) - 1] = '\0';
+                } else if (strcmp(key, "event_log_sync_ms") == 0) {
+                    g_config.event_log_sync_ms = atoi(value);
+                    if (g_config.event_log_sync_ms < 0) {
+                        g_config.event_log_sync_ms = 0;
+                    }
+                } else if (strcmp(key, "event_log_segment_size") == 0) {
+                    g_config.event_log_segment_size = parse_size(value);
+                    if (g_config.event_log_segment_size == 0) {
+                        g_config.event_log_segment_size = EVENT_LOG_DEFAULT_SEGMENT_SIZE;
+                    }
+                } else if (strcmp(key, "request_timeout_ms") == 0) {
+                    g_config.request_timeout_ms = atoi(value);
+                    if (g_config.request_timeout_ms <= 0) {
+                        g_config.request_timeout_ms = REQUEST_DEFAULT_TIMEOUT_MS;
+                    }
+                } else if (strcmp(key, "bus_memory_limit") == 0) {
+                    g_config.bus_memory_limit = parse_size(value);
+                    if (g_config.bus_memory_limit == 0) {
+                        g_config.bus_memory_limit = FLOW_DEFAULT_MEMORY_LIMIT;
+                    }
+                } else if (strcmp(key, "bus_high_watermark") == 0) {
+                    g_config.bus_high_watermark = atoi(value);
+                } else if (strcmp(key, "bus_low_watermark") == 0) {
+                    g_config.bus_low_watermark = atoi(value);
+                }
+            } else if (strcmp(section, "priorities") == 0) {
+                // TYPE = high | normal | low, for exact event types
+                EventPriority priority;
+                EventTypeId id = strpbrk(key, "*#") ? EVENT_TYPE_NONE : event_type_intern(key);
+                if (!parse_priority(value, &priority)) {
+                    fprintf(stderr, "Unknown priority '%s' for %s\n", value, key);
+                } else if (id == EVENT_TYPE_NONE) {
+                    fprintf(stderr, "Cannot set priority of event type '%s'\n", key);
+                } else {
+                    event_type_set_priority(id, priority);
                 }
             }
         }
@@ -205,7 +321,7 @@ int config_get_tools(ToolConfig** tools_out, int* count_out) {
                 section[sizeof(section) - 1] = '\0';
                 
                 // Check if it's a tool section (format: tool:toolname)
-                if (strncmp(section, "tool:", 5) == 0) {
+                if (is_tool_section(section)) {
                     tool_count++;
                 }
             }
@@ -248,7 +364,7 @@ int config_get_tools(ToolConfig** tools_out, int* count_out) {
                 section[sizeof(section) - 1] = '\0';
                 
                 // Check if it's a tool section (format: tool:toolname)
-                if (strncmp(section, "tool:", 5) == 0) {
+                if (is_tool_section(section)) {
                     current_tool++;
                     // Extract tool name (after "tool:")
                     strncpy(tools[current_tool].name, section + 5, MAX_TOOL_NAME - 1);
@@ -261,13 +377,22 @@ int config_get_tools(ToolConfig** tools_out, int* count_out) {
                     tools[current_tool].restart_policy = RESTART_ALWAYS;  // NEW default
                     tools[current_tool].max_queue_size = 100;  // NEW default
                     tools[current_tool].queue_policy = QUEUE_POLICY_DROP_OLDEST;  // NEW default
+                    tools[current_tool].max_batch_size = TOOL_DEFAULT_BATCH_SIZE;
+                    tools[current_tool].max_queue_bytes = 0;
+                    tools[current_tool].restart_max_delay_sec = 60;
+                    tools[current_tool].heartbeat_timeout_sec = 0;
+                    tools[current_tool].start_timeout_sec = 0;
+                    tools[current_tool].idle_timeout_sec = 0;
+                    tools[current_tool].log_rate_limit = LOG_FRAMER_DEFAULT_RATE;
+                    tools[current_tool].dedup_window = DEDUP_DEFAULT_WINDOW;
+                    tools[current_tool].sequence_numbers = false;
                 }
             }
             continue;
         }
         
         // Key=value pair for current tool
-        if (current_tool >= 0 && strncmp(section, "tool:", 5) == 0) {
+        if (current_tool >= 0 && is_tool_section(section)) {
             char* eq = strchr(p, '=');
             if (eq) {
                 *eq = '\0';
@@ -309,7 +434,39 @@ int config_get_tools(ToolConfig** tools_out, int* count_out) {
                         tools[current_tool].queue_policy = QUEUE_POLICY_DROP_NEWEST;
                     } else if (strcmp(value, "block") == 0) {
                         tools[current_tool].queue_policy = QUEUE_POLICY_BLOCK;
+                    } else if (strcmp(value, "conflate") == 0) {
+                        tools[current_tool].queue_policy = QUEUE_POLICY_CONFLATE;
+                    }
+                } else if (strcmp(key, "max_batch_size") == 0) {
+                    tools[current_tool].max_batch_size = atoi(value);
+                    if (tools[current_tool].max_batch_size <= 0) {
+                        tools[current_tool].max_batch_size = TOOL_DEFAULT_BATCH_SIZE;
+                    }
+                } else if (strcmp(key, "max_queue_bytes") == 0) {
+                    tools[current_tool].max_queue_bytes = parse_size(value);
+                } else if (strcmp(key, "conflate_key") == 0) {
+                    strncpy(tools[current_tool].conflate_key, value, MAX_EVENT_TYPE - 1);
+                    tools[current_tool].conflate_key[MAX_EVENT_TYPE - 1] = '\0';
+                } else if (strcmp(key, "restart_max_delay") == 0) {
+                    tools[current_tool].restart_max_delay_sec = atoi(value);
+                    if (tools[current_tool].restart_max_delay_sec <= 0) {
+                        tools[current_tool].restart_max_delay_sec = 60;
+                    }
+                } else if (strcmp(key, "heartbeat_timeout") == 0) {
+                    tools[current_tool].heartbeat_timeout_sec = atoi(value);
+                } else if (strcmp(key, "start_timeout") == 0) {
+                    tools[current_tool].start_timeout_sec = atoi(value);
+                } else if (strcmp(key, "idle_timeout") == 0) {
+                    tools[current_tool].idle_timeout_sec = atoi(value);
+                } else if (strcmp(key, "log_rate_limit") == 0) {
+                    tools[current_tool].log_rate_limit = atoi(value);
+                } else if (strcmp(key, "dedup_window") == 0) {
+                    tools[current_tool].dedup_window = atoi(value);
+                    if (tools[current_tool].dedup_window < 0) {
+                        tools[current_tool].dedup_window = 0;
                     }
+                } else if (strcmp(key, "sequence_numbers") == 0) {
+                    tools[current_tool].sequence_numbers = (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0);
                 } else if (strcmp(key, "subscribe_to") == 0) {
                     strncpy(tools[current_tool].subscriptions, value, 511);
                     tools[current_tool].subscriptions[511] = '\0';
@@ -9,6 +9,13 @@
 #include "yuki_frame/framework.h"
 #include "yuki_frame/tool.h"
 #include "yuki_frame/logger.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/log_replay.h"
+#include "yuki_frame/request.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/flow_control.h"
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
@@ -70,12 +77,9 @@ int control_get_tool_status(const char* tool_name, ControlToolInfo* info) {
     
     // Fill in the info structure
     memset(info, 0, sizeof(ControlToolInfo));
-    strncpy(info->name, tool->name, sizeof(info->name) - 1);
-    info->name[sizeof(info->name) - 1] = '\0';
-    strncpy(info->command, tool->command, sizeof(info->command) - 1);
-    info->command[sizeof(info->command) - 1] = '\0';
-    strncpy(info->description, tool->description, sizeof(info->description) - 1);
-    info->description[sizeof(info->description) - 1] = '\0';
+    snprintf(info->name, sizeof(info->name), "%s", tool->name);
+    snprintf(info->command, sizeof(info->command), "%s", tool->command);
+    snprintf(info->description, sizeof(info->description), "%s", tool->description);
     info->status = tool->status;
     info->pid = tool->pid;
     info->autostart = tool->autostart;
@@ -85,6 +89,13 @@ int control_get_tool_status(const char* tool_name, ControlToolInfo* info) {
     info->events_sent = tool->events_sent;
     info->events_received = tool->events_received;
     info->subscription_count = tool->subscription_count;
+    info->has_exited = tool->has_exited;
+    info->last_exit_code = tool->last_exit.exit_code;
+    info->last_exit_signal = tool->last_exit.signal;
+    info->last_cpu_ms = tool->last_exit.user_cpu_ms + tool->last_exit.system_cpu_ms;
+    info->last_max_rss_kb = tool->last_exit.max_rss_kb;
+    info->last_sequence = atomic_load(&tool->publish_seq);
+    info->duplicates = atomic_load(&tool->duplicates);
     
     return FW_OK;
 }
@@ -103,12 +114,9 @@ int control_list_tools(control_list_callback_t callback, void* user_data) {
         
         // Fill info structure
         memset(&info, 0, sizeof(ControlToolInfo));
-        strncpy(info.name, tool->name, sizeof(info.name) - 1);
-        info.name[sizeof(info.name) - 1] = '\0';
-        strncpy(info.command, tool->command, sizeof(info.command) - 1);
-        info.command[sizeof(info.command) - 1] = '\0';
-        strncpy(info.description, tool->description, sizeof(info.description) - 1);
-        info.description[sizeof(info.description) - 1] = '\0';
+        snprintf(info.name, sizeof(info.name), "%s", tool->name);
+        snprintf(info.command, sizeof(info.command), "%s", tool->command);
+        snprintf(info.description, sizeof(info.description), "%s", tool->description);
         info.status = tool->status;
         info.pid = tool->pid;
         info.autostart = tool->autostart;
@@ -118,6 +126,11 @@ int control_list_tools(control_list_callback_t callback, void* user_data) {
         info.events_sent = tool->events_sent;
         info.events_received = tool->events_received;
         info.subscription_count = tool->subscription_count;
+        info.has_exited = tool->has_exited;
+        info.last_exit_code = tool->last_exit.exit_code;
+        info.last_exit_signal = tool->last_exit.signal;
+        info.last_cpu_ms = tool->last_exit.user_cpu_ms + tool->last_exit.system_cpu_ms;
+        info.last_max_rss_kb = tool->last_exit.max_rss_kb;
         
         // Call callback
         bool continue_iteration = callback(&info, user_data);
@@ -160,6 +173,7 @@ bool control_tool_exists(const char* tool_name) {
 int control_shutdown_framework(void) {
     LOG_INFO("control_api", "Framework shutdown requested");
     g_running = false;
+    event_loop_wakeup(event_loop_control());  // The main loop may be idle until its next deadline
     return FW_OK;
 }
 
@@ -305,6 +319,21 @@ int control_execute_command(const char* command, char* response, size_t response
                          "  Events sent: %" PRIu64 "\n", info.events_sent);
         offset += snprintf(response + offset, response_size - offset,
                          "  Events received: %" PRIu64 "\n", info.events_received);
+        offset += snprintf(response + offset, response_size - offset,
+                         "  Last sequence: %" PRIu64 " (%" PRIu64 " repeats dropped)\n",
+                         info.last_sequence, info.duplicates);
+        if (info.has_exited) {
+            if (info.last_exit_signal) {
+                offset += snprintf(response + offset, response_size - offset,
+                                 "  Last exit: signal %d", info.last_exit_signal);
+            } else {
+                offset += snprintf(response + offset, response_size - offset,
+                                 "  Last exit: code %d", info.last_exit_code);
+            }
+            offset += snprintf(response + offset, response_size - offset,
+                             " (cpu %" PRIu64 " ms, max RSS %" PRIu64 " KB)\n",
+                             info.last_cpu_ms, info.last_max_rss_kb);
+        }
         snprintf(response + offset, response_size - offset, "\n");
         return FW_OK;
     }
@@ -322,6 +351,168 @@ int control_execute_command(const char* command, char* response, size_t response
                 hours, minutes, seconds);
         return FW_OK;
     }
+    else if (strcmp(cmd, "loops") == 0) {
+        static const char* mode_names[] = { "blocking", "hybrid", "busy-poll" };
+        int offset = snprintf(response, response_size, "\nEvent loops (%s):\n",
+                              mode_names[event_loop_mode()]);
+        offset += snprintf(response + offset, response_size - offset,
+                          "%-8s %12s %12s %12s %12s %12s\n",
+                          "Loop", "Waits", "Spins", "Sleeps", "Timeouts", "Wakeups");
+        for (int i = 0; i <= event_loop_control() && offset < (int)response_size - 100; i++) {
+            LoopStats stats;
+            event_loop_get_stats(i, &stats);
+            char name[24];
+            if (i == event_loop_control() && event_loop_shard_count() > 1) {
+                snprintf(name, sizeof(name), "control");
+            } else {
+                snprintf(name, sizeof(name), "shard %d", i);
+            }
+            offset += snprintf(response + offset, response_size - offset,
+                              "%-8s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+                              name, stats.waits, stats.spins, stats.sleeps,
+                              stats.empty_sleeps, stats.wakeups);
+        }
+        snprintf(response + offset, response_size - offset, "\n");
+        return FW_OK;
+    }
+    else if (strcmp(cmd, "types") == 0) {
+        int offset = snprintf(response, response_size, "\nEvent types (%u):\n",
+                              (unsigned int)event_type_count());
+        offset += snprintf(response + offset, response_size - offset,
+                          "%-32s %12s %12s\n", "Type", "Routed", "Delivered");
+        for (EventTypeId id = 1; id <= event_type_count() && offset < (int)response_size - 100; id++) {
+            EventTypeStats stats;
+            event_type_get_stats(id, &stats);
+            if (stats.routed == 0) {
+                continue;  // Only subscribed to so far
+            }
+            offset += snprintf(response + offset, response_size - offset,
+                              "%-32s %12" PRIu64 " %12" PRIu64 "\n",
+                              event_type_name(id), stats.routed, stats.delivered);
+        }
+        snprintf(response + offset, response_size - offset, "\n");
+        return FW_OK;
+    }
+    else if (strcmp(cmd, "eventlog") == 0) {
+        if (!event_log_is_open()) {
+            snprintf(response, response_size, "Event log is off ([core] event_log)\n");
+            return FW_OK;
+        }
+        EventLogStats stats;
+        event_log_get_stats(&stats);
+        snprintf(response, response_size,
+                "\nEvent log %s:\n"
+                "  Last LSN:   %" PRIu64 "\n"
+                "  Synced LSN: %" PRIu64 "\n"
+                "  Appended:   %" PRIu64 "\n"
+                "  Syncs:      %" PRIu64 "\n"
+                "  Bytes:      %" PRIu64 "\n"
+                "  Replayed:   %" PRIu64 "\n"
+                "  Segments:   %d\n\n",
+                g_config.event_log, event_log_last_lsn(), stats.synced_lsn, stats.appended,
+                stats.syncs, stats.bytes, stats.replayed, stats.segments);
+        return FW_OK;
+    }
+    else if (strcmp(cmd, "requests") == 0) {
+        RequestStats stats;
+        request_get_stats(&stats);
+        snprintf(response, response_size,
+                "\nRequests:\n"
+                "  Pending:    %d\n"
+                "  Sent:       %" PRIu64 "\n"
+                "  Replied:    %" PRIu64 "\n"
+                "  Timed out:  %" PRIu64 "\n"
+                "  Failed:     %" PRIu64 "\n"
+                "  Late:       %" PRIu64 "\n\n",
+                stats.pending, stats.sent, stats.replied, stats.timed_out, stats.failed,
+                stats.late);
+        return FW_OK;
+    }
+    else if (strcmp(cmd, "bus") == 0) {
+        FlowStats flow;
+        EventBusStats bus;
+        flow_get_stats(&flow);
+        event_bus_get_stats(&bus);
+        int offset = snprintf(response, response_size,
+                "\nEvent bus:\n"
+                "  Queued:     %zu of %zu bytes (peak %zu)\n"
+                "  Watermarks: pause at %zu, resume at %zu bytes%s\n"
+                "  Pressure:   %" PRIu64 " times, %" PRIu64 " publisher pauses\n"
+                "  Rejected:   %" PRIu64 "\n"
+                "  Ring:       %d of %d, %d overflowed (peak %d, total %" PRIu64 ")\n",
+                flow.used, flow.limit, flow.peak, flow.high_watermark, flow.low_watermark,
+                flow.pressure ? " (under pressure)" : "", flow.pressure_count, flow.pauses,
+                flow.rejected, bus.queued, bus.ring_capacity, bus.overflowed, bus.overflow_peak,
+                bus.overflow_total);
+        
+        // Publishers with events queued now or paused before
+        bool header = false;
+        for (Tool* tool = tool_get_first(); tool && offset < (int)response_size - 100;
+             tool = tool_get_next()) {
+            size_t bytes = flow_account_bytes(tool->flow);
+            uint64_t pauses = atomic_load(&tool->stdout_pauses);
+            if (bytes == 0 && pauses == 0) {
+                continue;
+            }
+            if (!header) {
+                offset += snprintf(response + offset, response_size - offset,
+                                  "\n%-20s %14s %8s %10s\n",
+                                  "Publisher", "Queued bytes", "Paused", "Pauses");
+                header = true;
+            }
+            offset += snprintf(response + offset, response_size - offset,
+                              "%-20s %14zu %8s %10" PRIu64 "\n",
+                              tool->name, bytes, tool->stdout_paused ? "yes" : "no", pauses);
+        }
+        snprintf(response + offset, response_size - offset, "\n");
+        return FW_OK;
+    }
+    else if (strcmp(cmd, "replay") == 0) {
+        if (parsed < 2) {
+            LogReplayStatus replays[LOG_REPLAY_MAX];
+            int count = log_replay_list(replays, LOG_REPLAY_MAX);
+            int offset = snprintf(response, response_size, "\nReplays (%d):\n", count);
+            for (int i = 0; i < count && offset < (int)response_size - 100; i++) {
+                offset += snprintf(response + offset, response_size - offset,
+                                  "  %-20s %10" PRIu64 " sent, at LSN %" PRIu64 " of %" PRIu64
+                                  " (%d/s)\n", replays[i].tool, replays[i].sent,
+                                  replays[i].last_lsn, replays[i].until_lsn, replays[i].rate);
+            }
+            snprintf(response + offset, response_size - offset, "\n");
+            return FW_OK;
+        }
+        
+        // The options follow the command and the tool name
+        const char* options_text = command;
+        for (int word = 0; word < 2; word++) {
+            options_text += strspn(options_text, " \t");
+            options_text += strcspn(options_text, " \t");
+        }
+        options_text += strspn(options_text, " \t");
+        if (strcmp(options_text, "stop") == 0) {
+            int result = log_replay_stop(arg);
+            snprintf(response, response_size, result == FW_OK ? "Stopped replay to '%s'\n"
+                     : "No replay to '%s'\n", arg);
+            return result;
+        }
+        LogReplayOptions options;
+        char error[128];
+        if (log_replay_parse(options_text, &options, error, sizeof(error)) != FW_OK) {
+            snprintf(response, response_size, "Error: %s\n", error);
+            return FW_ERROR_PARSE_FAILED;
+        }
+        int result = log_replay_start(arg, &options);
+        if (result == FW_OK) {
+            snprintf(response, response_size, "Replaying logged events to '%s'\n", arg);
+        } else if (result == FW_ERROR_NOT_FOUND) {
+            snprintf(response, response_size, event_log_is_open()
+                     ? "Error: Tool '%s' not found\n"
+                     : "Error: Event log is off ([core] event_log), cannot replay to '%s'\n", arg);
+        } else {
+            snprintf(response, response_size, "Error: Cannot replay to '%s' (%d)\n", arg, result);
+        }
+        return result;
+    }
     else if (strcmp(cmd, "version") == 0) {
         snprintf(response, response_size,
                 "Yuki-Frame version %s\n", control_get_version());
@@ -335,6 +526,14 @@ int control_execute_command(const char* command, char* response, size_t response
                 "  stop <tool>          - Stop a tool\n"
                 "  restart <tool>       - Restart a tool\n"
                 "  status <tool>        - Show detailed tool status\n"
+                "  loops                - Show event loop wait counters\n"
+                "  types                - Show per-event-type counters\n"
+                "  eventlog             - Show event log counters\n"
+                "  requests             - Show request/reply counters\n"
+                "  bus                  - Show event bus memory and paused publishers\n"
+                "  replay <tool> [--from <lsn|time>] [--types A,B] [--rate N]\n"
+                "                       - Send logged events to a tool again\n"
+                "  replay <tool> stop   - Stop a replay; 'replay' lists them\n"
                 "  uptime               - Show framework uptime\n"
                 "  version              - Show framework version\n"
                 "  shutdown             - Shutdown the framework\n"
@@ -1,6 +1,6 @@
 /**
  * @file control_socket.c
- * @brief Control Socket Server Implementation (Windows)
+ * @brief Control Socket Server Implementation (Winsock / BSD sockets)
  * 
  * This is PART OF THE FRAMEWORK CORE!
  * Provides socket interface to Control API functions.
@@ -9,37 +9,112 @@
  * - Runs in separate thread within framework process
  * - Listens on TCP socket (default port 9999)
  * - Accepts connections from console/scripts
- * - Executes Control API commands
+ * - Hands each command to the main loop, which executes it through the
+ *   Control API, and waits for the response
  * - Returns responses to clients
  */
 
 #include "yuki_frame/framework.h"
 #include "yuki_frame/control_socket.h"
 #include "yuki_frame/control_api.h"
+#include "yuki_frame/io_worker.h"
 #include "yuki_frame/logger.h"
+#include <string.h>
+#include <stdio.h>
+
+#ifdef PLATFORM_WINDOWS
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <process.h>
-#include <string.h>
-#include <stdio.h>
 
+#ifdef _MSC_VER
 #pragma comment(lib, "ws2_32.lib")
+#endif
+
+typedef HANDLE SocketThread;
+typedef CRITICAL_SECTION SocketLock;
+typedef CONDITION_VARIABLE SocketCond;
+#define SOCKET_THREAD_RETURN unsigned int __stdcall
+#define socket_last_error() WSAGetLastError()
+#define SOCKET_EINTR WSAEINTR
+#define SOCKET_ETIMEDOUT WSAETIMEDOUT
+#define socket_lock_init(lock) InitializeCriticalSection(lock)
+#define socket_lock_destroy(lock) DeleteCriticalSection(lock)
+#define socket_lock(lock) EnterCriticalSection(lock)
+#define socket_unlock(lock) LeaveCriticalSection(lock)
+#define socket_cond_init(cond) InitializeConditionVariable(cond)
+#define socket_cond_destroy(cond) ((void)(cond))
+#define socket_cond_signal(cond) WakeAllConditionVariable(cond)
+#define socket_cond_wait_ms(cond, lock, ms) SleepConditionVariableCS(cond, lock, ms)
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+
+typedef int SOCKET;
+typedef pthread_t SocketThread;
+typedef pthread_mutex_t SocketLock;
+typedef pthread_cond_t SocketCond;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define closesocket(s) close(s)
+#define SOCKET_THREAD_RETURN void*
+#define socket_last_error() errno
+#define SOCKET_EINTR EINTR
+#define SOCKET_ETIMEDOUT EAGAIN
+#define socket_lock_init(lock) pthread_mutex_init(lock, NULL)
+#define socket_lock_destroy(lock) pthread_mutex_destroy(lock)
+#define socket_lock(lock) pthread_mutex_lock(lock)
+#define socket_unlock(lock) pthread_mutex_unlock(lock)
+#define socket_cond_init(cond) pthread_cond_init(cond, NULL)
+#define socket_cond_destroy(cond) pthread_cond_destroy(cond)
+#define socket_cond_signal(cond) pthread_cond_broadcast(cond)
+
+static void socket_cond_wait_ms(SocketCond* cond, SocketLock* lock, int ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(cond, lock, &deadline);
+}
+#endif
 
 // Socket server state
 static SOCKET g_listen_socket = INVALID_SOCKET;
-static HANDLE g_server_thread = NULL;
+static SOCKET g_client_socket = INVALID_SOCKET;
+static SocketThread g_server_thread;
+static bool g_server_thread_started = false;
 static bool g_socket_running = false;
 static int g_listen_port = 0;
-static CRITICAL_SECTION g_socket_lock;
+static SocketLock g_socket_lock;
+
+// The command the socket thread is waiting on the main loop for; guarded
+// by g_socket_lock
+static SocketCond g_command_cond;
+static bool g_command_waiting = false;
+static bool g_command_done = false;
+static int g_command_result = FW_OK;
+static char* g_command_response = NULL;
+static size_t g_command_response_size = 0;
 
 // Forward declarations
-static unsigned int __stdcall socket_server_thread(void* arg);
+static SOCKET_THREAD_RETURN socket_server_thread(void* arg);
 static void handle_client_connection(SOCKET client_socket);
 
 /**
  * Initialize control socket system
  */
 int control_socket_init(void) {
+#ifdef PLATFORM_WINDOWS
     // Initialize Winsock
     WSADATA wsa_data;
     int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
@@ -47,9 +122,11 @@ int control_socket_init(void) {
         LOG_ERROR("control_socket", "WSAStartup failed: %d", result);
         return FW_ERROR_GENERIC;
     }
+#endif
     
-    // Initialize critical section for thread safety
-    InitializeCriticalSection(&g_socket_lock);
+    // Initialize lock for thread safety
+    socket_lock_init(&g_socket_lock);
+    socket_cond_init(&g_command_cond);
     
     LOG_INFO("control_socket", "Control socket system initialized");
     return FW_OK;
@@ -74,7 +151,7 @@ int control_socket_start(int port) {
     // Create socket
     g_listen_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (g_listen_socket == INVALID_SOCKET) {
-        LOG_ERROR("control_socket", "Failed to create socket: %d", WSAGetLastError());
+        LOG_ERROR("control_socket", "Failed to create socket: %d", socket_last_error());
         return FW_ERROR_GENERIC;
     }
     
@@ -87,10 +164,10 @@ int control_socket_start(int port) {
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // localhost only
-    server_addr.sin_port = htons((u_short)port);
+    server_addr.sin_port = htons((unsigned short)port);
     
     if (bind(g_listen_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) == SOCKET_ERROR) {
-        LOG_ERROR("control_socket", "Failed to bind socket: %d", WSAGetLastError());
+        LOG_ERROR("control_socket", "Failed to bind socket: %d", socket_last_error());
         closesocket(g_listen_socket);
         g_listen_socket = INVALID_SOCKET;
         return FW_ERROR_GENERIC;
@@ -98,7 +175,7 @@ int control_socket_start(int port) {
     
     // Listen
     if (listen(g_listen_socket, SOMAXCONN) == SOCKET_ERROR) {
-        LOG_ERROR("control_socket", "Failed to listen: %d", WSAGetLastError());
+        LOG_ERROR("control_socket", "Failed to listen: %d", socket_last_error());
         closesocket(g_listen_socket);
         g_listen_socket = INVALID_SOCKET;
         return FW_ERROR_GENERIC;
@@ -106,6 +183,7 @@ int control_socket_start(int port) {
     
     // Start server thread
     g_socket_running = true;
+#ifdef PLATFORM_WINDOWS
     g_server_thread = (HANDLE)_beginthreadex(
         NULL,                   // Security
         0,                      // Stack size
@@ -114,8 +192,12 @@ int control_socket_start(int port) {
         0,                      // Flags
         NULL                    // Thread ID
     );
+    g_server_thread_started = (g_server_thread != NULL);
+#else
+    g_server_thread_started = (pthread_create(&g_server_thread, NULL, socket_server_thread, NULL) == 0);
+#endif
     
-    if (g_server_thread == NULL) {
+    if (!g_server_thread_started) {
         LOG_ERROR("control_socket", "Failed to create server thread");
         g_socket_running = false;
         closesocket(g_listen_socket);
@@ -142,17 +224,39 @@ void control_socket_stop(void) {
     // Signal thread to stop
     g_socket_running = false;
     
-    // Close listening socket (this will unblock accept())
+    // Close listening socket (this will unblock accept()). On POSIX,
+    // close() alone does not wake a blocked accept()/recv(), shutdown() does.
     if (g_listen_socket != INVALID_SOCKET) {
+#ifndef PLATFORM_WINDOWS
+        shutdown(g_listen_socket, SHUT_RDWR);
+#endif
         closesocket(g_listen_socket);
         g_listen_socket = INVALID_SOCKET;
     }
     
+    // Kick a connected client out of its blocking recv(), or out of
+    // waiting for the main loop, which is the caller here
+    socket_lock(&g_socket_lock);
+    socket_cond_signal(&g_command_cond);
+    if (g_client_socket != INVALID_SOCKET) {
+#ifdef PLATFORM_WINDOWS
+        shutdown(g_client_socket, SD_BOTH);
+#else
+        shutdown(g_client_socket, SHUT_RDWR);
+#endif
+    }
+    socket_unlock(&g_socket_lock);
+    
     // Wait for thread to finish (with timeout)
-    if (g_server_thread != NULL) {
+    if (g_server_thread_started) {
+#ifdef PLATFORM_WINDOWS
         WaitForSingleObject(g_server_thread, 2000);
         CloseHandle(g_server_thread);
         g_server_thread = NULL;
+#else
+        pthread_join(g_server_thread, NULL);
+#endif
+        g_server_thread_started = false;
     }
     
     LOG_INFO("control_socket", "Control socket server stopped");
@@ -164,11 +268,14 @@ void control_socket_stop(void) {
 void control_socket_shutdown(void) {
     control_socket_stop();
     
+#ifdef PLATFORM_WINDOWS
     // Cleanup Winsock
     WSACleanup();
+#endif
     
-    // Cleanup critical section
-    DeleteCriticalSection(&g_socket_lock);
+    // Cleanup lock
+    socket_cond_destroy(&g_command_cond);
+    socket_lock_destroy(&g_socket_lock);
     
     LOG_INFO("control_socket", "Control socket system shutdown");
 }
@@ -193,7 +300,7 @@ int control_socket_get_port(void) {
  * This runs in the framework process, in a separate thread.
  * It continuously accepts connections and handles them.
  */
-static unsigned int __stdcall socket_server_thread(void* arg) {
+static SOCKET_THREAD_RETURN socket_server_thread(void* arg) {
     (void)arg;  // Unused
     
     LOG_INFO("control_socket", "Socket server thread started");
@@ -201,7 +308,7 @@ static unsigned int __stdcall socket_server_thread(void* arg) {
     while (g_socket_running) {
         // Accept connection
         struct sockaddr_in client_addr;
-        int client_addr_len = sizeof(client_addr);
+        socklen_t client_addr_len = sizeof(client_addr);
         
         SOCKET client_socket = accept(
             g_listen_socket,
@@ -212,8 +319,8 @@ static unsigned int __stdcall socket_server_thread(void* arg) {
         if (client_socket == INVALID_SOCKET) {
             if (g_socket_running) {
                 // Only log error if we're still supposed to be running
-                int error = WSAGetLastError();
-                if (error != WSAEINTR) {
+                int error = socket_last_error();
+                if (error != SOCKET_EINTR) {
                     LOG_ERROR("control_socket", "Accept failed: %d", error);
                 }
             }
@@ -228,9 +335,16 @@ static unsigned int __stdcall socket_server_thread(void* arg) {
         
         // Handle client in same thread (simple approach)
         // For production, consider thread pool or async I/O
+        socket_lock(&g_socket_lock);
+        g_client_socket = client_socket;
+        socket_unlock(&g_socket_lock);
+        
         handle_client_connection(client_socket);
         
         // Close client socket
+        socket_lock(&g_socket_lock);
+        g_client_socket = INVALID_SOCKET;
+        socket_unlock(&g_socket_lock);
         closesocket(client_socket);
         
         LOG_INFO("control_socket", "Client disconnected");
@@ -240,6 +354,47 @@ static unsigned int __stdcall socket_server_thread(void* arg) {
     return 0;
 }
 
+/**
+ * Run a command on the main thread
+ * 
+ * Tool lifecycle and the timers behind it belong to the main thread, so
+ * the command is posted to its control loop and this thread waits for the
+ * response. Gives up when the server is stopped meanwhile.
+ */
+static int execute_on_main_thread(const char* command, char* response, size_t response_size) {
+    socket_lock(&g_socket_lock);
+    g_command_waiting = true;
+    g_command_done = false;
+    g_command_response = response;
+    g_command_response_size = response_size;
+    socket_unlock(&g_socket_lock);
+    
+    int result = io_worker_post_control(WORK_SOCKET_COMMAND, NULL, NULL, NULL, command);
+    
+    socket_lock(&g_socket_lock);
+    while (result == FW_OK && !g_command_done && g_socket_running) {
+        socket_cond_wait_ms(&g_command_cond, &g_socket_lock, 100);
+    }
+    if (result == FW_OK) {
+        result = g_command_done ? g_command_result : FW_ERROR_GENERIC;
+    }
+    g_command_waiting = false;
+    g_command_response = NULL;
+    socket_unlock(&g_socket_lock);
+    return result;
+}
+
+void control_socket_run_command(const char* command) {
+    socket_lock(&g_socket_lock);
+    if (g_command_waiting && !g_command_done) {
+        g_command_result = control_execute_command(command, g_command_response,
+                                                   g_command_response_size);
+        g_command_done = true;
+        socket_cond_signal(&g_command_cond);
+    }
+    socket_unlock(&g_socket_lock);
+}
+
 /**
  * Handle client connection
  * 
@@ -251,7 +406,11 @@ static void handle_client_connection(SOCKET client_socket) {
     int bytes_received;
     
     // Set receive timeout (30 seconds of inactivity)
+#ifdef PLATFORM_WINDOWS
     int timeout = 30000;
+#else
+    struct timeval timeout = { .tv_sec = 30, .tv_usec = 0 };
+#endif
     setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
     
     // Keep connection alive and handle multiple commands
@@ -263,8 +422,8 @@ static void handle_client_connection(SOCKET client_socket) {
             if (bytes_received == 0) {
                 LOG_DEBUG("control_socket", "Client closed connection gracefully");
             } else {
-                int error = WSAGetLastError();
-                if (error == WSAETIMEDOUT) {
+                int error = socket_last_error();
+                if (error == SOCKET_ETIMEDOUT) {
                     LOG_DEBUG("control_socket", "Client timeout");
                 } else {
                     LOG_ERROR("control_socket", "Receive failed: %d", error);
@@ -289,9 +448,7 @@ static void handle_client_connection(SOCKET client_socket) {
         LOG_DEBUG("control_socket", "Received command: %s", buffer);
         
         // Execute command using Control API (FRAMEWORK FUNCTION!)
-        EnterCriticalSection(&g_socket_lock);
-        int result = control_execute_command(buffer, response, sizeof(response));
-        LeaveCriticalSection(&g_socket_lock);
+        int result = execute_on_main_thread(buffer, response, sizeof(response));
         
         if (result != FW_OK) {
             snprintf(response, sizeof(response), "Error: Command execution failed\n");
@@ -301,7 +458,7 @@ static void handle_client_connection(SOCKET client_socket) {
         int bytes_sent = send(client_socket, response, (int)strlen(response), 0);
         
         if (bytes_sent == SOCKET_ERROR) {
-            LOG_ERROR("control_socket", "Send failed: %d", WSAGetLastError());
+            LOG_ERROR("control_socket", "Send failed: %d", socket_last_error());
             break;  // Connection broken
         } else {
             LOG_DEBUG("control_socket", "Sent %d bytes response", bytes_sent);
@@ -0,0 +1,166 @@
+/**
+ * @file dedup.c
+ * @brief Bounded window of recent message ids
+ *
+ * The ids live in a ring in arrival order, so the oldest is the one the
+ * next id overwrites, and an open-addressed table with twice as many
+ * slots finds them by hash. Evicting removes the old id from the table
+ * with a backward shift, so lookups never wade through tombstones. A
+ * window belongs to one publisher and is only used by its I/O shard.
+ */
+
+#include "yuki_frame/dedup.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t hash;
+    char id[DEDUP_MAX_ID];
+} DedupEntry;
+
+struct DedupWindow {
+    DedupEntry* ring;
+    int capacity;
+    int count;
+    int next;                   // Ring slot the next id goes to
+    int* slots;                 // Ring index + 1, 0 = empty
+    uint32_t mask;
+};
+
+static uint32_t id_hash(const char* id, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)id[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+DedupWindow* dedup_create(int capacity) {
+    if (capacity <= 0) {
+        return NULL;
+    }
+    uint32_t slot_count = 2;
+    while (slot_count < (uint32_t)capacity * 2) {
+        slot_count <<= 1;
+    }
+
+    DedupWindow* window = (DedupWindow*)calloc(1, sizeof(DedupWindow));
+    if (!window) {
+        return NULL;
+    }
+    window->ring = (DedupEntry*)calloc((size_t)capacity, sizeof(DedupEntry));
+    window->slots = (int*)calloc(slot_count, sizeof(int));
+    if (!window->ring || !window->slots) {
+        dedup_destroy(window);
+        return NULL;
+    }
+    window->capacity = capacity;
+    window->mask = slot_count - 1;
+    return window;
+}
+
+void dedup_destroy(DedupWindow* window) {
+    if (window) {
+        free(window->ring);
+        free(window->slots);
+        free(window);
+    }
+}
+
+// Take ring entry index out of the table, moving later entries of its
+// probe run back so none is left behind an empty slot
+static void remove_entry(DedupWindow* window, int index) {
+    uint32_t slot = window->ring[index].hash & window->mask;
+    while (window->slots[slot] != index + 1) {
+        slot = (slot + 1) & window->mask;
+    }
+    window->slots[slot] = 0;
+
+    uint32_t hole = slot;
+    for (slot = (slot + 1) & window->mask; window->slots[slot]; slot = (slot + 1) & window->mask) {
+        uint32_t home = window->ring[window->slots[slot] - 1].hash & window->mask;
+        // Move it unless its home lies after the hole, up to its slot
+        bool stays = hole <= slot ? (home > hole && home <= slot)
+                                  : (home > hole || home <= slot);
+        if (!stays) {
+            window->slots[hole] = window->slots[slot];
+            window->slots[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
+// Probe for id; when it is absent, *empty is the slot that ends its run
+static bool find_id(const DedupWindow* window, const char* id, size_t length, uint32_t hash,
+                    uint32_t* empty) {
+    uint32_t slot = hash & window->mask;
+    for (; window->slots[slot]; slot = (slot + 1) & window->mask) {
+        const DedupEntry* entry = &window->ring[window->slots[slot] - 1];
+        if (entry->hash == hash && strncmp(entry->id, id, length) == 0 &&
+            entry->id[length] == '\0') {
+            return true;
+        }
+    }
+    *empty = slot;
+    return false;
+}
+
+// Add an id find_id() did not find, the oldest making room for it
+static void add_id(DedupWindow* window, const char* id, size_t length, uint32_t hash,
+                   uint32_t slot) {
+    int index = window->next;
+    if (window->count == window->capacity) {
+        remove_entry(window, index);
+        // The shift may have moved the run this id probes through
+        slot = hash & window->mask;
+        while (window->slots[slot]) {
+            slot = (slot + 1) & window->mask;
+        }
+    } else {
+        window->count++;
+    }
+    DedupEntry* entry = &window->ring[index];
+    entry->hash = hash;
+    memcpy(entry->id, id, length);
+    entry->id[length] = '\0';
+    window->slots[slot] = index + 1;
+    window->next = (index + 1) % window->capacity;
+}
+
+bool dedup_seen(DedupWindow* window, const char* id, size_t length) {
+    if (length >= DEDUP_MAX_ID) {
+        length = DEDUP_MAX_ID - 1;
+    }
+    uint32_t hash = id_hash(id, length);
+    uint32_t slot;
+    if (find_id(window, id, length, hash, &slot)) {
+        return true;
+    }
+    add_id(window, id, length, hash, slot);
+    return false;
+}
+
+bool dedup_contains(const DedupWindow* window, const char* id, size_t length) {
+    if (length >= DEDUP_MAX_ID) {
+        length = DEDUP_MAX_ID - 1;
+    }
+    uint32_t slot;
+    return find_id(window, id, length, id_hash(id, length), &slot);
+}
+
+void dedup_remember(DedupWindow* window, const char* id, size_t length) {
+    if (length >= DEDUP_MAX_ID) {
+        length = DEDUP_MAX_ID - 1;
+    }
+    uint32_t hash = id_hash(id, length);
+    uint32_t slot;
+    if (!find_id(window, id, length, hash, &slot)) {
+        add_id(window, id, length, hash, slot);
+    }
+}
+
+int dedup_count(const DedupWindow* window) {
+    return window ? window->count : 0;
+}
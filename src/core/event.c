@@ -1,69 +1,403 @@
 #include "yuki_frame/framework.h"
 #include "yuki_frame/event.h"
+#include "yuki_frame/event_buffer.h"
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/event_filter.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/flow_control.h"
 #include "yuki_frame/tool.h"
 #include "yuki_frame/tool_queue.h"
 #include "yuki_frame/logger.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/platform.h"
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
+// A queued event: type, sender and data NUL-terminated back to back
+typedef struct BusEvent {
+    struct BusPool* pool;       // Pool of the thread that published it
+    uint32_t size;              // Bytes taken from the pool
+    EventTypeId type_id;        // EVENT_TYPE_NONE if not interned
+    EventPriority priority;     // Lane it was queued in
+    uint64_t lsn;               // Event log sequence number, 0 if not logged
+    uint64_t seq;               // Publisher's sequence number, 0 if none
+    uint32_t sender_offset;     // Offsets into text
+    uint32_t data_offset;
+    struct BusEvent* next;      // On an overflow list
+    char text[];
+} BusEvent;
+
+// A publishing thread's allocator. Pools live until event_bus_shutdown(),
+// since the router may still be returning records after a thread exits.
+typedef struct BusPool {
+    SlabPool slab;
+    struct BusPool* next;
+} BusPool;
+
 static MessageBus bus;
+static int ring_capacity = MAX_EVENTS_QUEUE;
+static atomic_int bus_queued;
+static atomic_int overflow_peak;
+static atomic_uint_fast64_t overflow_total;
+
+static THREAD_LOCAL BusPool* local_pool;
+static THREAD_LOCAL unsigned int local_generation;
+
+static void routes_free_all(void);
+static int route_event(EventTypeId id, EventPriority priority, uint64_t lsn, uint64_t seq,
+                       bool replay, const char* type, const char* sender, const char* data);
 
 int event_bus_init(void) {
     memset(&bus, 0, sizeof(bus));
-    bus.head = 0;
-    bus.tail = 0;
-    bus.count = 0;
+    ring_capacity = g_config.message_queue_size > 0 ? g_config.message_queue_size
+                                                     : MAX_EVENTS_QUEUE;
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        atomic_init(&bus.overflow_count[lane], 0);
+        bus.rings[lane] = ring_create((size_t)ring_capacity);
+        if (!bus.rings[lane]) {
+            while (lane-- > 0) {
+                ring_destroy(bus.rings[lane]);
+                bus.rings[lane] = NULL;
+            }
+            return FW_ERROR_MEMORY;
+        }
+    }
+    atomic_init(&bus.signalled, false);
+    atomic_store(&bus_queued, 0);
+    atomic_store(&overflow_peak, 0);
+    atomic_store(&overflow_total, 0);
+    platform_mutex_init(&bus.overflow_lock);
+    static atomic_uint generations = 0;
+    atomic_init(&bus.generation, atomic_fetch_add(&generations, 1) + 1);
+    platform_mutex_init(&bus.pools_lock);
     LOG_INFO("event", "Event bus initialized");
     return FW_OK;
 }
 
+static void bus_event_free(BusEvent* event) {
+    flow_release(NULL, event->size);
+    if (event->pool == local_pool) {
+        slab_free(&event->pool->slab, event, event->size);
+    } else {
+        slab_free_remote(&event->pool->slab, event, event->size);
+    }
+}
+
 void event_bus_shutdown(void) {
-    // Free any events in queue
-    for (int i = 0; i < bus.count; i++) {
-        int index = (bus.head + i) % MAX_EVENTS_QUEUE;
-        if (bus.queue[index]) {
-            free(bus.queue[index]);
-            bus.queue[index] = NULL;
+    if (!bus.rings[EVENT_PRIORITY_NORMAL]) {
+        routes_free_all();
+        return;
+    }
+    
+    // Publishers have stopped: free any events in queue, then every pool
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        BusEvent* event;
+        while ((event = (BusEvent*)ring_pop(bus.rings[lane])) != NULL) {
+            bus_event_free(event);
         }
+        while ((event = bus.overflow_head[lane]) != NULL) {
+            bus.overflow_head[lane] = event->next;
+            bus_event_free(event);
+        }
+        ring_destroy(bus.rings[lane]);
+        bus.rings[lane] = NULL;
     }
-    bus.count = 0;
+    platform_mutex_destroy(&bus.overflow_lock);
+    
+    BusPool* pool = bus.pools;
+    while (pool) {
+        BusPool* next = pool->next;
+        slab_pool_destroy(&pool->slab);
+        free(pool);
+        pool = next;
+    }
+    bus.pools = NULL;
+    local_pool = NULL;
+    platform_mutex_destroy(&bus.pools_lock);
+    
+    routes_free_all();
     LOG_INFO("event", "Event bus shutdown");
 }
 
+// This thread's pool for the current bus, created on its first publish
+static BusPool* publisher_pool(void) {
+    unsigned int generation = atomic_load_explicit(&bus.generation, memory_order_relaxed);
+    if (local_pool && local_generation == generation) {
+        return local_pool;
+    }
+    
+    BusPool* pool = (BusPool*)malloc(sizeof(BusPool));
+    if (!pool) {
+        return NULL;
+    }
+    slab_pool_init(&pool->slab);
+    platform_mutex_lock(&bus.pools_lock);
+    pool->next = bus.pools;
+    bus.pools = pool;
+    platform_mutex_unlock(&bus.pools_lock);
+    
+    local_pool = pool;
+    local_generation = generation;
+    return pool;
+}
+
+// NULL with *result FW_ERROR_QUEUE_FULL when the event does not fit the
+// memory budget
+static BusEvent* bus_event_create(BusPool* pool, EventTypeId type_id, EventPriority priority,
+                                  uint64_t lsn, uint64_t seq, const char* type,
+                                  const char* sender, const char* data, int* result) {
+    // Type and sender keep their old limits; data is stored at its length
+    size_t type_len = strnlen(type, MAX_EVENT_TYPE - 1);
+    size_t sender_len = strnlen(sender, MAX_TOOL_NAME - 1);
+    size_t data_len = data ? strlen(data) : 0;
+    size_t size = sizeof(BusEvent) + type_len + sender_len + data_len + 3;
+    *result = FW_ERROR_MEMORY;
+    if (size > UINT32_MAX) {
+        return NULL;
+    }
+    if (!flow_reserve(size)) {
+        *result = FW_ERROR_QUEUE_FULL;
+        return NULL;
+    }
+    
+    BusEvent* event = (BusEvent*)slab_alloc(&pool->slab, size);
+    if (!event) {
+        flow_release(NULL, size);
+        return NULL;
+    }
+    
+    event->pool = pool;
+    event->next = NULL;
+    event->size = (uint32_t)size;
+    event->type_id = type_id;
+    event->priority = priority;
+    event->lsn = lsn;
+    event->seq = seq;
+    event->sender_offset = (uint32_t)(type_len + 1);
+    event->data_offset = (uint32_t)(type_len + sender_len + 2);
+    memcpy(event->text, type, type_len);
+    event->text[type_len] = '\0';
+    memcpy(event->text + event->sender_offset, sender, sender_len);
+    event->text[event->sender_offset + sender_len] = '\0';
+    if (data_len > 0) {
+        memcpy(event->text + event->data_offset, data, data_len);
+    }
+    event->text[event->data_offset + data_len] = '\0';
+    return event;
+}
+
+// Queue events on a lane in order: on its ring while that has room and no
+// overflow is waiting, otherwise at the end of the lane's overflow list
+static void bus_push(EventPriority lane, BusEvent** events, int count) {
+    atomic_fetch_add_explicit(&bus_queued, count, memory_order_relaxed);
+    if (atomic_load_explicit(&bus.overflow_count[lane], memory_order_acquire) == 0 &&
+        (count == 1 ? ring_push(bus.rings[lane], events[0])
+                    : ring_push_batch(bus.rings[lane], (void* const*)events, (size_t)count))) {
+        return;
+    }
+    
+    platform_mutex_lock(&bus.overflow_lock);
+    for (int i = 0; i < count; i++) {
+        events[i]->next = NULL;
+        if (bus.overflow_tail[lane]) {
+            bus.overflow_tail[lane]->next = events[i];
+        } else {
+            bus.overflow_head[lane] = events[i];
+        }
+        bus.overflow_tail[lane] = events[i];
+    }
+    int overflowed = atomic_fetch_add_explicit(&bus.overflow_count[lane], count,
+                                               memory_order_release) + count;
+    platform_mutex_unlock(&bus.overflow_lock);
+    
+    atomic_fetch_add_explicit(&overflow_total, (uint_fast64_t)count, memory_order_relaxed);
+    int peak = atomic_load_explicit(&overflow_peak, memory_order_relaxed);
+    while (overflowed > peak &&
+           !atomic_compare_exchange_weak_explicit(&overflow_peak, &peak, overflowed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Wake the main thread unless a wakeup is already on its way
+static void signal_router(void) {
+    if (!atomic_exchange_explicit(&bus.signalled, true, memory_order_acq_rel)) {
+        event_loop_wakeup(event_loop_control());
+    }
+}
+
+// ID the router keys type by. Types nobody subscribed to exactly are only
+// interned for their counters and priority, and only up to a limit.
+static EventTypeId route_type_id(const char* type) {
+    EventTypeId id = event_type_find(type);
+    if (id == EVENT_TYPE_NONE && event_type_count() < EVENT_TYPE_MAX_UNSUBSCRIBED) {
+        id = event_type_intern(type);
+    }
+    return id;
+}
+
+// The type's configured priority, raised to priority if that is higher
+static EventPriority effective_priority(EventTypeId id, EventPriority priority) {
+    EventPriority configured = event_type_priority(id);
+    if (priority < 0 || priority >= EVENT_PRIORITY_COUNT) {
+        priority = EVENT_PRIORITY_NORMAL;
+    }
+    return configured > priority ? configured : priority;
+}
+
 int event_publish(const char* type, const char* sender, const char* data) {
+    return event_publish_priority(type, sender, data, EVENT_PRIORITY_LOW);
+}
+
+int event_publish_priority(const char* type, const char* sender, const char* data,
+                           EventPriority priority) {
+    return event_publish_sequenced(type, sender, data, priority, 0);
+}
+
+int event_publish_sequenced(const char* type, const char* sender, const char* data,
+                            EventPriority priority, uint64_t seq) {
     if (!type || !sender) {
         return FW_ERROR_INVALID_ARG;
     }
+    EventTypeId id = route_type_id(type);
+    priority = effective_priority(id, priority);
+    uint64_t lsn = event_log_append(priority, type, sender, data);
     
-    if (bus.count >= MAX_EVENTS_QUEUE) {
-        LOG_ERROR("event", "Event queue full");
-        return FW_ERROR_QUEUE_FULL;
+    // On an I/O shard (reading a tool's stdout) route straight away; the
+    // subscribers' shards pick the event up from their rings
+    if (event_loop_current_shard() >= 0) {
+        LOG_DEBUG("event", "Published event: %s from %s", type, sender);
+        int routed = route_event(id, priority, lsn, seq, false, type, sender, data ? data : "");
+        return routed < 0 ? routed : FW_OK;
     }
     
-    Event* event = (Event*)malloc(sizeof(Event));
+    if (!bus.rings[priority]) {
+        event_log_release(lsn);
+        return FW_ERROR_GENERIC;  // Bus not initialized
+    }
+    BusPool* pool = publisher_pool();
+    int result = FW_ERROR_MEMORY;
+    BusEvent* event = pool ? bus_event_create(pool, id, priority, lsn, seq, type, sender, data,
+                                              &result) : NULL;
     if (!event) {
-        return FW_ERROR_MEMORY;
+        if (result == FW_ERROR_QUEUE_FULL) {
+            LOG_ERROR("event", "Event bus over its memory budget, dropped %s", type);
+        }
+        event_log_release(lsn);  // Never routed
+        return result;
     }
+    bus_push(priority, &event, 1);
     
-    memset(event, 0, sizeof(Event));
-    strncpy(event->type, type, MAX_EVENT_TYPE - 1);
-    strncpy(event->sender, sender, MAX_TOOL_NAME - 1);
-    if (data) {
-        strncpy(event->data, data, MAX_EVENT_DATA - 1);
-    }
-    event->timestamp = time(NULL);
+    LOG_DEBUG("event", "Published event: %s from %s", type, sender);
     
-    bus.queue[bus.tail] = event;
-    bus.tail = (bus.tail + 1) % MAX_EVENTS_QUEUE;
-    bus.count++;
+    // The main thread drains the bus
+    signal_router();
     
-    LOG_DEBUG("event", "Published event: %s from %s", type, sender);
+    return FW_OK;
+}
+
+// Queue up to MAX_EVENTS_QUEUE events with one ring claim, or none of them
+static int publish_chunk(BusPool* pool, const EventView* events, int count) {
+    // One claim keeps the batch in order, so it all waits in one lane
+    EventTypeId ids[MAX_EVENTS_QUEUE];
+    EventPriority lane = EVENT_PRIORITY_LOW;
+    for (int i = 0; i < count; i++) {
+        ids[i] = route_type_id(events[i].type);
+        EventPriority priority = event_type_priority(ids[i]);
+        if (priority > lane) {
+            lane = priority;
+        }
+    }
     
+    BusEvent* batch[MAX_EVENTS_QUEUE];
+    int result = FW_OK;
+    int created = 0;
+    for (; created < count; created++) {
+        EventPriority priority = event_type_priority(ids[created]);
+        uint64_t lsn = event_log_append(priority, events[created].type, events[created].sender,
+                                        events[created].data);
+        batch[created] = bus_event_create(pool, ids[created], priority, lsn, 0,
+                                          events[created].type, events[created].sender,
+                                          events[created].data, &result);
+        if (!batch[created]) {
+            event_log_release(lsn);
+            break;
+        }
+    }
+    
+    if (created < count) {
+        if (result == FW_ERROR_QUEUE_FULL) {
+            LOG_ERROR("event", "Event bus over its memory budget, dropped batch of %d", count);
+        }
+        for (int i = 0; i < created; i++) {
+            event_log_release(batch[i]->lsn);
+            bus_event_free(batch[i]);
+        }
+        return result;
+    }
+    bus_push(lane, batch, count);
     return FW_OK;
 }
 
+int event_publish_batch(const EventView* events, int count) {
+    if (!events || count < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!events[i].type || !events[i].sender) {
+            return FW_ERROR_INVALID_ARG;
+        }
+    }
+    if (count == 0) {
+        return FW_OK;
+    }
+    
+    if (event_loop_current_shard() >= 0) {
+        // Logged and routed one by one, as event_publish() would
+        int first_error = FW_OK;
+        for (int i = 0; i < count; i++) {
+            int result = event_publish_sequenced(events[i].type, events[i].sender,
+                                                 events[i].data, EVENT_PRIORITY_LOW, 0);
+            if (result != FW_OK && first_error == FW_OK) {
+                first_error = result;
+            }
+        }
+        return first_error;
+    }
+    
+    if (!bus.rings[EVENT_PRIORITY_NORMAL]) {
+        return FW_ERROR_GENERIC;
+    }
+    BusPool* pool = publisher_pool();
+    if (!pool) {
+        return FW_ERROR_MEMORY;
+    }
+    
+    int published = 0;
+    int result = FW_OK;
+    while (published < count && result == FW_OK) {
+        int chunk = count - published;
+        if (chunk > MAX_EVENTS_QUEUE) {
+            chunk = MAX_EVENTS_QUEUE;
+        }
+        result = publish_chunk(pool, events + published, chunk);
+        if (result == FW_OK) {
+            published += chunk;
+        }
+    }
+    
+    if (published > 0) {
+        LOG_DEBUG("event", "Published batch of %d events", published);
+        signal_router();
+    }
+    return result;
+}
+
 int event_parse(const char* line, Event* event) {
     if (!line || !event) {
         return FW_ERROR_INVALID_ARG;
@@ -104,89 +438,715 @@ int event_format(const Event* event, char* buffer, size_t size) {
     return FW_OK;
 }
 
-void event_process_queue(void) {
-    // Route events to subscribed tools
-    while (bus.count > 0) {
-        Event* event = bus.queue[bus.head];
-        if (event) {
-            LOG_DEBUG("event", "Processing event: %s from %s", 
-                     event->type, event->sender);
-            
-            // Deliver event to all subscribed tools
-            Tool* tool = tool_get_first();
-            int delivery_count = 0;
-            
-            while (tool != NULL) {
-                // Check if tool is subscribed to this event type
-                bool is_subscribed = false;
-                
-                // Check for wildcard subscription (*)
-                for (int i = 0; i < tool->subscription_count; i++) {
-                    // Trim leading/trailing quotes and whitespace from subscription
-                    char sub[256];
-                    strncpy(sub, tool->subscriptions[i], sizeof(sub) - 1);
-                    sub[sizeof(sub) - 1] = '\0';
-                    
-                    // Remove leading quote/whitespace
-                    char* s = sub;
-                    while (*s == '\'' || *s == '"' || *s == ' ') s++;
-                    
-                    // Remove trailing quote/whitespace
-                    char* end = s + strlen(s) - 1;
-                    while (end > s && (*end == '\'' || *end == '"' || *end == ' ' || *end == '\n' || *end == '\r')) {
-                        *end = '\0';
-                        end--;
-                    }
-                    
-                    if (strcmp(s, "*") == 0) {
-                        is_subscribed = true;
-                        break;
-                    }
-                    if (strcmp(s, event->type) == 0) {
-                        is_subscribed = true;
-                        break;
-                    }
+// Next queued event, most urgent lane first. A lane's overflow list only
+// holds events queued after everything on its ring.
+static BusEvent* bus_pop(void) {
+    for (int lane = EVENT_PRIORITY_COUNT - 1; lane >= 0; lane--) {
+        BusEvent* event = (BusEvent*)ring_pop(bus.rings[lane]);
+        if (!event && atomic_load_explicit(&bus.overflow_count[lane], memory_order_acquire) > 0) {
+            platform_mutex_lock(&bus.overflow_lock);
+            event = bus.overflow_head[lane];
+            if (event) {
+                bus.overflow_head[lane] = event->next;
+                if (!bus.overflow_head[lane]) {
+                    bus.overflow_tail[lane] = NULL;
                 }
-                
-                if (is_subscribed) {
-                    // Format event message: TYPE|sender|data
-                    char event_msg[8192];
-                    snprintf(event_msg, sizeof(event_msg), "%s|%s|%s\n",
-                             event->type, event->sender, event->data);
-                    
-                    // Add event to tool's inbox queue
-                    int result = tool_queue_add(tool->inbox, event_msg);
-                    
-                    if (result == FW_OK) {
-                        delivery_count++;
-                        LOG_DEBUG("event", "Queued %s for tool: %s (queue: %d/%d)", 
-                                 event->type, tool->name,
-                                 tool_queue_count(tool->inbox),
-                                 tool_queue_capacity(tool->inbox));
-                        
-                        // On-demand tool support
-                        if (tool->is_on_demand && tool->status == TOOL_STOPPED && !tool->is_starting) {
-                            LOG_INFO("event", "Starting on-demand tool: %s (triggered by %s)", 
-                                    tool->name, event->type);
-                            tool_start(tool->name);
-                            tool->is_starting = true;
-                        }
-                    } else {
-                        LOG_ERROR("event", "Failed to queue event for %s: %d", tool->name, result);
-                    }
+                atomic_fetch_sub_explicit(&bus.overflow_count[lane], 1, memory_order_release);
+            }
+            platform_mutex_unlock(&bus.overflow_lock);
+        }
+        if (event) {
+            atomic_fetch_sub_explicit(&bus_queued, 1, memory_order_relaxed);
+            return event;
+        }
+    }
+    return NULL;
+}
+
+void event_bus_get_stats(EventBusStats* stats) {
+    memset(stats, 0, sizeof(EventBusStats));
+    stats->ring_capacity = ring_capacity;
+    stats->queued = atomic_load(&bus_queued);
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        stats->overflowed += atomic_load(&bus.overflow_count[lane]);
+    }
+    stats->overflow_peak = atomic_load(&overflow_peak);
+    stats->overflow_total = atomic_load(&overflow_total);
+}
+
+void event_process_queue(void) {
+    if (!bus.rings[EVENT_PRIORITY_NORMAL]) {
+        return;
+    }
+    
+    // Later publishers wake us again; what they queued before this is
+    // visible to the pops below
+    atomic_exchange_explicit(&bus.signalled, false, memory_order_acq_rel);
+    
+    // Route events to subscribed tools. An urgent event published while
+    // a backlog drains is taken before the rest of it.
+    BusEvent* event;
+    while ((event = bus_pop()) != NULL) {
+        const char* type = event->text;
+        const char* sender = event->text + event->sender_offset;
+        LOG_DEBUG("event", "Processing event: %s from %s", type, sender);
+        route_event(event->type_id, event->priority, event->lsn, event->seq, false, type, sender,
+                    event->text + event->data_offset);
+        bus_event_free(event);
+    }
+}
+
+// ============================================================================
+// Routing snapshot
+//
+// Routers on every I/O shard read the subscription table without locks.
+// Changes build a new table and swap it in; the old one is freed by the
+// main thread once every shard has left the pass that might still be
+// reading it (quiescent-state reclamation).
+//
+// The table maps each exact event type, by its interned ID, to a dense
+// list of its subscribers.
+// Patterns with "*" (one segment) or a trailing "#" (any suffix) are
+// compiled into a trie of dotted segments, so matching a type costs one
+// lookup per segment rather than one comparison per pattern. Tools
+// subscribed to everything ("*" or "#") are kept on their own list.
+//
+// A subscription with a content filter carries a reference to the compiled
+// filter, which is run over the event's data when the subscription matches;
+// the tool is only added if it passes. A filtered "*" or "#" goes into the
+// trie as "#", since the wildcard list is never filtered.
+// ============================================================================
+
+#define TRIE_ROOT 0
+#define TRIE_NONE (-1)
+
+// Subscribers of one exact event type: subscribers[first .. first + count)
+typedef struct {
+    int first;
+    int count;
+} RouteSpan;
+
+// Trie node: the pattern prefix up to here
+typedef struct {
+    int star;                   // Child for a "*" segment
+    int hash;                   // Child for a final "#" segment
+    int subs;                   // Patterns ending here: head of a sub_links list
+} TrieNode;
+
+// Literal segment edge, in a hash table keyed by (parent, segment)
+typedef struct {
+    uint32_t hash;
+    int parent;                 // TRIE_NONE when empty
+    int child;
+    char segment[MAX_EVENT_TYPE];
+} TrieEdge;
+
+typedef struct {
+    int tool;                   // Index in RouteTable.tools
+    EventFilter* filter;        // NULL for none
+    int next;
+} TrieSub;
+
+typedef struct RouteTable {
+    Tool** tools;               // Tools with subscriptions; routes use indexes
+    int tool_count;
+    RouteSpan* by_type;         // Indexed by EventTypeId
+    uint32_t type_limit;        // Highest subscribed exact ID + 1
+    int* subscribers;           // Grouped by event type
+    int subscriber_total;
+    EventFilter** filters;      // Filter of each subscribers[] entry, or NULL
+    int filter_count;           // Filtered subscriptions in the table
+    int* wildcards;             // Tools subscribed to everything
+    int wildcard_count;
+    TrieNode* nodes;            // nodes[TRIE_ROOT] always exists
+    int node_count;
+    TrieEdge* edges;
+    uint32_t edge_mask;
+    TrieSub* sub_links;
+    int sub_link_count;
+    uint64_t retired_epoch;
+    struct RouteTable* next_retired;
+} RouteTable;
+
+// Tools an event was matched to, each once
+typedef struct {
+    uint64_t seen[(MAX_TOOLS + 63) / 64];
+    int tools[MAX_TOOLS];
+    int count;
+    const char* data;           // For filters
+    size_t data_len;
+} RouteMatch;
+
+static _Atomic(RouteTable*) routes = NULL;
+static atomic_uint_fast64_t route_epoch = 0;
+static atomic_uint_fast64_t shard_epoch[MAX_IO_THREADS];  // 0 = not routing, else epoch + 1
+static atomic_flag routes_building = ATOMIC_FLAG_INIT;
+static RouteTable* retired = NULL;
+
+static void route_table_free(RouteTable* table) {
+    if (table) {
+        free(table->tools);
+        free(table->by_type);
+        for (int i = 0; table->filters && i < table->subscriber_total; i++) {
+            event_filter_release(table->filters[i]);
+        }
+        for (int i = 0; i < table->sub_link_count; i++) {
+            event_filter_release(table->sub_links[i].filter);
+        }
+        free(table->subscribers);
+        free(table->filters);
+        free(table->wildcards);
+        free(table->nodes);
+        free(table->edges);
+        free(table->sub_links);
+        free(table);
+    }
+}
+
+// FNV-1a over length bytes, starting from seed
+static uint32_t hash_bytes(const char* data, size_t length, uint32_t seed) {
+    uint32_t hash = seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t edge_hash(int parent, const char* segment, size_t length) {
+    return hash_bytes(segment, length, 2166136261u ^ ((uint32_t)parent * 0x9E3779B1u));
+}
+
+// Edge from parent over segment, or the empty slot where it would go
+// (NULL for a segment too long to be in the trie)
+static TrieEdge* trie_edge(const RouteTable* table, int parent,
+                           const char* segment, size_t length) {
+    if (length >= MAX_EVENT_TYPE) {
+        return NULL;
+    }
+    uint32_t hash = edge_hash(parent, segment, length);
+    uint32_t index = hash & table->edge_mask;
+    for (;;) {
+        TrieEdge* edge = &table->edges[index];
+        if (edge->parent == TRIE_NONE ||
+            (edge->hash == hash && edge->parent == parent &&
+             memcmp(edge->segment, segment, length) == 0 && edge->segment[length] == '\0')) {
+            return edge;
+        }
+        index = (index + 1) & table->edge_mask;
+    }
+}
+
+static int trie_new_node(RouteTable* table) {
+    TrieNode* node = &table->nodes[table->node_count];
+    node->star = TRIE_NONE;
+    node->hash = TRIE_NONE;
+    node->subs = TRIE_NONE;
+    return table->node_count++;
+}
+
+static void trie_insert(RouteTable* table, const char* pattern, int tool, EventFilter* filter) {
+    int node = TRIE_ROOT;
+    const char* segment = pattern;
+    for (;;) {
+        const char* dot = strchr(segment, '.');
+        size_t length = dot ? (size_t)(dot - segment) : strlen(segment);
+        
+        int* wild = NULL;
+        if (length == 1 && segment[0] == '*') {
+            wild = &table->nodes[node].star;
+        } else if (length == 1 && segment[0] == '#') {
+            wild = &table->nodes[node].hash;  // Always last (event_pattern_valid)
+        }
+        
+        if (wild) {
+            if (*wild == TRIE_NONE) {
+                int child = trie_new_node(table);
+                *wild = child;  // nodes[] is not reallocated while building
+            }
+            node = *wild;
+        } else {
+            TrieEdge* edge = trie_edge(table, node, segment, length);
+            if (edge->parent == TRIE_NONE) {
+                edge->hash = edge_hash(node, segment, length);
+                edge->parent = node;
+                memcpy(edge->segment, segment, length);
+                edge->segment[length] = '\0';
+                edge->child = trie_new_node(table);
+            }
+            node = edge->child;
+        }
+        
+        if (!dot) {
+            break;
+        }
+        segment = dot + 1;
+    }
+    
+    TrieSub* link = &table->sub_links[table->sub_link_count];
+    link->tool = tool;
+    link->filter = filter;
+    event_filter_ref(filter);
+    link->next = table->nodes[node].subs;
+    table->nodes[node].subs = table->sub_link_count++;
+}
+
+static bool is_pattern(const char* type) {
+    return strchr(type, '*') != NULL || strchr(type, '#') != NULL;
+}
+
+static bool is_wildcard(const Tool* tool, EventTypeId star, EventTypeId hash) {
+    for (int j = 0; j < tool->subscription_count; j++) {
+        EventTypeId sub = tool->subscriptions[j];
+        if ((sub == star || sub == hash) && !tool->filters[j]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Subscriptions are normalized and de-duplicated by tool_subscribe(), so
+// each tool appears at most once per type. A tool subscribed to everything
+// is only on the wildcard list; overlapping patterns are de-duplicated
+// when an event is matched.
+static RouteTable* route_table_build(void) {
+    int tool_count = tool_get_count();
+    int sub_total = 0;
+    int segment_total = 0;
+    uint32_t type_limit = 1;
+    for (int i = 0; i < tool_count; i++) {
+        Tool* tool = tool_get_at(i);
+        sub_total += tool->subscription_count;
+        for (int j = 0; j < tool->subscription_count; j++) {
+            const char* name = event_type_name(tool->subscriptions[j]);
+            if (is_pattern(name)) {
+                segment_total++;
+                for (const char* c = name; *c; c++) {
+                    segment_total += (*c == '.');
                 }
-                
-                tool = tool_get_next();
+            } else if (tool->subscriptions[j] >= type_limit) {
+                type_limit = tool->subscriptions[j] + 1;
             }
-            
-            if (delivery_count > 0) {
-                LOG_DEBUG("event", "Event %s queued for %d tools", event->type, delivery_count);
+        }
+    }
+    EventTypeId star = event_type_find("*");
+    EventTypeId hash = event_type_find("#");
+    
+    uint32_t edge_count = 16;
+    while (edge_count < (uint32_t)segment_total * 2) {
+        edge_count *= 2;
+    }
+    
+    RouteTable* table = (RouteTable*)calloc(1, sizeof(RouteTable));
+    if (!table) {
+        return NULL;
+    }
+    table->tools = (Tool**)calloc(tool_count > 0 ? tool_count : 1, sizeof(Tool*));
+    table->type_limit = type_limit;
+    table->by_type = (RouteSpan*)calloc(type_limit, sizeof(RouteSpan));
+    table->subscribers = (int*)calloc(sub_total > 0 ? sub_total : 1, sizeof(int));
+    table->filters = (EventFilter**)calloc(sub_total > 0 ? sub_total : 1, sizeof(EventFilter*));
+    table->subscriber_total = sub_total;
+    table->wildcards = (int*)calloc(tool_count > 0 ? tool_count : 1, sizeof(int));
+    table->nodes = (TrieNode*)calloc((size_t)segment_total + 1, sizeof(TrieNode));
+    table->edge_mask = edge_count - 1;
+    table->edges = (TrieEdge*)calloc(edge_count, sizeof(TrieEdge));
+    table->sub_links = (TrieSub*)calloc(sub_total > 0 ? sub_total : 1, sizeof(TrieSub));
+    if (!table->tools || !table->by_type || !table->subscribers || !table->filters || !table->wildcards ||
+        !table->nodes || !table->edges || !table->sub_links) {
+        route_table_free(table);
+        return NULL;
+    }
+    for (uint32_t e = 0; e < edge_count; e++) {
+        table->edges[e].parent = TRIE_NONE;
+    }
+    trie_new_node(table);
+    
+    // Count subscribers per exact type; compile the patterns
+    for (int i = 0; i < tool_count; i++) {
+        Tool* tool = tool_get_at(i);
+        if (tool->subscription_count == 0) {
+            continue;
+        }
+        int id = table->tool_count++;
+        table->tools[id] = tool;
+        if (is_wildcard(tool, star, hash)) {
+            table->wildcards[table->wildcard_count++] = id;
+            continue;
+        }
+        for (int j = 0; j < tool->subscription_count; j++) {
+            const char* name = event_type_name(tool->subscriptions[j]);
+            EventFilter* filter = tool->filters[j];
+            if (filter) {
+                table->filter_count++;
+            }
+            if (is_pattern(name)) {
+                bool everything = strcmp(name, "*") == 0 || strcmp(name, "#") == 0;
+                trie_insert(table, everything ? "#" : name, id, filter);
+            } else {
+                table->by_type[tool->subscriptions[j]].count++;
+            }
+        }
+    }
+    
+    // Lay the lists out back to back, then fill them
+    int next = 0;
+    for (uint32_t type = 0; type < type_limit; type++) {
+        RouteSpan* span = &table->by_type[type];
+        span->first = next;
+        next += span->count;
+        span->count = 0;
+    }
+    for (int id = 0; id < table->tool_count; id++) {
+        Tool* tool = table->tools[id];
+        if (is_wildcard(tool, star, hash)) {
+            continue;
+        }
+        for (int j = 0; j < tool->subscription_count; j++) {
+            EventTypeId type = tool->subscriptions[j];
+            if (!is_pattern(event_type_name(type))) {
+                RouteSpan* span = &table->by_type[type];
+                table->filters[span->first + span->count] = tool->filters[j];
+                event_filter_ref(tool->filters[j]);
+                table->subscribers[span->first + span->count++] = id;
             }
-            
-            free(event);
-            bus.queue[bus.head] = NULL;
         }
-        bus.head = (bus.head + 1) % MAX_EVENTS_QUEUE;
-        bus.count--;
     }
+    
+    return table;
+}
+
+// A tool turned away by one filter may still match through another
+// subscription, so only a tool that is added is marked seen
+static void match_add(RouteMatch* match, int tool, const EventFilter* filter) {
+    uint64_t bit = (uint64_t)1 << (tool % 64);
+    if (!(match->seen[tool / 64] & bit) &&
+        (!filter || event_filter_match(filter, match->data, match->data_len))) {
+        match->seen[tool / 64] |= bit;
+        match->tools[match->count++] = tool;
+    }
+}
+
+static void match_subs(const RouteTable* table, RouteMatch* match, int node) {
+    for (int link = table->nodes[node].subs; link != TRIE_NONE; link = table->sub_links[link].next) {
+        match_add(match, table->sub_links[link].tool, table->sub_links[link].filter);
+    }
+}
+
+// Walk the trie along type's segments from node; "*" children take any one
+// segment and "#" children match whatever is left, including nothing
+static void trie_match(const RouteTable* table, RouteMatch* match, int node, const char* segment) {
+    for (;;) {
+        const TrieNode* current = &table->nodes[node];
+        if (current->hash != TRIE_NONE) {
+            match_subs(table, match, current->hash);
+        }
+        if (!segment) {
+            match_subs(table, match, node);
+            return;
+        }
+        
+        const char* dot = strchr(segment, '.');
+        size_t length = dot ? (size_t)(dot - segment) : strlen(segment);
+        const char* rest = dot ? dot + 1 : NULL;
+        
+        if (current->star != TRIE_NONE) {
+            trie_match(table, match, current->star, rest);
+        }
+        const TrieEdge* edge = trie_edge(table, node, segment, length);
+        if (!edge || edge->parent == TRIE_NONE) {
+            return;
+        }
+        node = edge->child;
+        segment = rest;
+    }
+}
+
+bool event_pattern_valid(const char* pattern) {
+    if (!pattern || !*pattern) {
+        return false;
+    }
+    const char* segment = pattern;
+    for (;;) {
+        const char* dot = strchr(segment, '.');
+        size_t length = dot ? (size_t)(dot - segment) : strlen(segment);
+        for (size_t i = 0; i < length; i++) {
+            if ((segment[i] == '*' || segment[i] == '#') && length != 1) {
+                return false;  // Wildcards are whole segments
+            }
+        }
+        if (length == 1 && segment[0] == '#' && dot) {
+            return false;  // "#" only at the end
+        }
+        if (!dot) {
+            return true;
+        }
+        segment = dot + 1;
+    }
+}
+
+static void routes_free_all(void) {
+    route_table_free(atomic_exchange(&routes, NULL));
+    while (retired) {
+        RouteTable* next = retired->next_retired;
+        route_table_free(retired);
+        retired = next;
+    }
+}
+
+void event_routes_changed(void) {
+    while (atomic_flag_test_and_set(&routes_building)) {
+        // Rebuilds are rare and short
+    }
+    
+    RouteTable* table = route_table_build();
+    if (table) {
+        RouteTable* old = atomic_exchange(&routes, table);
+        if (old) {
+            old->retired_epoch = atomic_fetch_add(&route_epoch, 1) + 1;
+            old->next_retired = retired;
+            retired = old;
+        }
+    } else {
+        LOG_ERROR("event", "Out of memory rebuilding routes");
+    }
+    
+    atomic_flag_clear(&routes_building);
+}
+
+void event_routes_enter(int shard) {
+    if (shard >= 0 && shard < MAX_IO_THREADS) {
+        atomic_store(&shard_epoch[shard], atomic_load(&route_epoch) + 1);
+    }
+}
+
+void event_routes_exit(int shard) {
+    if (shard >= 0 && shard < MAX_IO_THREADS) {
+        atomic_store(&shard_epoch[shard], 0);
+    }
+}
+
+// Oldest epoch any shard may still be reading
+static uint64_t routes_oldest_epoch(void) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < event_loop_shard_count(); i++) {
+        uint64_t seen = atomic_load(&shard_epoch[i]);
+        if (seen != 0 && seen - 1 < oldest) {
+            oldest = seen - 1;
+        }
+    }
+    return oldest;
+}
+
+uint64_t event_routes_epoch(void) {
+    return atomic_load(&route_epoch);
+}
+
+bool event_routes_passed(uint64_t epoch) {
+    return epoch <= routes_oldest_epoch();
+}
+
+void event_routes_reclaim(void) {
+    while (atomic_flag_test_and_set(&routes_building)) {
+    }
+    
+    uint64_t oldest = routes_oldest_epoch();
+    RouteTable** link = &retired;
+    while (*link) {
+        RouteTable* table = *link;
+        if (table->retired_epoch <= oldest) {
+            *link = table->next_retired;
+            route_table_free(table);
+        } else {
+            link = &table->next_retired;
+        }
+    }
+    
+    atomic_flag_clear(&routes_building);
+}
+
+int event_route(const char* type, const char* sender, const char* data) {
+    return event_route_priority(type, sender, data, EVENT_PRIORITY_LOW);
+}
+
+int event_route_priority(const char* type, const char* sender, const char* data,
+                         EventPriority priority) {
+    EventTypeId id = route_type_id(type);
+    int routed = route_event(id, effective_priority(id, priority), 0, 0, false, type, sender,
+                             data);
+    return routed < 0 ? routed : FW_OK;
+}
+
+int event_replay(uint64_t lsn, EventPriority priority, const char* type, const char* sender,
+                 const char* data) {
+    return route_event(route_type_id(type), priority, lsn, 0, true, type, sender, data);
+}
+
+// Queue buffer for one tool, handing it one reference. A logged event
+// raises the tool's owed LSN; a replayed one is skipped by tools that were
+// written past it before the restart, and goes straight into the inbox
+// under the shard's lock, as a replay can be longer than the shard's ring.
+static int deliver(Tool* tool, EventBuffer* buffer, bool replay) {
+    uint64_t lsn = buffer->lsn;
+    if (replay) {
+        if (atomic_load_explicit(&tool->log_acked, memory_order_relaxed) >= lsn) {
+            event_buffer_release(buffer);
+            return FW_ERROR_NOT_FOUND;
+        }
+        atomic_store_explicit(&tool->log_owed, lsn, memory_order_relaxed);
+        event_loop_lock(tool->shard);
+        int result = io_worker_deliver(tool, buffer);
+        event_loop_unlock(tool->shard);
+        return result;
+    }
+    if (lsn != 0) {
+        uint64_t owed = atomic_load_explicit(&tool->log_owed, memory_order_relaxed);
+        while (owed < lsn &&
+               !atomic_compare_exchange_weak_explicit(&tool->log_owed, &owed, lsn,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+        }
+    }
+    return io_worker_deliver(tool, buffer);
+}
+
+// The tools subscribed to the event exactly or by a pattern, without the
+// ones subscribed to everything
+static void route_match(const RouteTable* table, RouteMatch* match, EventTypeId id,
+                        const char* type, const char* data) {
+    match->count = 0;
+    RouteSpan span = { 0, 0 };
+    if (id != EVENT_TYPE_NONE && id < table->type_limit) {
+        span = table->by_type[id];
+    }
+    if (table->node_count > 1 || table->filter_count > 0) {
+        memset(match->seen, 0, sizeof(match->seen));
+        match->data = data;
+        match->data_len = data ? strlen(data) : 0;
+        for (int i = 0; i < span.count; i++) {
+            match_add(match, table->subscribers[span.first + i], table->filters[span.first + i]);
+        }
+        if (table->node_count > 1) {
+            trie_match(table, match, TRIE_ROOT, type);
+        }
+    } else {
+        // No patterns or filters: the exact subscribers are already distinct
+        memcpy(match->tools, table->subscribers + span.first, (size_t)span.count * sizeof(int));
+        match->count = span.count;
+    }
+}
+
+// Format the event once for every inbox that shares it, charged to the
+// publisher whose stdout is being read (flow_control.h)
+static EventBuffer* route_buffer(EventPriority priority, uint64_t lsn, const char* type,
+                                 const char* sender, const char* data, int refs) {
+    EventBuffer* buffer = event_buffer_format(type, sender, data);
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->priority = priority;
+    buffer->lsn = lsn;
+    Tool* publisher = flow_publisher();
+    buffer->publisher = publisher ? publisher->flow : NULL;
+    buffer->charged = sizeof(EventBuffer) + buffer->length;
+    flow_charge(buffer->publisher, buffer->charged);
+    event_buffer_ref(buffer, refs - 1);
+    return buffer;
+}
+
+// Queue the event for every subscriber
+static int route_targets(EventTypeId id, EventPriority priority, uint64_t lsn, uint64_t seq,
+                         bool replay, const char* type, const char* sender, const char* data) {
+    RouteTable* table = atomic_load(&routes);
+    if (!table) {
+        return 0;
+    }
+    
+    RouteMatch match;
+    route_match(table, &match, id, type, data);
+    int total = match.count + table->wildcard_count;
+    if (total == 0) {
+        event_type_count_routed(id, 0);
+        return 0;
+    }
+    
+    // Tools that asked for sequence numbers share a second buffer, from
+    // sender@seq; everyone else shares the plain one
+    Tool* targets[MAX_TOOLS];
+    int sequenced = 0;
+    for (int i = 0; i < total; i++) {
+        targets[i] = table->tools[i < match.count ? match.tools[i]
+                                                  : table->wildcards[i - match.count]];
+        if (seq && targets[i]->sequence_numbers) {
+            sequenced++;
+        }
+    }
+    EventBuffer* plain = NULL;
+    EventBuffer* numbered = NULL;
+    if (sequenced < total) {
+        plain = route_buffer(priority, lsn, type, sender, data, total - sequenced);
+    }
+    if (sequenced > 0) {
+        char numbered_sender[MAX_TOOL_NAME + 24];
+        snprintf(numbered_sender, sizeof(numbered_sender), "%s@%" PRIu64, sender, seq);
+        numbered = route_buffer(priority, lsn, type, numbered_sender, data, sequenced);
+    }
+    if ((sequenced < total && !plain) || (sequenced > 0 && !numbered)) {
+        for (int i = 0; plain && i < total - sequenced; i++) {
+            event_buffer_release(plain);
+        }
+        for (int i = 0; numbered && i < sequenced; i++) {
+            event_buffer_release(numbered);
+        }
+        LOG_ERROR("event", "Failed to route %s: out of memory", type);
+        return FW_ERROR_MEMORY;
+    }
+    
+    if (lsn != 0 && !replay) {
+        if (plain) plain->log_held = true;
+        if (numbered) numbered->log_held = true;
+        event_log_hold(lsn, total);
+    }
+    int delivery_count = 0;
+    for (int i = 0; i < total; i++) {
+        EventBuffer* buffer = seq && targets[i]->sequence_numbers ? numbered : plain;
+        if (deliver(targets[i], buffer, replay) == FW_OK) {
+            delivery_count++;
+        }
+    }
+    event_type_count_routed(id, delivery_count);
+    
+    if (delivery_count > 0) {
+        LOG_DEBUG("event", "Event %s queued for %d tools", type, delivery_count);
+    }
+    return delivery_count;
+}
+
+// Returns how many tools the event was queued for, or an error. A logged
+// event (not a replay) is routed with the log hold its append took, which
+// is handed on as one hold per delivery (event_log_hold).
+static int route_event(EventTypeId id, EventPriority priority, uint64_t lsn, uint64_t seq,
+                       bool replay, const char* type, const char* sender, const char* data) {
+    int result = route_targets(id, priority, lsn, seq, replay, type, sender, data);
+    if (!replay) {
+        event_log_release(lsn);
+    }
+    return result;
+}
+
+Tool* event_route_one(const char* type, const char* data, const Tool* skip, unsigned int turn) {
+    RouteTable* table = atomic_load(&routes);
+    if (!table) {
+        return NULL;
+    }
+    
+    RouteMatch match;
+    route_match(table, &match, event_type_find(type), type, data);
+    for (int i = 0; i < match.count; i++) {
+        Tool* tool = table->tools[match.tools[(turn + (unsigned int)i) % (unsigned int)match.count]];
+        if (tool != skip && (tool->status == TOOL_RUNNING || tool->status == TOOL_STARTING ||
+                             tool->is_on_demand)) {
+            return tool;
+        }
+    }
+    return NULL;
 }
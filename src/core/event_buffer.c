@@ -0,0 +1,88 @@
+/**
+ * @file event_buffer.c
+ * @brief Reference-counted event wire buffers
+ *
+ * An event is formatted once when it is routed; every subscriber's inbox
+ * then queues a pointer to the same buffer instead of its own copy, so
+ * fan-out costs one allocation per event rather than one per subscriber.
+ */
+
+#include "yuki_frame/event_buffer.h"
+#include "yuki_frame/flow_control.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+EventBuffer* event_buffer_create(const char* data, size_t length) {
+    EventBuffer* buffer = (EventBuffer*)malloc(sizeof(EventBuffer) + length + 1);
+    if (!buffer) {
+        return NULL;
+    }
+    atomic_init(&buffer->refs, 1);
+    buffer->priority = EVENT_PRIORITY_NORMAL;
+    buffer->lsn = 0;
+    buffer->log_held = false;
+    buffer->publisher = NULL;
+    buffer->charged = 0;
+    buffer->length = length;
+    memcpy(buffer->data, data, length);
+    buffer->data[length] = '\0';
+    return buffer;
+}
+
+EventBuffer* event_buffer_format(const char* type, const char* sender, const char* data) {
+    size_t type_len = strlen(type);
+    size_t sender_len = strlen(sender);
+    size_t data_len = strlen(data);
+
+    // Data with a newline cannot be a line: write it as a frame,
+    // "#<length>|TYPE|sender\n<data>\n"
+    char prefix[24] = "";
+    size_t prefix_len = 0;
+    if (memchr(data, '\n', data_len)) {
+        prefix_len = (size_t)snprintf(prefix, sizeof(prefix), "#%zu|", data_len);
+    }
+    size_t length = prefix_len + type_len + sender_len + data_len + 3;
+
+    EventBuffer* buffer = (EventBuffer*)malloc(sizeof(EventBuffer) + length + 1);
+    if (!buffer) {
+        return NULL;
+    }
+    atomic_init(&buffer->refs, 1);
+    buffer->priority = EVENT_PRIORITY_NORMAL;
+    buffer->lsn = 0;
+    buffer->log_held = false;
+    buffer->publisher = NULL;
+    buffer->charged = 0;
+    buffer->length = length;
+
+    char* out = buffer->data;
+    memcpy(out, prefix, prefix_len);
+    out += prefix_len;
+    memcpy(out, type, type_len);
+    out += type_len;
+    *out++ = '|';
+    memcpy(out, sender, sender_len);
+    out += sender_len;
+    *out++ = prefix_len ? '\n' : '|';
+    memcpy(out, data, data_len);
+    out += data_len;
+    *out++ = '\n';
+    *out = '\0';
+    return buffer;
+}
+
+void event_buffer_ref(EventBuffer* buffer, int count) {
+    if (buffer && count > 0) {
+        atomic_fetch_add_explicit(&buffer->refs, count, memory_order_relaxed);
+    }
+}
+
+void event_buffer_release(EventBuffer* buffer) {
+    if (buffer && atomic_fetch_sub_explicit(&buffer->refs, 1, memory_order_acq_rel) == 1) {
+        if (buffer->charged) {
+            flow_release(buffer->publisher, buffer->charged);
+        }
+        free(buffer);
+    }
+}
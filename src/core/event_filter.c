@@ -0,0 +1,460 @@
+/**
+ * @file event_filter.c
+ * @brief Subscription content filters
+ *
+ * A filter compiles to straight-line code for a one-register machine: TEST
+ * sets the register from one comparison, NOT inverts it, and the two
+ * conditional jumps skip the rest of an "&&" or "||" chain as soon as its
+ * outcome is known. A field is looked up in the data at most once per
+ * event, when the first instruction that needs it runs.
+ */
+
+#include "yuki_frame/event_filter.h"
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILTER_MAX_DEPTH 32
+#define FILTER_MAX_NUMBER 64            // Longest text parsed as a number
+
+typedef enum {
+    FILTER_TEST,                // result = comparison
+    FILTER_NOT,                 // result = !result
+    FILTER_JUMP_IF_TRUE,        // Past the rest of a satisfied "||" chain
+    FILTER_JUMP_IF_FALSE        // Past the rest of a failed "&&" chain
+} FilterOpcode;
+
+typedef enum {
+    COMPARE_PRESENT,
+    COMPARE_EQ,
+    COMPARE_NE,
+    COMPARE_LT,
+    COMPARE_LE,
+    COMPARE_GT,
+    COMPARE_GE
+} FilterCompare;
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t compare;
+    uint8_t field;              // Index in EventFilter.fields
+    bool is_number;             // Unquoted value that parses as a number
+    uint16_t target;            // Jump destination
+    uint16_t value;             // Offset of the value in EventFilter.strings
+    uint16_t value_len;
+    double number;
+} FilterInstr;
+
+struct EventFilter {
+    atomic_int refs;
+    int code_count;
+    int field_count;
+    FilterInstr code[EVENT_FILTER_MAX_CODE];
+    char fields[EVENT_FILTER_MAX_FIELDS][MAX_EVENT_TYPE];
+    char strings[EVENT_FILTER_MAX_SOURCE];  // Comparison values, back to back
+    char source[EVENT_FILTER_MAX_SOURCE];
+};
+
+typedef struct {
+    EventFilter* filter;
+    const char* p;
+    size_t strings_used;
+    int depth;
+    bool failed;
+    char* error;
+    size_t error_size;
+} FilterParser;
+
+static bool is_field_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.';
+}
+
+// Where an unquoted value in event data stops
+static bool is_value_end(char c) {
+    return c == ' ' || c == ',' || c == ';' || c == '}' || c == '"' ||
+           c == '\t' || c == '\r' || c == '\n';
+}
+
+bool event_field_find(const char* data, size_t length, const char* field,
+                      const char** value, size_t* value_len) {
+    size_t field_len = strlen(field);
+    if (field_len == 0) {
+        return false;
+    }
+    const char* end = data + length;
+    const char* p = data;
+    while (p + field_len < end) {
+        p = (const char*)memchr(p, field[0], (size_t)(end - p) - field_len);
+        if (!p) {
+            return false;
+        }
+        const char* c = p + field_len;
+        if (memcmp(p, field, field_len) != 0 || (p > data && is_field_char(p[-1]))) {
+            p++;
+            continue;
+        }
+        if (*c == '"') {
+            c++;
+        }
+        while (c < end && *c == ' ') {
+            c++;
+        }
+        if (c == end || (*c != '=' && *c != ':')) {
+            p++;
+            continue;
+        }
+        c++;
+        while (c < end && (*c == ' ' || *c == '"')) {
+            c++;
+        }
+        const char* start = c;
+        while (c < end && !is_value_end(*c)) {
+            c++;
+        }
+        *value = start;
+        *value_len = (size_t)(c - start);
+        return true;
+    }
+    return false;
+}
+
+// Decimal number filling all of text
+static bool parse_number(const char* text, size_t length, double* number) {
+    if (length == 0 || length >= FILTER_MAX_NUMBER ||
+        !(isdigit((unsigned char)text[0]) || text[0] == '-' || text[0] == '+' || text[0] == '.')) {
+        return false;
+    }
+    char buffer[FILTER_MAX_NUMBER];
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    char* end;
+    *number = strtod(buffer, &end);
+    return end == buffer + length;
+}
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+static void parse_fail(FilterParser* parser, const char* reason) {
+    if (parser->failed) {
+        return;
+    }
+    parser->failed = true;
+    if (parser->error && parser->error_size > 0) {
+        snprintf(parser->error, parser->error_size, "%s at column %d", reason,
+                 (int)(parser->p - parser->filter->source) + 1);
+    }
+}
+
+static void skip_spaces(FilterParser* parser) {
+    while (*parser->p == ' ' || *parser->p == '\t') {
+        parser->p++;
+    }
+}
+
+static FilterInstr* emit(FilterParser* parser, FilterOpcode opcode) {
+    EventFilter* filter = parser->filter;
+    if (filter->code_count >= EVENT_FILTER_MAX_CODE) {
+        parse_fail(parser, "filter too long");
+        return NULL;
+    }
+    FilterInstr* instr = &filter->code[filter->code_count++];
+    memset(instr, 0, sizeof(FilterInstr));
+    instr->opcode = (uint8_t)opcode;
+    return instr;
+}
+
+static int field_index(FilterParser* parser, const char* name, size_t length) {
+    EventFilter* filter = parser->filter;
+    if (length >= MAX_EVENT_TYPE) {
+        parse_fail(parser, "field name too long");
+        return -1;
+    }
+    for (int i = 0; i < filter->field_count; i++) {
+        if (strncmp(filter->fields[i], name, length) == 0 && filter->fields[i][length] == '\0') {
+            return i;
+        }
+    }
+    if (filter->field_count >= EVENT_FILTER_MAX_FIELDS) {
+        parse_fail(parser, "too many fields");
+        return -1;
+    }
+    memcpy(filter->fields[filter->field_count], name, length);
+    filter->fields[filter->field_count][length] = '\0';
+    return filter->field_count++;
+}
+
+// field [op value]
+static void parse_comparison(FilterParser* parser) {
+    const char* name = parser->p;
+    while (is_field_char(*parser->p)) {
+        parser->p++;
+    }
+    if (parser->p == name) {
+        parse_fail(parser, "expected a field name");
+        return;
+    }
+    int field = field_index(parser, name, (size_t)(parser->p - name));
+    FilterInstr* instr = field >= 0 ? emit(parser, FILTER_TEST) : NULL;
+    if (!instr) {
+        return;
+    }
+    instr->field = (uint8_t)field;
+
+    skip_spaces(parser);
+    const char* p = parser->p;
+    FilterCompare compare = COMPARE_PRESENT;
+    if (p[0] == '=') {
+        compare = COMPARE_EQ;
+        p += p[1] == '=' ? 2 : 1;
+    } else if (p[0] == '!' && p[1] == '=') {
+        compare = COMPARE_NE;
+        p += 2;
+    } else if (p[0] == '<') {
+        compare = p[1] == '=' ? COMPARE_LE : COMPARE_LT;
+        p += p[1] == '=' ? 2 : 1;
+    } else if (p[0] == '>') {
+        compare = p[1] == '=' ? COMPARE_GE : COMPARE_GT;
+        p += p[1] == '=' ? 2 : 1;
+    }
+    instr->compare = (uint8_t)compare;
+    if (compare == COMPARE_PRESENT) {
+        return;
+    }
+    parser->p = p;
+    skip_spaces(parser);
+
+    const char* value = parser->p;
+    size_t length;
+    bool quoted = *value == '"' || *value == '\'';
+    if (quoted) {
+        const char* close = strchr(value + 1, *value);
+        if (!close) {
+            parse_fail(parser, "unterminated string");
+            return;
+        }
+        value++;
+        length = (size_t)(close - value);
+        parser->p = close + 1;
+    } else {
+        while (*parser->p && !isspace((unsigned char)*parser->p) && *parser->p != ')' &&
+               *parser->p != '&' && *parser->p != '|') {
+            parser->p++;
+        }
+        length = (size_t)(parser->p - value);
+        if (length == 0) {
+            parse_fail(parser, "expected a value");
+            return;
+        }
+    }
+
+    // Values are pieces of the source, so they always fit
+    memcpy(parser->filter->strings + parser->strings_used, value, length);
+    instr->value = (uint16_t)parser->strings_used;
+    instr->value_len = (uint16_t)length;
+    instr->is_number = !quoted && parse_number(value, length, &instr->number);
+    parser->strings_used += length;
+}
+
+static void parse_or(FilterParser* parser);
+
+static void parse_unary(FilterParser* parser) {
+    skip_spaces(parser);
+    if (++parser->depth > FILTER_MAX_DEPTH) {
+        parse_fail(parser, "filter nested too deeply");
+    } else if (parser->p[0] == '!' && parser->p[1] != '=') {
+        parser->p++;
+        parse_unary(parser);
+        if (!parser->failed) {
+            emit(parser, FILTER_NOT);
+        }
+    } else if (parser->p[0] == '(') {
+        parser->p++;
+        parse_or(parser);
+        skip_spaces(parser);
+        if (*parser->p != ')') {
+            parse_fail(parser, "expected ')'");
+        } else {
+            parser->p++;
+        }
+    } else {
+        parse_comparison(parser);
+    }
+    parser->depth--;
+}
+
+// operand (op operand)*: each op jumps to the end of the chain when the
+// operand before it already decides it
+static void parse_chain(FilterParser* parser, const char* op, FilterOpcode jump,
+                        void (*operand)(FilterParser*)) {
+    int jumps[EVENT_FILTER_MAX_CODE];
+    int jump_count = 0;
+    operand(parser);
+    skip_spaces(parser);
+    while (!parser->failed && parser->p[0] == op[0] && parser->p[1] == op[1]) {
+        parser->p += 2;
+        if (!emit(parser, jump)) {
+            return;
+        }
+        jumps[jump_count++] = parser->filter->code_count - 1;
+        operand(parser);
+        skip_spaces(parser);
+    }
+    for (int i = 0; i < jump_count; i++) {
+        parser->filter->code[jumps[i]].target = (uint16_t)parser->filter->code_count;
+    }
+}
+
+static void parse_and(FilterParser* parser) {
+    parse_chain(parser, "&&", FILTER_JUMP_IF_FALSE, parse_unary);
+}
+
+static void parse_or(FilterParser* parser) {
+    parse_chain(parser, "||", FILTER_JUMP_IF_TRUE, parse_and);
+}
+
+EventFilter* event_filter_compile(const char* source, char* error, size_t error_size) {
+    if (error && error_size > 0) {
+        error[0] = '\0';
+    }
+    if (!source) {
+        return NULL;
+    }
+    if (strlen(source) >= EVENT_FILTER_MAX_SOURCE) {
+        if (error && error_size > 0) {
+            snprintf(error, error_size, "filter longer than %d characters",
+                     EVENT_FILTER_MAX_SOURCE - 1);
+        }
+        return NULL;
+    }
+
+    EventFilter* filter = (EventFilter*)calloc(1, sizeof(EventFilter));
+    if (!filter) {
+        if (error && error_size > 0) {
+            snprintf(error, error_size, "out of memory");
+        }
+        return NULL;
+    }
+    strcpy(filter->source, source);
+
+    FilterParser parser = { filter, filter->source, 0, 0, false, error, error_size };
+    parse_or(&parser);
+    skip_spaces(&parser);
+    if (*parser.p != '\0') {
+        parse_fail(&parser, "unexpected character");
+    }
+    if (parser.failed) {
+        free(filter);
+        return NULL;
+    }
+
+    atomic_init(&filter->refs, 1);
+    return filter;
+}
+
+void event_filter_ref(EventFilter* filter) {
+    if (filter) {
+        atomic_fetch_add_explicit(&filter->refs, 1, memory_order_relaxed);
+    }
+}
+
+void event_filter_release(EventFilter* filter) {
+    if (filter && atomic_fetch_sub_explicit(&filter->refs, 1, memory_order_acq_rel) == 1) {
+        free(filter);
+    }
+}
+
+const char* event_filter_source(const EventFilter* filter) {
+    return filter ? filter->source : "";
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+// A field's value in the event, looked up on first use
+typedef struct {
+    const char* value;
+    size_t length;
+    int8_t state;               // 0 = not looked up, 1 = found, -1 = missing
+} FieldValue;
+
+static bool compare(const EventFilter* filter, const FilterInstr* instr,
+                    const char* value, size_t length) {
+    int order;
+    double number;
+    if (instr->is_number && parse_number(value, length, &number)) {
+        order = (number > instr->number) - (number < instr->number);
+    } else {
+        const char* constant = filter->strings + instr->value;
+        size_t common = length < instr->value_len ? length : instr->value_len;
+        order = memcmp(value, constant, common);
+        if (order == 0) {
+            order = (length > instr->value_len) - (length < instr->value_len);
+        }
+    }
+
+    switch (instr->compare) {
+        case COMPARE_EQ: return order == 0;
+        case COMPARE_NE: return order != 0;
+        case COMPARE_LT: return order < 0;
+        case COMPARE_LE: return order <= 0;
+        case COMPARE_GT: return order > 0;
+        case COMPARE_GE: return order >= 0;
+        default:         return true;
+    }
+}
+
+bool event_filter_match(const EventFilter* filter, const char* data, size_t length) {
+    if (!filter) {
+        return true;
+    }
+    if (!data) {
+        data = "";
+        length = 0;
+    }
+
+    FieldValue fields[EVENT_FILTER_MAX_FIELDS];
+    memset(fields, 0, sizeof(FieldValue) * (size_t)filter->field_count);
+
+    bool result = true;
+    int pc = 0;
+    while (pc < filter->code_count) {
+        const FilterInstr* instr = &filter->code[pc];
+        switch (instr->opcode) {
+            case FILTER_TEST: {
+                FieldValue* field = &fields[instr->field];
+                if (field->state == 0) {
+                    field->state = event_field_find(data, length, filter->fields[instr->field],
+                                                    &field->value, &field->length) ? 1 : -1;
+                }
+                if (field->state < 0) {
+                    result = false;
+                } else if (instr->compare == COMPARE_PRESENT) {
+                    result = true;
+                } else {
+                    result = compare(filter, instr, field->value, field->length);
+                }
+                pc++;
+                break;
+            }
+            case FILTER_NOT:
+                result = !result;
+                pc++;
+                break;
+            case FILTER_JUMP_IF_TRUE:
+                pc = result ? instr->target : pc + 1;
+                break;
+            case FILTER_JUMP_IF_FALSE:
+                pc = result ? pc + 1 : instr->target;
+                break;
+            default:
+                return false;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,1006 @@
+/**
+ * @file event_log.c
+ * @brief Durable, segmented event log
+ *
+ * Appending copies a record into the pending buffer under a lock; the
+ * publishing thread does not touch the disk unless sync_ms is 0. The
+ * flusher swaps the pending buffer for an empty one, fills in the records'
+ * checksums, writes them to the current segment and syncs it, so one
+ * fdatasync covers every event appended since the last one.
+ *
+ * Segments are "events-<number>.log" files of records back to back. Once a
+ * segment has segment_size bytes the next number is started. A record torn
+ * by a crash fails its checksum and ends the scan of its segment, which is
+ * never appended to again. The checkpoint file names the oldest segment
+ * still needed and each tool's offset; it is written beside the old one
+ * and renamed over it.
+ *
+ * Cursors map segments read-only and walk their records; the sparse index
+ * built while writing (and while recovering) points them at the right
+ * part of the right segment.
+ *
+ * Events reach a tool's inbox out of LSN order when they come from
+ * different publishers or shards, so a tool's own offset can pass an event
+ * still on its way to it. Each appended LSN keeps a count of holds until
+ * it is in every subscriber's inbox; checkpoints never record an offset
+ * at or past the lowest LSN still held.
+ */
+
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_PATH_MAX 512
+#define LOG_MAX_RECORD ((uint32_t)1 << 31)
+
+// Record header; the type, sender and data follow without separators
+typedef struct {
+    uint32_t length;            // Bytes after the header
+    uint32_t checksum;          // FNV-1a of everything after this field
+    uint64_t lsn;
+    uint64_t timestamp_ms;      // Wall clock at append, never decreasing
+    uint16_t type_len;
+    uint16_t sender_len;
+    uint8_t priority;
+    uint8_t reserved[3];
+} LogRecord;
+
+#define CHECKSUMMED_HEADER (sizeof(LogRecord) - offsetof(LogRecord, lsn))
+
+typedef struct {
+    uint64_t lsn;
+    uint64_t timestamp_ms;
+    size_t offset;              // Of the record in the segment file
+} LogIndexEntry;
+
+typedef struct {
+    int number;
+    uint64_t first_lsn;         // 0 while empty
+    LogIndexEntry* index;       // First record, then one per EVENT_LOG_INDEX_INTERVAL bytes
+    int index_count;
+    int index_capacity;
+} LogSegment;
+
+struct EventLogCursor {
+    int number;                 // Segment being read
+    const char* map;            // Its mapping, NULL if none
+    size_t map_size;
+    size_t offset;              // Next record in the mapping
+    uint64_t min_lsn;           // Records before both of these are skipped
+    uint64_t min_time_ms;
+    char* data;                 // NUL-terminated copy of the record's data
+    size_t data_capacity;
+};
+
+typedef struct {
+    char name[MAX_TOOL_NAME];
+    uint64_t offset;
+} LogOffset;
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} LogBuffer;
+
+// Hold counts of the LSNs from base on, in a ring starting at head
+typedef struct {
+    PlatformMutex lock;
+    uint32_t* counts;
+    size_t capacity;            // Power of two
+    size_t head;
+    size_t length;              // LSNs tracked: base .. base + length - 1
+    uint64_t base;
+    atomic_uint_fast64_t floor; // base, published for lock-free reads
+} LogHolds;
+
+static struct {
+    atomic_bool open;
+    char directory[256];
+    int sync_ms;
+    size_t segment_size;
+
+    PlatformMutex lock;         // Guards pending, next_lsn and the checkpoint
+    LogBuffer pending;
+    uint64_t next_lsn;
+    uint64_t last_time_ms;      // Timestamp of the last append
+    LogOffset offsets[MAX_TOOLS];
+    int offset_count;
+    uint64_t keep_lsn;          // Oldest offset of a tool with events to write
+    bool checkpoint_due;
+
+    PlatformMutex write_lock;   // Guards the files and everything below
+    LogBuffer writing;
+    FILE* file;
+    size_t file_bytes;
+    LogSegment* segments;       // Oldest first; the last is being written
+    int segment_count;
+    int segment_capacity;
+    bool write_failed;
+
+    PlatformThread thread;
+    atomic_bool running;
+    uint64_t next_checkpoint_ms;
+    uint64_t open_lsn;          // Last LSN recovered when opened
+
+    atomic_uint_fast64_t appended;
+    atomic_uint_fast64_t synced_lsn;
+    atomic_uint_fast64_t syncs;
+    atomic_uint_fast64_t bytes;
+    atomic_uint_fast64_t replayed;
+
+    LogHolds holds;
+} wal;
+
+// Offsets read from the checkpoint when the log was opened
+static LogOffset restored[MAX_TOOLS];
+static int restored_count;
+
+// FNV-1a over length bytes, continuing from hash
+static uint32_t checksum_bytes(uint32_t hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t record_checksum(const LogRecord* header, const char* text) {
+    uint32_t hash = checksum_bytes(2166136261u, (const char*)&header->lsn, CHECKSUMMED_HEADER);
+    return checksum_bytes(hash, text, header->length);
+}
+
+static void segment_path(char* path, size_t size, int number) {
+    snprintf(path, size, "%s/events-%08d.log", wal.directory, number);
+}
+
+static bool buffer_reserve(LogBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 64 * 1024;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    char* data = (char*)realloc(buffer->data, capacity);
+    if (!data) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool segment_add(int number, uint64_t first_lsn) {
+    if (wal.segment_count == wal.segment_capacity) {
+        int capacity = wal.segment_capacity ? wal.segment_capacity * 2 : 16;
+        LogSegment* segments = (LogSegment*)realloc(wal.segments, (size_t)capacity * sizeof(LogSegment));
+        if (!segments) {
+            return false;
+        }
+        wal.segments = segments;
+        wal.segment_capacity = capacity;
+    }
+    memset(&wal.segments[wal.segment_count], 0, sizeof(LogSegment));
+    wal.segments[wal.segment_count].number = number;
+    wal.segments[wal.segment_count].first_lsn = first_lsn;
+    wal.segment_count++;
+    return true;
+}
+
+// Index the record at offset if it is the segment's first or far enough
+// past the last one indexed
+static void index_add(LogSegment* segment, const LogRecord* header, size_t offset) {
+    if (segment->index_count > 0 &&
+        offset < segment->index[segment->index_count - 1].offset + EVENT_LOG_INDEX_INTERVAL) {
+        return;
+    }
+    if (segment->index_count == segment->index_capacity) {
+        int capacity = segment->index_capacity ? segment->index_capacity * 2 : 16;
+        LogIndexEntry* index = (LogIndexEntry*)realloc(segment->index,
+                                                       (size_t)capacity * sizeof(LogIndexEntry));
+        if (!index) {
+            return;  // Seeks just read further
+        }
+        segment->index = index;
+        segment->index_capacity = capacity;
+    }
+    LogIndexEntry* entry = &segment->index[segment->index_count++];
+    entry->lsn = header->lsn;
+    entry->timestamp_ms = header->timestamp_ms;
+    entry->offset = offset;
+}
+
+// Start writing a new segment (write_lock held)
+static int segment_open(int number) {
+    char path[LOG_PATH_MAX];
+    segment_path(path, sizeof(path), number);
+    wal.file = fopen(path, "wb");
+    wal.file_bytes = 0;
+    if (!wal.file || !segment_add(number, 0)) {
+        LOG_ERROR("event_log", "Cannot create segment %s", path);
+        if (wal.file) {
+            fclose(wal.file);
+            wal.file = NULL;
+        }
+        return FW_ERROR_IO;
+    }
+    return FW_OK;
+}
+
+static void segment_sync(void) {
+    if (wal.file && (fflush(wal.file) != 0 ||
+                     platform_file_sync(fileno(wal.file)) != FW_OK) && !wal.write_failed) {
+        wal.write_failed = true;
+        LOG_ERROR("event_log", "Failed to sync the event log");
+    }
+}
+
+static void segment_write(const char* data, size_t length) {
+    if (!wal.file || length == 0) {
+        return;
+    }
+    if (fwrite(data, 1, length, wal.file) != length && !wal.write_failed) {
+        wal.write_failed = true;
+        LOG_ERROR("event_log", "Failed to write the event log");
+    }
+    wal.file_bytes += length;
+    atomic_fetch_add_explicit(&wal.bytes, length, memory_order_relaxed);
+}
+
+// Checksum the records and write them, starting a new segment whenever the
+// current one is full (write_lock held)
+static void write_records(char* data, size_t length) {
+    size_t start = 0;
+    size_t offset = 0;
+    while (offset < length) {
+        LogRecord header;
+        memcpy(&header, data + offset, sizeof(LogRecord));
+        size_t size = sizeof(LogRecord) + header.length;
+
+        if (wal.file_bytes + (offset - start) > 0 &&
+            wal.file_bytes + (offset - start) + size > wal.segment_size) {
+            segment_write(data + start, offset - start);
+            start = offset;
+            segment_sync();
+            if (wal.file) {
+                fclose(wal.file);
+                wal.file = NULL;
+            }
+            segment_open(wal.segments[wal.segment_count - 1].number + 1);
+        }
+        LogSegment* current = &wal.segments[wal.segment_count - 1];
+        if (current->first_lsn == 0) {
+            current->first_lsn = header.lsn;
+        }
+        index_add(current, &header, wal.file_bytes + (offset - start));
+
+        header.checksum = record_checksum(&header, data + offset + sizeof(LogRecord));
+        memcpy(data + offset, &header, sizeof(LogRecord));
+        offset += size;
+    }
+    segment_write(data + start, offset - start);
+}
+
+// First LSN after segment index, or 0 if no later segment has records yet
+static uint64_t segment_next_lsn(int index) {
+    for (int i = index + 1; i < wal.segment_count; i++) {
+        if (wal.segments[i].first_lsn != 0) {
+            return wal.segments[i].first_lsn;
+        }
+    }
+    return 0;
+}
+
+// Write the checkpoint last taken, then delete the segments no tool needs
+// (write_lock held)
+static void write_checkpoint(void) {
+    LogOffset offsets[MAX_TOOLS];
+    platform_mutex_lock(&wal.lock);
+    int count = wal.offset_count;
+    memcpy(offsets, wal.offsets, (size_t)count * sizeof(LogOffset));
+    uint64_t keep = wal.keep_lsn;
+    platform_mutex_unlock(&wal.lock);
+
+    // A segment can go once every record in it is at or below keep; the
+    // segment being written always stays
+    int drop = 0;
+    while (drop + 1 < wal.segment_count) {
+        uint64_t next_lsn = segment_next_lsn(drop);
+        if (wal.segments[drop].first_lsn != 0 && (next_lsn == 0 || next_lsn - 1 > keep)) {
+            break;
+        }
+        drop++;
+    }
+
+    char path[LOG_PATH_MAX];
+    char temp[LOG_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/checkpoint", wal.directory);
+    snprintf(temp, sizeof(temp), "%s/checkpoint.tmp", wal.directory);
+    FILE* file = fopen(temp, "w");
+    if (!file) {
+        LOG_ERROR("event_log", "Cannot write %s", temp);
+        return;
+    }
+    fprintf(file, "first_segment %d\n", wal.segments[drop].number);
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "tool %" PRIu64 " %s\n", offsets[i].offset, offsets[i].name);
+    }
+    bool written = fflush(file) == 0 && platform_file_sync(fileno(file)) == FW_OK;
+    fclose(file);
+    if (!written || platform_replace_file(temp, path) != FW_OK) {
+        LOG_ERROR("event_log", "Failed to write checkpoint %s", path);
+        return;
+    }
+
+    for (int i = 0; i < drop; i++) {
+        segment_path(path, sizeof(path), wal.segments[i].number);
+        remove(path);
+        free(wal.segments[i].index);
+    }
+    if (drop > 0) {
+        memmove(wal.segments, wal.segments + drop,
+                (size_t)(wal.segment_count - drop) * sizeof(LogSegment));
+        wal.segment_count -= drop;
+        LOG_DEBUG("event_log", "Deleted %d event log segments", drop);
+    }
+}
+
+// Group commit: write and sync everything appended so far
+static void log_flush(void) {
+    platform_mutex_lock(&wal.write_lock);
+
+    platform_mutex_lock(&wal.lock);
+    LogBuffer swap = wal.pending;
+    wal.pending = wal.writing;
+    wal.writing = swap;
+    wal.pending.length = 0;
+    uint64_t last_lsn = wal.next_lsn - 1;
+    bool checkpoint = wal.checkpoint_due;
+    wal.checkpoint_due = false;
+    platform_mutex_unlock(&wal.lock);
+
+    if (wal.writing.length > 0) {
+        write_records(wal.writing.data, wal.writing.length);
+        segment_sync();
+        wal.writing.length = 0;
+        atomic_store_explicit(&wal.synced_lsn, last_lsn, memory_order_release);
+        atomic_fetch_add_explicit(&wal.syncs, 1, memory_order_relaxed);
+    }
+    if (checkpoint) {
+        write_checkpoint();
+    }
+
+    platform_mutex_unlock(&wal.write_lock);
+}
+
+static void flusher_main(void* arg) {
+    (void)arg;
+    int interval = wal.sync_ms > 0 ? wal.sync_ms : EVENT_LOG_CHECKPOINT_MS / 10;
+    while (atomic_load(&wal.running)) {
+        platform_sleep_ms(interval);
+        log_flush();
+    }
+}
+
+// ============================================================================
+// Recovery
+// ============================================================================
+
+static int read_checkpoint(void) {
+    char path[LOG_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/checkpoint", wal.directory);
+    int first_segment = 1;
+    restored_count = 0;
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return first_segment;
+    }
+    char line[MAX_TOOL_NAME + 64];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        uint64_t offset;
+        int consumed = 0;
+        if (sscanf(line, "first_segment %d", &first_segment) == 1) {
+            continue;
+        }
+        if (sscanf(line, "tool %" SCNu64 " %n", &offset, &consumed) == 1 && consumed > 0 &&
+            restored_count < MAX_TOOLS) {
+            LogOffset* entry = &restored[restored_count++];
+            strncpy(entry->name, line + consumed, MAX_TOOL_NAME - 1);
+            entry->name[MAX_TOOL_NAME - 1] = '\0';
+            entry->offset = offset;
+        }
+    }
+    fclose(file);
+    return first_segment > 0 ? first_segment : 1;
+}
+
+// Header of the record at data (size bytes available), if it is whole and
+// intact
+static bool record_valid(const char* data, size_t size, LogRecord* header) {
+    if (size < sizeof(LogRecord)) {
+        return false;
+    }
+    memcpy(header, data, sizeof(LogRecord));
+    return header->length < LOG_MAX_RECORD &&
+           (size_t)header->type_len + header->sender_len <= header->length &&
+           header->type_len < MAX_EVENT_TYPE && header->sender_len < MAX_TOOL_NAME &&
+           header->priority < EVENT_PRIORITY_COUNT &&
+           header->length <= size - sizeof(LogRecord) &&
+           record_checksum(header, data + sizeof(LogRecord)) == header->checksum;
+}
+
+// Index a segment's valid records and find its last LSN and timestamp. A
+// bad record ends the segment.
+static void scan_segment(int number, LogSegment* segment, uint64_t* last_lsn,
+                         uint64_t* last_time_ms) {
+    char path[LOG_PATH_MAX];
+    segment_path(path, sizeof(path), number);
+    const char* data = NULL;
+    size_t size = 0;
+    if (platform_map_file(path, &data, &size) != FW_OK) {
+        return;
+    }
+    size_t offset = 0;
+    LogRecord header;
+    while (offset < size && record_valid(data + offset, size - offset, &header)) {
+        if (segment->first_lsn == 0) {
+            segment->first_lsn = header.lsn;
+        }
+        index_add(segment, &header, offset);
+        if (header.lsn > *last_lsn) {
+            *last_lsn = header.lsn;
+        }
+        if (header.timestamp_ms > *last_time_ms) {
+            *last_time_ms = header.timestamp_ms;
+        }
+        offset += sizeof(LogRecord) + header.length;
+    }
+    platform_unmap_file(data, size);
+}
+
+int event_log_open(const char* directory, int sync_ms, size_t segment_size) {
+    if (!directory || !*directory) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (atomic_load(&wal.open)) {
+        return FW_ERROR_ALREADY_EXISTS;
+    }
+    if (platform_make_dir(directory) != FW_OK) {
+        LOG_ERROR("event_log", "Cannot create event log directory %s", directory);
+        return FW_ERROR_IO;
+    }
+
+    memset(&wal, 0, sizeof(wal));
+    strncpy(wal.directory, directory, sizeof(wal.directory) - 1);
+    wal.sync_ms = sync_ms >= 0 ? sync_ms : EVENT_LOG_DEFAULT_SYNC_MS;
+    wal.segment_size = segment_size > 0 ? segment_size : EVENT_LOG_DEFAULT_SEGMENT_SIZE;
+    platform_mutex_init(&wal.lock);
+    platform_mutex_init(&wal.write_lock);
+    platform_mutex_init(&wal.holds.lock);
+
+    // Segments older than the checkpoint's first may be left over from a
+    // crash while deleting them
+    int first_segment = read_checkpoint();
+    char path[LOG_PATH_MAX];
+    for (int number = first_segment - 1; number > 0; number--) {
+        segment_path(path, sizeof(path), number);
+        if (remove(path) != 0) {
+            break;
+        }
+    }
+
+    uint64_t last_lsn = 0;
+    int number = first_segment;
+    for (;; number++) {
+        segment_path(path, sizeof(path), number);
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            break;
+        }
+        fclose(file);
+        if (!segment_add(number, 0)) {
+            break;
+        }
+        scan_segment(number, &wal.segments[wal.segment_count - 1], &last_lsn,
+                     &wal.last_time_ms);
+    }
+    wal.next_lsn = last_lsn + 1;
+    wal.open_lsn = last_lsn;
+    if (segment_open(number) != FW_OK) {
+        for (int i = 0; i < wal.segment_count; i++) {
+            free(wal.segments[i].index);
+        }
+        free(wal.segments);
+        platform_mutex_destroy(&wal.lock);
+        platform_mutex_destroy(&wal.write_lock);
+        platform_mutex_destroy(&wal.holds.lock);
+        memset(&wal, 0, sizeof(wal));
+        return FW_ERROR_IO;
+    }
+    wal.holds.base = wal.next_lsn;
+    atomic_store(&wal.holds.floor, wal.next_lsn);
+
+    // Tools not in the checkpoint are new: they start at the end
+    for (int i = 0; i < tool_get_count(); i++) {
+        Tool* tool = tool_get_at(i);
+        uint64_t offset = last_lsn;
+        for (int j = 0; j < restored_count; j++) {
+            if (strcmp(restored[j].name, tool->name) == 0 && restored[j].offset < last_lsn) {
+                offset = restored[j].offset;
+                break;
+            }
+        }
+        atomic_store(&tool->log_acked, offset);
+        atomic_store(&tool->log_owed, offset);
+        tool->log_queued = offset;
+    }
+
+    atomic_store(&wal.synced_lsn, last_lsn);
+    wal.next_checkpoint_ms = platform_monotonic_ms() + EVENT_LOG_CHECKPOINT_MS;
+    atomic_store(&wal.open, true);
+    atomic_store(&wal.running, true);
+    if (platform_thread_create(&wal.thread, flusher_main, NULL) != FW_OK) {
+        LOG_ERROR("event_log", "Cannot start the event log flusher");
+        atomic_store(&wal.running, false);
+        event_log_close();
+        return FW_ERROR_GENERIC;
+    }
+
+    LOG_INFO("event_log", "Event log %s opened at LSN %" PRIu64 " (%d segments, sync %d ms)",
+             directory, last_lsn, wal.segment_count, wal.sync_ms);
+    return FW_OK;
+}
+
+uint64_t event_log_replay(void) {
+    if (!atomic_load(&wal.open)) {
+        return 0;
+    }
+    uint64_t from = UINT64_MAX;
+    for (int i = 0; i < tool_get_count(); i++) {
+        uint64_t offset = atomic_load(&tool_get_at(i)->log_acked);
+        if (offset < from) {
+            from = offset;
+        }
+    }
+    if (from >= wal.open_lsn) {
+        return 0;  // No tools, or every tool is past what was recovered
+    }
+
+    EventLogCursor* cursor = event_log_seek_lsn(from + 1);
+    if (!cursor) {
+        return 0;
+    }
+    uint64_t replayed = 0;
+    EventLogRecord record;
+    while (event_log_cursor_next(cursor, &record) && record.lsn <= wal.open_lsn) {
+        if (event_replay(record.lsn, record.priority, record.type, record.sender,
+                         record.data) > 0) {
+            replayed++;
+        }
+    }
+    event_log_cursor_close(cursor);
+    atomic_fetch_add_explicit(&wal.replayed, replayed, memory_order_relaxed);
+
+    if (replayed > 0) {
+        LOG_INFO("event_log", "Replayed %" PRIu64 " logged events", replayed);
+    }
+    return replayed;
+}
+
+void event_log_close(void) {
+    if (!atomic_load(&wal.open)) {
+        return;
+    }
+    if (atomic_exchange(&wal.running, false)) {
+        platform_thread_join(wal.thread);
+    }
+    event_log_checkpoint();
+    log_flush();
+    atomic_store(&wal.open, false);
+
+    if (wal.file) {
+        fclose(wal.file);
+    }
+    free(wal.pending.data);
+    free(wal.writing.data);
+    for (int i = 0; i < wal.segment_count; i++) {
+        free(wal.segments[i].index);
+    }
+    free(wal.segments);
+    free(wal.holds.counts);
+    platform_mutex_destroy(&wal.lock);
+    platform_mutex_destroy(&wal.write_lock);
+    platform_mutex_destroy(&wal.holds.lock);
+    LOG_INFO("event_log", "Event log closed at LSN %" PRIu64, wal.next_lsn - 1);
+    memset(&wal, 0, sizeof(wal));
+}
+
+bool event_log_is_open(void) {
+    return atomic_load(&wal.open);
+}
+
+// ============================================================================
+// Appending and checkpoints
+// ============================================================================
+
+// Track the LSN about to be appended, with the append's own hold (wal.lock
+// held)
+static bool holds_push(void) {
+    LogHolds* holds = &wal.holds;
+    platform_mutex_lock(&holds->lock);
+    if (holds->length == holds->capacity) {
+        size_t capacity = holds->capacity ? holds->capacity * 2 : 1024;
+        uint32_t* counts = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        if (!counts) {
+            platform_mutex_unlock(&holds->lock);
+            return false;
+        }
+        for (size_t i = 0; i < holds->length; i++) {
+            counts[i] = holds->counts[(holds->head + i) & (holds->capacity - 1)];
+        }
+        free(holds->counts);
+        holds->counts = counts;
+        holds->capacity = capacity;
+        holds->head = 0;
+    }
+    holds->counts[(holds->head + holds->length) & (holds->capacity - 1)] = 1;
+    holds->length++;
+    platform_mutex_unlock(&holds->lock);
+    return true;
+}
+
+uint64_t event_log_append(EventPriority priority, const char* type, const char* sender,
+                          const char* data) {
+    if (!atomic_load_explicit(&wal.open, memory_order_acquire) || !type || !sender) {
+        return 0;
+    }
+    size_t type_len = strnlen(type, MAX_EVENT_TYPE - 1);
+    size_t sender_len = strnlen(sender, MAX_TOOL_NAME - 1);
+    size_t data_len = data ? strlen(data) : 0;
+    size_t length = type_len + sender_len + data_len;
+    if (length >= LOG_MAX_RECORD) {
+        return 0;
+    }
+
+    LogRecord header;
+    memset(&header, 0, sizeof(header));
+    header.length = (uint32_t)length;
+    header.type_len = (uint16_t)type_len;
+    header.sender_len = (uint16_t)sender_len;
+    header.priority = (uint8_t)priority;
+
+    platform_mutex_lock(&wal.lock);
+    if (!buffer_reserve(&wal.pending, sizeof(LogRecord) + length) || !holds_push()) {
+        platform_mutex_unlock(&wal.lock);
+        LOG_ERROR("event_log", "Out of memory logging %s", type);
+        return 0;
+    }
+    header.lsn = wal.next_lsn++;
+    uint64_t now = event_log_time_ms();
+    wal.last_time_ms = now > wal.last_time_ms ? now : wal.last_time_ms;
+    header.timestamp_ms = wal.last_time_ms;
+    char* out = wal.pending.data + wal.pending.length;
+    memcpy(out, &header, sizeof(LogRecord));
+    out += sizeof(LogRecord);
+    memcpy(out, type, type_len);
+    memcpy(out + type_len, sender, sender_len);
+    if (data_len > 0) {
+        memcpy(out + type_len + sender_len, data, data_len);
+    }
+    wal.pending.length += sizeof(LogRecord) + length;
+    platform_mutex_unlock(&wal.lock);
+
+    atomic_fetch_add_explicit(&wal.appended, 1, memory_order_relaxed);
+    if (wal.sync_ms == 0) {
+        log_flush();
+    }
+    return header.lsn;
+}
+
+void event_log_hold(uint64_t lsn, int count) {
+    if (lsn == 0 || count <= 0 || !atomic_load_explicit(&wal.open, memory_order_acquire)) {
+        return;
+    }
+    LogHolds* holds = &wal.holds;
+    platform_mutex_lock(&holds->lock);
+    if (lsn >= holds->base && lsn - holds->base < holds->length) {
+        holds->counts[(holds->head + (lsn - holds->base)) & (holds->capacity - 1)] +=
+            (uint32_t)count;
+    }
+    platform_mutex_unlock(&holds->lock);
+}
+
+void event_log_release(uint64_t lsn) {
+    if (lsn == 0 || !atomic_load_explicit(&wal.open, memory_order_acquire)) {
+        return;
+    }
+    LogHolds* holds = &wal.holds;
+    platform_mutex_lock(&holds->lock);
+    if (lsn >= holds->base && lsn - holds->base < holds->length) {
+        uint32_t* count = &holds->counts[(holds->head + (lsn - holds->base)) &
+                                         (holds->capacity - 1)];
+        if (*count > 0) {
+            (*count)--;
+        }
+        // The floor moves past every LSN at its front that is done with
+        bool moved = false;
+        while (holds->length > 0 && holds->counts[holds->head] == 0) {
+            holds->head = (holds->head + 1) & (holds->capacity - 1);
+            holds->length--;
+            holds->base++;
+            moved = true;
+        }
+        if (moved) {
+            atomic_store_explicit(&holds->floor, holds->base, memory_order_release);
+        }
+    }
+    platform_mutex_unlock(&holds->lock);
+}
+
+uint64_t event_log_floor(void) {
+    return atomic_load_explicit(&wal.holds.floor, memory_order_acquire);
+}
+
+uint64_t event_log_last_lsn(void) {
+    if (!atomic_load(&wal.open)) {
+        return 0;
+    }
+    platform_mutex_lock(&wal.lock);
+    uint64_t lsn = wal.next_lsn - 1;
+    platform_mutex_unlock(&wal.lock);
+    return lsn;
+}
+
+void event_log_flush(void) {
+    if (atomic_load(&wal.open)) {
+        log_flush();
+    }
+}
+
+void event_log_checkpoint(void) {
+    if (!atomic_load(&wal.open)) {
+        return;
+    }
+    LogOffset offsets[MAX_TOOLS];
+    memset(offsets, 0, sizeof(offsets));
+    int count = 0;
+    uint64_t keep = UINT64_MAX;
+    // Read before the offsets: everything below it was in its inboxes
+    // before they were last updated
+    uint64_t floor = event_log_floor();
+    for (int i = 0; i < tool_get_count() && count < MAX_TOOLS; i++) {
+        Tool* tool = tool_get_at(i);
+        uint64_t acked = atomic_load(&tool->log_acked);
+        uint64_t owed = atomic_load(&tool->log_owed);
+        if (acked >= floor) {
+            acked = floor - 1;  // An event before it may still be on its way
+        }
+        snprintf(offsets[count].name, sizeof(offsets[count].name), "%s", tool->name);
+        offsets[count++].offset = acked;
+        if (owed > acked && acked < keep) {
+            keep = acked;  // Still has logged events to write
+        }
+    }
+
+    platform_mutex_lock(&wal.lock);
+    if (count != wal.offset_count || keep != wal.keep_lsn ||
+        memcmp(offsets, wal.offsets, (size_t)count * sizeof(LogOffset)) != 0) {
+        memcpy(wal.offsets, offsets, (size_t)count * sizeof(LogOffset));
+        wal.offset_count = count;
+        wal.keep_lsn = keep;
+        wal.checkpoint_due = true;
+    }
+    platform_mutex_unlock(&wal.lock);
+}
+
+int event_log_run(void) {
+    if (!atomic_load(&wal.open)) {
+        return -1;
+    }
+    uint64_t now = platform_monotonic_ms();
+    if (now >= wal.next_checkpoint_ms) {
+        event_log_checkpoint();
+        wal.next_checkpoint_ms = now + EVENT_LOG_CHECKPOINT_MS;
+    }
+    return (int)(wal.next_checkpoint_ms - now);
+}
+
+void event_log_get_stats(EventLogStats* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(EventLogStats));
+    if (!atomic_load(&wal.open)) {
+        return;
+    }
+    stats->appended = atomic_load_explicit(&wal.appended, memory_order_relaxed);
+    stats->synced_lsn = atomic_load_explicit(&wal.synced_lsn, memory_order_acquire);
+    stats->syncs = atomic_load_explicit(&wal.syncs, memory_order_relaxed);
+    stats->bytes = atomic_load_explicit(&wal.bytes, memory_order_relaxed);
+    stats->replayed = atomic_load_explicit(&wal.replayed, memory_order_relaxed);
+    platform_mutex_lock(&wal.write_lock);
+    stats->segments = wal.segment_count;
+    platform_mutex_unlock(&wal.write_lock);
+}
+
+uint64_t event_log_time_ms(void) {
+    struct timespec ts;
+    if (timespec_get(&ts, TIME_UTC) == 0) {
+        return (uint64_t)time(NULL) * 1000;
+    }
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+// ============================================================================
+// Cursors
+// ============================================================================
+
+// Is the record at entry before the one the cursor looks for?
+static bool cursor_before(const EventLogCursor* cursor, uint64_t lsn, uint64_t timestamp_ms) {
+    return lsn < cursor->min_lsn || timestamp_ms < cursor->min_time_ms;
+}
+
+static void cursor_unmap(EventLogCursor* cursor) {
+    platform_unmap_file(cursor->map, cursor->map_size);
+    cursor->map = NULL;
+    cursor->map_size = 0;
+}
+
+// Map segment number, keeping the read position. False if it is gone.
+static bool cursor_map(EventLogCursor* cursor, int number) {
+    char path[LOG_PATH_MAX];
+    segment_path(path, sizeof(path), number);
+    cursor_unmap(cursor);
+    cursor->number = number;
+    return platform_map_file(path, &cursor->map, &cursor->map_size) == FW_OK;
+}
+
+static EventLogCursor* cursor_create(uint64_t lsn, uint64_t timestamp_ms) {
+    if (!atomic_load(&wal.open)) {
+        return NULL;
+    }
+    EventLogCursor* cursor = (EventLogCursor*)calloc(1, sizeof(EventLogCursor));
+    if (!cursor) {
+        return NULL;
+    }
+    cursor->min_lsn = lsn;
+    cursor->min_time_ms = timestamp_ms;
+
+    // Every record before the last index entry that is still too early is
+    // too early as well, since LSNs and timestamps only grow
+    platform_mutex_lock(&wal.write_lock);
+    int number = wal.segment_count > 0 ? wal.segments[0].number : 0;
+    size_t offset = 0;
+    for (int i = 0; i < wal.segment_count; i++) {
+        const LogSegment* segment = &wal.segments[i];
+        if (segment->index_count == 0) {
+            continue;
+        }
+        if (!cursor_before(cursor, segment->index[0].lsn, segment->index[0].timestamp_ms)) {
+            break;
+        }
+        int low = 0;
+        int high = segment->index_count - 1;
+        while (low < high) {
+            int middle = (low + high + 1) / 2;
+            const LogIndexEntry* entry = &segment->index[middle];
+            if (cursor_before(cursor, entry->lsn, entry->timestamp_ms)) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        number = segment->number;
+        offset = segment->index[low].offset;
+    }
+    platform_mutex_unlock(&wal.write_lock);
+
+    cursor_map(cursor, number);
+    cursor->offset = offset;
+    return cursor;
+}
+
+EventLogCursor* event_log_seek_lsn(uint64_t lsn) {
+    return cursor_create(lsn, 0);
+}
+
+EventLogCursor* event_log_seek_time(uint64_t timestamp_ms) {
+    return cursor_create(0, timestamp_ms);
+}
+
+// Read the record at the cursor from its mapping
+static bool cursor_read(EventLogCursor* cursor, EventLogRecord* record) {
+    LogRecord header;
+    if (!cursor->map || cursor->offset >= cursor->map_size ||
+        !record_valid(cursor->map + cursor->offset, cursor->map_size - cursor->offset, &header)) {
+        return false;
+    }
+    size_t data_len = header.length - header.type_len - header.sender_len;
+    if (data_len + 1 > cursor->data_capacity) {
+        char* data = (char*)realloc(cursor->data, data_len + 1);
+        if (!data) {
+            return false;
+        }
+        cursor->data = data;
+        cursor->data_capacity = data_len + 1;
+    }
+
+    const char* text = cursor->map + cursor->offset + sizeof(LogRecord);
+    record->lsn = header.lsn;
+    record->timestamp_ms = header.timestamp_ms;
+    record->priority = (EventPriority)header.priority;
+    memcpy(record->type, text, header.type_len);
+    record->type[header.type_len] = '\0';
+    memcpy(record->sender, text + header.type_len, header.sender_len);
+    record->sender[header.sender_len] = '\0';
+    memcpy(cursor->data, text + header.type_len + header.sender_len, data_len);
+    cursor->data[data_len] = '\0';
+    record->data = cursor->data;
+    record->data_len = data_len;
+    cursor->offset += sizeof(LogRecord) + header.length;
+    return true;
+}
+
+bool event_log_cursor_next(EventLogCursor* cursor, EventLogRecord* record) {
+    if (!cursor || !record) {
+        return false;
+    }
+    for (;;) {
+        if (cursor_read(cursor, record)) {
+            if (cursor_before(cursor, record->lsn, record->timestamp_ms)) {
+                continue;
+            }
+            return true;
+        }
+
+        // End of the mapping: the segment after it, or more of the one
+        // being written
+        int next = 0;
+        int current = 0;
+        platform_mutex_lock(&wal.write_lock);
+        if (atomic_load(&wal.open) && wal.segment_count > 0) {
+            current = wal.segments[wal.segment_count - 1].number;
+            for (int i = 0; i < wal.segment_count; i++) {
+                if (wal.segments[i].number > cursor->number) {
+                    next = wal.segments[i].number;
+                    break;
+                }
+            }
+        }
+        platform_mutex_unlock(&wal.write_lock);
+
+        if (cursor->number == current && cursor->number != 0) {
+            size_t mapped = cursor->map_size;
+            if (!cursor_map(cursor, current) || cursor->map_size <= mapped) {
+                return false;  // Caught up
+            }
+            continue;
+        }
+        if (next == 0) {
+            return false;
+        }
+        cursor->offset = 0;
+        cursor_map(cursor, next);
+    }
+}
+
+void event_log_cursor_close(EventLogCursor* cursor) {
+    if (!cursor) {
+        return;
+    }
+    cursor_unmap(cursor);
+    free(cursor->data);
+    free(cursor);
+}
@@ -0,0 +1,535 @@
+/**
+ * @file event_loop.c
+ * @brief Readiness-driven main loop support
+ *
+ * Every running tool's stdout/stderr pipe is registered with the poller of
+ * the shard the tool is pinned to. A shard's thread blocks in
+ * event_loop_wait() until one of its pipes is readable, a tool's stdin
+ * becomes writable again, another thread posts work to it or it is woken,
+ * and then only handles the tools that are actually ready.
+ *
+ * A tool's exit fd (its pidfd) is watched by the same shard, so a crash
+ * reaches the main thread as one posted item rather than being found by
+ * polling. Without pidfds the control loop watches the SIGCHLD signalfd.
+ *
+ * In hybrid and busy-poll mode ([core] loop_mode) a loop first polls
+ * without sleeping, so a post or a ready pipe is picked up without the
+ * poster paying for a wakeup syscall or the loop for a reschedule.
+ *
+ * With io_threads = 1 there is a single loop, run by the main thread.
+ * With N > 1 there are N shard loops run by worker threads plus a control
+ * loop without pipes for the main thread.
+ */
+
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/ring.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define cpu_relax() _mm_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+typedef struct {
+    PlatformPoller* poller;
+    PlatformMutex lock;
+    Ring* posted;                   // Work handed over by other threads
+    atomic_bool waiting;            // Blocked in platform_poller_wait()
+    atomic_bool woken;              // event_loop_wakeup() while spinning
+    Tool* pending[MAX_TOOLS];       // Tools with inbox work to deliver
+    int pending_count;
+    atomic_uint_fast64_t waits;     // LoopStats
+    atomic_uint_fast64_t spins;
+    atomic_uint_fast64_t sleeps;
+    atomic_uint_fast64_t empty_sleeps;
+    atomic_uint_fast64_t wakeups;
+} EventLoop;
+
+static EventLoop loops[MAX_IO_THREADS + 1];
+static int loop_count = 0;          // Shards plus the control loop, if any
+static int shard_count = 0;
+static int next_shard = 0;
+
+static THREAD_LOCAL int current_shard = -1;
+
+static LoopMode loop_mode = LOOP_MODE_BLOCKING;
+static uint64_t spin_budget_us = 0;
+static int first_cpu = -1;
+
+// user_data of the SIGCHLD signalfd on the control loop
+static char child_exit_marker;
+static atomic_bool child_exits;
+
+static EventLoop* tool_loop(Tool* tool) {
+    if (!tool || tool->shard < 0 || tool->shard >= shard_count) {
+        return NULL;  // Not running a loop (e.g. unit tests)
+    }
+    return &loops[tool->shard];
+}
+
+int event_loop_init(int shards) {
+    if (shards < 1) {
+        shards = 1;
+    } else if (shards > MAX_IO_THREADS) {
+        shards = MAX_IO_THREADS;
+    }
+
+    memset(loops, 0, sizeof(loops));
+    shard_count = shards;
+    loop_count = shards > 1 ? shards + 1 : 1;
+    next_shard = 0;
+
+    for (int i = 0; i < loop_count; i++) {
+        EventLoop* loop = &loops[i];
+        loop->poller = platform_poller_create();
+        loop->posted = ring_create(LOOP_RING_SIZE);
+        if (!loop->poller || !loop->posted) {
+            LOG_ERROR("event_loop", "Failed to create event loop %d", i);
+            loop_count = i + 1;
+            event_loop_shutdown();
+            return FW_ERROR_GENERIC;
+        }
+        platform_mutex_init(&loop->lock);
+        atomic_init(&loop->waiting, false);
+        atomic_init(&loop->woken, false);
+        atomic_init(&loop->waits, 0);
+        atomic_init(&loop->spins, 0);
+        atomic_init(&loop->sleeps, 0);
+        atomic_init(&loop->empty_sleeps, 0);
+        atomic_init(&loop->wakeups, 0);
+    }
+
+    atomic_init(&child_exits, false);
+    int child_fd = platform_child_exit_fd();
+    if (child_fd >= 0) {
+        platform_poller_add(loops[loop_count - 1].poller, child_fd,
+                            PLATFORM_POLL_READ, &child_exit_marker);
+    }
+
+    LOG_INFO("event_loop", "Event loop initialized (%d I/O shard%s)",
+             shard_count, shard_count > 1 ? "s" : "");
+    return FW_OK;
+}
+
+void event_loop_shutdown(void) {
+    for (int i = 0; i < loop_count; i++) {
+        EventLoop* loop = &loops[i];
+        if (loop->poller) {
+            platform_poller_destroy(loop->poller);
+            platform_mutex_destroy(&loop->lock);
+        }
+        ring_destroy(loop->posted);
+    }
+    memset(loops, 0, sizeof(loops));
+    loop_count = 0;
+    shard_count = 0;
+    LOG_INFO("event_loop", "Event loop shutdown");
+}
+
+int event_loop_shard_count(void) {
+    return shard_count;
+}
+
+int event_loop_control(void) {
+    return loop_count - 1;
+}
+
+int event_loop_assign_shard(void) {
+    if (shard_count == 0) {
+        return -1;
+    }
+    int shard = next_shard;
+    next_shard = (next_shard + 1) % shard_count;
+    return shard;
+}
+
+void event_loop_lock(int shard) {
+    if (shard < 0 || shard >= shard_count) {
+        return;
+    }
+    platform_mutex_lock(&loops[shard].lock);
+    current_shard = shard;
+}
+
+void event_loop_unlock(int shard) {
+    if (shard < 0 || shard >= shard_count) {
+        return;
+    }
+    current_shard = -1;
+    platform_mutex_unlock(&loops[shard].lock);
+}
+
+int event_loop_current_shard(void) {
+    return current_shard;
+}
+
+int event_loop_add_tool(Tool* tool) {
+    if (!tool) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    EventLoop* loop = tool_loop(tool);
+    if (!loop) {
+        tool->exit_fd = -1;  // Nobody would report the exit
+        return FW_OK;
+    }
+
+    tool->stdout_paused = false;
+    int result = platform_poller_add(loop->poller, tool->stdout_fd, PLATFORM_POLL_READ, tool);
+    if (result == FW_OK) {
+        result = platform_poller_add(loop->poller, tool->stderr_fd, PLATFORM_POLL_READ, tool);
+    }
+    if (result == FW_OK && tool->exit_fd >= 0) {
+        tool->exit_watched = platform_poller_add(loop->poller, tool->exit_fd,
+                                                 PLATFORM_POLL_READ, tool) == FW_OK;
+        if (!tool->exit_watched) {
+            tool->exit_fd = -1;  // Left to the liveness sweep
+        }
+    }
+    if (result != FW_OK) {
+        LOG_ERROR("event_loop", "Failed to watch pipes of %s", tool->name);
+        event_loop_remove_tool(tool);
+        return result;
+    }
+
+    // Events may have queued up while the tool was stopped; the shard may
+    // be blocked in its wait while another thread starts the tool
+    if (!tool_queue_is_empty(tool->inbox)) {
+        event_loop_schedule_delivery(tool);
+        event_loop_wakeup(tool->shard);
+    }
+    return FW_OK;
+}
+
+void event_loop_remove_source(Tool* tool, LoopSource source) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop) {
+        return;
+    }
+
+    switch (source) {
+        case LOOP_SOURCE_STDOUT:
+            if (tool->stdout_paused) {
+                tool->stdout_paused = false;   // Not watched already
+            } else {
+                platform_poller_remove(loop->poller, tool->stdout_fd);
+            }
+            break;
+        case LOOP_SOURCE_STDERR:
+            platform_poller_remove(loop->poller, tool->stderr_fd);
+            break;
+        case LOOP_SOURCE_STDIN:
+            if (tool->stdin_watched) {
+                platform_poller_remove(loop->poller, tool->stdin_fd);
+                tool->stdin_watched = false;
+            }
+            break;
+        case LOOP_SOURCE_EXIT:
+            if (tool->exit_watched) {
+                platform_poller_remove(loop->poller, tool->exit_fd);
+                tool->exit_watched = false;
+            }
+            break;
+    }
+}
+
+void event_loop_pause_stdout(Tool* tool) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop || tool->stdout_paused) {
+        return;
+    }
+    if (platform_poller_remove(loop->poller, tool->stdout_fd) == FW_OK) {
+        tool->stdout_paused = true;
+    }
+}
+
+void event_loop_resume_stdout(Tool* tool) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop || !tool->stdout_paused) {
+        return;
+    }
+    tool->stdout_paused = false;
+    if (tool->status == TOOL_RUNNING &&
+        platform_poller_add(loop->poller, tool->stdout_fd, PLATFORM_POLL_READ, tool) != FW_OK) {
+        LOG_ERROR("event_loop", "Failed to watch stdout of %s again", tool->name);
+    }
+}
+
+void event_loop_remove_tool(Tool* tool) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop) {
+        return;
+    }
+
+    event_loop_remove_source(tool, LOOP_SOURCE_STDOUT);
+    event_loop_remove_source(tool, LOOP_SOURCE_STDERR);
+    event_loop_remove_source(tool, LOOP_SOURCE_STDIN);
+    event_loop_remove_source(tool, LOOP_SOURCE_EXIT);
+
+    if (tool->delivery_pending) {
+        for (int i = 0; i < loop->pending_count; i++) {
+            if (loop->pending[i] == tool) {
+                loop->pending[i] = loop->pending[--loop->pending_count];
+                break;
+            }
+        }
+        tool->delivery_pending = false;
+    }
+}
+
+bool event_loop_source(const LoopEvent* event, LoopSource* source) {
+    Tool* tool = event->tool;
+
+    // The pipe may have been closed (and its number reused) since the wait
+    if (tool->status != TOOL_RUNNING) {
+        return false;
+    }
+
+    if (event->fd == tool->stdout_fd) {
+        *source = LOOP_SOURCE_STDOUT;
+    } else if (event->fd == tool->stderr_fd) {
+        *source = LOOP_SOURCE_STDERR;
+    } else if (event->fd == tool->stdin_fd && tool->stdin_watched) {
+        // Writable (or the reader went away): stop watching, deliver
+        event_loop_remove_source(tool, LOOP_SOURCE_STDIN);
+        *source = LOOP_SOURCE_STDIN;
+    } else if (event->fd == tool->exit_fd && tool->exit_watched) {
+        // Stays readable from now on: report it once
+        event_loop_remove_source(tool, LOOP_SOURCE_EXIT);
+        *source = LOOP_SOURCE_EXIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void event_loop_schedule_delivery(Tool* tool) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop || tool->delivery_pending || tool->stdin_watched) {
+        return;  // Already scheduled, or waiting for the pipe to drain
+    }
+    if (loop->pending_count >= MAX_TOOLS) {
+        return;
+    }
+
+    tool->delivery_pending = true;
+    loop->pending[loop->pending_count++] = tool;
+}
+
+int event_loop_take_deliveries(int shard, Tool** tools, int max_tools) {
+    if (shard < 0 || shard >= shard_count) {
+        return 0;
+    }
+    EventLoop* loop = &loops[shard];
+
+    int count = 0;
+    while (loop->pending_count > 0 && count < max_tools) {
+        Tool* tool = loop->pending[--loop->pending_count];
+        tool->delivery_pending = false;
+        tools[count++] = tool;
+    }
+    return count;
+}
+
+void event_loop_watch_writable(Tool* tool) {
+    EventLoop* loop = tool_loop(tool);
+    if (!loop || tool->stdin_watched || tool->stdin_fd < 0) {
+        return;
+    }
+
+    if (platform_poller_add(loop->poller, tool->stdin_fd, PLATFORM_POLL_WRITE, tool) == FW_OK) {
+        tool->stdin_watched = true;
+    } else {
+        // Fall back to retrying on the next pass
+        event_loop_schedule_delivery(tool);
+    }
+}
+
+bool event_loop_post(int shard, void* item) {
+    if (shard < 0 || shard >= loop_count) {
+        return false;
+    }
+    EventLoop* loop = &loops[shard];
+
+    if (!ring_push(loop->posted, item)) {
+        return false;
+    }
+
+    // Pairs with the fence in event_loop_wait(): either the loop sees the
+    // item before it blocks or we see it waiting and wake it
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&loop->waiting, memory_order_relaxed)) {
+        platform_poller_wakeup(loop->poller);
+    }
+    return true;
+}
+
+void* event_loop_take_posted(int shard) {
+    if (shard < 0 || shard >= loop_count) {
+        return NULL;
+    }
+    return ring_pop(loops[shard].posted);
+}
+
+static void stat_add(atomic_uint_fast64_t* counter) {
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+static bool loop_has_work(EventLoop* loop) {
+    return loop->pending_count > 0 || !ring_is_empty(loop->posted);
+}
+
+// Poll without sleeping until a pipe is ready, work is posted, the loop is
+// woken or budget_us passes (UINT64_MAX = never). Returns the ready count
+// (0 if woken or given work) and sets *expired if the budget ran out first.
+static int loop_spin(EventLoop* loop, PlatformPollEvent* ready, int max_events,
+                     uint64_t budget_us, bool* expired) {
+    uint64_t start = platform_monotonic_us();
+    *expired = false;
+
+    for (;;) {
+        int n = platform_poller_wait(loop->poller, ready, max_events, 0);
+        if (n != 0) {
+            return n;
+        }
+        if (atomic_exchange_explicit(&loop->woken, false, memory_order_acquire) ||
+            loop_has_work(loop)) {
+            return 0;
+        }
+        stat_add(&loop->spins);
+        if (budget_us != UINT64_MAX && platform_monotonic_us() - start >= budget_us) {
+            *expired = true;
+            return 0;
+        }
+        cpu_relax();
+    }
+}
+
+int event_loop_wait(int shard, LoopEvent* events, int max_events, int timeout_ms) {
+    if (!events || max_events <= 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (shard < 0 || shard >= loop_count) {
+        platform_sleep_ms(timeout_ms > 0 ? timeout_ms : 0);
+        return 0;
+    }
+    EventLoop* loop = &loops[shard];
+
+    if (max_events > LOOP_MAX_EVENTS) {
+        max_events = LOOP_MAX_EVENTS;
+    }
+    stat_add(&loop->waits);
+
+    PlatformPollEvent ready[LOOP_MAX_EVENTS];
+    int n = 0;
+    bool sleep = true;
+
+    if (loop_mode != LOOP_MODE_BLOCKING && timeout_ms != 0 && !loop_has_work(loop)) {
+        uint64_t budget = spin_budget_us;
+        if (loop_mode == LOOP_MODE_BUSY_POLL) {
+            budget = timeout_ms < 0 ? UINT64_MAX : (uint64_t)timeout_ms * 1000;
+        }
+        bool expired;
+        n = loop_spin(loop, ready, max_events, budget, &expired);
+        // Busy-poll spins out the whole timeout; hybrid sleeps after its spin
+        sleep = expired && loop_mode == LOOP_MODE_HYBRID;
+    }
+
+    if (sleep) {
+        atomic_store_explicit(&loop->waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (loop_has_work(loop) ||
+            atomic_exchange_explicit(&loop->woken, false, memory_order_relaxed)) {
+            timeout_ms = 0;  // Work is waiting: just collect ready pipes
+        }
+
+        n = platform_poller_wait(loop->poller, ready, max_events, timeout_ms);
+        atomic_store_explicit(&loop->waiting, false, memory_order_relaxed);
+        if (timeout_ms != 0) {
+            stat_add(&loop->sleeps);
+            if (n == 0 && !loop_has_work(loop)) {
+                stat_add(&loop->empty_sleeps);
+            }
+        }
+    }
+
+    if (n < 0) {
+        LOG_ERROR("event_loop", "Poller wait failed: %d", n);
+        return n;
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (!ready[i].user_data) {
+            continue;
+        }
+        if (ready[i].user_data == &child_exit_marker) {
+            platform_child_exit_drain();
+            atomic_store_explicit(&child_exits, true, memory_order_release);
+            continue;
+        }
+        events[count].tool = (Tool*)ready[i].user_data;
+        events[count].fd = ready[i].fd;
+        events[count].hangup = (ready[i].events & PLATFORM_POLL_HANGUP) != 0;
+        count++;
+    }
+
+    return count;
+}
+
+void event_loop_wakeup(int shard) {
+    if (shard < 0 || shard >= loop_count) {
+        return;
+    }
+    EventLoop* loop = &loops[shard];
+
+    // A spinning loop sees the flag on its next poll
+    if (loop_mode != LOOP_MODE_BLOCKING) {
+        atomic_store_explicit(&loop->woken, true, memory_order_release);
+    }
+
+    // Only a blocked loop needs the syscall; a busy one checks for work
+    // before it waits again
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&loop->waiting, memory_order_relaxed)) {
+        stat_add(&loop->wakeups);
+        platform_poller_wakeup(loop->poller);
+    }
+}
+
+void event_loop_set_mode(LoopMode mode, int spin_us, int cpu) {
+    loop_mode = mode;
+    spin_budget_us = spin_us > 0 ? (uint64_t)spin_us : 0;
+    first_cpu = cpu;
+}
+
+LoopMode event_loop_mode(void) {
+    return loop_mode;
+}
+
+void event_loop_pin(int shard) {
+    if (first_cpu >= 0 && shard >= 0 && shard < loop_count) {
+        platform_pin_thread(first_cpu + shard);
+    }
+}
+
+void event_loop_get_stats(int shard, LoopStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (shard < 0 || shard >= loop_count) {
+        return;
+    }
+    EventLoop* loop = &loops[shard];
+    stats->waits = atomic_load_explicit(&loop->waits, memory_order_relaxed);
+    stats->spins = atomic_load_explicit(&loop->spins, memory_order_relaxed);
+    stats->sleeps = atomic_load_explicit(&loop->sleeps, memory_order_relaxed);
+    stats->empty_sleeps = atomic_load_explicit(&loop->empty_sleeps, memory_order_relaxed);
+    stats->wakeups = atomic_load_explicit(&loop->wakeups, memory_order_relaxed);
+}
+
+bool event_loop_take_child_exits(void) {
+    return atomic_exchange_explicit(&child_exits, false, memory_order_acquire);
+}
@@ -0,0 +1,186 @@
+/**
+ * @file event_type.c
+ * @brief Event type intern table
+ *
+ * Entries live in fixed chunks that are allocated as IDs are handed out and
+ * never move, so a name or counter can be reached from its ID without a
+ * lock. The index from string to ID is an open-addressing table of IDs
+ * twice the size of the ID space, so it never fills or grows.
+ *
+ * A new type is written into its entry before its ID is stored in the
+ * index (release), and readers load index slots with acquire, so a reader
+ * that finds an ID sees the whole entry.
+ */
+
+#include "yuki_frame/event_type.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_SHIFT 8
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define CHUNK_COUNT (EVENT_TYPE_MAX_IDS / CHUNK_SIZE)
+#define INDEX_SIZE (EVENT_TYPE_MAX_IDS * 2)
+
+typedef struct {
+    uint32_t hash;
+    atomic_int priority;
+    atomic_uint_fast64_t routed;
+    atomic_uint_fast64_t delivered;
+    char name[MAX_EVENT_TYPE];
+} TypeEntry;
+
+static _Atomic(TypeEntry*) chunks[CHUNK_COUNT];
+static _Atomic(EventTypeId) index_slots[INDEX_SIZE];
+static _Atomic(uint32_t) type_count = 0;
+static atomic_flag interning = ATOMIC_FLAG_INIT;
+
+// FNV-1a
+static uint32_t type_hash(const char* type, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)type[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static TypeEntry* type_entry(EventTypeId id) {
+    TypeEntry* chunk = atomic_load_explicit(&chunks[(id - 1) >> CHUNK_SHIFT], memory_order_acquire);
+    return &chunk[(id - 1) & (CHUNK_SIZE - 1)];
+}
+
+// ID of type, or EVENT_TYPE_NONE with *slot set to where it would go
+static EventTypeId type_lookup(const char* type, size_t length, uint32_t hash, uint32_t* slot) {
+    uint32_t index = hash & (INDEX_SIZE - 1);
+    for (;;) {
+        EventTypeId id = atomic_load_explicit(&index_slots[index], memory_order_acquire);
+        if (id == EVENT_TYPE_NONE) {
+            *slot = index;
+            return EVENT_TYPE_NONE;
+        }
+        const TypeEntry* entry = type_entry(id);
+        if (entry->hash == hash && memcmp(entry->name, type, length + 1) == 0) {
+            return id;
+        }
+        index = (index + 1) & (INDEX_SIZE - 1);
+    }
+}
+
+EventTypeId event_type_find(const char* type) {
+    if (!type) {
+        return EVENT_TYPE_NONE;
+    }
+    size_t length = strnlen(type, MAX_EVENT_TYPE);
+    if (length >= MAX_EVENT_TYPE) {
+        return EVENT_TYPE_NONE;
+    }
+    uint32_t slot;
+    return type_lookup(type, length, type_hash(type, length), &slot);
+}
+
+EventTypeId event_type_intern(const char* type) {
+    if (!type) {
+        return EVENT_TYPE_NONE;
+    }
+    size_t length = strnlen(type, MAX_EVENT_TYPE);
+    if (length >= MAX_EVENT_TYPE) {
+        return EVENT_TYPE_NONE;
+    }
+    uint32_t hash = type_hash(type, length);
+    uint32_t slot;
+    EventTypeId id = type_lookup(type, length, hash, &slot);
+    if (id != EVENT_TYPE_NONE) {
+        return id;
+    }
+
+    while (atomic_flag_test_and_set_explicit(&interning, memory_order_acquire)) {
+        // New types are rare after startup
+    }
+
+    // Another thread may have added it, or taken the slot, meanwhile
+    id = type_lookup(type, length, hash, &slot);
+    uint32_t count = atomic_load_explicit(&type_count, memory_order_relaxed);
+    if (id == EVENT_TYPE_NONE && count < EVENT_TYPE_MAX_IDS) {
+        id = count + 1;
+        size_t chunk_index = (id - 1) >> CHUNK_SHIFT;
+        TypeEntry* chunk = atomic_load_explicit(&chunks[chunk_index], memory_order_relaxed);
+        if (!chunk) {
+            chunk = (TypeEntry*)calloc(CHUNK_SIZE, sizeof(TypeEntry));
+            atomic_store_explicit(&chunks[chunk_index], chunk, memory_order_release);
+        }
+        if (chunk) {
+            TypeEntry* entry = &chunk[(id - 1) & (CHUNK_SIZE - 1)];
+            entry->hash = hash;
+            atomic_init(&entry->priority, EVENT_PRIORITY_NORMAL);
+            memcpy(entry->name, type, length + 1);
+            atomic_store_explicit(&type_count, id, memory_order_release);
+            atomic_store_explicit(&index_slots[slot], id, memory_order_release);
+        } else {
+            id = EVENT_TYPE_NONE;  // Out of memory
+        }
+    }
+
+    atomic_flag_clear_explicit(&interning, memory_order_release);
+    return id;
+}
+
+const char* event_type_name(EventTypeId id) {
+    if (id == EVENT_TYPE_NONE || id > atomic_load_explicit(&type_count, memory_order_acquire)) {
+        return NULL;
+    }
+    return type_entry(id)->name;
+}
+
+uint32_t event_type_count(void) {
+    return atomic_load_explicit(&type_count, memory_order_acquire);
+}
+
+void event_type_set_priority(EventTypeId id, EventPriority priority) {
+    if (id == EVENT_TYPE_NONE || id > atomic_load_explicit(&type_count, memory_order_acquire) ||
+        priority < 0 || priority >= EVENT_PRIORITY_COUNT) {
+        return;
+    }
+    atomic_store_explicit(&type_entry(id)->priority, (int)priority, memory_order_relaxed);
+}
+
+EventPriority event_type_priority(EventTypeId id) {
+    if (id == EVENT_TYPE_NONE || id > atomic_load_explicit(&type_count, memory_order_acquire)) {
+        return EVENT_PRIORITY_NORMAL;
+    }
+    return (EventPriority)atomic_load_explicit(&type_entry(id)->priority, memory_order_relaxed);
+}
+
+void event_type_count_routed(EventTypeId id, int deliveries) {
+    if (id == EVENT_TYPE_NONE || id > atomic_load_explicit(&type_count, memory_order_acquire)) {
+        return;
+    }
+    TypeEntry* entry = type_entry(id);
+    atomic_fetch_add_explicit(&entry->routed, 1, memory_order_relaxed);
+    if (deliveries > 0) {
+        atomic_fetch_add_explicit(&entry->delivered, (uint64_t)deliveries, memory_order_relaxed);
+    }
+}
+
+void event_type_get_stats(EventTypeId id, EventTypeStats* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(EventTypeStats));
+    if (id == EVENT_TYPE_NONE || id > atomic_load_explicit(&type_count, memory_order_acquire)) {
+        return;
+    }
+    TypeEntry* entry = type_entry(id);
+    stats->routed = atomic_load_explicit(&entry->routed, memory_order_relaxed);
+    stats->delivered = atomic_load_explicit(&entry->delivered, memory_order_relaxed);
+}
+
+void event_types_shutdown(void) {
+    for (int i = 0; i < CHUNK_COUNT; i++) {
+        free(atomic_exchange(&chunks[i], NULL));
+    }
+    for (int i = 0; i < INDEX_SIZE; i++) {
+        atomic_store_explicit(&index_slots[i], EVENT_TYPE_NONE, memory_order_relaxed);
+    }
+    atomic_store(&type_count, 0);
+}
@@ -0,0 +1,177 @@
+/**
+ * @file flow_control.c
+ * @brief Memory budget for queued events and publisher backpressure
+ *
+ * Usage is kept in relaxed atomics: the shards charge each routed event
+ * and whoever drops the last reference to it releases it. The pressure
+ * flag flips with a compare-and-swap at the watermarks, so each crossing
+ * is counted once; when it clears, every shard is told to resume the
+ * publishers it paused. A tool's account keeps its queued bytes and an
+ * owner bit in one counter, so whoever clears the last of both frees it
+ * without a lock, even on another shard after the tool is gone.
+ */
+
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t limit = FLOW_DEFAULT_MEMORY_LIMIT;
+static size_t high_watermark = FLOW_DEFAULT_MEMORY_LIMIT / 100 * FLOW_DEFAULT_HIGH_WATERMARK;
+static size_t low_watermark = FLOW_DEFAULT_MEMORY_LIMIT / 100 * FLOW_DEFAULT_LOW_WATERMARK;
+
+static atomic_size_t used = 0;
+static atomic_size_t peak = 0;
+static atomic_size_t publisher_bytes = 0;   // Part of used charged to tools
+static atomic_int active_publishers = 0;    // Tools with bytes queued
+static atomic_bool pressure = false;
+static atomic_uint_fast64_t pressure_count = 0;
+static atomic_uint_fast64_t pauses = 0;
+static atomic_uint_fast64_t rejected = 0;
+
+static THREAD_LOCAL Tool* current_publisher = NULL;
+
+void flow_init(size_t memory_limit, int high_percent, int low_percent) {
+    if (high_percent <= 0 || high_percent > 100) {
+        high_percent = FLOW_DEFAULT_HIGH_WATERMARK;
+    }
+    if (low_percent <= 0 || low_percent > high_percent) {
+        low_percent = high_percent < FLOW_DEFAULT_LOW_WATERMARK ? high_percent
+                                                                 : FLOW_DEFAULT_LOW_WATERMARK;
+    }
+    limit = memory_limit > 0 ? memory_limit : FLOW_DEFAULT_MEMORY_LIMIT;
+    high_watermark = limit / 100 * (size_t)high_percent;
+    low_watermark = limit / 100 * (size_t)low_percent;
+
+    atomic_store(&peak, atomic_load(&used));
+    atomic_store(&pressure, false);
+    atomic_store(&pressure_count, 0);
+    atomic_store(&pauses, 0);
+    atomic_store(&rejected, 0);
+}
+
+FlowAccount* flow_account_create(void) {
+    FlowAccount* account = malloc(sizeof(FlowAccount));
+    if (account) {
+        atomic_init(&account->held, FLOW_ACCOUNT_OWNED);
+    }
+    return account;
+}
+
+void flow_account_close(FlowAccount* account) {
+    if (account && atomic_fetch_sub_explicit(&account->held, FLOW_ACCOUNT_OWNED,
+                                             memory_order_acq_rel) == FLOW_ACCOUNT_OWNED) {
+        free(account);
+    }
+}
+
+size_t flow_account_bytes(const FlowAccount* account) {
+    if (!account) {
+        return 0;
+    }
+    return atomic_load_explicit(&account->held, memory_order_relaxed) & ~FLOW_ACCOUNT_OWNED;
+}
+
+void flow_charge(FlowAccount* publisher, size_t bytes) {
+    size_t now = atomic_fetch_add_explicit(&used, bytes, memory_order_relaxed) + bytes;
+    size_t highest = atomic_load_explicit(&peak, memory_order_relaxed);
+    while (now > highest &&
+           !atomic_compare_exchange_weak_explicit(&peak, &highest, now,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    if (publisher) {
+        size_t held = atomic_fetch_add_explicit(&publisher->held, bytes, memory_order_relaxed);
+        if ((held & ~FLOW_ACCOUNT_OWNED) == 0) {
+            atomic_fetch_add_explicit(&active_publishers, 1, memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&publisher_bytes, bytes, memory_order_relaxed);
+    }
+
+    if (now >= high_watermark && !atomic_load_explicit(&pressure, memory_order_relaxed)) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&pressure, &expected, true)) {
+            // Warn once; the counters show how often it happens after that
+            if (atomic_fetch_add_explicit(&pressure_count, 1, memory_order_relaxed) == 0) {
+                LOG_WARN("flow", "Queued events at %zu bytes, pausing the busiest publishers", now);
+            } else {
+                LOG_DEBUG("flow", "Queued events at %zu bytes, pausing the busiest publishers", now);
+            }
+        }
+    }
+}
+
+bool flow_reserve(size_t bytes) {
+    if (atomic_load_explicit(&used, memory_order_relaxed) + bytes > limit) {
+        atomic_fetch_add_explicit(&rejected, 1, memory_order_relaxed);
+        return false;
+    }
+    flow_charge(NULL, bytes);
+    return true;
+}
+
+void flow_release(FlowAccount* publisher, size_t bytes) {
+    if (publisher) {
+        atomic_fetch_sub_explicit(&publisher_bytes, bytes, memory_order_relaxed);
+        size_t held = atomic_fetch_sub_explicit(&publisher->held, bytes,
+                                                memory_order_acq_rel) - bytes;
+        if ((held & ~FLOW_ACCOUNT_OWNED) == 0) {
+            atomic_fetch_sub_explicit(&active_publishers, 1, memory_order_relaxed);
+        }
+        if (held == 0) {
+            free(publisher);   // Its tool is gone
+        }
+    }
+    size_t now = atomic_fetch_sub_explicit(&used, bytes, memory_order_relaxed) - bytes;
+
+    if (now <= low_watermark && atomic_load_explicit(&pressure, memory_order_relaxed)) {
+        bool expected = true;
+        if (atomic_compare_exchange_strong(&pressure, &expected, false)) {
+            LOG_DEBUG("flow", "Queued events down to %zu bytes, resuming publishers", now);
+            io_worker_resume_publishers();
+        }
+    }
+}
+
+void flow_set_publisher(Tool* publisher) {
+    current_publisher = publisher;
+}
+
+Tool* flow_publisher(void) {
+    return current_publisher;
+}
+
+bool flow_under_pressure(void) {
+    return atomic_load_explicit(&pressure, memory_order_relaxed);
+}
+
+bool flow_should_pause(const FlowAccount* publisher) {
+    if (!atomic_load_explicit(&pressure, memory_order_relaxed)) {
+        return false;
+    }
+    size_t bytes = flow_account_bytes(publisher);
+    int active = atomic_load_explicit(&active_publishers, memory_order_relaxed);
+    size_t total = atomic_load_explicit(&publisher_bytes, memory_order_relaxed);
+    return bytes > 0 && active > 0 && bytes * (size_t)active >= total;
+}
+
+void flow_count_pause(void) {
+    atomic_fetch_add_explicit(&pauses, 1, memory_order_relaxed);
+}
+
+void flow_get_stats(FlowStats* stats) {
+    memset(stats, 0, sizeof(FlowStats));
+    stats->limit = limit;
+    stats->high_watermark = high_watermark;
+    stats->low_watermark = low_watermark;
+    stats->used = atomic_load(&used);
+    stats->peak = atomic_load(&peak);
+    stats->pressure = atomic_load(&pressure);
+    stats->pressure_count = atomic_load(&pressure_count);
+    stats->pauses = atomic_load(&pauses);
+    stats->rejected = atomic_load(&rejected);
+}
@@ -0,0 +1,633 @@
+/**
+ * @file io_worker.c
+ * @brief I/O shards: tool pipe reading, routing and delivery
+ *
+ * Each tool is pinned to one shard. The shard's thread is the only one
+ * that reads the tool's stdout/stderr, touches its inbox and writes its
+ * stdin. Events a tool publishes are routed on the publishing shard and
+ * handed to each subscriber's shard through that shard's ring, so shards
+ * never wait for each other.
+ *
+ * Anything that changes tool lifecycle or subscriptions (SUBSCRIBE,
+ * TOOL_READY, COMMAND lines, hung-up pipes, on-demand starts) is posted to
+ * the main thread's control loop instead of being handled on the shard.
+ */
+
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/line_framer.h"
+#include "yuki_frame/log_framer.h"
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/dedup.h"
+#include "yuki_frame/request.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/logger.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Most stdout bytes read from one tool per wakeup, so a tool that writes
+// faster than we route cannot starve the others on its shard
+#define STDOUT_READ_BUDGET (1024 * 1024)
+
+// Same for stderr, which only feeds the log; read in chunks of this size
+#define STDERR_READ_BUDGET (256 * 1024)
+#define STDERR_READ_CHUNK (16 * 1024)
+
+static PlatformThread workers[MAX_IO_THREADS];
+static int worker_count = 0;
+
+// Control work the main thread took off its own shard's ring (one shard)
+static WorkItem* backlog_head = NULL;
+static WorkItem* backlog_tail = NULL;
+
+static void forget_paused_tool(int shard, const Tool* tool);
+
+static WorkItem* work_alloc(WorkType type, Tool* tool, size_t text_size) {
+    WorkItem* item = (WorkItem*)malloc(sizeof(WorkItem) + text_size);
+    if (item) {
+        memset(item, 0, sizeof(WorkItem));
+        item->type = type;
+        item->tool = tool;
+    }
+    return item;
+}
+
+// A delivery of a logged event is over: in the inbox, refused or dropped
+static void delivery_done(uint64_t lsn, bool held) {
+    if (held) {
+        event_log_release(lsn);
+    }
+}
+
+void io_worker_free(WorkItem* item) {
+    if (!item) {
+        return;
+    }
+    if (item->type == WORK_DELIVER) {
+        delivery_done(item->buffer->lsn, item->buffer->log_held);
+        event_buffer_release(item->buffer);
+    } else if (item->type == WORK_RETIRE) {
+        tool_destroy(item->tool);
+    }
+    free(item);
+}
+
+// ============================================================================
+// Delivery (shard side)
+// ============================================================================
+
+// Queue an event for a tool on its own shard (shard lock held)
+static int accept_delivery(Tool* tool, EventBuffer* buffer) {
+    uint64_t lsn = buffer->lsn;
+    bool held = buffer->log_held;
+    if (tool->retired) {
+        event_buffer_release(buffer);   // Routed before it was unregistered
+        delivery_done(lsn, held);
+        return FW_ERROR_NOT_FOUND;
+    }
+
+    if (lsn > tool->log_queued) {
+        // A refused event counts as handled too, so it is not replayed
+        tool->log_queued = lsn;
+    }
+    int result = tool_queue_add_buffer(tool->inbox, buffer);
+    if (lsn != 0) {
+        tool_update_log_offset(tool);
+    }
+    delivery_done(lsn, held);   // After the offset that accounts for it
+    if (result != FW_OK) {
+        LOG_ERROR("event", "Failed to queue event for %s: %d", tool->name, result);
+        return result;
+    }
+
+    LOG_DEBUG("event", "Queued event for tool: %s (queue: %d/%d)",
+             tool->name, tool_queue_count(tool->inbox), tool_queue_capacity(tool->inbox));
+
+    if (tool->idle_timeout_sec > 0) {
+        // Read by the idle timer on the main thread
+        atomic_store_explicit(&tool->last_active_ms, platform_monotonic_ms(),
+                              memory_order_relaxed);
+    }
+
+    if (tool->status == TOOL_RUNNING) {
+        event_loop_schedule_delivery(tool);
+    } else if (tool->is_on_demand && tool->status == TOOL_STOPPED && !tool->is_starting) {
+        // On-demand tool support: the main thread starts it
+        LOG_INFO("event", "Starting on-demand tool: %s", tool->name);
+        tool->is_starting = true;
+        io_worker_post_control(WORK_START_TOOL, tool, NULL, NULL, NULL);
+    }
+    return FW_OK;
+}
+
+int io_worker_deliver(Tool* tool, EventBuffer* buffer) {
+    if (!tool || !buffer) {
+        if (buffer) {
+            delivery_done(buffer->lsn, buffer->log_held);
+        }
+        event_buffer_release(buffer);
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    int shard = tool->shard;
+    if (shard < 0 || shard == event_loop_current_shard()) {
+        return accept_delivery(tool, buffer);
+    }
+
+    WorkItem* item = work_alloc(WORK_DELIVER, tool, 0);
+    if (!item) {
+        delivery_done(buffer->lsn, buffer->log_held);
+        event_buffer_release(buffer);
+        return FW_ERROR_MEMORY;
+    }
+    item->buffer = buffer;
+
+    if (!event_loop_post(shard, item)) {
+        LOG_WARN("event", "Shard %d ring full, dropped event for %s", shard, tool->name);
+        io_worker_free(item);
+        return FW_ERROR_QUEUE_FULL;
+    }
+    return FW_OK;
+}
+
+// Deliver queued events to the tools the shard has scheduled
+static void deliver_queued_events(int shard) {
+    Tool* tools[MAX_TOOLS];
+    int count = event_loop_take_deliveries(shard, tools, MAX_TOOLS);
+
+    for (int t = 0; t < count; t++) {
+        Tool* tool = tools[t];
+
+        // Write as much of the inbox as the pipe takes, in batches
+        int result = tool_flush_inbox(tool);
+        tool_update_log_offset(tool);
+
+        if (result == FW_ERROR_QUEUE_FULL) {
+            // Pipe full, leave the rest queued until stdin is writable again
+            LOG_TRACE("io_worker", "Tool %s pipe full, waiting for it to drain (queue: %d)",
+                     tool->name, tool_queue_count(tool->inbox));
+            event_loop_watch_writable(tool);
+        } else if (result == FW_ERROR_IO) {
+            // Reader is gone: drop the event that failed, as before
+            tool_queue_remove(tool->inbox);
+        }
+    }
+}
+
+int io_worker_retire(Tool* tool) {
+    WorkItem* item = work_alloc(WORK_RETIRE, tool, 0);
+    if (!item) {
+        return FW_ERROR_MEMORY;
+    }
+    if (!event_loop_post(tool->shard, item)) {
+        free(item);
+        return FW_ERROR_QUEUE_FULL;
+    }
+    return FW_OK;
+}
+
+void io_worker_resume_publishers(void) {
+    for (int shard = 0; shard < event_loop_shard_count(); shard++) {
+        WorkItem* item = work_alloc(WORK_RESUME, NULL, 0);
+        if (item && !event_loop_post(shard, item)) {
+            free(item);   // Ring full: the shard is busy and checks on its next pass
+        }
+    }
+}
+
+// ============================================================================
+// Control work (main thread side)
+// ============================================================================
+
+int io_worker_post_control(WorkType type, Tool* tool,
+                           const char* type_name, const char* sender, const char* data) {
+    size_t type_len = type_name ? strlen(type_name) : 0;
+    size_t sender_len = sender ? strlen(sender) : 0;
+    size_t data_len = data ? strlen(data) : 0;
+
+    WorkItem* item = work_alloc(type, tool, type_len + sender_len + data_len + 3);
+    if (!item) {
+        return FW_ERROR_MEMORY;
+    }
+
+    item->type_name = item->text;
+    item->sender = item->type_name + type_len + 1;
+    item->data = item->sender + sender_len + 1;
+    memcpy(item->type_name, type_name ? type_name : "", type_len + 1);
+    memcpy(item->sender, sender ? sender : "", sender_len + 1);
+    memcpy(item->data, data ? data : "", data_len + 1);
+
+    if (!event_loop_post(event_loop_control(), item)) {
+        LOG_ERROR("io_worker", "Control ring full, dropped work item %d", (int)type);
+        free(item);
+        return FW_ERROR_QUEUE_FULL;
+    }
+    return FW_OK;
+}
+
+WorkItem* io_worker_take_control(void) {
+    if (backlog_head) {
+        WorkItem* item = backlog_head;
+        backlog_head = item->next;
+        if (!backlog_head) {
+            backlog_tail = NULL;
+        }
+        return item;
+    }
+
+    WorkItem* item;
+    while ((item = (WorkItem*)event_loop_take_posted(event_loop_control())) != NULL) {
+        if (item->type == WORK_DELIVER) {
+            // One shard: the control loop is shard 0's loop
+            event_loop_lock(item->tool->shard);
+            accept_delivery(item->tool, item->buffer);
+            event_loop_unlock(item->tool->shard);
+            free(item);
+            continue;
+        }
+        if (item->type == WORK_RESUME) {
+            // One shard: resumed by the shard pass that follows
+            free(item);
+            continue;
+        }
+        if (item->type == WORK_RETIRE) {
+            // One shard: its pause list was not looked at on the way
+            event_loop_lock(item->tool->shard);
+            forget_paused_tool(item->tool->shard, item->tool);
+            event_loop_unlock(item->tool->shard);
+        }
+        return item;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Pipe reading (shard side)
+// ============================================================================
+
+// Publish an event from a tool's stdout, numbered in the tool's stream.
+// A message id (sender@<id>) is cut off the sender; an id the tool sent
+// within its dedup window marks a repeat, which is dropped unnumbered.
+static void publish_tool_event(Tool* tool, const char* type, const LineFrame* frame,
+                               EventPriority priority) {
+    const char* id = NULL;
+    size_t id_len = 0;
+    char* at = (char*)memchr(frame->sender, '@', frame->sender_len);
+    if (at) {
+        *at = '\0';
+        id = at + 1;
+        id_len = frame->sender_len - (size_t)(id - frame->sender);
+        if (id_len > 0 && tool->dedup_window > 0) {
+            if (!tool->dedup) {
+                tool->dedup = dedup_create(tool->dedup_window);
+            }
+            if (tool->dedup && dedup_contains(tool->dedup, id, id_len)) {
+                atomic_fetch_add_explicit(&tool->duplicates, 1, memory_order_relaxed);
+                LOG_DEBUG("io_worker", "Dropped repeated %s %s from %s", type, id, tool->name);
+                return;
+            }
+        }
+    }
+    
+    // Only this shard numbers the tool's events, and an event that was
+    // not published neither uses a number nor marks its id as seen, so
+    // the tool can send it again
+    uint64_t seq = atomic_load_explicit(&tool->publish_seq, memory_order_relaxed) + 1;
+    LOG_DEBUG("io_worker", "Publishing event: %s from %s", type, frame->sender);
+    int result = event_publish_sequenced(type, frame->sender, frame->data, priority, seq);
+    if (result != FW_OK) {
+        LOG_WARN("io_worker", "Failed to publish %s from %s: %d", type, tool->name, result);
+        return;
+    }
+    atomic_store_explicit(&tool->publish_seq, seq, memory_order_relaxed);
+    if (id_len > 0 && tool->dedup) {
+        dedup_remember(tool->dedup, id, id_len);
+    }
+}
+
+// Handle one complete line from a tool's stdout: TYPE|sender|data, or
+// !TYPE|sender|data for an urgent event
+static void handle_tool_line(Tool* tool, const LineFrame* frame) {
+    const char* type = frame->type;
+    EventPriority priority = EVENT_PRIORITY_NORMAL;
+    if (type[0] == '!') {
+        type++;
+        priority = EVENT_PRIORITY_HIGH;
+    }
+
+    if (strcmp(type, "SUBSCRIBE") == 0 ||
+        strcmp(type, "TOOL_READY") == 0 ||
+        strcmp(type, "HEARTBEAT") == 0 ||
+        strcmp(type, "COMMAND") == 0) {
+        // Control messages are handled by the main thread
+        io_worker_post_control(WORK_CONTROL_LINE, NULL, type, frame->sender, frame->data);
+    } else if (strcmp(type, "REQUEST") == 0) {
+        // Routed to one responder, not published
+        request_send(tool, frame->data, priority);
+    } else if (strcmp(type, "REPLY") == 0 || strcmp(type, "REPLY_ERROR") == 0) {
+        request_reply(tool, frame->data, type[5] == '_', priority);
+    } else if (*type) {
+        // Regular event - route it from here
+        publish_tool_event(tool, type, frame, priority);
+    }
+}
+
+// Tools whose stdout each shard stopped reading under memory pressure
+// (flow_control.h); the shard's lock guards its list
+static Tool* paused_tools[MAX_IO_THREADS][MAX_TOOLS];
+static int paused_count[MAX_IO_THREADS];
+
+static void resume_paused_tools(int shard) {
+    for (int i = 0; i < paused_count[shard]; i++) {
+        event_loop_resume_stdout(paused_tools[shard][i]);
+    }
+    paused_count[shard] = 0;
+}
+
+// Retired tools on their way to the control loop, when its ring was full
+static WorkItem* retiring[MAX_IO_THREADS];
+
+// Nothing left on this shard's ring reaches a retired tool, and control
+// work this shard posted for it is ahead in the control ring
+static void pass_on_retired(int shard, WorkItem* item) {
+    if (item) {
+        item->next = retiring[shard];
+        retiring[shard] = item;
+    }
+    WorkItem** link = &retiring[shard];
+    while (*link) {
+        WorkItem* next = (*link)->next;
+        if (event_loop_post(event_loop_control(), *link)) {
+            *link = next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+}
+
+static void forget_paused_tool(int shard, const Tool* tool) {
+    for (int i = 0; i < paused_count[shard]; i++) {
+        if (paused_tools[shard][i] == tool) {
+            paused_tools[shard][i] = paused_tools[shard][--paused_count[shard]];
+            break;
+        }
+    }
+}
+
+static void pause_tool_stdout(Tool* tool) {
+    int shard = tool->shard;
+    event_loop_pause_stdout(tool);
+    if (!tool->stdout_paused) {
+        return;
+    }
+    atomic_fetch_add_explicit(&tool->stdout_pauses, 1, memory_order_relaxed);
+    flow_count_pause();
+    LOG_DEBUG("io_worker", "Paused reading %s under memory pressure", tool->name);
+    bool listed = false;
+    for (int i = 0; i < paused_count[shard]; i++) {
+        listed = listed || paused_tools[shard][i] == tool;
+    }
+    if (!listed) {
+        paused_tools[shard][paused_count[shard]++] = tool;
+    }
+    // Pressure may have ended before the pause; a later end posts WORK_RESUME
+    if (!flow_under_pressure()) {
+        resume_paused_tools(shard);
+    }
+}
+
+// Read a readable stdout pipe until it is drained (or the per-wakeup budget
+// is spent); returns false once it is drained and closed. Under memory
+// pressure a tool that holds its share of the queued events is paused and
+// the rest is left in the pipe.
+static bool read_tool_stdout(Tool* tool, bool hangup) {
+    LineFramer* framer = &tool->stdout_framer;
+    int oversized = framer->oversized_lines;
+    int oversized_frames = framer->oversized_frames;
+    size_t total = 0;
+    int bytes = 0;
+
+    while (total < STDOUT_READ_BUDGET) {
+        size_t available;
+        char* space = line_framer_prepare(framer, &available);
+        if (!space) {
+            LOG_ERROR("io_worker", "Out of memory buffering stdout of %s", tool->name);
+            break;
+        }
+
+        bytes = platform_read_nonblocking(tool->stdout_fd, space, available);
+        if (bytes <= 0) {
+            break;
+        }
+        line_framer_commit(framer, (size_t)bytes);
+        total += (size_t)bytes;
+
+        LineFrame frame;
+        flow_set_publisher(tool);
+        while (line_framer_next(framer, &frame)) {
+            handle_tool_line(tool, &frame);
+        }
+        flow_set_publisher(NULL);
+        
+        if (flow_should_pause(tool->flow)) {
+            pause_tool_stdout(tool);
+            break;
+        }
+    }
+
+    if (framer->oversized_lines != oversized) {
+        LOG_WARN("io_worker", "Dropped stdout line from %s longer than %d bytes",
+                 tool->name, LINE_FRAMER_MAX_LINE);
+    }
+    if (framer->oversized_frames != oversized_frames) {
+        LOG_WARN("io_worker", "Dropped frame from %s larger than %zu bytes",
+                 tool->name, framer->max_frame);
+    }
+
+    return !(hangup && bytes <= 0);
+}
+
+// Read a readable stderr pipe into the log, line by line and batched per
+// chunk; same return as read_tool_stdout()
+static bool read_tool_stderr(Tool* tool, bool hangup) {
+    char buffer[STDERR_READ_CHUNK];
+    uint64_t now = platform_monotonic_ms();
+    size_t total = 0;
+    int bytes = 0;
+
+    while (total < STDERR_READ_BUDGET) {
+        bytes = platform_read_nonblocking(tool->stderr_fd, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+            break;
+        }
+        log_framer_write(&tool->stderr_framer, tool->name, buffer, (size_t)bytes, now);
+        total += (size_t)bytes;
+    }
+
+    if (hangup && bytes <= 0) {
+        log_framer_flush(&tool->stderr_framer, tool->name);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Shard pass and worker threads
+// ============================================================================
+
+void io_worker_poll(int shard, int timeout_ms) {
+    LoopEvent events[LOOP_MAX_EVENTS];
+    int count = event_loop_wait(shard, events, LOOP_MAX_EVENTS, timeout_ms);
+
+    event_loop_lock(shard);
+    event_routes_enter(shard);
+    if (retiring[shard]) {
+        pass_on_retired(shard, NULL);
+    }
+
+    // 1. Work handed over by other shards and the main thread
+    WorkItem* item;
+    while ((item = (WorkItem*)event_loop_take_posted(shard)) != NULL) {
+        if (item->type == WORK_DELIVER) {
+            accept_delivery(item->tool, item->buffer);
+            free(item);
+        } else if (item->type == WORK_STOP || item->type == WORK_RESUME) {
+            free(item);  // Only wakes the worker, which checks its flag
+        } else if (item->type == WORK_RETIRE && shard != event_loop_control()) {
+            forget_paused_tool(shard, item->tool);
+            pass_on_retired(shard, item);
+        } else {
+            if (item->type == WORK_RETIRE) {
+                forget_paused_tool(shard, item->tool);
+            }
+            // One shard: the control loop is this loop
+            item->next = NULL;
+            if (backlog_tail) {
+                backlog_tail->next = item;
+            } else {
+                backlog_head = item;
+            }
+            backlog_tail = item;
+        }
+    }
+
+    // Publishers paused under memory pressure read again once it ends
+    if (paused_count[shard] > 0 && !flow_under_pressure()) {
+        resume_paused_tools(shard);
+    }
+
+    // 2. Ready tool pipes
+    for (int i = 0; i < count; i++) {
+        Tool* tool = events[i].tool;
+        LoopSource source;
+        if (!event_loop_source(&events[i], &source)) {
+            continue;
+        }
+
+        bool open = true;
+        switch (source) {
+            case LOOP_SOURCE_STDOUT:
+                open = read_tool_stdout(tool, events[i].hangup);
+                break;
+            case LOOP_SOURCE_STDERR:
+                open = read_tool_stderr(tool, events[i].hangup);
+                break;
+            case LOOP_SOURCE_STDIN:
+                event_loop_schedule_delivery(tool);
+                break;
+            case LOOP_SOURCE_EXIT:
+                io_worker_post_control(WORK_TOOL_EXITED, tool, NULL, NULL, NULL);
+                break;
+        }
+
+        if (!open) {
+            // Pipe closed: stop watching it and have the main thread see
+            // whether the tool exited
+            event_loop_remove_source(tool, source);
+            io_worker_post_control(WORK_CHECK_HEALTH, tool, NULL, NULL, NULL);
+        }
+    }
+
+    // 3. Deliver queued events to tools that have work
+    deliver_queued_events(shard);
+
+    event_routes_exit(shard);
+    event_loop_unlock(shard);
+}
+
+typedef struct {
+    int shard;
+    atomic_bool stopped;
+} WorkerState;
+
+static WorkerState worker_state[MAX_IO_THREADS];
+
+static void worker_main(void* arg) {
+    WorkerState* state = (WorkerState*)arg;
+
+    event_loop_pin(state->shard);
+    LOG_DEBUG("io_worker", "I/O worker %d running", state->shard);
+    while (!atomic_load(&state->stopped)) {
+        io_worker_poll(state->shard, -1);
+    }
+    LOG_DEBUG("io_worker", "I/O worker %d exiting", state->shard);
+}
+
+int io_worker_start(void) {
+    int shards = event_loop_shard_count();
+    if (shards <= 1) {
+        return FW_OK;  // The main thread polls the only shard
+    }
+
+    for (int i = 0; i < shards; i++) {
+        worker_state[i].shard = i;
+        atomic_init(&worker_state[i].stopped, false);
+        if (platform_thread_create(&workers[i], worker_main, &worker_state[i]) != FW_OK) {
+            LOG_ERROR("io_worker", "Failed to start I/O worker %d", i);
+            io_worker_stop();
+            return FW_ERROR_GENERIC;
+        }
+        worker_count++;
+    }
+
+    LOG_INFO("io_worker", "Started %d I/O worker threads", worker_count);
+    return FW_OK;
+}
+
+void io_worker_stop(void) {
+    for (int i = 0; i < worker_count; i++) {
+        atomic_store(&worker_state[i].stopped, true);
+
+        // Posting (rather than a bare wakeup) cannot be missed by a worker
+        // that is just about to block
+        WorkItem* item = work_alloc(WORK_STOP, NULL, 0);
+        if (!item || !event_loop_post(i, item)) {
+            free(item);
+            event_loop_wakeup(i);
+        }
+    }
+    for (int i = 0; i < worker_count; i++) {
+        platform_thread_join(workers[i]);
+    }
+    if (worker_count > 0) {
+        LOG_INFO("io_worker", "Stopped %d I/O worker threads", worker_count);
+    }
+    worker_count = 0;
+    for (int i = 0; i < MAX_IO_THREADS; i++) {
+        while (retiring[i]) {
+            WorkItem* next = retiring[i]->next;
+            io_worker_free(retiring[i]);
+            retiring[i] = next;
+        }
+    }
+
+    // Anything still queued for the main thread is moot now
+    WorkItem* item;
+    while ((item = io_worker_take_control()) != NULL) {
+        io_worker_free(item);
+    }
+}
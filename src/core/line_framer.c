@@ -0,0 +1,311 @@
+/**
+ * @file line_framer.c
+ * @brief Per-tool stdout line reassembly
+ *
+ * Tools write "TYPE|sender|data\n" lines. Each tool owns a LineFramer so
+ * partial lines from different tools never mix. Lines are split in place:
+ * the two header separators are found with a 16-byte SSE2 scan (the header
+ * is short) and the end of the data with memchr, which the C library
+ * already vectorizes for long runs. The resulting slices are handed to the
+ * router without copying.
+ *
+ * A header line starting with '#' announces a frame of that many payload
+ * bytes. The buffer is grown once to fit the whole frame and reads land
+ * directly in place, so a large payload is never rescanned or moved while
+ * it arrives.
+ */
+
+#include "yuki_frame/line_framer.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINE_FRAMER_SSE2
+#endif
+
+#if defined(LINE_FRAMER_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+static int lowest_bit(unsigned int mask) {
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+}
+#elif defined(LINE_FRAMER_SSE2)
+static int lowest_bit(unsigned int mask) {
+    return __builtin_ctz(mask);
+}
+#endif
+
+// Scan line[from..len) recording up to two '|' before the first '\n'.
+// Returns the offset of the '\n', or len if the line is not complete yet.
+static size_t scan_line(const char* line, size_t len, size_t from,
+                        size_t pipes[2], int* pipe_count) {
+    size_t i = from;
+
+#ifdef LINE_FRAMER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i bar = _mm_set1_epi8('|');
+
+    while (*pipe_count < 2 && i + 16 <= len) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(line + i));
+        unsigned int nl_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        unsigned int bar_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, bar));
+
+        if (nl_mask) {
+            bar_mask &= (nl_mask & (0u - nl_mask)) - 1;  // Only bars before the newline
+        }
+        while (bar_mask && *pipe_count < 2) {
+            pipes[(*pipe_count)++] = i + (size_t)lowest_bit(bar_mask);
+            bar_mask &= bar_mask - 1;
+        }
+        if (nl_mask) {
+            return i + (size_t)lowest_bit(nl_mask);
+        }
+        i += 16;
+    }
+#endif
+
+    // Header bytes left over from the vector loop
+    while (*pipe_count < 2 && i < len) {
+        if (line[i] == '\n') {
+            return i;
+        }
+        if (line[i] == '|') {
+            pipes[(*pipe_count)++] = i;
+        }
+        i++;
+    }
+
+    // Data: any further '|' belongs to it
+    if (i < len) {
+        const char* newline_pos = (const char*)memchr(line + i, '\n', len - i);
+        if (newline_pos) {
+            return (size_t)(newline_pos - line);
+        }
+    }
+    return len;
+}
+
+static void reset_scan(LineFramer* framer) {
+    framer->scanned = 0;
+    framer->pipe_count = 0;
+}
+
+// Payload length of a "#<digits>" frame header, false if it is not one
+static bool parse_frame_length(const char* text, size_t len, size_t* length) {
+    if (len < 2 || len > 20) {
+        return false;
+    }
+    size_t value = 0;
+    for (size_t i = 1; i < len; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        size_t digit = (size_t)(text[i] - '0');
+        if (value > (SIZE_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    *length = value;
+    return true;
+}
+
+static bool resize_buffer(LineFramer* framer, size_t capacity) {
+    char* buffer = (char*)realloc(framer->buffer, capacity);
+    if (!buffer) {
+        return false;
+    }
+    framer->buffer = buffer;
+    framer->capacity = capacity;
+    return true;
+}
+
+void line_framer_init(LineFramer* framer) {
+    memset(framer, 0, sizeof(LineFramer));
+    framer->max_frame = LINE_FRAMER_DEFAULT_MAX_FRAME;
+}
+
+void line_framer_free(LineFramer* framer) {
+    size_t max_frame = framer->max_frame;
+    free(framer->buffer);
+    memset(framer, 0, sizeof(LineFramer));
+    framer->max_frame = max_frame;
+}
+
+void line_framer_reset(LineFramer* framer) {
+    framer->start = 0;
+    framer->end = 0;
+    framer->discarding = false;
+    framer->frame_header = 0;
+    framer->skipping = 0;
+    reset_scan(framer);
+}
+
+char* line_framer_prepare(LineFramer* framer, size_t* available) {
+    // Move the partial line to the front; only its tail is ever copied
+    if (framer->start > 0) {
+        size_t pending = framer->end - framer->start;
+        if (pending > 0) {
+            memmove(framer->buffer, framer->buffer + framer->start, pending);
+        }
+        framer->start = 0;
+        framer->end = pending;
+    }
+
+    if (framer->frame_header > 0) {
+        // Room for the whole pending frame, allocated once
+        size_t needed = framer->frame_header + framer->frame_length + 1;
+        if (needed > framer->capacity && !resize_buffer(framer, needed)) {
+            return NULL;
+        }
+    } else if (framer->capacity > LINE_FRAMER_MAX_LINE && framer->end < LINE_FRAMER_MAX_LINE) {
+        // Done with a large frame: give the memory back
+        resize_buffer(framer, LINE_FRAMER_MAX_LINE);
+    }
+
+    if (framer->end == framer->capacity) {
+        if (framer->frame_header > 0) {
+            // The whole frame is in but not taken yet; make room after it
+            if (!resize_buffer(framer, framer->capacity + LINE_FRAMER_INITIAL_SIZE)) {
+                return NULL;
+            }
+        } else if (framer->capacity >= LINE_FRAMER_MAX_LINE) {
+            // No newline within the limit: drop what we have and skip the
+            // rest of this line once its newline arrives
+            if (!framer->discarding) {
+                framer->oversized_lines++;
+            }
+            framer->start = 0;
+            framer->end = 0;
+            framer->discarding = true;
+            reset_scan(framer);
+        } else {
+            size_t capacity = framer->capacity ? framer->capacity * 2 : LINE_FRAMER_INITIAL_SIZE;
+            if (capacity > LINE_FRAMER_MAX_LINE) {
+                capacity = LINE_FRAMER_MAX_LINE;
+            }
+            if (!resize_buffer(framer, capacity)) {
+                return NULL;
+            }
+        }
+    }
+
+    *available = framer->capacity - framer->end;
+    return framer->buffer + framer->end;
+}
+
+void line_framer_commit(LineFramer* framer, size_t bytes) {
+    framer->end += bytes;
+}
+
+bool line_framer_next(LineFramer* framer, LineFrame* frame) {
+    while (framer->start < framer->end) {
+        char* line = framer->buffer + framer->start;
+        size_t len = framer->end - framer->start;
+
+        if (framer->skipping > 0) {
+            size_t skip = len < framer->skipping ? len : framer->skipping;
+            framer->start += skip;
+            framer->skipping -= skip;
+            continue;
+        }
+
+        if (framer->frame_header > 0) {
+            // The header was split when it arrived; wait for the payload
+            size_t header = framer->frame_header;
+            size_t data_len = framer->frame_length;
+            if (len < header + data_len + 1) {
+                return false;
+            }
+            framer->frame_header = 0;
+            framer->start += header + data_len + 1;
+
+            char* data = line + header;
+            if (data[data_len] != '\n' || memchr(data, '\0', data_len)) {
+                framer->malformed_lines++;
+                continue;
+            }
+            data[data_len] = '\0';
+
+            frame->type = line + framer->pipes[0] + 1;
+            frame->type_len = framer->pipes[1] - framer->pipes[0] - 1;
+            frame->sender = line + framer->pipes[1] + 1;
+            frame->sender_len = strlen(frame->sender);
+            frame->data = data;
+            frame->data_len = data_len;
+            return true;
+        }
+
+        size_t newline = scan_line(line, len, framer->scanned, framer->pipes, &framer->pipe_count);
+        if (newline == len) {
+            framer->scanned = len;
+            return false;
+        }
+
+        size_t next_start = framer->start + newline + 1;
+        int pipe_count = framer->pipe_count;
+        reset_scan(framer);
+
+        if (framer->discarding) {
+            framer->discarding = false;
+            framer->start = next_start;
+            continue;
+        }
+
+        // Tolerate CRLF line endings
+        size_t line_len = newline;
+        if (line_len > 0 && line[line_len - 1] == '\r') {
+            line_len--;
+        }
+
+        if (pipe_count < 2 || framer->pipes[0] == 0 || framer->pipes[1] == framer->pipes[0] + 1) {
+            if (line_len > 0) {
+                framer->malformed_lines++;
+            }
+            framer->start = next_start;
+            continue;
+        }
+
+        size_t first = framer->pipes[0];
+        size_t second = framer->pipes[1];
+
+        line[first] = '\0';
+        line[second] = '\0';
+        line[line_len] = '\0';
+
+        if (line[0] == '#') {
+            // "#<length>|TYPE|sender": the payload follows the header line
+            size_t data_len;
+            if (!parse_frame_length(line, first, &data_len) || line_len == second + 1) {
+                framer->malformed_lines++;
+                framer->start = next_start;
+            } else if (data_len > framer->max_frame) {
+                framer->oversized_frames++;
+                framer->start = next_start;
+                framer->skipping = data_len + 1;
+            } else {
+                // Keep the header (and its split) until the payload is in
+                framer->pipes[0] = first;
+                framer->pipes[1] = second;
+                framer->frame_header = newline + 1;
+                framer->frame_length = data_len;
+            }
+            continue;
+        }
+
+        frame->type = line;
+        frame->type_len = first;
+        frame->sender = line + first + 1;
+        frame->sender_len = second - first - 1;
+        frame->data = line + second + 1;
+        frame->data_len = line_len - second - 1;
+
+        framer->start = next_start;
+        return true;
+    }
+
+    return false;
+}
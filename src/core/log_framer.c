@@ -0,0 +1,192 @@
+/**
+ * @file log_framer.c
+ * @brief Per-tool stderr line reassembly for the log
+ *
+ * A tool's stderr is read in large chunks; every complete line in a chunk
+ * becomes one log record, and the records of a chunk are written with a
+ * single logger call (one timestamp, one flush). Lines are logged straight
+ * from the read buffer; only a line split across reads is copied. A
+ * per-tool cap on lines per second keeps a chatty tool from flooding the
+ * log file, with a notice of how many lines were dropped.
+ */
+
+#include "yuki_frame/log_framer.h"
+#include <string.h>
+
+typedef struct {
+    LogLine lines[LOG_FRAMER_BATCH];
+    int count;
+    const char* component;
+} LogBatch;
+
+static const struct {
+    const char* tag;
+    size_t length;
+    LogLevel level;
+} level_tags[] = {
+    { "TRACE", 5, LOG_TRACE },
+    { "DEBUG", 5, LOG_DEBUG },
+    { "INFO", 4, LOG_INFO },
+    { "WARN", 4, LOG_WARN },
+    { "WARNING", 7, LOG_WARN },
+    { "ERROR", 5, LOG_ERROR },
+    { "FATAL", 5, LOG_FATAL },
+    { "CRITICAL", 8, LOG_FATAL },
+};
+
+void log_framer_init(LogFramer* framer, int rate_limit) {
+    memset(framer, 0, sizeof(*framer));
+    framer->rate_limit = rate_limit > 0 ? rate_limit : 0;
+}
+
+void log_framer_reset(LogFramer* framer) {
+    framer->partial_length = 0;
+}
+
+LogLevel log_framer_parse_level(const char** text, size_t* length, LogLevel fallback) {
+    const char* line = *text;
+    size_t len = *length;
+    if (len < 3 || line[0] != '[') {
+        return fallback;
+    }
+
+    const char* close = (const char*)memchr(line + 1, ']', len - 1 < 10 ? len - 1 : 10);
+    if (!close) {
+        return fallback;
+    }
+    size_t tag_length = (size_t)(close - line - 1);
+
+    for (size_t i = 0; i < sizeof(level_tags) / sizeof(level_tags[0]); i++) {
+        if (level_tags[i].length == tag_length &&
+            memcmp(line + 1, level_tags[i].tag, tag_length) == 0) {
+            size_t skip = tag_length + 2;
+            if (skip < len && line[skip] == ' ') {
+                skip++;
+            }
+            *text = line + skip;
+            *length = len - skip;
+            return level_tags[i].level;
+        }
+    }
+    return fallback;
+}
+
+static void batch_flush(LogBatch* batch) {
+    if (batch->count > 0) {
+        logger_log_lines(batch->component, batch->lines, batch->count);
+        batch->count = 0;
+    }
+}
+
+// Report lines the cap dropped in the window that just ended
+static void report_suppressed(LogFramer* framer, LogBatch* batch) {
+    if (framer->suppressed == 0) {
+        return;
+    }
+    batch_flush(batch);
+    logger_log(LOG_WARN, batch->component, "Suppressed %d stderr lines (limit %d per second)",
+               framer->suppressed, framer->rate_limit);
+    framer->suppressed_total += (uint64_t)framer->suppressed;
+    framer->suppressed = 0;
+}
+
+static void batch_add(LogFramer* framer, LogBatch* batch, const char* text, size_t length) {
+    if (length > 0 && text[length - 1] == '\r') {
+        length--;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    if (framer->rate_limit > 0) {
+        if (framer->window_lines >= framer->rate_limit) {
+            framer->suppressed++;
+            return;
+        }
+        framer->window_lines++;
+    }
+
+    LogLine* line = &batch->lines[batch->count];
+    line->level = log_framer_parse_level(&text, &length, LOG_INFO);
+    line->text = text;
+    line->length = length;
+    if (++batch->count == LOG_FRAMER_BATCH) {
+        batch_flush(batch);
+    }
+}
+
+// Append to the partial line, logging it whenever it reaches the maximum
+static void partial_append(LogFramer* framer, LogBatch* batch, const char* data, size_t size) {
+    while (size > 0) {
+        size_t room = LOG_FRAMER_MAX_LINE - framer->partial_length;
+        size_t take = size < room ? size : room;
+        memcpy(framer->partial + framer->partial_length, data, take);
+        framer->partial_length += take;
+        data += take;
+        size -= take;
+
+        if (framer->partial_length == LOG_FRAMER_MAX_LINE) {
+            batch_add(framer, batch, framer->partial, framer->partial_length);
+            batch_flush(batch);  // Before the buffer is reused
+            framer->partial_length = 0;
+        }
+    }
+}
+
+void log_framer_write(LogFramer* framer, const char* component,
+                      const char* data, size_t size, uint64_t now_ms) {
+    LogBatch batch;
+    batch.count = 0;
+    batch.component = component;
+
+    if (now_ms - framer->window_start_ms >= 1000) {
+        report_suppressed(framer, &batch);
+        framer->window_start_ms = now_ms;
+        framer->window_lines = 0;
+    }
+
+    while (size > 0) {
+        const char* newline = (const char*)memchr(data, '\n', size);
+        if (!newline) {
+            batch_flush(&batch);
+            partial_append(framer, &batch, data, size);
+            break;
+        }
+
+        size_t length = (size_t)(newline - data);
+        if (framer->partial_length > 0) {
+            // Completes the line the previous read ended in
+            partial_append(framer, &batch, data, length);
+            batch_add(framer, &batch, framer->partial, framer->partial_length);
+            batch_flush(&batch);
+            framer->partial_length = 0;
+        } else {
+            // Long lines are split the same way as buffered ones
+            while (length > LOG_FRAMER_MAX_LINE) {
+                batch_add(framer, &batch, data, LOG_FRAMER_MAX_LINE);
+                data += LOG_FRAMER_MAX_LINE;
+                size -= LOG_FRAMER_MAX_LINE;
+                length -= LOG_FRAMER_MAX_LINE;
+            }
+            batch_add(framer, &batch, data, length);
+        }
+
+        data += length + 1;
+        size -= length + 1;
+    }
+
+    batch_flush(&batch);
+}
+
+void log_framer_flush(LogFramer* framer, const char* component) {
+    LogBatch batch;
+    batch.count = 0;
+    batch.component = component;
+
+    if (framer->partial_length > 0) {
+        batch_add(framer, &batch, framer->partial, framer->partial_length);
+        batch_flush(&batch);
+        framer->partial_length = 0;
+    }
+    report_suppressed(framer, &batch);
+}
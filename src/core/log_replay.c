@@ -0,0 +1,429 @@
+/**
+ * @file log_replay.c
+ * @brief Rate-limited replays of the event log into a tool's inbox
+ *
+ * Each replay owns an event log cursor, sought to its starting LSN or time
+ * through the log's sparse index, and stops at the last LSN logged when it
+ * started. On each pass of the main loop a replay reads and formats up
+ * to its rate allowance without holding any shard lock, then takes the
+ * tool's shard lock only to queue what fits in half the inbox, and wakes
+ * the shard to write it. What did not fit waits for the next pass.
+ */
+
+#include "yuki_frame/log_replay.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/event_buffer.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Records a replay may skip by type in one pass before yielding
+#define LOG_REPLAY_MAX_SCAN (LOG_REPLAY_BATCH * 16)
+
+typedef struct {
+    bool active;
+    char tool[MAX_TOOL_NAME];
+    LogReplayOptions options;
+    EventLogCursor* cursor;
+    uint64_t until_lsn;
+    uint64_t last_lsn;
+    uint64_t sent;
+    uint64_t started_ms;        // Monotonic, for the rate
+    bool read_all;              // The cursor reached until_lsn
+    // Read and formatted, not queued yet: batch[batch_next .. batch_count)
+    EventBuffer* batch[LOG_REPLAY_BATCH];
+    uint64_t batch_lsn[LOG_REPLAY_BATCH];
+    int batch_count;
+    int batch_next;
+} ReplaySession;
+
+static ReplaySession sessions[LOG_REPLAY_MAX];
+static PlatformMutex replay_lock;
+static bool initialized = false;
+
+int log_replay_init(void) {
+    if (initialized) {
+        return FW_OK;
+    }
+    memset(sessions, 0, sizeof(sessions));
+    platform_mutex_init(&replay_lock);
+    initialized = true;
+    return FW_OK;
+}
+
+static void session_end(ReplaySession* session) {
+    for (int i = session->batch_next; i < session->batch_count; i++) {
+        event_buffer_release(session->batch[i]);
+    }
+    event_log_cursor_close(session->cursor);
+    memset(session, 0, sizeof(ReplaySession));
+}
+
+void log_replay_shutdown(void) {
+    if (!initialized) {
+        return;
+    }
+    platform_mutex_lock(&replay_lock);
+    for (int i = 0; i < LOG_REPLAY_MAX; i++) {
+        if (sessions[i].active) {
+            session_end(&sessions[i]);
+        }
+    }
+    platform_mutex_unlock(&replay_lock);
+    platform_mutex_destroy(&replay_lock);
+    initialized = false;
+}
+
+// ============================================================================
+// Options
+// ============================================================================
+
+// "-30s", "-5m", "-2h", "-1d" before now, or a local "YYYY-MM-DDTHH:MM[:SS]"
+static bool parse_time(const char* value, uint64_t* timestamp_ms) {
+    if (value[0] == '-') {
+        char* end = NULL;
+        unsigned long long amount = strtoull(value + 1, &end, 10);
+        uint64_t unit_ms;
+        switch (end && end != value + 1 ? *end : '\0') {
+            case 's': unit_ms = 1000; break;
+            case 'm': unit_ms = 60 * 1000; break;
+            case 'h': unit_ms = 60 * 60 * 1000; break;
+            case 'd': unit_ms = 24 * 60 * 60 * 1000; break;
+            default: return false;
+        }
+        if (end[1] != '\0') {
+            return false;
+        }
+        uint64_t now = event_log_time_ms();
+        uint64_t back = (uint64_t)amount * unit_ms;
+        *timestamp_ms = back < now ? now - back : 1;
+        return true;
+    }
+
+    struct tm when;
+    memset(&when, 0, sizeof(when));
+    int consumed = 0;
+    int fields = sscanf(value, "%d-%d-%dT%d:%d%n:%d%n", &when.tm_year, &when.tm_mon,
+                        &when.tm_mday, &when.tm_hour, &when.tm_min, &consumed,
+                        &when.tm_sec, &consumed);
+    if (fields < 5 || value[consumed] != '\0') {
+        return false;
+    }
+    when.tm_year -= 1900;
+    when.tm_mon -= 1;
+    when.tm_isdst = -1;
+    time_t seconds = mktime(&when);
+    if (seconds == (time_t)-1 || seconds < 0) {
+        return false;
+    }
+    *timestamp_ms = (uint64_t)seconds * 1000;
+    return true;
+}
+
+// Comma separated, "A,B"
+static bool parse_types(const char* value, LogReplayOptions* options) {
+    options->type_count = 0;
+    while (*value) {
+        size_t length = strcspn(value, ",");
+        if (length > 0) {
+            if (options->type_count == LOG_REPLAY_MAX_TYPES || length >= MAX_EVENT_TYPE) {
+                return false;
+            }
+            memcpy(options->types[options->type_count], value, length);
+            options->types[options->type_count++][length] = '\0';
+        }
+        value += length;
+        if (*value == ',') {
+            value++;
+        }
+    }
+    return options->type_count > 0;
+}
+
+int log_replay_parse(const char* args, LogReplayOptions* options, char* error, size_t error_size) {
+    if (!options) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    memset(options, 0, sizeof(LogReplayOptions));
+    char copy[512];
+    snprintf(copy, sizeof(copy), "%s", args ? args : "");
+
+    // Split into words (strtok would race the console's use of it)
+    char* words[16];
+    int count = 0;
+    for (char* c = copy; *c && count < 16;) {
+        while (*c == ' ' || *c == '\t') {
+            *c++ = '\0';
+        }
+        if (*c) {
+            words[count++] = c;
+            while (*c && *c != ' ' && *c != '\t') {
+                c++;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const char* option = words[i];
+        char* value = i + 1 < count ? words[i + 1] : NULL;
+        bool valid = value != NULL;
+        if (strcmp(option, "--from") == 0 && value) {
+            bool digits = true;
+            for (const char* d = value; *d; d++) {
+                digits = digits && isdigit((unsigned char)*d);
+            }
+            if (digits) {
+                options->from_lsn = strtoull(value, NULL, 10);
+            } else {
+                valid = parse_time(value, &options->from_time_ms);
+            }
+        } else if (strcmp(option, "--types") == 0 && value) {
+            valid = parse_types(value, options);
+        } else if (strcmp(option, "--rate") == 0 && value) {
+            options->rate = atoi(value);
+            valid = options->rate >= 0;
+        } else {
+            if (error) {
+                snprintf(error, error_size, "Unknown option '%s'", option);
+            }
+            return FW_ERROR_PARSE_FAILED;
+        }
+        if (!valid) {
+            if (error) {
+                snprintf(error, error_size, "Bad value for %s", option);
+            }
+            return FW_ERROR_PARSE_FAILED;
+        }
+        i++;
+    }
+    return FW_OK;
+}
+
+// ============================================================================
+// Replays
+// ============================================================================
+
+static ReplaySession* session_find(const char* tool) {
+    for (int i = 0; i < LOG_REPLAY_MAX; i++) {
+        if (sessions[i].active && strcmp(sessions[i].tool, tool) == 0) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+int log_replay_start(const char* tool, const LogReplayOptions* options) {
+    if (!tool || !options || !initialized) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (!event_log_is_open()) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    if (!tool_find(tool)) {
+        return FW_ERROR_NOT_FOUND;
+    }
+
+    // Everything up to now must be on disk for the cursor to read it
+    uint64_t until_lsn = event_log_last_lsn();
+    event_log_flush();
+    EventLogCursor* cursor = options->from_time_ms > 0
+        ? event_log_seek_time(options->from_time_ms)
+        : event_log_seek_lsn(options->from_lsn);
+    if (!cursor) {
+        return FW_ERROR_MEMORY;
+    }
+
+    platform_mutex_lock(&replay_lock);
+    ReplaySession* session = session_find(tool);
+    if (session) {
+        session_end(session);
+    } else {
+        for (int i = 0; i < LOG_REPLAY_MAX && !session; i++) {
+            if (!sessions[i].active) {
+                session = &sessions[i];
+            }
+        }
+    }
+    if (!session) {
+        platform_mutex_unlock(&replay_lock);
+        event_log_cursor_close(cursor);
+        return FW_ERROR_QUEUE_FULL;
+    }
+    session->active = true;
+    strncpy(session->tool, tool, MAX_TOOL_NAME - 1);
+    session->options = *options;
+    session->cursor = cursor;
+    session->until_lsn = until_lsn;
+    session->started_ms = platform_monotonic_ms();
+    platform_mutex_unlock(&replay_lock);
+
+    LOG_INFO("log_replay", "Replaying events up to LSN %" PRIu64 " to %s (%d/s)",
+             until_lsn, tool, options->rate);
+    return FW_OK;
+}
+
+int log_replay_stop(const char* tool) {
+    if (!tool || !initialized) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    platform_mutex_lock(&replay_lock);
+    ReplaySession* session = session_find(tool);
+    if (session) {
+        LOG_INFO("log_replay", "Stopped replay to %s after %" PRIu64 " events",
+                 tool, session->sent);
+        session_end(session);
+    }
+    platform_mutex_unlock(&replay_lock);
+    return session ? FW_OK : FW_ERROR_NOT_FOUND;
+}
+
+int log_replay_list(LogReplayStatus* status, int max_status) {
+    if (!status || !initialized) {
+        return 0;
+    }
+    int count = 0;
+    platform_mutex_lock(&replay_lock);
+    for (int i = 0; i < LOG_REPLAY_MAX && count < max_status; i++) {
+        const ReplaySession* session = &sessions[i];
+        if (session->active) {
+            memcpy(status[count].tool, session->tool, MAX_TOOL_NAME);
+            status[count].until_lsn = session->until_lsn;
+            status[count].last_lsn = session->last_lsn;
+            status[count].sent = session->sent;
+            status[count].rate = session->options.rate;
+            count++;
+        }
+    }
+    platform_mutex_unlock(&replay_lock);
+    return count;
+}
+
+static bool type_selected(const LogReplayOptions* options, const char* type) {
+    if (options->type_count == 0) {
+        return true;
+    }
+    for (int i = 0; i < options->type_count; i++) {
+        if (strcmp(options->types[i], type) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queue what the session may send now. Returns false once it is done,
+// otherwise the milliseconds until it can send more in wait_ms.
+static bool session_run(ReplaySession* session, uint64_t now, int* wait_ms) {
+    Tool* tool = tool_find(session->tool);
+    if (!tool) {
+        LOG_WARN("log_replay", "Replay to %s stopped: tool is gone", session->tool);
+        return false;
+    }
+
+    // The first event goes at once, then one every 1/rate seconds
+    int budget = LOG_REPLAY_BATCH;
+    int rate = session->options.rate;
+    uint64_t elapsed = now - session->started_ms;
+    if (rate > 0) {
+        uint64_t allowed = elapsed * (uint64_t)rate / 1000 + 1;
+        if (allowed <= session->sent) {
+            *wait_ms = (int)((session->sent * 1000 + (uint64_t)rate - 1) / (uint64_t)rate - elapsed);
+            return true;
+        }
+        if (allowed - session->sent < (uint64_t)budget) {
+            budget = (int)(allowed - session->sent);
+        }
+    }
+
+    // Reading the log may fault pages in: no shard lock held here
+    if (session->batch_next == session->batch_count && !session->read_all) {
+        session->batch_count = 0;
+        session->batch_next = 0;
+        int scanned = 0;
+        EventLogRecord record;
+        while (session->batch_count < budget && scanned < LOG_REPLAY_MAX_SCAN) {
+            if (!event_log_cursor_next(session->cursor, &record) ||
+                record.lsn > session->until_lsn) {
+                session->read_all = true;
+                break;
+            }
+            scanned++;
+            if (!type_selected(&session->options, record.type)) {
+                continue;
+            }
+            EventBuffer* buffer = event_buffer_format(record.type, record.sender, record.data);
+            if (!buffer) {
+                break;
+            }
+            buffer->priority = EVENT_PRIORITY_LOW;
+            session->batch[session->batch_count] = buffer;
+            session->batch_lsn[session->batch_count++] = record.lsn;
+        }
+    }
+
+    int pending = session->batch_count - session->batch_next;
+    if (pending > budget) {
+        pending = budget;
+    }
+    event_loop_lock(tool->shard);
+    ToolQueue* inbox = tool->inbox;
+    int room = tool_queue_capacity(inbox) / 2 - tool_queue_count(inbox);
+    int queued = 0;
+    while (queued < pending && queued < room) {
+        int next = session->batch_next++;
+        io_worker_deliver(tool, session->batch[next]);
+        session->last_lsn = session->batch_lsn[next];
+        queued++;
+    }
+    event_loop_unlock(tool->shard);
+    session->sent += (uint64_t)queued;
+    if (queued > 0 && tool->shard >= 0) {
+        event_loop_wakeup(tool->shard);
+    }
+
+    bool done = session->read_all && session->batch_next == session->batch_count;
+    if (done) {
+        LOG_INFO("log_replay", "Replay to %s finished: %" PRIu64 " events",
+                 session->tool, session->sent);
+        return false;
+    }
+    if (room <= 0) {
+        *wait_ms = LOG_REPLAY_RETRY_MS;
+    } else if (rate > 0 && session->sent * 1000 > elapsed * (uint64_t)rate) {
+        *wait_ms = (int)((session->sent * 1000 + (uint64_t)rate - 1) / (uint64_t)rate - elapsed);
+    } else {
+        *wait_ms = 0;
+    }
+    return true;
+}
+
+int log_replay_run(void) {
+    if (!initialized) {
+        return -1;
+    }
+    int timeout_ms = -1;
+    uint64_t now = platform_monotonic_ms();
+    platform_mutex_lock(&replay_lock);
+    for (int i = 0; i < LOG_REPLAY_MAX; i++) {
+        ReplaySession* session = &sessions[i];
+        if (!session->active) {
+            continue;
+        }
+        int wait_ms = 0;
+        if (!session_run(session, now, &wait_ms)) {
+            session_end(session);
+        } else if (timeout_ms < 0 || wait_ms < timeout_ms) {
+            timeout_ms = wait_ms;
+        }
+    }
+    platform_mutex_unlock(&replay_lock);
+    return timeout_ms;
+}
@@ -128,10 +128,16 @@ void logger_log(LogLevel level, const char* component, const char* format, ...)
     }
     
     // Get timestamp
+    // (reentrant: I/O worker threads log too)
     time_t now = time(NULL);
-    struct tm* tm_info = localtime(&now);
+    struct tm tm_info;
+#ifdef PLATFORM_WINDOWS
+    localtime_s(&tm_info, &now);
+#else
+    localtime_r(&now, &tm_info);
+#endif
     char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
     
     // Build message
     char message[MAX_LOG_MESSAGE];
@@ -160,6 +166,44 @@ void logger_log_tool(const char* tool_name, LogLevel level, const char* message)
     logger_log(level, tool_name, "%s", message);
 }
 
+void logger_log_lines(const char* component, const LogLine* lines, int count) {
+    if (!component || !lines || count <= 0) {
+        return;
+    }
+    
+    time_t now = time(NULL);
+    struct tm tm_info;
+#ifdef PLATFORM_WINDOWS
+    localtime_s(&tm_info, &now);
+#else
+    localtime_r(&now, &tm_info);
+#endif
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+    
+    // One timestamp and one flush for the whole batch
+    for (int i = 0; i < count; i++) {
+        const LogLine* line = &lines[i];
+        if (line->level < current_level) {
+            continue;
+        }
+        int length = line->length > MAX_LOG_MESSAGE ? MAX_LOG_MESSAGE : (int)line->length;
+        const char* level_str = log_level_string(line->level);
+        
+        if (log_file) {
+            fprintf(log_file, "%s [%s] [%s] %.*s\n",
+                    timestamp, level_str, component, length, line->text);
+        }
+        if (line->level >= LOG_INFO) {
+            fprintf(stderr, "[%s] [%s] %.*s\n", level_str, component, length, line->text);
+        }
+    }
+    
+    if (log_file) {
+        fflush(log_file);
+    }
+}
+
 void logger_set_level(LogLevel level) {
     current_level = level;
 }
@@ -1,6 +1,6 @@
 /**
  * @file main.c
- * @brief Main entry point for Yuki-Frame v2.0 (Windows)
+ * @brief Main entry point for Yuki-Frame v2.0
  * 
  * This version includes integrated control via command file monitoring.
  * No separate control utility needed - all control is built into the framework.
@@ -11,7 +11,14 @@
 #include "yuki_frame/config.h"
 #include "yuki_frame/tool.h"
 #include "yuki_frame/event.h"
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/log_replay.h"
+#include "yuki_frame/request.h"
+#include "yuki_frame/flow_control.h"
 #include "yuki_frame/platform.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
 #include "yuki_frame/control_api.h"
 #include "yuki_frame/control_socket.h"
 #include <stdio.h>
@@ -19,6 +26,7 @@
 #include <string.h>
 #include <signal.h>
 #include <ctype.h>
+#include <inttypes.h>
 
 // Declare control_api_init (internal function)
 void control_api_init(void);
@@ -27,14 +35,16 @@ void control_api_init(void);
 FrameworkConfig g_config;
 bool g_running = true;
 
-// Signal handler (Windows-style)
+// Signal handler
 void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM || sig == SIGABRT) {
         LOG_INFO("main", "Received shutdown signal");
         g_running = false;
+        event_loop_wakeup(event_loop_control());  // A spinning loop is not interrupted
     }
 }
 
+#ifdef PLATFORM_WINDOWS
 // Windows Console Control Handler
 BOOL WINAPI console_ctrl_handler(DWORD ctrl_type) {
     switch (ctrl_type) {
@@ -44,16 +54,18 @@ BOOL WINAPI console_ctrl_handler(DWORD ctrl_type) {
         case CTRL_SHUTDOWN_EVENT:
             LOG_INFO("main", "Received Windows console control signal");
             g_running = false;
+            event_loop_wakeup(event_loop_control());
             return TRUE;
         default:
             return FALSE;
     }
 }
+#endif
 
 // Print usage
 void print_usage(const char* prog_name) {
-    printf("%s v%s - Event-driven tool orchestration framework for Windows\n\n", 
-           YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING);
+    printf("%s v%s - Event-driven tool orchestration framework for %s\n\n", 
+           YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING, YUKI_FRAME_PLATFORM_NAME);
     printf("Usage: %s [OPTIONS]\n\n", prog_name);
     printf("Options:\n");
     printf("  -c, --config FILE    Configuration file (default: yuki-frame.conf)\n");
@@ -93,7 +105,8 @@ int framework_init(const char* config_file, int control_port) {
     }
     
     LOG_INFO("main", "========================================");
-    LOG_INFO("main", "%s v%s starting on Windows", YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING);
+    LOG_INFO("main", "%s v%s starting on %s", YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING,
+             YUKI_FRAME_PLATFORM_NAME);
     LOG_INFO("main", "========================================");
     
     // Initialize platform-specific code
@@ -103,6 +116,26 @@ int framework_init(const char* config_file, int control_port) {
         return ret;
     }
     
+    // Pollers are created with the backend selected here
+    platform_select_io_backend(g_config.io_backend);
+    
+    // Initialize event loop
+    ret = event_loop_init(g_config.io_threads);
+    if (ret != FW_OK) {
+        LOG_ERROR("main", "Failed to initialize event loop");
+        return ret;
+    }
+    event_loop_set_mode(g_config.loop_mode, g_config.spin_us, g_config.loop_cpu);
+    if (g_config.loop_mode != LOOP_MODE_BLOCKING) {
+        LOG_INFO("main", "Loop mode: %s (spin %d us)",
+                 g_config.loop_mode == LOOP_MODE_HYBRID ? "hybrid" : "busy-poll",
+                 g_config.spin_us);
+    }
+    
+    // Memory budget for queued events, before anything can queue one
+    flow_init(g_config.bus_memory_limit, g_config.bus_high_watermark,
+              g_config.bus_low_watermark);
+    
     // Initialize event bus
     ret = event_bus_init();
     if (ret != FW_OK) {
@@ -160,6 +193,13 @@ int framework_init(const char* config_file, int control_port) {
     
     // ================================================================
     
+    // Request/reply routing, before any tool can ask
+    ret = request_init(g_config.request_timeout_ms);
+    if (ret != FW_OK) {
+        LOG_ERROR("main", "Failed to initialize request routing");
+        return ret;
+    }
+    
     // Load and register tools from configuration
     ToolConfig* tools;
     int tool_count;
@@ -170,16 +210,42 @@ int framework_init(const char* config_file, int control_port) {
         for (int i = 0; i < tool_count; i++) {
             LOG_INFO("main", "Registering tool: %s", tools[i].name);
             tool_register(tools[i].name, tools[i].command);
+            tool_set_queue_config(tools[i].name, tools[i].max_queue_size,
+                                  tools[i].queue_policy, tools[i].max_batch_size);
+            tool_set_restart_config(tools[i].name, tools[i].restart_policy,
+                                    tools[i].restart_on_crash, tools[i].max_restarts,
+                                    tools[i].restart_max_delay_sec);
+            tool_set_timeouts(tools[i].name, tools[i].heartbeat_timeout_sec,
+                              tools[i].start_timeout_sec, tools[i].idle_timeout_sec);
+            tool_set_log_rate(tools[i].name, tools[i].log_rate_limit);
+            tool_set_queue_bytes(tools[i].name, tools[i].max_queue_bytes);
+            tool_set_conflate_key(tools[i].name, tools[i].conflate_key);
+            tool_set_sequencing(tools[i].name, tools[i].dedup_window, tools[i].sequence_numbers);
             
             // Subscribe to events
             if (strlen(tools[i].subscriptions) > 0) {
-                char* subs = _strdup(tools[i].subscriptions);
-                char* token = strtok(subs, ",");
-                while (token) {
-                    // Trim whitespace
-                    while (*token == ' ') token++;
-                    tool_subscribe(tools[i].name, token);
-                    token = strtok(NULL, ",");
+                // Comma separated; commas inside a [filter] are its own
+                char* subs = strdup(tools[i].subscriptions);
+                char* token = subs;
+                int depth = 0;
+                for (char* c = subs; c; c++) {
+                    if (*c == '[') {
+                        depth++;
+                    } else if (*c == ']' && depth > 0) {
+                        depth--;
+                    } else if (*c == '\0' || (*c == ',' && depth == 0)) {
+                        bool last = *c == '\0';
+                        *c = '\0';
+                        // Trim whitespace
+                        while (*token == ' ') token++;
+                        if (*token) {
+                            tool_subscribe(tools[i].name, token);
+                        }
+                        if (last) {
+                            break;
+                        }
+                        token = c + 1;
+                    }
                 }
                 free(subs);
             }
@@ -198,43 +264,120 @@ int framework_init(const char* config_file, int control_port) {
         LOG_WARN("main", "No tools found in configuration");
     }
     
+    // Event log: opened once the tools are subscribed, so what they were
+    // not written before the last shutdown can be routed to them again
+    if (g_config.event_log[0] != '\0') {
+        ret = event_log_open(g_config.event_log, g_config.event_log_sync_ms,
+                             g_config.event_log_segment_size);
+        if (ret != FW_OK) {
+            LOG_ERROR("main", "Failed to open event log %s: %d", g_config.event_log, ret);
+            return ret;
+        }
+        event_log_replay();
+        log_replay_init();
+    }
+    
     LOG_INFO("main", "Framework initialized successfully");
     return FW_OK;
 }
 
-// Forward declaration
+// Forward declarations
 void handle_console_command(const char* tool_name, const char* command);
+static void execute_console_command(const char* command, char* response, size_t response_size);
 
-// Deliver queued events to running tools
-void deliver_queued_events(void) {
-    Tool* tool = tool_get_first();
-    
-    while (tool != NULL) {
-        // Only deliver to running tools with queued events
-        if (tool->status == TOOL_RUNNING && !tool_queue_is_empty(tool->inbox)) {
-            // Try to deliver next event
-            const char* event_msg = tool_queue_peek(tool->inbox);
-            if (event_msg) {
-                // Try non-blocking send
-                int result = tool_send_event_nonblocking(tool->name, event_msg);
-                
-                if (result == FW_OK) {
-                    // Successfully delivered, remove from queue
-                    tool_queue_remove(tool->inbox);
-                    LOG_TRACE("main", "Delivered event to %s (queue: %d remaining)", 
-                             tool->name, tool_queue_count(tool->inbox));
-                } else if (result == FW_ERROR_QUEUE_FULL) {
-                    // Pipe full, leave in queue, try next tool
-                    LOG_TRACE("main", "Tool %s pipe full, will retry", tool->name);
-                } else {
-                    // Other error, remove event and log
-                    tool_queue_remove(tool->inbox);
-                    LOG_ERROR("main", "Failed to deliver event to %s: %d", tool->name, result);
-                }
+// Queue a framework response for a tool (e.g. the console)
+static void send_to_tool(const char* tool_name, const char* msg) {
+    Tool* tool = tool_find(tool_name);
+    if (!tool) {
+        return;
+    }
+    EventBuffer* buffer = event_buffer_create(msg, strlen(msg));
+    if (buffer) {
+        io_worker_deliver(tool, buffer);
+    }
+}
+
+// Handle a control line a tool wrote to stdout, posted by its I/O shard
+static void handle_control_line(const WorkItem* item) {
+    const char* type = item->type_name;
+    const char* sender = item->sender;
+    const char* data = item->data;
+    
+    if (strcmp(type, "SUBSCRIBE") == 0) {
+        // Tool subscribing to event type
+        if (data[0] != '\0') {
+            LOG_DEBUG("main", "Tool %s subscribing to: %s", sender, data);
+            tool_subscribe(sender, data);
+        }
+    }
+    else if (strcmp(type, "TOOL_READY") == 0) {
+        // Tool ready signal
+        LOG_DEBUG("main", "Tool %s is ready: %s", sender, data);
+        tool_mark_ready(sender);
+    }
+    else if (strcmp(type, "HEARTBEAT") == 0) {
+        tool_update_heartbeat(sender);
+    }
+    else if (strcmp(type, "COMMAND") == 0) {
+        // Console command - handle it
+        LOG_DEBUG("main", "Command from %s: %s", sender, data);
+        handle_console_command(sender, data);
+    }
+    else if (strcmp(type, "REQUEST") == 0) {
+        // A console command asked for as a request: the reply goes only
+        // to the tool that asked
+        char id[REQUEST_MAX_ID];
+        char request_type[MAX_EVENT_TYPE];
+        const char* command;
+        if (item->tool && request_parse(data, id, request_type, &command)) {
+            char response[8192];
+            execute_console_command(command, response, sizeof(response));
+            size_t length = strlen(response);
+            if (length > 0 && response[length - 1] == '\n') {
+                response[length - 1] = '\0';   // One-line answers stay lines
             }
+            request_answer(item->tool, id, response);
         }
-        
-        tool = tool_get_next();
+    }
+}
+
+// Handle work the I/O shards handed to the main thread
+static void process_control_work(void) {
+    WorkItem* item;
+    while ((item = io_worker_take_control()) != NULL) {
+        if (item->tool && item->tool->retired) {
+            // Posted before it was unregistered; WORK_RETIRE frees it
+            io_worker_free(item);
+            continue;
+        }
+        switch (item->type) {
+            case WORK_CONTROL_LINE:
+                handle_control_line(item);
+                break;
+            case WORK_CHECK_HEALTH:
+                // A pipe closed: see if the tool exited
+                tool_check_hangup(item->tool);
+                break;
+            case WORK_TOOL_EXITED:
+                tool_check_exit(item->tool);
+                break;
+            case WORK_START_TOOL:
+                // On-demand tool that has events waiting
+                if (item->tool->status == TOOL_STOPPED &&
+                    tool_start(item->tool->name) != FW_OK) {
+                    event_loop_lock(item->tool->shard);
+                    item->tool->is_starting = false;
+                    event_loop_unlock(item->tool->shard);
+                }
+                break;
+            case WORK_SOCKET_COMMAND:
+                // Posted by the control socket thread, which waits for it
+                control_socket_run_command(item->data);
+                break;
+            default:
+                break;
+        }
+        io_worker_free(item);
     }
 }
 
@@ -242,99 +385,55 @@ void deliver_queued_events(void) {
 void framework_run(void) {
     LOG_INFO("main", "Entering main loop");
     
-    char buffer[4096];
-    char line_buffer[8192];  // Buffer for accumulating partial lines
-    int line_pos = 0;
+    if (io_worker_start() != FW_OK) {
+        return;
+    }
+    
+    bool single_shard = event_loop_shard_count() <= 1;
+    event_loop_pin(event_loop_control());
     
     while (g_running) {
-        // 1. Route events from bus to tool queues
+        // 1. Route events published outside the I/O shards
         event_process_queue();
         
-        // 2. Deliver queued events to tools (NEW!)
-        deliver_queued_events();
+        // 2. Lifecycle and subscription work handed over by the shards
+        process_control_work();
+        if (event_loop_take_child_exits()) {
+            tool_check_health();  // SIGCHLD fallback: find the tools that exited
+        }
+        event_routes_reclaim();
+        tool_reclaim();
         
-        // 3. Read from tool stdout/stderr
-        Tool* tool = tool_get_first();
-        while (tool) {
-            if (tool->status == TOOL_RUNNING) {
-                // Read stdout (events and commands)
-                if (tool->stdout_fd >= 0) {
-                    int bytes = platform_read_nonblocking(tool->stdout_fd, buffer, sizeof(buffer) - 1);
-                    if (bytes > 0) {
-                        buffer[bytes] = '\0';
-                        
-                        // Accumulate into line buffer
-                        for (int i = 0; i < bytes && line_pos < (int)sizeof(line_buffer) - 1; i++) {
-                            if (buffer[i] == '\n') {
-                                line_buffer[line_pos] = '\0';
-                                
-                                // Parse event: TYPE|sender|data
-                                char* type = strtok(line_buffer, "|");
-                                char* sender = strtok(NULL, "|");
-                                char* data = strtok(NULL, "");
-                                
-                                if (type && sender && data) {
-                                    // Handle control messages
-                                    if (strcmp(type, "SUBSCRIBE") == 0) {
-                                        // Tool subscribing to event type
-                                        LOG_DEBUG("main", "Tool %s subscribing to: %s", sender, data);
-                                        tool_subscribe(sender, data);
-                                    }
-                                    else if (strcmp(type, "TOOL_READY") == 0) {
-                                        // Tool ready signal
-                                        LOG_DEBUG("main", "Tool %s is ready: %s", sender, data);
-                                        
-                                        // Handle on-demand tools (mark as ready)
-                                        Tool* ready_tool = tool_find(sender);
-                                        if (ready_tool && ready_tool->is_on_demand && ready_tool->is_starting) {
-                                            ready_tool->is_starting = false;
-                                            LOG_INFO("main", "On-demand tool %s is now ready (queue: %d events)", 
-                                                    sender, tool_queue_count(ready_tool->inbox));
-                                        }
-                                    }
-                                    else if (strcmp(type, "COMMAND") == 0) {
-                                        // Console command - handle it
-                                        LOG_DEBUG("main", "Command from %s: %s", sender, data);
-                                        handle_console_command(sender, data);
-                                    }
-                                    else {
-                                        // Regular event - publish to event bus
-                                        LOG_DEBUG("main", "Publishing event: %s from %s", type, sender);
-                                        event_publish(type, sender, data);
-                                    }
-                                }
-                                
-                                line_pos = 0;
-                            } else {
-                                line_buffer[line_pos++] = buffer[i];
-                            }
-                        }
-                    }
-                }
-                
-                // Read stderr (logs)
-                if (tool->stderr_fd >= 0) {
-                    int bytes = platform_read_nonblocking(tool->stderr_fd, buffer, sizeof(buffer) - 1);
-                    if (bytes > 0) {
-                        buffer[bytes] = '\0';
-                        // Remove trailing newline
-                        char* newline = strchr(buffer, '\n');
-                        if (newline) *newline = '\0';
-                        LOG_INFO(tool->name, "%s", buffer);
-                    }
-                }
-            }
-            
-            tool = tool_get_next();
+        // 3. Restart, heartbeat, start and idle deadlines that are due
+        int timeout_ms = tool_run_timers();
+        
+        // 4. Event log checkpoint, when one is due, and replays to tools
+        int log_ms = event_log_run();
+        if (log_ms >= 0 && (timeout_ms < 0 || log_ms < timeout_ms)) {
+            timeout_ms = log_ms;
+        }
+        int replay_ms = log_replay_run();
+        if (replay_ms >= 0 && (timeout_ms < 0 || replay_ms < timeout_ms)) {
+            timeout_ms = replay_ms;
+        }
+        int request_ms = request_run();
+        if (request_ms >= 0 && (timeout_ms < 0 || request_ms < timeout_ms)) {
+            timeout_ms = request_ms;
         }
         
-        // Check tool health
-        tool_check_health();
+        // 5. Sleep until a pipe is ready, work is posted or the next
+        //    deadline. With one shard this thread also does its I/O.
         
-        // Sleep briefly to avoid busy-waiting
-        platform_sleep_ms(100);
+        if (single_shard) {
+            io_worker_poll(0, timeout_ms);
+        } else {
+            LoopEvent events[LOOP_MAX_EVENTS];
+            event_loop_wait(event_loop_control(), events, LOOP_MAX_EVENTS, timeout_ms);
+        }
     }
     
+    io_worker_stop();
+    
     LOG_INFO("main", "Main loop exited");
 }
 
@@ -363,8 +462,13 @@ void framework_shutdown(void) {
         debug_shutdown();
     }
     control_shutdown();
+    log_replay_shutdown();
+    event_log_close();
+    request_shutdown();
     tool_registry_shutdown();
     event_bus_shutdown();
+    event_types_shutdown();
+    event_loop_shutdown();
     platform_shutdown();
     logger_shutdown();
     
@@ -379,6 +483,16 @@ const char* framework_version(void) {
 // Handle console commands
 void handle_console_command(const char* tool_name, const char* command) {
     char response[8192];
+    execute_console_command(command, response, sizeof(response));
+    
+    // Send response back to console tool, all of it behind the prefix
+    char response_event[sizeof("RESPONSE|framework|") + sizeof(response)];
+    snprintf(response_event, sizeof(response_event), "RESPONSE|framework|%s", response);
+    send_to_tool(tool_name, response_event);
+}
+
+// Run a console command, writing what it prints to response
+static void execute_console_command(const char* command, char* response, size_t response_size) {
     response[0] = '\0';
     
     // Parse command
@@ -388,11 +502,9 @@ void handle_console_command(const char* tool_name, const char* command) {
     
     char* cmd = strtok(cmd_copy, " ");
     char* arg1 = strtok(NULL, " ");
-    char* arg2 = strtok(NULL, " ");
     
     if (!cmd) {
-        snprintf(response, sizeof(response), "RESPONSE|framework|Error: Empty command\n");
-        tool_send_event(tool_name, response);
+        snprintf(response, response_size, "Error: Empty command\n");
         return;
     }
     
@@ -404,15 +516,15 @@ void handle_console_command(const char* tool_name, const char* command) {
     // Execute command
     if (strcmp(cmd, "list") == 0) {
         int offset = 0;
-        offset += snprintf(response + offset, sizeof(response) - offset,
+        offset += snprintf(response + offset, response_size - offset,
                           "\nTools Status:\n");
-        offset += snprintf(response + offset, sizeof(response) - offset,
+        offset += snprintf(response + offset, response_size - offset,
                           "%-20s %-10s %-10s\n", "Name", "Status", "PID");
-        offset += snprintf(response + offset, sizeof(response) - offset,
+        offset += snprintf(response + offset, response_size - offset,
                           "------------------------------------------------------------\n");
         
         Tool* tool = tool_get_first();
-        while (tool && offset < (int)sizeof(response) - 100) {
+        while (tool && offset < (int)response_size - 100) {
             const char* status_str;
             switch (tool->status) {
                 case TOOL_STOPPED: status_str = "STOPPED"; break;
@@ -422,34 +534,34 @@ void handle_console_command(const char* tool_name, const char* command) {
                 default:           status_str = "UNKNOWN"; break;
             }
             
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "%-20s %-10s %-10d\n", tool->name, status_str, (int)tool->pid);
             tool = tool_get_next();
         }
-        snprintf(response + offset, sizeof(response) - offset, "\n");
+        snprintf(response + offset, response_size - offset, "\n");
     }
     else if (strcmp(cmd, "start") == 0 && arg1) {
         int result = tool_start(arg1);
         if (result == FW_OK) {
             Tool* tool = tool_find(arg1);
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Success: Tool '%s' started\n  PID: %d\n  Status: RUNNING\n",
                     arg1, tool ? (int)tool->pid : 0);
         } else if (result == FW_ERROR_NOT_FOUND) {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Error: Tool '%s' not found in configuration\n", arg1);
         } else {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Error: Failed to start tool '%s'\n", arg1);
         }
     }
     else if (strcmp(cmd, "stop") == 0 && arg1) {
         int result = tool_stop(arg1);
         if (result == FW_OK) {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Success: Tool '%s' stopped\n", arg1);
         } else {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Error: Failed to stop tool '%s'\n", arg1);
         }
     }
@@ -457,11 +569,11 @@ void handle_console_command(const char* tool_name, const char* command) {
         int result = tool_restart(arg1);
         if (result == FW_OK) {
             Tool* tool = tool_find(arg1);
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Success: Tool '%s' restarted\n  PID: %d\n",
                     arg1, tool ? (int)tool->pid : 0);
         } else {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Error: Failed to restart tool '%s'\n", arg1);
         }
     }
@@ -469,36 +581,47 @@ void handle_console_command(const char* tool_name, const char* command) {
         Tool* tool = tool_find(arg1);
         
         if (!tool) {
-            snprintf(response, sizeof(response),
+            snprintf(response, response_size,
                     "Error: Tool '%s' not found\n", arg1);
         } else {
             int offset = 0;
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "\nTool Status:\n");
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  Name: %s\n", tool->name);
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  Command: %s\n", tool->command);
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  Status: %s\n",
                              tool->status == TOOL_RUNNING ? "RUNNING" :
                              tool->status == TOOL_STOPPED ? "STOPPED" :
                              tool->status == TOOL_CRASHED ? "CRASHED" : "UNKNOWN");
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  PID: %d\n", (int)tool->pid);
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  Autostart: %s\n", tool->autostart ? "yes" : "no");
-            offset += snprintf(response + offset, sizeof(response) - offset,
+            offset += snprintf(response + offset, response_size - offset,
                              "  Restart on crash: %s\n", tool->restart_on_crash ? "yes" : "no");
-            offset += snprintf(response + offset, sizeof(response) - offset,
-                             "  Events sent: %lu\n", tool->events_sent);
-            offset += snprintf(response + offset, sizeof(response) - offset,
-                             "  Events received: %lu\n", tool->events_received);
-            snprintf(response + offset, sizeof(response) - offset, "\n");
+            offset += snprintf(response + offset, response_size - offset,
+                             "  Events sent: %d\n", tool->events_sent);
+            offset += snprintf(response + offset, response_size - offset,
+                             "  Events received: %d\n", tool->events_received);
+            offset += snprintf(response + offset, response_size - offset,
+                             "  Last sequence: %" PRIu64 " (%" PRIu64 " repeats dropped)\n",
+                             (uint64_t)atomic_load(&tool->publish_seq),
+                             (uint64_t)atomic_load(&tool->duplicates));
+            offset += snprintf(response + offset, response_size - offset,
+                             "  Queued: %d events, %zu bytes\n",
+                             tool_queue_count(tool->inbox), tool_queue_bytes(tool->inbox));
+            if (tool->queue_policy == QUEUE_POLICY_CONFLATE) {
+                offset += snprintf(response + offset, response_size - offset,
+                                 "  Conflated: %d events\n", tool_queue_conflated(tool->inbox));
+            }
+            snprintf(response + offset, response_size - offset, "\n");
         }
     }
     else if (strcmp(cmd, "shutdown") == 0) {
-        snprintf(response, sizeof(response), "Shutting down framework...\n");
+        snprintf(response, response_size, "Shutting down framework...\n");
         g_running = false;
     }
     else if (strcmp(cmd, "uptime") == 0) {
@@ -512,22 +635,38 @@ void handle_console_command(const char* tool_name, const char* command) {
         uint64_t minutes = (uptime % 3600) / 60;
         uint64_t seconds = uptime % 60;
         
-        snprintf(response, sizeof(response),
-                "Framework uptime: %lluh %llum %llus\n",
+        snprintf(response, response_size,
+                "Framework uptime: %" PRIu64 "h %" PRIu64 "m %" PRIu64 "s\n",
                 hours, minutes, seconds);
     }
+    else if (strcmp(cmd, "loops") == 0 || strcmp(cmd, "types") == 0 ||
+             strcmp(cmd, "eventlog") == 0 || strcmp(cmd, "requests") == 0 ||
+             strcmp(cmd, "bus") == 0) {
+        control_execute_command(cmd, response, response_size);
+    }
+    else if (strcmp(cmd, "replay") == 0) {
+        control_execute_command(command, response, response_size);
+    }
     else if (strcmp(cmd, "version") == 0) {
-        snprintf(response, sizeof(response),
+        snprintf(response, response_size,
                 "Yuki-Frame version %s\n", framework_version());
     }
     else if (strcmp(cmd, "help") == 0) {
-        snprintf(response, sizeof(response),
+        snprintf(response, response_size,
                 "\nAvailable commands:\n"
                 "  list                 - List all tools and their status\n"
                 "  start <tool>         - Start a tool\n"
                 "  stop <tool>          - Stop a tool\n"
                 "  restart <tool>       - Restart a tool\n"
                 "  status <tool>        - Show detailed tool status\n"
+                "  loops                - Show event loop wait counters\n"
+                "  types                - Show per-event-type counters\n"
+                "  eventlog             - Show event log counters\n"
+                "  requests             - Show request/reply counters\n"
+                "  bus                  - Show event bus memory and paused publishers\n"
+                "  replay <tool> [--from <lsn|time>] [--types A,B] [--rate N]\n"
+                "                       - Send logged events to a tool again\n"
+                "  replay <tool> stop   - Stop a replay; 'replay' lists them\n"
                 "  uptime               - Show framework uptime\n"
                 "  version              - Show framework version\n"
                 "  shutdown             - Shutdown the framework\n"
@@ -535,15 +674,10 @@ void handle_console_command(const char* tool_name, const char* command) {
                 "\n");
     }
     else {
-        snprintf(response, sizeof(response),
+        snprintf(response, response_size,
                 "Error: Unknown command '%s'\nType 'help' for available commands\n",
                 cmd);
     }
-    
-    // Send response back to console tool
-    char response_event[8192];
-    snprintf(response_event, sizeof(response_event), "RESPONSE|framework|%s", response);
-    tool_send_event(tool_name, response_event);
 }
 
 // Main entry point
@@ -559,7 +693,8 @@ int main(int argc, char** argv) {
             return 0;
         }
         else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--version") == 0) {
-            printf("%s v%s (Windows)\n", YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING);
+            printf("%s v%s (%s)\n", YUKI_FRAME_NAME, YUKI_FRAME_VERSION_STRING,
+                   YUKI_FRAME_PLATFORM_NAME);
             printf("Integrated Control Socket Server\n");
             return 0;
         }
@@ -601,8 +736,10 @@ int main(int argc, char** argv) {
     signal(SIGTERM, signal_handler);
     signal(SIGABRT, signal_handler);
     
+#ifdef PLATFORM_WINDOWS
     // Setup Windows console control handler
     SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
+#endif
     
     // Set debug flag before framework_init()
     if (debug_mode) {
@@ -0,0 +1,379 @@
+/**
+ * @file request.c
+ * @brief Request/reply routing with correlation IDs and timeouts
+ *
+ * A request is routed on the shard that read it, to one responder picked
+ * from the routing snapshot, and waits in a fixed table of pending
+ * requests until the reply comes back or it times out. The responder sees
+ * the core's reference for it rather than the requester's id, so ids only
+ * have to be unique per requester; a reference encodes its slot, so a
+ * reply finds its request without a search. The main loop sweeps the
+ * table for timeouts when the earliest deadline is due. Expired or
+ * orphaned requests are copied out under the lock and answered after it
+ * is released, in batches of REQUEST_SWEEP_BATCH.
+ */
+
+#include "yuki_frame/request.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/event_buffer.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REQUEST_SWEEP_BATCH 64
+
+typedef struct {
+    uint64_t ref;               // Sequence * REQUEST_MAX_PENDING + slot, 0 = free
+    Tool* requester;
+    Tool* responder;
+    uint64_t deadline_ms;       // Monotonic
+    char id[REQUEST_MAX_ID];    // The requester's id
+} PendingRequest;
+
+static PendingRequest* pending = NULL;
+static PlatformMutex request_lock;
+static int timeout_ms = REQUEST_DEFAULT_TIMEOUT_MS;
+static uint64_t sequence = 0;
+static int free_hint = 0;
+static uint64_t next_deadline_ms = 0;
+static RequestStats stats;
+static atomic_uint turn = 0;
+
+int request_init(int timeout) {
+    if (pending) {
+        return FW_OK;
+    }
+    pending = calloc(REQUEST_MAX_PENDING, sizeof(PendingRequest));
+    if (!pending) {
+        return FW_ERROR_MEMORY;
+    }
+    platform_mutex_init(&request_lock);
+    timeout_ms = timeout > 0 ? timeout : REQUEST_DEFAULT_TIMEOUT_MS;
+    sequence = 0;
+    free_hint = 0;
+    next_deadline_ms = 0;
+    memset(&stats, 0, sizeof(stats));
+    return FW_OK;
+}
+
+void request_shutdown(void) {
+    if (!pending) {
+        return;
+    }
+    if (stats.pending > 0) {
+        LOG_INFO("request", "Dropping %d unanswered requests", stats.pending);
+    }
+    free(pending);
+    pending = NULL;
+    platform_mutex_destroy(&request_lock);
+}
+
+bool request_parse(const char* data, char* id, char* type, const char** payload) {
+    const char* id_end = strchr(data, '|');
+    if (!id_end || id_end == data || id_end - data >= REQUEST_MAX_ID) {
+        return false;
+    }
+    const char* type_start = id_end + 1;
+    const char* type_end = strchr(type_start, '|');
+    size_t type_len = type_end ? (size_t)(type_end - type_start) : strlen(type_start);
+    if (type_len == 0 || type_len >= MAX_EVENT_TYPE) {
+        return false;
+    }
+
+    memcpy(id, data, (size_t)(id_end - data));
+    id[id_end - data] = '\0';
+    memcpy(type, type_start, type_len);
+    type[type_len] = '\0';
+    if (strchr(type, '*') || strchr(type, '#')) {
+        return false;   // A request names one type, not a pattern
+    }
+    *payload = type_end ? type_end + 1 : "";
+    return true;
+}
+
+// Queue "<id>|<payload>" as a type event from sender for tool
+static int deliver_reply(Tool* tool, const char* type, const char* sender, const char* id,
+                         const char* payload, EventPriority priority) {
+    size_t id_len = strlen(id);
+    size_t payload_len = strlen(payload);
+    char* data = malloc(id_len + payload_len + 2);
+    if (!data) {
+        return FW_ERROR_MEMORY;
+    }
+    memcpy(data, id, id_len);
+    data[id_len] = '|';
+    memcpy(data + id_len + 1, payload, payload_len + 1);
+
+    EventBuffer* buffer = event_buffer_format(type, sender, data);
+    free(data);
+    if (!buffer) {
+        return FW_ERROR_MEMORY;
+    }
+    buffer->priority = priority;
+    return io_worker_deliver(tool, buffer);
+}
+
+static void answer_error(Tool* requester, const char* id, const char* reason) {
+    platform_mutex_lock(&request_lock);
+    stats.failed++;
+    platform_mutex_unlock(&request_lock);
+    LOG_DEBUG("request", "Request %s from %s failed: %s", id, requester->name, reason);
+    deliver_reply(requester, "REPLY_ERROR", "framework", id, reason, EVENT_PRIORITY_NORMAL);
+}
+
+// Take a free slot; called with the lock held. NULL when the table is full.
+static PendingRequest* pending_add(void) {
+    for (int i = 0; i < REQUEST_MAX_PENDING; i++) {
+        int slot = (free_hint + i) % REQUEST_MAX_PENDING;
+        if (pending[slot].ref == 0) {
+            free_hint = (slot + 1) % REQUEST_MAX_PENDING;
+            pending[slot].ref = ++sequence * REQUEST_MAX_PENDING + (uint64_t)slot;
+            stats.pending++;
+            return &pending[slot];
+        }
+    }
+    return NULL;
+}
+
+// Copy out and free the request ref names; called with the lock held
+static bool pending_take(uint64_t ref, const Tool* responder, PendingRequest* request) {
+    PendingRequest* slot = &pending[ref % REQUEST_MAX_PENDING];
+    if (ref == 0 || slot->ref != ref || (responder && slot->responder != responder)) {
+        return false;
+    }
+    *request = *slot;
+    slot->ref = 0;
+    stats.pending--;
+    return true;
+}
+
+int request_send(Tool* requester, const char* data, EventPriority priority) {
+    if (!pending || !requester || !data) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    char id[REQUEST_MAX_ID];
+    char type[MAX_EVENT_TYPE];
+    const char* payload;
+    if (!request_parse(data, id, type, &payload)) {
+        const char* bar = strchr(data, '|');
+        size_t id_len = bar ? (size_t)(bar - data) : strlen(data);
+        if (id_len >= REQUEST_MAX_ID) {
+            id_len = 0;
+        }
+        memcpy(id, data, id_len);
+        id[id_len] = '\0';
+        LOG_WARN("request", "Malformed request from %s", requester->name);
+        answer_error(requester, id, "malformed request");
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    if (strcmp(type, REQUEST_COMMAND_TYPE) == 0) {
+        // Console commands run on the main thread
+        return io_worker_post_control(WORK_CONTROL_LINE, requester, "REQUEST",
+                                      requester->name, data);
+    }
+
+    Tool* responder = event_route_one(type, payload, requester,
+                                      atomic_fetch_add_explicit(&turn, 1, memory_order_relaxed));
+    if (!responder) {
+        answer_error(requester, id, "no responder");
+        return FW_ERROR_NOT_FOUND;
+    }
+
+    platform_mutex_lock(&request_lock);
+    PendingRequest* request = pending_add();
+    if (!request) {
+        platform_mutex_unlock(&request_lock);
+        answer_error(requester, id, "too many pending requests");
+        return FW_ERROR_QUEUE_FULL;
+    }
+    request->requester = requester;
+    request->responder = responder;
+    request->deadline_ms = platform_monotonic_ms() + (uint64_t)timeout_ms;
+    memcpy(request->id, id, sizeof(id));
+    uint64_t ref = request->ref;
+    // Every request waits as long, so only the first one pending moves
+    // the earliest deadline
+    bool wake = stats.pending == 1;
+    if (wake) {
+        next_deadline_ms = request->deadline_ms;
+    }
+    platform_mutex_unlock(&request_lock);
+    if (wake) {
+        event_loop_wakeup(event_loop_control());
+    }
+
+    char header[64];
+    snprintf(header, sizeof(header), "%" PRIu64, ref);
+    size_t header_len = strlen(header);
+    size_t rest_len = strlen(data) - strlen(id);   // "|<TYPE>|<payload>"
+    char* forward = malloc(header_len + rest_len + 1);
+    int result = FW_ERROR_MEMORY;
+    if (forward) {
+        memcpy(forward, header, header_len);
+        memcpy(forward + header_len, data + strlen(id), rest_len + 1);
+        EventBuffer* buffer = event_buffer_format("REQUEST", requester->name, forward);
+        free(forward);
+        if (buffer) {
+            buffer->priority = priority;
+            result = io_worker_deliver(responder, buffer);
+        }
+    }
+    if (result != FW_OK) {
+        PendingRequest dropped;
+        platform_mutex_lock(&request_lock);
+        bool taken = pending_take(ref, NULL, &dropped);
+        platform_mutex_unlock(&request_lock);
+        if (taken) {
+            answer_error(requester, id, "responder busy");
+        }
+        return result;
+    }
+    platform_mutex_lock(&request_lock);
+    stats.sent++;
+    platform_mutex_unlock(&request_lock);
+    LOG_TRACE("request", "Request %s from %s sent to %s as %" PRIu64,
+              id, requester->name, responder->name, ref);
+    return FW_OK;
+}
+
+int request_reply(Tool* responder, const char* data, bool error, EventPriority priority) {
+    if (!pending || !responder || !data) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    char* end;
+    uint64_t ref = strtoull(data, &end, 10);
+    const char* payload = *end == '|' ? end + 1 : "";
+    if (end == data || (*end != '|' && *end != '\0')) {
+        ref = 0;
+    }
+
+    PendingRequest request;
+    platform_mutex_lock(&request_lock);
+    bool found = pending_take(ref, responder, &request);
+    if (found) {
+        stats.replied++;
+    } else {
+        stats.late++;
+    }
+    platform_mutex_unlock(&request_lock);
+    if (!found) {
+        LOG_DEBUG("request", "Reply from %s to no pending request", responder->name);
+        return FW_ERROR_NOT_FOUND;
+    }
+
+    return deliver_reply(request.requester, error ? "REPLY_ERROR" : "REPLY", responder->name,
+                         request.id, payload, priority);
+}
+
+int request_answer(Tool* requester, const char* id, const char* payload) {
+    if (!pending || !requester) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    platform_mutex_lock(&request_lock);
+    stats.replied++;
+    platform_mutex_unlock(&request_lock);
+    return deliver_reply(requester, "REPLY", "framework", id, payload, EVENT_PRIORITY_NORMAL);
+}
+
+int request_run(void) {
+    if (!pending) {
+        return -1;
+    }
+
+    uint64_t now = platform_monotonic_ms();
+    PendingRequest expired[REQUEST_SWEEP_BATCH];
+    int count;
+    uint64_t next;
+    do {
+        platform_mutex_lock(&request_lock);
+        if (stats.pending == 0) {
+            platform_mutex_unlock(&request_lock);
+            return -1;
+        }
+        if (now < next_deadline_ms) {
+            platform_mutex_unlock(&request_lock);
+            return (int)(next_deadline_ms - now);
+        }
+
+        count = 0;
+        next = 0;
+        for (int slot = 0; slot < REQUEST_MAX_PENDING; slot++) {
+            PendingRequest* request = &pending[slot];
+            if (request->ref == 0) {
+                continue;
+            }
+            if (request->deadline_ms > now) {
+                if (next == 0 || request->deadline_ms < next) {
+                    next = request->deadline_ms;
+                }
+                continue;
+            }
+            if (count == REQUEST_SWEEP_BATCH) {
+                next = now;   // Swept again once this batch is answered
+                break;
+            }
+            expired[count++] = *request;
+            request->ref = 0;
+            stats.pending--;
+            stats.timed_out++;
+        }
+        next_deadline_ms = next;
+        platform_mutex_unlock(&request_lock);
+
+        for (int i = 0; i < count; i++) {
+            LOG_DEBUG("request", "Request %s from %s to %s timed out",
+                      expired[i].id, expired[i].requester->name, expired[i].responder->name);
+            deliver_reply(expired[i].requester, "REPLY_ERROR", "framework", expired[i].id,
+                          "timeout", EVENT_PRIORITY_NORMAL);
+        }
+    } while (count == REQUEST_SWEEP_BATCH);
+    return next == 0 ? -1 : (int)(next - now);
+}
+
+void request_forget_tool(const Tool* tool) {
+    if (!pending || !tool) {
+        return;
+    }
+
+    PendingRequest orphaned[REQUEST_SWEEP_BATCH];
+    int count;
+    do {
+        count = 0;
+        platform_mutex_lock(&request_lock);
+        for (int slot = 0; slot < REQUEST_MAX_PENDING && count < REQUEST_SWEEP_BATCH; slot++) {
+            PendingRequest* request = &pending[slot];
+            if (request->ref == 0 || (request->requester != tool && request->responder != tool)) {
+                continue;
+            }
+            if (request->requester != tool) {
+                orphaned[count++] = *request;   // Its requester is still waiting
+            }
+            request->ref = 0;
+            stats.pending--;
+        }
+        platform_mutex_unlock(&request_lock);
+
+        for (int i = 0; i < count; i++) {
+            answer_error(orphaned[i].requester, orphaned[i].id, "responder gone");
+        }
+    } while (count == REQUEST_SWEEP_BATCH);
+}
+
+void request_get_stats(RequestStats* out) {
+    if (!pending) {
+        memset(out, 0, sizeof(RequestStats));
+        return;
+    }
+    platform_mutex_lock(&request_lock);
+    *out = stats;
+    platform_mutex_unlock(&request_lock);
+}
@@ -0,0 +1,137 @@
+/**
+ * @file ring.c
+ * @brief Bounded lock-free MPSC ring
+ *
+ * Each cell carries a sequence number. A producer claims slot `pos` with a
+ * CAS on head once the cell's sequence equals pos, writes the item and
+ * publishes it by storing pos + 1. The consumer takes the cell when its
+ * sequence is pos + 1 and frees it for the next lap by storing
+ * pos + capacity.
+ *
+ * A batch claims count slots with one CAS. The consumer frees cells in
+ * order, so once the batch's last cell is free for this lap all the cells
+ * before it are too.
+ */
+
+#include "yuki_frame/ring.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+Ring* ring_create(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    Ring* ring = (Ring*)calloc(1, sizeof(Ring));
+    if (!ring) {
+        return NULL;
+    }
+
+    ring->cells = (RingCell*)calloc(size, sizeof(RingCell));
+    if (!ring->cells) {
+        free(ring);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&ring->cells[i].sequence, i);
+        ring->cells[i].item = NULL;
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return ring;
+}
+
+void ring_destroy(Ring* ring) {
+    if (!ring) {
+        return;
+    }
+    free(ring->cells);
+    free(ring);
+}
+
+bool ring_push(Ring* ring, void* item) {
+    size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (;;) {
+        RingCell* cell = &ring->cells[pos & ring->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->item = item;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+            // pos was reloaded by the failed CAS
+        } else if (diff < 0) {
+            return false;  // Full: the consumer has not freed this cell yet
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool ring_push_batch(Ring* ring, void* const* items, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+    if (count > ring->mask + 1) {
+        return false;
+    }
+
+    size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        size_t last = pos + count - 1;
+        RingCell* cell = &ring->cells[last & ring->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)last;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + count,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // Not enough free cells
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        RingCell* cell = &ring->cells[(pos + i) & ring->mask];
+        cell->item = items[i];
+        atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+    }
+    return true;
+}
+
+void* ring_pop(Ring* ring) {
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    RingCell* cell = &ring->cells[pos & ring->mask];
+    size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+
+    if ((intptr_t)sequence - (intptr_t)(pos + 1) < 0) {
+        return NULL;  // Empty, or the producer has not published yet
+    }
+
+    void* item = cell->item;
+    atomic_store_explicit(&ring->tail, pos + 1, memory_order_relaxed);
+    atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+    return item;
+}
+
+bool ring_is_empty(Ring* ring) {
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    RingCell* cell = &ring->cells[pos & ring->mask];
+    size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    return (intptr_t)sequence - (intptr_t)(pos + 1) < 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file slab.c
+ * @brief Size-class slab allocator
+ *
+ * Each slab starts with a small header linking it into the pool's slab
+ * chain; the rest is split into blocks of one class, all pushed onto that
+ * class's free list at once. A free block's first word links it to the
+ * next free block.
+ *
+ * Blocks freed by other threads are pushed onto the pool's remote list
+ * with a CAS. Only the owner takes from that list, and it takes the whole
+ * list at once with an exchange, so pushes cannot suffer ABA.
+ */
+
+#include "yuki_frame/slab.h"
+#include <stdlib.h>
+
+typedef struct SlabHeader {
+    struct SlabHeader* next;
+    char pad[16 - sizeof(void*)];   // Keep blocks 16-byte aligned, like malloc
+} SlabHeader;
+
+// A block on the remote list remembers its size (blocks are >= 32 bytes)
+typedef struct RemoteBlock {
+    struct RemoteBlock* next;
+    size_t size;
+} RemoteBlock;
+
+static int slab_class(size_t size) {
+    int index = 0;
+    size_t block = (size_t)1 << SLAB_MIN_SHIFT;
+    while (block < size) {
+        block <<= 1;
+        index++;
+    }
+    return index;
+}
+
+static size_t class_size(int index) {
+    return (size_t)1 << (SLAB_MIN_SHIFT + index);
+}
+
+static bool slab_refill(SlabPool* pool, int index) {
+    SlabHeader* slab = (SlabHeader*)malloc(SLAB_SIZE);
+    if (!slab) {
+        return false;
+    }
+    slab->next = (SlabHeader*)pool->slabs;
+    pool->slabs = slab;
+    pool->reserved += SLAB_SIZE;
+
+    size_t size = class_size(index);
+    char* block = (char*)slab + sizeof(SlabHeader);
+    char* end = (char*)slab + SLAB_SIZE;
+    void* head = pool->free_lists[index];
+    while (block + size <= end) {
+        *(void**)block = head;
+        head = block;
+        block += size;
+    }
+    pool->free_lists[index] = head;
+    return true;
+}
+
+// Put blocks other threads returned back on the local free lists
+static void reclaim_remote(SlabPool* pool) {
+    RemoteBlock* block = (RemoteBlock*)atomic_exchange_explicit(&pool->remote_free, NULL,
+                                                                memory_order_acquire);
+    while (block) {
+        RemoteBlock* next = block->next;
+        slab_free(pool, block, block->size);
+        block = next;
+    }
+}
+
+void slab_pool_init(SlabPool* pool) {
+    for (int i = 0; i < SLAB_CLASS_COUNT; i++) {
+        pool->free_lists[i] = NULL;
+    }
+    pool->slabs = NULL;
+    pool->reserved = 0;
+    pool->in_use = 0;
+    atomic_init(&pool->remote_free, NULL);
+}
+
+void slab_pool_destroy(SlabPool* pool) {
+    reclaim_remote(pool);  // Large blocks are freed here
+    SlabHeader* slab = (SlabHeader*)pool->slabs;
+    while (slab) {
+        SlabHeader* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    slab_pool_init(pool);
+}
+
+void* slab_alloc(SlabPool* pool, size_t size) {
+    if (atomic_load_explicit(&pool->remote_free, memory_order_relaxed)) {
+        reclaim_remote(pool);
+    }
+
+    if (size > SLAB_MAX_BLOCK) {
+        void* block = malloc(size);
+        if (block) {
+            pool->reserved += size;
+            pool->in_use += size;
+        }
+        return block;
+    }
+
+    int index = slab_class(size);
+    if (!pool->free_lists[index] && !slab_refill(pool, index)) {
+        return NULL;
+    }
+    void* block = pool->free_lists[index];
+    pool->free_lists[index] = *(void**)block;
+    pool->in_use += class_size(index);
+    return block;
+}
+
+void slab_free(SlabPool* pool, void* block, size_t size) {
+    if (!block) {
+        return;
+    }
+    if (size > SLAB_MAX_BLOCK) {
+        free(block);
+        pool->reserved -= size;
+        pool->in_use -= size;
+        return;
+    }
+
+    int index = slab_class(size);
+    *(void**)block = pool->free_lists[index];
+    pool->free_lists[index] = block;
+    pool->in_use -= class_size(index);
+}
+
+void slab_free_remote(SlabPool* pool, void* block, size_t size) {
+    if (!block) {
+        return;
+    }
+    RemoteBlock* remote = (RemoteBlock*)block;
+    remote->size = size;
+    void* head = atomic_load_explicit(&pool->remote_free, memory_order_relaxed);
+    do {
+        remote->next = (RemoteBlock*)head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->remote_free, &head, block,
+                                                    memory_order_release, memory_order_relaxed));
+}
@@ -0,0 +1,211 @@
+/**
+ * @file timer_wheel.c
+ * @brief Hierarchical timer wheel
+ *
+ * Level 0 has one slot per tick; a slot of level L spans 64^L ticks. A
+ * timer goes into the finest level whose current lap still reaches its
+ * deadline. When the clock enters a coarse slot's span, that slot is
+ * cascaded: its timers are re-inserted and land in finer levels, until
+ * they reach level 0 and fire. Each level keeps a bitmap of its non-empty
+ * slots so empty stretches are skipped and the next deadline is found
+ * without walking lists.
+ */
+
+#include "yuki_frame/timer_wheel.h"
+#include <limits.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#define SLOT_MASK ((uint64_t)TIMER_WHEEL_SLOTS - 1)
+
+static int lowest_bit(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static uint64_t rotate_right(uint64_t bits, int n) {
+    n &= TIMER_WHEEL_SLOTS - 1;
+    return n ? (bits >> n) | (bits << (TIMER_WHEEL_SLOTS - n)) : bits;
+}
+
+static void wheel_link(TimerWheel* wheel, Timer* timer) {
+    uint64_t expires = timer->expires < wheel->now ? wheel->now : timer->expires;
+
+    // Finest level whose current lap reaches the deadline
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           (expires >> (TIMER_WHEEL_BITS * level)) -
+           (wheel->now >> (TIMER_WHEEL_BITS * level)) >= TIMER_WHEEL_SLOTS) {
+        level++;
+    }
+
+    uint64_t bucket = expires >> (TIMER_WHEEL_BITS * level);
+    uint64_t current = wheel->now >> (TIMER_WHEEL_BITS * level);
+    if (bucket - current >= TIMER_WHEEL_SLOTS) {
+        // Beyond the whole wheel: park in the last slot, cascaded again later
+        bucket = current + TIMER_WHEEL_SLOTS - 1;
+    }
+    int slot = (int)(bucket & SLOT_MASK);
+
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = wheel->slots[level][slot];
+    if (timer->next) {
+        timer->next->prev = timer;
+    }
+    wheel->slots[level][slot] = timer;
+    wheel->occupied[level] |= (uint64_t)1 << slot;
+}
+
+static void wheel_unlink(TimerWheel* wheel, Timer* timer) {
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        wheel->slots[timer->level][timer->slot] = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    if (!wheel->slots[timer->level][timer->slot]) {
+        wheel->occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->level = -1;
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint64_t now_ms) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now_ms / TIMER_TICK_MS;
+}
+
+void timer_init(Timer* timer, TimerCallback callback, void* arg) {
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->level = -1;
+}
+
+bool timer_is_armed(const Timer* timer) {
+    return timer->level >= 0;
+}
+
+void timer_wheel_arm(TimerWheel* wheel, Timer* timer, uint64_t deadline_ms) {
+    if (timer_is_armed(timer)) {
+        wheel_unlink(wheel, timer);
+        wheel->count--;
+    }
+
+    // Round up so a timer never fires before its deadline
+    uint64_t expires = (deadline_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    if (expires <= wheel->now) {
+        expires = wheel->now + 1;
+    }
+    timer->expires = expires;
+
+    wheel_link(wheel, timer);
+    wheel->count++;
+}
+
+void timer_wheel_cancel(TimerWheel* wheel, Timer* timer) {
+    if (timer_is_armed(timer)) {
+        wheel_unlink(wheel, timer);
+        wheel->count--;
+    }
+}
+
+// Tick at which the wheel next has work: a level 0 slot firing or a coarse
+// slot being cascaded (UINT64_MAX when empty)
+static uint64_t wheel_next_tick(const TimerWheel* wheel) {
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t bits = wheel->occupied[level];
+        if (!bits) {
+            continue;
+        }
+
+        // Nearest non-empty slot after the current one, in slot spans
+        int shift = TIMER_WHEEL_BITS * level;
+        uint64_t current = wheel->now >> shift;
+        int current_slot = (int)(current & SLOT_MASK);
+        int distance = lowest_bit(rotate_right(bits, current_slot + 1)) + 1;
+
+        uint64_t tick = (current + (uint64_t)distance) << shift;
+        if (tick < next) {
+            next = tick;
+        }
+    }
+    return next;
+}
+
+// Re-insert a coarse slot's timers now that its span has started
+static void wheel_cascade(TimerWheel* wheel, int level, int slot) {
+    Timer* timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~((uint64_t)1 << slot);
+
+    while (timer) {
+        Timer* next = timer->next;
+        wheel_link(wheel, timer);
+        timer = next;
+    }
+}
+
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms) {
+    uint64_t target = now_ms / TIMER_TICK_MS;
+    int fired = 0;
+
+    while (wheel->now < target) {
+        // Skip the ticks where nothing fires or cascades
+        uint64_t next = wheel_next_tick(wheel);
+        if (next > wheel->now + 1) {
+            wheel->now = next - 1 < target ? next - 1 : target;
+            continue;
+        }
+
+        wheel->now++;
+
+        // Cascade coarse slots whose span starts at this tick, coarsest first
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            uint64_t span = ((uint64_t)1 << (TIMER_WHEEL_BITS * level)) - 1;
+            if ((wheel->now & span) == 0) {
+                int slot = (int)((wheel->now >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+                wheel_cascade(wheel, level, slot);
+            }
+        }
+
+        // Fire this tick's slot; callbacks may re-arm (never into this slot)
+        int slot = (int)(wheel->now & SLOT_MASK);
+        Timer* timer;
+        while ((timer = wheel->slots[0][slot]) != NULL) {
+            wheel_unlink(wheel, timer);
+            wheel->count--;
+            timer->callback(timer, timer->arg);
+            fired++;
+        }
+    }
+
+    return fired;
+}
+
+int timer_wheel_next_timeout(const TimerWheel* wheel, uint64_t now_ms) {
+    if (wheel->count == 0) {
+        return -1;
+    }
+
+    uint64_t deadline_ms = wheel_next_tick(wheel) * TIMER_TICK_MS;
+    if (deadline_ms <= now_ms) {
+        return 0;
+    }
+    uint64_t remaining = deadline_ms - now_ms;
+    return remaining > INT_MAX ? INT_MAX : (int)remaining;
+}
@@ -2,23 +2,77 @@
 #include "yuki_frame/tool_queue.h"
 #include "yuki_frame/logger.h"
 #include "yuki_frame/platform.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/dedup.h"
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/request.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <io.h>  // For _open_osfhandle
 
 // Tool registry
 static ToolRegistry registry;
 static int current_iterator = 0;
 
+// Unregistered tools that shards may still reach, linked through next
+static Tool* retired_tools = NULL;
+
+// Lifecycle deadlines, driven by the main loop through tool_run_timers()
+static TimerWheel timers;
+static Timer health_timer;
+
+static void on_restart_timer(Timer* timer, void* arg);
+static void on_heartbeat_timer(Timer* timer, void* arg);
+static void on_start_timer(Timer* timer, void* arg);
+static void on_idle_timer(Timer* timer, void* arg);
+static void on_exit_timer(Timer* timer, void* arg);
+static void on_health_timer(Timer* timer, void* arg);
+
+// Cancel the deadlines that only apply while the tool runs
+static void tool_disarm_timers(Tool* tool) {
+    timer_wheel_cancel(&timers, &tool->heartbeat_timer);
+    timer_wheel_cancel(&timers, &tool->start_timer);
+    timer_wheel_cancel(&timers, &tool->idle_timer);
+    timer_wheel_cancel(&timers, &tool->exit_timer);
+}
+
+// Close a tool's pipe ends (safe to call more than once)
+static void tool_close_pipes(Tool* tool) {
+    event_loop_remove_tool(tool);  // Unwatch before the fds can be reused
+    tool->exit_fd = -1;            // Owned by the platform layer
+    platform_close_fd(tool->stdin_fd);
+    platform_close_fd(tool->stdout_fd);
+    platform_close_fd(tool->stderr_fd);
+    tool->stdin_fd = -1;
+    tool->stdout_fd = -1;
+    tool->stderr_fd = -1;
+}
+
 int tool_registry_init(void) {
     memset(&registry, 0, sizeof(registry));
     registry.count = 0;
+    
+    uint64_t now = platform_monotonic_ms();
+    timer_wheel_init(&timers, now);
+    timer_init(&health_timer, on_health_timer, NULL);
+    timer_wheel_arm(&timers, &health_timer, now + TOOL_HEALTH_SWEEP_INTERVAL_MS);
+    
     LOG_INFO("tool", "Tool registry initialized");
     return FW_OK;
 }
 
+// Routing snapshots hold their own references
+static void tool_free_filters(Tool* tool) {
+    for (int i = 0; i < tool->subscription_count; i++) {
+        event_filter_release(tool->filters[i]);
+        tool->filters[i] = NULL;
+    }
+}
+
 void tool_registry_shutdown(void) {
     // Stop all running tools
     for (int i = 0; i < registry.count; i++) {
@@ -27,24 +81,32 @@ void tool_registry_shutdown(void) {
         }
     }
     
-    // Free all tools
+    // Free every queue first: a queued event is charged to the tool that
+    // published it (flow_control.h)
+    for (int i = 0; i < registry.count; i++) {
+        if (registry.tools[i] && registry.tools[i]->inbox) {
+            tool_queue_shutdown(registry.tools[i]->inbox);
+            registry.tools[i]->inbox = NULL;
+        }
+    }
+    
+    // Free all tools; the I/O shards are stopped by now
     for (int i = 0; i < registry.count; i++) {
         if (registry.tools[i]) {
-            // Free subscriptions
-            for (int j = 0; j < registry.tools[i]->subscription_count; j++) {
-                if (registry.tools[i]->subscriptions[j]) {
-                    free(registry.tools[i]->subscriptions[j]);
-                }
-            }
-            // Free queue (NEW!)
-            if (registry.tools[i]->inbox) {
-                tool_queue_shutdown(registry.tools[i]->inbox);
-            }
-            free(registry.tools[i]);
+            tool_disarm_timers(registry.tools[i]);
+            timer_wheel_cancel(&timers, &registry.tools[i]->restart_timer);
+            tool_destroy(registry.tools[i]);
             registry.tools[i] = NULL;
         }
     }
     registry.count = 0;
+    while (retired_tools) {
+        Tool* next = retired_tools->next;
+        tool_destroy(retired_tools);
+        retired_tools = next;
+    }
+    timer_wheel_cancel(&timers, &health_timer);
+    event_routes_changed();
     LOG_INFO("tool", "Tool registry shutdown");
 }
 
@@ -83,19 +145,57 @@ int tool_register(const char* name, const char* command) {
     tool->events_received = 0;
     tool->start_time = 0;
     tool->log_lines = 0;
+    tool->process_handle = INVALID_PROCESS_HANDLE;
+    tool->stdin_fd = -1;
+    tool->stdout_fd = -1;
+    tool->stderr_fd = -1;
+    tool->exit_fd = -1;
+    tool->shard = event_loop_assign_shard();
+    uint64_t lsn = event_log_last_lsn();
+    atomic_init(&tool->log_acked, lsn);
+    atomic_init(&tool->log_owed, lsn);
+    tool->log_queued = lsn;
+    line_framer_init(&tool->stdout_framer);
+    if (g_config.max_frame_size > 0) {
+        tool->stdout_framer.max_frame = g_config.max_frame_size;
+    }
+    log_framer_init(&tool->stderr_framer, LOG_FRAMER_DEFAULT_RATE);
+    timer_init(&tool->restart_timer, on_restart_timer, tool);
+    timer_init(&tool->heartbeat_timer, on_heartbeat_timer, tool);
+    timer_init(&tool->start_timer, on_start_timer, tool);
+    timer_init(&tool->idle_timer, on_idle_timer, tool);
+    timer_init(&tool->exit_timer, on_exit_timer, tool);
     
     // Initialize new queue fields (NEW!)
     tool->max_queue_size = 100;  // default
     tool->queue_policy = QUEUE_POLICY_DROP_OLDEST;  // default
+    tool->max_batch_size = TOOL_DEFAULT_BATCH_SIZE;
+    tool->max_queue_bytes = 0;
     tool->is_on_demand = false;
     tool->is_starting = false;
     tool->inbox = NULL;
+    tool->flow = NULL;
+    tool->stdout_paused = false;
+    atomic_init(&tool->stdout_pauses, 0);
+    atomic_init(&tool->publish_seq, 0);
+    atomic_init(&tool->duplicates, 0);
+    tool->dedup_window = DEDUP_DEFAULT_WINDOW;
+    tool->dedup = NULL;
+    tool->sequence_numbers = false;
+    
+    tool->flow = flow_account_create();
+    if (!tool->flow) {
+        LOG_ERROR("tool", "Failed to allocate flow account for %s", name);
+        free(tool);
+        return FW_ERROR_MEMORY;
+    }
     
     // Initialize queue (NEW!)
     int queue_size = tool->max_queue_size;
     int queue_result = tool_queue_init(&tool->inbox, queue_size, tool->queue_policy);
     if (queue_result != FW_OK) {
         LOG_ERROR("tool", "Failed to initialize queue for %s", name);
+        flow_account_close(tool->flow);
         free(tool);
         return queue_result;
     }
@@ -104,6 +204,7 @@ int tool_register(const char* name, const char* command) {
              name, queue_size, tool->queue_policy);
     
     registry.tools[registry.count++] = tool;
+    event_routes_changed();
     
     LOG_DEBUG("tool", "Registered tool: %s", name);
     return FW_OK;
@@ -120,29 +221,38 @@ int tool_unregister(const char* name) {
         tool_stop(name);
     }
     
-    // Remove from registry
+    // Remove from registry and routes first, so nothing new is sent to it
     for (int i = 0; i < registry.count; i++) {
         if (registry.tools[i] == tool) {
-            // Free subscriptions
-            for (int j = 0; j < tool->subscription_count; j++) {
-                // subscriptions is array of char arrays, don't free individual ones
+            for (int j = i; j < registry.count - 1; j++) {
+                registry.tools[j] = registry.tools[j + 1];
             }
+            registry.count--;
+            event_routes_changed();
             
-            // Free queue (NEW!)
+            // Its shard refuses deliveries from here on
+            event_loop_lock(tool->shard);
+            tool->retired = true;
             if (tool->inbox) {
                 tool_queue_shutdown(tool->inbox);
                 tool->inbox = NULL;
             }
+            event_loop_unlock(tool->shard);
+            tool_disarm_timers(tool);
+            timer_wheel_cancel(&timers, &tool->restart_timer);
+            request_forget_tool(tool);
             
-            free(tool);
+            LOG_DEBUG("tool", "Unregistered tool: %s", name);
             
-            // Shift array
-            for (int j = i; j < registry.count - 1; j++) {
-                registry.tools[j] = registry.tools[j + 1];
+            // Shards routing with the old snapshot may still hand it events:
+            // freed once tool_reclaim() sees them all past it
+            if (tool->shard < 0 || tool->shard >= event_loop_shard_count()) {
+                tool_destroy(tool);   // No shards (unit tests)
+            } else {
+                tool->retired_epoch = event_routes_epoch();
+                tool->next = retired_tools;
+                retired_tools = tool;
             }
-            registry.count--;
-            
-            LOG_DEBUG("tool", "Unregistered tool: %s", name);
             return FW_OK;
         }
     }
@@ -150,6 +260,36 @@ int tool_unregister(const char* name) {
     return FW_ERROR_NOT_FOUND;
 }
 
+void tool_reclaim(void) {
+    Tool** link = &retired_tools;
+    while (*link) {
+        Tool* tool = *link;
+        if (event_routes_passed(tool->retired_epoch) && io_worker_retire(tool) == FW_OK) {
+            *link = tool->next;   // Its shard hands it back as WORK_RETIRE
+        } else {
+            link = &tool->next;
+        }
+    }
+}
+
+void tool_destroy(Tool* tool) {
+    if (!tool) {
+        return;
+    }
+    // A shard still routing with an older snapshot may have added one since
+    request_forget_tool(tool);
+    if (tool->inbox) {
+        tool_queue_shutdown(tool->inbox);
+    }
+    line_framer_free(&tool->stdout_framer);
+    tool_free_filters(tool);
+    dedup_destroy(tool->dedup);
+    // Events it published may still wait in other inboxes: they keep the
+    // account until they are released
+    flow_account_close(tool->flow);
+    free(tool);
+}
+
 Tool* tool_find(const char* name) {
     if (!name) {
         return NULL;
@@ -164,6 +304,8 @@ Tool* tool_find(const char* name) {
     return NULL;
 }
 
+static int tool_start_locked(Tool* tool);
+
 int tool_start(const char* name) {
     Tool* tool = tool_find(name);
     if (!tool) {
@@ -176,8 +318,26 @@ int tool_start(const char* name) {
     
     LOG_INFO("tool", "Starting tool: %s", name);
     
+    // The tool's shard must not touch its pipes or inbox meanwhile
+    event_loop_lock(tool->shard);
+    int result = tool_start_locked(tool);
+    event_loop_unlock(tool->shard);
+    return result;
+}
+
+static int tool_start_locked(Tool* tool) {
+    const char* name = tool->name;
     tool->status = TOOL_STARTING;
     
+    // A partial line from the previous run must not prefix the new output
+    line_framer_reset(&tool->stdout_framer);
+    log_framer_reset(&tool->stderr_framer);
+    
+    // Nor may the rest of an event the previous process only half received
+    if (tool->inbox && tool->inbox->head_offset > 0) {
+        tool_queue_remove(tool->inbox);
+    }
+    
     // Spawn process - platform_spawn_process returns fds, not handles
     tool->process_handle = platform_spawn_process(
         tool->command,
@@ -186,31 +346,48 @@ int tool_start(const char* name) {
         &tool->stderr_fd
     );
     
-    if (tool->process_handle == INVALID_HANDLE_VALUE) {
+    if (tool->process_handle == INVALID_PROCESS_HANDLE) {
         LOG_ERROR("tool", "Failed to start tool: %s", name);
         tool->status = TOOL_ERROR;
         return FW_ERROR_PROCESS_FAILED;
     }
     
-    // Get handles from file descriptors
-    tool->stdin_handle = (HANDLE)_get_osfhandle(tool->stdin_fd);
-    tool->stdout_handle = (HANDLE)_get_osfhandle(tool->stdout_fd);
-    tool->stderr_handle = (HANDLE)_get_osfhandle(tool->stderr_fd);
-    
     if (tool->stdin_fd < 0 || tool->stdout_fd < 0 || tool->stderr_fd < 0) {
         LOG_ERROR("tool", "Failed to get file descriptors for tool: %s", name);
         platform_kill_process(tool->process_handle, true);
+        tool_close_pipes(tool);
         tool->status = TOOL_ERROR;
         return FW_ERROR_PIPE_FAILED;
     }
     
     tool->status = TOOL_RUNNING;
+    tool->exit_fd = platform_process_exit_fd(tool->process_handle);
     tool->started_at = time(NULL);
     tool->pid = platform_get_process_id(tool->process_handle);
     tool->last_heartbeat = time(NULL);
     tool->start_time = time(NULL);
     
-    LOG_INFO("tool", "Tool %s started with PID %lu", name, tool->pid);
+    LOG_INFO("tool", "Tool %s started with PID %lu", name, (unsigned long)tool->pid);
+    
+    event_loop_add_tool(tool);
+    
+    // Deadlines for this run; a pending crash restart is moot now
+    uint64_t now = platform_monotonic_ms();
+    timer_wheel_cancel(&timers, &tool->restart_timer);
+    tool->heartbeat_ms = now;
+    atomic_store_explicit(&tool->last_active_ms, now, memory_order_relaxed);
+    if (tool->heartbeat_timeout_sec > 0) {
+        timer_wheel_arm(&timers, &tool->heartbeat_timer,
+                        now + (uint64_t)tool->heartbeat_timeout_sec * 1000);
+    }
+    if (tool->start_timeout_sec > 0 && tool->is_starting) {
+        timer_wheel_arm(&timers, &tool->start_timer,
+                        now + (uint64_t)tool->start_timeout_sec * 1000);
+    }
+    if (tool->idle_timeout_sec > 0 && tool->is_on_demand) {
+        timer_wheel_arm(&timers, &tool->idle_timer,
+                        now + (uint64_t)tool->idle_timeout_sec * 1000);
+    }
     
     return FW_OK;
 }
@@ -221,13 +398,20 @@ int tool_stop(const char* name) {
         return FW_ERROR_NOT_FOUND;
     }
     
+    // An explicit stop also calls off a pending crash restart
+    timer_wheel_cancel(&timers, &tool->restart_timer);
+    
     if (tool->status != TOOL_RUNNING) {
         return FW_OK;  // Already stopped
     }
     
     LOG_INFO("tool", "Stopping tool: %s", name);
+    tool_disarm_timers(tool);
     
+    event_loop_lock(tool->shard);
     tool->status = TOOL_STOPPING;
+    event_loop_remove_tool(tool);
+    event_loop_unlock(tool->shard);
     
     // Try graceful shutdown first
     int result = platform_kill_process(tool->process_handle, false);
@@ -238,8 +422,10 @@ int tool_stop(const char* name) {
     
     // Wait for process to exit
     platform_wait_process(tool->process_handle, 1000);
+    tool->has_exited = platform_get_exit_info(tool->process_handle, &tool->last_exit);
     
     // Handle queue (NEW!)
+    event_loop_lock(tool->shard);
     if (!tool->is_on_demand || !tool->restart_on_crash) {
         // Clear queue if not restarting
         tool_queue_clear(tool->inbox);
@@ -250,8 +436,10 @@ int tool_stop(const char* name) {
                  name, tool_queue_count(tool->inbox));
     }
     
+    tool_close_pipes(tool);
     tool->status = TOOL_STOPPED;
-    tool->process_handle = INVALID_HANDLE_VALUE;
+    tool->process_handle = INVALID_PROCESS_HANDLE;
+    event_loop_unlock(tool->shard);
     
     LOG_INFO("tool", "Tool %s stopped", name);
     
@@ -278,23 +466,137 @@ int tool_restart(const char* name) {
     return tool_start(name);
 }
 
+// Strip quotes and whitespace the way subscriptions have always been read
+static void normalize_subscription(const char* in, char* out, size_t size) {
+    while (*in == '\'' || *in == '"' || *in == ' ') in++;
+    strncpy(out, in, size - 1);
+    out[size - 1] = '\0';
+    
+    char* end = out + strlen(out);
+    while (end > out && (end[-1] == '\'' || end[-1] == '"' || end[-1] == ' ' ||
+                         end[-1] == '\n' || end[-1] == '\r')) {
+        *--end = '\0';
+    }
+}
+
+// Split "TYPE[filter]" into its type and compiled filter (NULL for a plain
+// type). Returns false with a warning logged for a malformed filter or a
+// type of MAX_EVENT_TYPE bytes or more.
+static bool split_subscription(const char* name, char* text, char* type, EventFilter** filter) {
+    *filter = NULL;
+    char* open = strchr(text, '[');
+    if (open) {
+        size_t length = strlen(text);
+        if (text[length - 1] != ']') {
+            LOG_WARN("tool", "Tool %s: subscription '%s' has no closing ']'", name, text);
+            return false;
+        }
+        text[length - 1] = '\0';
+        char error[128];
+        *filter = event_filter_compile(open + 1, error, sizeof(error));
+        if (!*filter) {
+            LOG_WARN("tool", "Tool %s: invalid filter '%s': %s", name, open + 1, error);
+            return false;
+        }
+        *open = '\0';
+        while (open > text && open[-1] == ' ') {
+            *--open = '\0';
+        }
+    }
+    size_t type_len = strnlen(text, MAX_EVENT_TYPE);
+    if (type_len == MAX_EVENT_TYPE) {
+        LOG_WARN("tool", "Tool %s: subscription type '%s' is too long", name, text);
+        event_filter_release(*filter);
+        *filter = NULL;
+        return false;
+    }
+    memcpy(type, text, type_len);
+    type[type_len] = '\0';
+    return true;
+}
+
+// Another subscription to a type the tool already has: either one without
+// a filter gets every event, otherwise it gets what passes either filter
+static int merge_filter(Tool* tool, int index, EventFilter* filter) {
+    EventFilter* old = tool->filters[index];
+    if (!old) {
+        event_filter_release(filter);
+        return FW_OK;
+    }
+    if (!filter) {
+        tool->filters[index] = NULL;
+        event_filter_release(old);
+        event_routes_changed();
+        return FW_OK;
+    }
+    
+    char source[EVENT_FILTER_MAX_SOURCE * 2 + 8];
+    char error[128];
+    snprintf(source, sizeof(source), "(%s) || (%s)",
+             event_filter_source(old), event_filter_source(filter));
+    EventFilter* merged = event_filter_compile(source, error, sizeof(error));
+    event_filter_release(filter);
+    if (!merged) {
+        LOG_WARN("tool", "Tool %s: cannot add filter to '%s': %s",
+                 tool->name, event_type_name(tool->subscriptions[index]), error);
+        return FW_ERROR_PARSE_FAILED;
+    }
+    tool->filters[index] = merged;
+    event_filter_release(old);
+    event_routes_changed();
+    return FW_OK;
+}
+
 int tool_subscribe(const char* name, const char* event_type) {
+    if (!event_type) {
+        return FW_ERROR_INVALID_ARG;
+    }
     Tool* tool = tool_find(name);
     if (!tool) {
         return FW_ERROR_NOT_FOUND;
     }
     
+    // Normalized, interned and compiled once here, so routing works on the
+    // ID and runs the filter's program
+    char text[MAX_EVENT_TYPE + EVENT_FILTER_MAX_SOURCE + 2];
+    char type[MAX_EVENT_TYPE];
+    EventFilter* filter;
+    normalize_subscription(event_type, text, sizeof(text));
+    if (!split_subscription(name, text, type, &filter)) {
+        return FW_ERROR_PARSE_FAILED;
+    }
+    if (!event_pattern_valid(type)) {
+        LOG_WARN("tool", "Tool %s: invalid subscription '%s'", name, type);
+        event_filter_release(filter);
+        return FW_ERROR_INVALID_ARG;
+    }
+    EventTypeId id = event_type_intern(type);
+    if (id == EVENT_TYPE_NONE) {
+        LOG_ERROR("tool", "Tool %s: cannot subscribe to '%s', event type table full", name, type);
+        event_filter_release(filter);
+        return FW_ERROR_GENERIC;
+    }
+    for (int i = 0; i < tool->subscription_count; i++) {
+        if (tool->subscriptions[i] == id) {
+            return merge_filter(tool, i, filter);  // Already subscribed
+        }
+    }
+    
     if (tool->subscription_count >= MAX_SUBSCRIPTIONS) {
         LOG_ERROR("tool", "Tool %s subscription limit reached", name);
+        event_filter_release(filter);
         return FW_ERROR_GENERIC;
     }
     
-    // Store subscription (it's an array of char arrays, not pointers)
-    strncpy(tool->subscriptions[tool->subscription_count], event_type, MAX_EVENT_TYPE - 1);
-    tool->subscriptions[tool->subscription_count][MAX_EVENT_TYPE - 1] = '\0';
-    tool->subscription_count++;
+    tool->filters[tool->subscription_count] = filter;
+    tool->subscriptions[tool->subscription_count++] = id;
+    event_routes_changed();
     
-    LOG_DEBUG("tool", "Tool %s subscribed to: %s", name, event_type);
+    if (filter) {
+        LOG_DEBUG("tool", "Tool %s subscribed to: %s [%s]", name, type, event_filter_source(filter));
+    } else {
+        LOG_DEBUG("tool", "Tool %s subscribed to: %s", name, type);
+    }
     
     return FW_OK;
 }
@@ -322,11 +624,9 @@ int tool_send_event(const char* name, const char* event_msg) {
     }
     
     // Write to tool's stdin
-    DWORD bytes_written;
-    DWORD bytes_to_write = (DWORD)strlen(event_msg);
-    
-    BOOL success = WriteFile(tool->stdin_handle, event_msg, bytes_to_write, &bytes_written, NULL);
-    if (!success || bytes_written != bytes_to_write) {
+    size_t bytes_to_write = strlen(event_msg);
+    int bytes_written = platform_write_all(tool->stdin_fd, event_msg, bytes_to_write);
+    if (bytes_written < 0 || (size_t)bytes_written != bytes_to_write) {
         LOG_ERROR("tool", "Failed to send event to tool %s", name);
         return FW_ERROR_IO;
     }
@@ -344,20 +644,17 @@ int tool_send_event_nonblocking(const char* name, const char* event_msg) {
     }
     
     // Try to write without blocking
-    DWORD bytes_written;
-    DWORD bytes_to_write = (DWORD)strlen(event_msg);
+    size_t bytes_to_write = strlen(event_msg);
+    int bytes_written = platform_write_nonblocking(tool->stdin_fd, event_msg, bytes_to_write);
     
-    BOOL success = WriteFile(tool->stdin_handle, event_msg, bytes_to_write, &bytes_written, NULL);
-    
-    if (!success) {
-        DWORD error = GetLastError();
-        if (error == ERROR_NO_DATA || error == ERROR_PIPE_NOT_CONNECTED) {
-            return FW_ERROR_QUEUE_FULL;  // Pipe full or not ready
-        }
+    if (bytes_written == 0) {
+        return FW_ERROR_QUEUE_FULL;  // Pipe full or not ready
+    }
+    if (bytes_written < 0) {
         return FW_ERROR_IO;
     }
     
-    if (bytes_written != bytes_to_write) {
+    if ((size_t)bytes_written != bytes_to_write) {
         return FW_ERROR_IO;  // Partial write
     }
     
@@ -365,6 +662,104 @@ int tool_send_event_nonblocking(const char* name, const char* event_msg) {
     return FW_OK;
 }
 
+int tool_flush_inbox(Tool* tool) {
+    if (!tool || tool->status != TOOL_RUNNING) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    ToolQueue* inbox = tool->inbox;
+    PlatformIoVec iov[TOOL_MAX_BATCH_SIZE];
+    
+    while (!tool_queue_is_empty(inbox)) {
+        int batch = tool_queue_count(inbox);
+        if (batch > tool->max_batch_size) {
+            batch = tool->max_batch_size;
+        }
+        
+        for (int i = 0; i < batch; i++) {
+            const EventBuffer* msg = tool_queue_peek_buffer_at(inbox, i);
+            iov[i].data = msg->data;
+            iov[i].size = msg->length;
+        }
+        // Resume a partially written head event
+        iov[0].data += inbox->head_offset;
+        iov[0].size -= inbox->head_offset;
+        
+        int written = platform_writev_nonblocking(tool->stdin_fd, iov, batch);
+        if (written < 0) {
+            LOG_ERROR("tool", "Failed to deliver events to %s: %d", tool->name, written);
+            return FW_ERROR_IO;
+        }
+        if (written == 0) {
+            return FW_ERROR_QUEUE_FULL;
+        }
+        
+        size_t remaining = (size_t)written;
+        for (int i = 0; i < batch; i++) {
+            if (remaining < iov[i].size) {
+                // Pipe took part of this event: keep our place in it
+                inbox->head_offset += remaining;
+                LOG_TRACE("tool", "Partial write to %s, %d events queued", 
+                         tool->name, tool_queue_count(inbox));
+                return FW_ERROR_QUEUE_FULL;
+            }
+            remaining -= iov[i].size;
+            tool_queue_remove(inbox);
+            tool->events_sent++;
+        }
+    }
+    
+    return FW_OK;
+}
+
+void tool_update_log_offset(Tool* tool) {
+    uint64_t oldest = tool_queue_oldest_lsn(tool->inbox);
+    atomic_store_explicit(&tool->log_acked, oldest ? oldest - 1 : tool->log_queued,
+                          memory_order_relaxed);
+}
+
+int tool_set_queue_config(const char* name, int max_queue_size, QueuePolicy policy, int max_batch_size) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    if (max_batch_size < 1) {
+        max_batch_size = 1;
+    } else if (max_batch_size > TOOL_MAX_BATCH_SIZE) {
+        max_batch_size = TOOL_MAX_BATCH_SIZE;
+    }
+    
+    event_loop_lock(tool->shard);
+    tool->max_batch_size = max_batch_size;
+    
+    int result = FW_OK;
+    if (max_queue_size != tool->max_queue_size || policy != tool->queue_policy) {
+        ToolQueue* inbox = NULL;
+        if (!tool_queue_is_empty(tool->inbox)) {
+            result = FW_ERROR_GENERIC;  // Only resize an idle inbox
+        } else {
+            result = tool_queue_init(&inbox, max_queue_size, policy);
+        }
+        if (result == FW_OK) {
+            tool_queue_set_max_bytes(inbox, tool->max_queue_bytes);
+            tool_queue_set_conflate_field(inbox, tool->conflate_key);
+            tool_queue_shutdown(tool->inbox);
+            tool->inbox = inbox;
+            tool->max_queue_size = max_queue_size;
+            tool->queue_policy = policy;
+        }
+    }
+    event_loop_unlock(tool->shard);
+    if (result != FW_OK) {
+        return result;
+    }
+    
+    LOG_DEBUG("tool", "Tool %s queue: size=%d, policy=%d, batch=%d", 
+             name, tool->max_queue_size, tool->queue_policy, tool->max_batch_size);
+    return FW_OK;
+}
+
 bool tool_is_running(const char* name) {
     Tool* tool = tool_find(name);
     if (!tool) {
@@ -382,49 +777,293 @@ bool tool_is_running(const char* name) {
     return true;
 }
 
+int tool_set_restart_config(const char* name, RestartPolicy policy, bool restart_on_crash,
+                            int max_restarts, int restart_max_delay_sec) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    tool->restart_policy = policy;
+    tool->is_on_demand = (policy == RESTART_ON_DEMAND);
+    tool->restart_on_crash = restart_on_crash && policy != RESTART_NEVER;
+    tool->max_restarts = max_restarts >= 0 ? max_restarts : 0;
+    tool->restart_max_delay_sec = restart_max_delay_sec > 0 ? restart_max_delay_sec : 1;
+    
+    LOG_DEBUG("tool", "Tool %s restart: policy=%d, on_crash=%d, max=%d, max_delay=%ds",
+             name, policy, tool->restart_on_crash, tool->max_restarts, tool->restart_max_delay_sec);
+    return FW_OK;
+}
+
+int tool_set_timeouts(const char* name, int heartbeat_timeout_sec,
+                      int start_timeout_sec, int idle_timeout_sec) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    tool->heartbeat_timeout_sec = heartbeat_timeout_sec > 0 ? heartbeat_timeout_sec : 0;
+    tool->start_timeout_sec = start_timeout_sec > 0 ? start_timeout_sec : 0;
+    tool->idle_timeout_sec = idle_timeout_sec > 0 ? idle_timeout_sec : 0;
+    
+    LOG_DEBUG("tool", "Tool %s timeouts: heartbeat=%ds, start=%ds, idle=%ds",
+             name, tool->heartbeat_timeout_sec, tool->start_timeout_sec, tool->idle_timeout_sec);
+    return FW_OK;
+}
+
+int tool_set_log_rate(const char* name, int lines_per_sec) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    event_loop_lock(tool->shard);
+    tool->stderr_framer.rate_limit = lines_per_sec > 0 ? lines_per_sec : 0;
+    event_loop_unlock(tool->shard);
+    
+    LOG_DEBUG("tool", "Tool %s stderr log rate: %d lines/s", name, lines_per_sec);
+    return FW_OK;
+}
+
+int tool_set_queue_bytes(const char* name, size_t max_queue_bytes) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    event_loop_lock(tool->shard);
+    tool->max_queue_bytes = max_queue_bytes;
+    tool_queue_set_max_bytes(tool->inbox, max_queue_bytes);
+    event_loop_unlock(tool->shard);
+    
+    LOG_DEBUG("tool", "Tool %s queue budget: %zu bytes", name, max_queue_bytes);
+    return FW_OK;
+}
+
+int tool_set_conflate_key(const char* name, const char* field) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    event_loop_lock(tool->shard);
+    strncpy(tool->conflate_key, field ? field : "", MAX_EVENT_TYPE - 1);
+    tool->conflate_key[MAX_EVENT_TYPE - 1] = '\0';
+    tool_queue_set_conflate_field(tool->inbox, tool->conflate_key);
+    event_loop_unlock(tool->shard);
+    
+    LOG_DEBUG("tool", "Tool %s conflation key: %s", name,
+              tool->conflate_key[0] ? tool->conflate_key : "sender");
+    return FW_OK;
+}
+
+int tool_set_sequencing(const char* name, int dedup_window, bool sequence_numbers) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    
+    // The shard creates the window on the first id it reads
+    event_loop_lock(tool->shard);
+    tool->dedup_window = dedup_window > 0 ? dedup_window : 0;
+    dedup_destroy(tool->dedup);
+    tool->dedup = NULL;
+    tool->sequence_numbers = sequence_numbers;
+    event_loop_unlock(tool->shard);
+    
+    LOG_DEBUG("tool", "Tool %s dedup window: %d ids, sequence numbers %s", name,
+              tool->dedup_window, sequence_numbers ? "on" : "off");
+    return FW_OK;
+}
+
 void tool_update_heartbeat(const char* name) {
     Tool* tool = tool_find(name);
     if (tool && tool->status == TOOL_RUNNING) {
         tool->last_heartbeat = time(NULL);
+        // The heartbeat timer notices this when it next fires
+        tool->heartbeat_ms = platform_monotonic_ms();
+    }
+}
+
+void tool_mark_ready(const char* name) {
+    Tool* tool = tool_find(name);
+    if (!tool) {
+        return;
+    }
+    
+    tool_update_heartbeat(name);
+    timer_wheel_cancel(&timers, &tool->start_timer);
+    
+    // Handle on-demand tools (mark as ready)
+    if (tool->is_on_demand && tool->is_starting) {
+        event_loop_lock(tool->shard);
+        tool->is_starting = false;
+        event_loop_unlock(tool->shard);
+        LOG_INFO("tool", "On-demand tool %s is now ready (queue: %d events)", 
+                name, tool_queue_count(tool->inbox));
     }
 }
 
+// Delay before the next restart: doubles per restart, capped by config
+static uint64_t tool_restart_delay_ms(const Tool* tool) {
+    uint64_t max_delay = (uint64_t)tool->restart_max_delay_sec * 1000;
+    int doublings = tool->restart_count < 20 ? tool->restart_count : 20;
+    uint64_t delay = (uint64_t)TOOL_RESTART_BASE_DELAY_MS << doublings;
+    return delay < max_delay ? delay : max_delay;
+}
+
+// Restart a tool that died or hung later, if its config allows
+static void tool_schedule_restart(Tool* tool) {
+    if (!tool->restart_on_crash || tool->restart_count >= tool->max_restarts) {
+        return;
+    }
+    
+    uint64_t delay = tool_restart_delay_ms(tool);
+    LOG_INFO("tool", "Restarting tool %s in %lu ms (attempt %d/%d)", 
+             tool->name, (unsigned long)delay, tool->restart_count + 1, tool->max_restarts);
+    timer_wheel_arm(&timers, &tool->restart_timer, platform_monotonic_ms() + delay);
+}
+
+// Log how a tool's process ended
+static void tool_log_exit(const Tool* tool) {
+    const PlatformExitInfo* info = &tool->last_exit;
+    char how[64];
+    if (info->signal) {
+        snprintf(how, sizeof(how), "killed by signal %d", info->signal);
+    } else {
+        snprintf(how, sizeof(how), "exited with code %d", info->exit_code);
+    }
+    LOG_ERROR("tool", "Tool %s crashed: %s (cpu %lu ms user, %lu ms system, max RSS %lu KB)",
+              tool->name, how, (unsigned long)info->user_cpu_ms,
+              (unsigned long)info->system_cpu_ms, (unsigned long)info->max_rss_kb);
+}
+
+void tool_check_health_one(Tool* tool) {
+    // Check if running tool has crashed
+    if (!tool || tool->status != TOOL_RUNNING) {
+        return;
+    }
+    
+    tool->has_exited = platform_get_exit_info(tool->process_handle, &tool->last_exit);
+    if (tool->has_exited) {
+        tool_log_exit(tool);
+        tool_disarm_timers(tool);
+        
+        // Close pipes
+        event_loop_lock(tool->shard);
+        tool->status = TOOL_CRASHED;
+        tool_close_pipes(tool);
+        event_loop_unlock(tool->shard);
+        
+        // Restart if configured
+        tool_schedule_restart(tool);
+    }
+}
+
+void tool_check_hangup(Tool* tool) {
+    if (!tool || tool->exit_fd >= 0) {
+        return;  // Its exit fd reports the exit, if that is what this was
+    }
+    tool_check_health_one(tool);
+    if (tool->status == TOOL_RUNNING) {
+        // Still being torn down, or it really only closed a pipe
+        timer_wheel_arm(&timers, &tool->exit_timer, platform_monotonic_ms() + TOOL_EXIT_RECHECK_MS);
+    }
+}
+
+void tool_check_exit(Tool* tool) {
+    tool_check_health_one(tool);
+}
+
 void tool_check_health(void) {
     for (int i = 0; i < registry.count; i++) {
-        Tool* tool = registry.tools[i];
-        if (!tool) {
-            continue;
-        }
-        
-        // Check if running tool has crashed
-        if (tool->status == TOOL_RUNNING) {
-            if (!platform_is_process_running(tool->process_handle)) {
-                LOG_ERROR("tool", "Tool %s crashed", tool->name);
-                tool->status = TOOL_CRASHED;
-                
-                // Close handles
-                if (tool->stdin_handle != INVALID_HANDLE_VALUE) {
-                    CloseHandle(tool->stdin_handle);
-                    tool->stdin_handle = INVALID_HANDLE_VALUE;
-                }
-                if (tool->stdout_handle != INVALID_HANDLE_VALUE) {
-                    CloseHandle(tool->stdout_handle);
-                    tool->stdout_handle = INVALID_HANDLE_VALUE;
-                }
-                if (tool->stderr_handle != INVALID_HANDLE_VALUE) {
-                    CloseHandle(tool->stderr_handle);
-                    tool->stderr_handle = INVALID_HANDLE_VALUE;
-                }
-                
-                // Restart if configured
-                if (tool->restart_on_crash && tool->restart_count < tool->max_restarts) {
-                    LOG_INFO("tool", "Restarting crashed tool %s (attempt %d/%d)", 
-                             tool->name, tool->restart_count + 1, tool->max_restarts);
-                    tool_restart(tool->name);
-                }
-            }
+        tool_check_health_one(registry.tools[i]);
+    }
+}
+
+static void on_restart_timer(Timer* timer, void* arg) {
+    (void)timer;
+    Tool* tool = (Tool*)arg;
+    if (tool->status != TOOL_RUNNING) {
+        tool_restart(tool->name);
+    }
+}
+
+static void on_heartbeat_timer(Timer* timer, void* arg) {
+    Tool* tool = (Tool*)arg;
+    uint64_t timeout = (uint64_t)tool->heartbeat_timeout_sec * 1000;
+    
+    if (platform_monotonic_ms() - tool->heartbeat_ms < timeout) {
+        // Heard from it since the timer was armed: wait out the rest
+        timer_wheel_arm(&timers, timer, tool->heartbeat_ms + timeout);
+        return;
+    }
+    
+    LOG_ERROR("tool", "Tool %s sent no heartbeat for %d s, restarting it", 
+              tool->name, tool->heartbeat_timeout_sec);
+    tool_stop(tool->name);
+    tool_schedule_restart(tool);
+}
+
+static void on_start_timer(Timer* timer, void* arg) {
+    (void)timer;
+    Tool* tool = (Tool*)arg;
+    if (!tool->is_starting) {
+        return;
+    }
+    
+    LOG_ERROR("tool", "Tool %s did not send TOOL_READY within %d s", 
+              tool->name, tool->start_timeout_sec);
+    tool_stop(tool->name);
+    
+    // The next event for it tries again
+    event_loop_lock(tool->shard);
+    tool->is_starting = false;
+    event_loop_unlock(tool->shard);
+}
+
+static void on_idle_timer(Timer* timer, void* arg) {
+    Tool* tool = (Tool*)arg;
+    uint64_t timeout = (uint64_t)tool->idle_timeout_sec * 1000;
+    
+    uint64_t now = platform_monotonic_ms();
+    
+    event_loop_lock(tool->shard);
+    uint64_t last_active = atomic_load_explicit(&tool->last_active_ms, memory_order_relaxed);
+    bool busy = !tool_queue_is_empty(tool->inbox);
+    event_loop_unlock(tool->shard);
+    
+    if (busy || now - last_active < timeout) {
+        uint64_t next = busy ? now + timeout : last_active + timeout;
+        timer_wheel_arm(&timers, timer, next);
+        return;
+    }
+    
+    LOG_INFO("tool", "Stopping idle on-demand tool %s", tool->name);
+    tool_stop(tool->name);
+}
+
+static void on_exit_timer(Timer* timer, void* arg) {
+    (void)timer;
+    tool_check_health_one((Tool*)arg);
+}
+
+static void on_health_timer(Timer* timer, void* arg) {
+    (void)arg;
+    // Exits the event loop reports need no polling
+    bool child_signals = platform_child_exit_fd() >= 0;
+    for (int i = 0; i < registry.count; i++) {
+        if (registry.tools[i]->exit_fd < 0 && !child_signals) {
+            tool_check_health_one(registry.tools[i]);
         }
     }
+    timer_wheel_arm(&timers, timer, platform_monotonic_ms() + TOOL_HEALTH_SWEEP_INTERVAL_MS);
+}
+
+int tool_run_timers(void) {
+    uint64_t now = platform_monotonic_ms();
+    timer_wheel_advance(&timers, now);
+    return timer_wheel_next_timeout(&timers, now);
 }
 
 Tool* tool_get_first(void) {
@@ -443,6 +1082,17 @@ Tool* tool_get_next(void) {
     return NULL;
 }
 
+int tool_get_count(void) {
+    return registry.count;
+}
+
+Tool* tool_get_at(int index) {
+    if (index < 0 || index >= registry.count) {
+        return NULL;
+    }
+    return registry.tools[index];
+}
+
 int tool_get_status(const char* name, char* buffer, size_t size) {
     Tool* tool = tool_find(name);
     if (!tool) {
@@ -1,4 +1,5 @@
 #include "yuki_frame/tool_queue.h"
+#include "yuki_frame/event_filter.h"
 #include "yuki_frame/logger.h"
 #include <stdlib.h>
 #include <string.h>
@@ -8,43 +9,65 @@ int tool_queue_init(ToolQueue** queue, int capacity, QueuePolicy policy) {
         return FW_ERROR_INVALID_ARG;
     }
     
-    *queue = (ToolQueue*)malloc(sizeof(ToolQueue));
+    *queue = (ToolQueue*)calloc(1, sizeof(ToolQueue));
     if (!*queue) {
         return FW_ERROR_MEMORY;
     }
     
-    (*queue)->messages = (char**)calloc(capacity, sizeof(char*));
-    if (!(*queue)->messages) {
+    // Other lanes are allocated when an event of their priority arrives
+    ToolQueueLane* normal = &(*queue)->lanes[EVENT_PRIORITY_NORMAL];
+    normal->messages = (EventBuffer**)calloc(capacity, sizeof(EventBuffer*));
+    if (!normal->messages) {
         free(*queue);
         *queue = NULL;
         return FW_ERROR_MEMORY;
     }
     
     (*queue)->capacity = capacity;
-    (*queue)->head = 0;
-    (*queue)->tail = 0;
     (*queue)->count = 0;
+    (*queue)->head_lane = EVENT_PRIORITY_NORMAL;
+    (*queue)->head_offset = 0;
+    (*queue)->bytes = 0;
+    (*queue)->max_bytes = 0;
     (*queue)->policy = policy;
     (*queue)->dropped_count = 0;
     (*queue)->delivered_count = 0;
+    (*queue)->conflated_count = 0;
     
     return FW_OK;
 }
 
-void tool_queue_shutdown(ToolQueue* queue) {
+void tool_queue_set_max_bytes(ToolQueue* queue, size_t max_bytes) {
+    if (queue) {
+        queue->max_bytes = max_bytes;
+    }
+}
+
+void tool_queue_set_conflate_field(ToolQueue* queue, const char* field) {
     if (!queue) {
         return;
     }
+    strncpy(queue->conflate_field, field ? field : "", MAX_EVENT_TYPE - 1);
+    queue->conflate_field[MAX_EVENT_TYPE - 1] = '\0';
     
-    // Free all queued messages
-    for (int i = 0; i < queue->capacity; i++) {
-        if (queue->messages[i]) {
-            free(queue->messages[i]);
-            queue->messages[i] = NULL;
-        }
+    // Keys of queued events were taken with the old field
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        free(queue->lanes[lane].keys);
+        queue->lanes[lane].keys = NULL;
+    }
+}
+
+void tool_queue_shutdown(ToolQueue* queue) {
+    if (!queue) {
+        return;
     }
     
-    free(queue->messages);
+    // Release all queued messages
+    tool_queue_clear(queue);
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        free(queue->lanes[lane].messages);
+        free(queue->lanes[lane].keys);
+    }
     free(queue);
 }
 
@@ -53,18 +76,254 @@ int tool_queue_add(ToolQueue* queue, const char* event_msg) {
         return FW_ERROR_INVALID_ARG;
     }
     
-    // Queue full - apply policy
+    EventBuffer* buffer = event_buffer_create(event_msg, strlen(event_msg));
+    if (!buffer) {
+        return FW_ERROR_MEMORY;
+    }
+    return tool_queue_add_buffer(queue, buffer);
+}
+
+// Unless the head is half written, the next event to write is the oldest
+// of the most urgent lane
+static void update_head_lane(ToolQueue* queue) {
+    if (queue->head_offset > 0) {
+        return;
+    }
+    for (int lane = EVENT_PRIORITY_COUNT - 1; lane >= 0; lane--) {
+        if (queue->lanes[lane].count > 0) {
+            queue->head_lane = lane;
+            return;
+        }
+    }
+}
+
+// An event's type and either its sender or the value of the data field
+typedef struct {
+    const char* type;
+    size_t type_len;
+    const char* part;
+    size_t part_len;
+    bool from_field;
+} ConflationKey;
+
+// Key of a formatted event: "TYPE|sender|data\n" or "#<length>|TYPE|sender\n<data>\n"
+static void conflation_key(const ToolQueue* queue, const EventBuffer* buffer, ConflationKey* key) {
+    const char* line = buffer->data;
+    const char* end = buffer->data + buffer->length;
+    bool frame = false;
+    if (line < end && *line == '#') {
+        const char* bar = (const char*)memchr(line, '|', (size_t)(end - line));
+        if (bar) {
+            line = bar + 1;
+            frame = true;
+        }
+    }
+    
+    const char* bar = (const char*)memchr(line, '|', (size_t)(end - line));
+    if (!bar) {
+        bar = end;
+    }
+    key->type = line;
+    key->type_len = (size_t)(bar - line);
+    key->part = bar;
+    key->part_len = 0;
+    key->from_field = false;
+    if (bar == end) {
+        return;
+    }
+    
+    const char* sender = bar + 1;
+    const char* sender_end = (const char*)memchr(sender, frame ? '\n' : '|', (size_t)(end - sender));
+    if (!sender_end) {
+        sender_end = end;
+    }
+    key->part = sender;
+    key->part_len = (size_t)(sender_end - sender);
+    const char* seq = (const char*)memchr(sender, '@', key->part_len);
+    if (seq) {
+        key->part_len = (size_t)(seq - sender);   // sender@seq: the sender keys it
+    }
+    
+    if (queue->conflate_field[0] && sender_end < end) {
+        const char* data = sender_end + 1;
+        size_t data_len = (size_t)(end - data);
+        const char* value;
+        size_t value_len;
+        if (event_field_find(data, data_len, queue->conflate_field, &value, &value_len)) {
+            key->part = value;
+            key->part_len = value_len;
+            key->from_field = true;
+        }
+    }
+}
+
+// FNV-1a over the key's parts
+static uint32_t conflation_hash(const ConflationKey* key) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key->type_len; i++) {
+        hash = (hash ^ (unsigned char)key->type[i]) * 16777619u;
+    }
+    hash = (hash ^ (key->from_field ? 0x1Eu : 0x1Fu)) * 16777619u;
+    for (size_t i = 0; i < key->part_len; i++) {
+        hash = (hash ^ (unsigned char)key->part[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool conflation_key_equal(const ConflationKey* a, const ConflationKey* b) {
+    return a->from_field == b->from_field &&
+           a->type_len == b->type_len && memcmp(a->type, b->type, a->type_len) == 0 &&
+           a->part_len == b->part_len && memcmp(a->part, b->part, a->part_len) == 0;
+}
+
+// The lane's key hashes, taken for the events already queued on first use
+static bool lane_keys(ToolQueue* queue, ToolQueueLane* lane) {
+    if (lane->keys) {
+        return true;
+    }
+    lane->keys = (uint32_t*)calloc(queue->capacity, sizeof(uint32_t));
+    if (!lane->keys) {
+        return false;
+    }
+    for (int i = 0; i < lane->count; i++) {
+        int slot = (lane->head + i) % queue->capacity;
+        ConflationKey key;
+        conflation_key(queue, lane->messages[slot], &key);
+        lane->keys[slot] = conflation_hash(&key);
+    }
+    return true;
+}
+
+// Put buffer in the place of a queued event with the same key; false if
+// there is none (a half written head cannot be replaced)
+static bool conflate(ToolQueue* queue, int lane_index, EventBuffer* buffer,
+                     const ConflationKey* key, uint32_t hash) {
+    ToolQueueLane* lane = &queue->lanes[lane_index];
+    int first = (lane_index == queue->head_lane && queue->head_offset > 0) ? 1 : 0;
+    for (int i = first; i < lane->count; i++) {
+        int slot = (lane->head + i) % queue->capacity;
+        if (lane->keys[slot] != hash) {
+            continue;
+        }
+        EventBuffer* old = lane->messages[slot];
+        ConflationKey old_key;
+        conflation_key(queue, old, &old_key);
+        if (!conflation_key_equal(key, &old_key)) {
+            continue;
+        }
+        queue->bytes = queue->bytes - old->length + buffer->length;
+        event_buffer_release(old);
+        lane->messages[slot] = buffer;
+        queue->conflated_count++;
+        return true;
+    }
+    return false;
+}
+
+static bool has_room(const ToolQueue* queue, size_t length) {
     if (queue->count >= queue->capacity) {
+        return false;
+    }
+    return queue->max_bytes == 0 || queue->count == 0 ||
+           queue->bytes + length <= queue->max_bytes;
+}
+
+// Least urgent lane with an event that may be dropped (not the half
+// written head), or -1
+static int victim_lane(const ToolQueue* queue) {
+    for (int lane = 0; lane < EVENT_PRIORITY_COUNT; lane++) {
+        int count = queue->lanes[lane].count;
+        if (lane == queue->head_lane && queue->head_offset > 0) {
+            count--;
+        }
+        if (count > 0) {
+            return lane;
+        }
+    }
+    return -1;
+}
+
+// Drop the oldest event of lane that is not half written
+static void drop_oldest(ToolQueue* queue, int lane_index) {
+    ToolQueueLane* lane = &queue->lanes[lane_index];
+    if (lane_index == queue->head_lane && queue->head_offset > 0) {
+        // The head is half written to the pipe and must be finished; drop
+        // the oldest event behind it instead
+        int next = (lane->head + 1) % queue->capacity;
+        queue->bytes -= lane->messages[next]->length;
+        event_buffer_release(lane->messages[next]);
+        lane->messages[next] = lane->messages[lane->head];
+        lane->messages[lane->head] = NULL;
+        if (lane->keys) {
+            lane->keys[next] = lane->keys[lane->head];
+        }
+        lane->head = next;
+    } else {
+        // Remove oldest, make space for new
+        queue->bytes -= lane->messages[lane->head]->length;
+        event_buffer_release(lane->messages[lane->head]);
+        lane->messages[lane->head] = NULL;
+        lane->head = (lane->head + 1) % queue->capacity;
+    }
+    lane->count--;
+    queue->count--;
+    queue->dropped_count++;
+    update_head_lane(queue);
+}
+
+int tool_queue_add_buffer(ToolQueue* queue, EventBuffer* buffer) {
+    if (!queue || !buffer) {
+        event_buffer_release(buffer);
+        return FW_ERROR_INVALID_ARG;
+    }
+    
+    int priority = buffer->priority;
+    if (priority < 0 || priority >= EVENT_PRIORITY_COUNT) {
+        priority = EVENT_PRIORITY_NORMAL;
+    }
+    ToolQueueLane* lane = &queue->lanes[priority];
+    if (!lane->messages) {
+        lane->messages = (EventBuffer**)calloc(queue->capacity, sizeof(EventBuffer*));
+        if (!lane->messages) {
+            event_buffer_release(buffer);
+            return FW_ERROR_MEMORY;
+        }
+    }
+    
+    // Only the latest event per key waits
+    uint32_t key_hash = 0;
+    if (queue->policy == QUEUE_POLICY_CONFLATE && !lane_keys(queue, lane)) {
+        event_buffer_release(buffer);
+        return FW_ERROR_MEMORY;
+    }
+    if (lane->keys) {
+        ConflationKey key;
+        conflation_key(queue, buffer, &key);
+        key_hash = conflation_hash(&key);
+        if (queue->policy == QUEUE_POLICY_CONFLATE &&
+            conflate(queue, priority, buffer, &key, key_hash)) {
+            return FW_OK;
+        }
+    }
+    
+    // Queue full - make room from less urgent events, then apply policy
+    while (!has_room(queue, buffer->length)) {
+        int victim = victim_lane(queue);
+        if (victim >= 0 && victim < priority) {
+            drop_oldest(queue, victim);
+            LOG_WARN("tool_queue", "Queue full, dropped lower priority event");
+            continue;
+        }
         switch (queue->policy) {
             case QUEUE_POLICY_DROP_OLDEST:
-                // Remove oldest, make space for new
-                if (queue->messages[queue->head]) {
-                    free(queue->messages[queue->head]);
-                    queue->messages[queue->head] = NULL;
+            case QUEUE_POLICY_CONFLATE:
+                if (victim != priority) {
+                    // Nothing droppable, or only more urgent events
+                    queue->dropped_count++;
+                    event_buffer_release(buffer);
+                    return FW_ERROR_QUEUE_FULL;
                 }
-                queue->head = (queue->head + 1) % queue->capacity;
-                queue->count--;
-                queue->dropped_count++;
+                drop_oldest(queue, victim);
                 LOG_WARN("tool_queue", "Queue full, dropped oldest event");
                 break;
                 
@@ -72,34 +331,71 @@ int tool_queue_add(ToolQueue* queue, const char* event_msg) {
                 // Reject new event
                 queue->dropped_count++;
                 LOG_WARN("tool_queue", "Queue full, dropped newest event");
+                event_buffer_release(buffer);
                 return FW_ERROR_QUEUE_FULL;
                 
             case QUEUE_POLICY_BLOCK:
                 // In this implementation, we return error
                 // Caller should retry later
                 LOG_WARN("tool_queue", "Queue full, blocking (retry needed)");
+                event_buffer_release(buffer);
                 return FW_ERROR_QUEUE_FULL;
         }
     }
     
-    // Add event to queue
-    queue->messages[queue->tail] = strdup(event_msg);
-    if (!queue->messages[queue->tail]) {
-        return FW_ERROR_MEMORY;
+    // Add event to its lane
+    lane->messages[lane->tail] = buffer;
+    if (lane->keys) {
+        lane->keys[lane->tail] = key_hash;
     }
-    
-    queue->tail = (queue->tail + 1) % queue->capacity;
+    lane->tail = (lane->tail + 1) % queue->capacity;
+    lane->count++;
     queue->count++;
+    queue->bytes += buffer->length;
+    update_head_lane(queue);
     
     return FW_OK;
 }
 
+// Slot of the index-th event in delivery order: the head lane's oldest,
+// then every lane from the most urgent, skipping that one
+static EventBuffer* const* queue_slot(const ToolQueue* queue, int index) {
+    const ToolQueueLane* head = &queue->lanes[queue->head_lane];
+    if (index == 0) {
+        return &head->messages[head->head];
+    }
+    index--;
+    for (int lane_index = EVENT_PRIORITY_COUNT - 1; lane_index >= 0; lane_index--) {
+        const ToolQueueLane* lane = &queue->lanes[lane_index];
+        int first = lane->head;
+        int count = lane->count;
+        if (lane == head) {
+            first = (first + 1) % queue->capacity;
+            count--;
+        }
+        if (index < count) {
+            return &lane->messages[(first + index) % queue->capacity];
+        }
+        index -= count;
+    }
+    return NULL;
+}
+
 const char* tool_queue_peek(ToolQueue* queue) {
-    if (!queue || queue->count == 0) {
+    return tool_queue_peek_at(queue, 0);
+}
+
+const char* tool_queue_peek_at(ToolQueue* queue, int index) {
+    const EventBuffer* buffer = tool_queue_peek_buffer_at(queue, index);
+    return buffer ? buffer->data : NULL;
+}
+
+const EventBuffer* tool_queue_peek_buffer_at(ToolQueue* queue, int index) {
+    if (!queue || index < 0 || index >= queue->count) {
         return NULL;
     }
     
-    return queue->messages[queue->head];
+    return *queue_slot(queue, index);
 }
 
 void tool_queue_remove(ToolQueue* queue) {
@@ -107,25 +403,45 @@ void tool_queue_remove(ToolQueue* queue) {
         return;
     }
     
-    // Free the message
-    if (queue->messages[queue->head]) {
-        free(queue->messages[queue->head]);
-        queue->messages[queue->head] = NULL;
+    // Drop this inbox's reference
+    ToolQueueLane* lane = &queue->lanes[queue->head_lane];
+    if (lane->messages[lane->head]) {
+        queue->bytes -= lane->messages[lane->head]->length;
+        event_buffer_release(lane->messages[lane->head]);
+        lane->messages[lane->head] = NULL;
     }
     
-    queue->head = (queue->head + 1) % queue->capacity;
+    lane->head = (lane->head + 1) % queue->capacity;
+    lane->count--;
     queue->count--;
+    queue->head_offset = 0;
     queue->delivered_count++;
+    update_head_lane(queue);
 }
 
 int tool_queue_count(ToolQueue* queue) {
     return queue ? queue->count : 0;
 }
 
+int tool_queue_lane_count(ToolQueue* queue, EventPriority priority) {
+    if (!queue || priority < 0 || priority >= EVENT_PRIORITY_COUNT) {
+        return 0;
+    }
+    return queue->lanes[priority].count;
+}
+
+int tool_queue_conflated(ToolQueue* queue) {
+    return queue ? queue->conflated_count : 0;
+}
+
 int tool_queue_capacity(ToolQueue* queue) {
     return queue ? queue->capacity : 0;
 }
 
+size_t tool_queue_bytes(ToolQueue* queue) {
+    return queue ? queue->bytes : 0;
+}
+
 int tool_queue_dropped(ToolQueue* queue) {
     return queue ? queue->dropped_count : 0;
 }
@@ -134,6 +450,32 @@ int tool_queue_delivered(ToolQueue* queue) {
     return queue ? queue->delivered_count : 0;
 }
 
+uint64_t tool_queue_oldest_lsn(const ToolQueue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    
+    // A lane holds its events in arrival order, so the first logged one is
+    // its oldest, except that conflation puts newer events in older slots
+    bool scan_all = queue->policy == QUEUE_POLICY_CONFLATE;
+    uint64_t oldest = 0;
+    for (int l = 0; l < EVENT_PRIORITY_COUNT; l++) {
+        const ToolQueueLane* lane = &queue->lanes[l];
+        int slot = lane->head;
+        for (int i = 0; i < lane->count; i++) {
+            uint64_t lsn = lane->messages[slot]->lsn;
+            if (lsn != 0 && (oldest == 0 || lsn < oldest)) {
+                oldest = lsn;
+            }
+            if (lsn != 0 && !scan_all) {
+                break;
+            }
+            slot = (slot + 1) % queue->capacity;
+        }
+    }
+    return oldest;
+}
+
 bool tool_queue_is_empty(ToolQueue* queue) {
     return queue ? (queue->count == 0) : true;
 }
@@ -147,16 +489,22 @@ void tool_queue_clear(ToolQueue* queue) {
         return;
     }
     
-    while (queue->count > 0) {
-        if (queue->messages[queue->head]) {
-            free(queue->messages[queue->head]);
-            queue->messages[queue->head] = NULL;
+    for (int lane_index = 0; lane_index < EVENT_PRIORITY_COUNT; lane_index++) {
+        ToolQueueLane* lane = &queue->lanes[lane_index];
+        while (lane->count > 0) {
+            if (lane->messages[lane->head]) {
+                event_buffer_release(lane->messages[lane->head]);
+                lane->messages[lane->head] = NULL;
+            }
+            lane->head = (lane->head + 1) % queue->capacity;
+            lane->count--;
         }
-        queue->head = (queue->head + 1) % queue->capacity;
-        queue->count--;
+        lane->head = 0;
+        lane->tail = 0;
     }
     
-    queue->head = 0;
-    queue->tail = 0;
     queue->count = 0;
+    queue->head_lane = EVENT_PRIORITY_NORMAL;
+    queue->head_offset = 0;
+    queue->bytes = 0;
 }
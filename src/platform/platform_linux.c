@@ -0,0 +1,1416 @@
+/**
+ * @file platform_linux.c
+ * @brief POSIX implementation of the platform layer (Linux)
+ *
+ * Tools are started with posix_spawn() through /bin/sh so that the
+ * command line in the config file behaves the same way it does with
+ * CreateProcess() on Windows. Every tool gets its own process group, so
+ * stopping a tool also stops anything its shell started.
+ *
+ * The framework keeps one PlatformChild record per spawned process. A pid
+ * is only ever signalled while its record says the child has not been
+ * reaped yet, which keeps us from killing an unrelated process that
+ * happened to reuse the pid.
+ *
+ * Exits are reported through each child's pidfd, which the event loop
+ * watches. Kernels without pidfd_open() (before 5.3) get one signalfd for
+ * SIGCHLD instead, after which every child is checked with a non-blocking
+ * wait4(). Either way the exit status and rusage are kept on the record.
+ */
+
+#include "yuki_frame/framework.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <linux/io_uring.h>
+
+extern char** environ;
+
+// Grace period between SIGTERM and SIGKILL for a non-forced kill
+#define PLATFORM_KILL_GRACE_MS 1000
+
+// Room for every tool plus a restarted instance of each
+#define PLATFORM_MAX_CHILDREN (MAX_TOOLS * 2)
+
+// Child process bookkeeping
+typedef struct {
+    pid_t pid;          // 0 = free slot
+    int pidfd;          // -1 if pidfd_open() is unavailable
+    bool exited;        // Reaped with wait4()
+    int status;         // wait4() status once exited
+    struct rusage usage;  // Resources used, once exited
+} PlatformChild;
+
+static PlatformChild children[PLATFORM_MAX_CHILDREN];
+
+// SIGCHLD signalfd when pidfds are unavailable, else -1
+static int child_signal_fd = -1;
+static bool pidfd_supported = false;
+
+static PlatformChild* child_find(pid_t pid) {
+    if (pid <= 0) {
+        return NULL;
+    }
+
+    for (int i = 0; i < PLATFORM_MAX_CHILDREN; i++) {
+        if (children[i].pid == pid) {
+            return &children[i];
+        }
+    }
+    return NULL;
+}
+
+static PlatformChild* child_alloc(void) {
+    // Prefer free slots, then recycle records of reaped children
+    for (int i = 0; i < PLATFORM_MAX_CHILDREN; i++) {
+        if (children[i].pid == 0) {
+            return &children[i];
+        }
+    }
+    for (int i = 0; i < PLATFORM_MAX_CHILDREN; i++) {
+        if (children[i].exited) {
+            return &children[i];
+        }
+    }
+    return NULL;
+}
+
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        return fd;
+    }
+#else
+    (void)pid;
+#endif
+    return -1;
+}
+
+// Reap the child if it has exited. Returns true once the child is gone.
+static bool child_reap(PlatformChild* child) {
+    if (child->exited) {
+        return true;
+    }
+
+    int status = 0;
+    struct rusage usage;
+    pid_t result;
+    do {
+        result = wait4(child->pid, &status, WNOHANG, &usage);
+    } while (result < 0 && errno == EINTR);
+
+    if (result == 0) {
+        return false;  // Still running
+    }
+
+    // result == pid (reaped now) or ECHILD (reaped elsewhere). The pidfd
+    // stays open until the record is recycled: the event loop may still
+    // have it registered.
+    child->exited = true;
+    child->status = (result == child->pid) ? status : 0;
+    if (result == child->pid) {
+        child->usage = usage;
+    } else {
+        memset(&child->usage, 0, sizeof(child->usage));
+    }
+    return true;
+}
+
+// Block until the child exits or the timeout expires (timeout_ms < 0 = forever)
+static bool child_wait(PlatformChild* child, int timeout_ms) {
+    uint64_t deadline = platform_monotonic_ms() + (uint64_t)(timeout_ms < 0 ? 0 : timeout_ms);
+
+    while (!child_reap(child)) {
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = platform_monotonic_ms();
+            if (now >= deadline) {
+                return false;
+            }
+            remaining = (int)(deadline - now);
+        }
+
+        if (child->pidfd >= 0) {
+            // pidfd becomes readable when the process exits
+            struct pollfd pfd = { .fd = child->pidfd, .events = POLLIN };
+            poll(&pfd, 1, remaining);
+        } else {
+            platform_sleep_ms((remaining < 0 || remaining > 10) ? 10 : remaining);
+        }
+    }
+    return true;
+}
+
+static int set_fd_flags(int fd, bool nonblocking) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        return FW_ERROR_IO;
+    }
+    flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(fd, F_SETFL, flags) < 0 ? FW_ERROR_IO : FW_OK;
+}
+
+static void close_pipe(int pipe_fds[2]) {
+    if (pipe_fds[0] >= 0) close(pipe_fds[0]);
+    if (pipe_fds[1] >= 0) close(pipe_fds[1]);
+    pipe_fds[0] = pipe_fds[1] = -1;
+}
+
+typedef struct {
+    PlatformThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+static void* thread_trampoline(void* param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return NULL;
+}
+
+int platform_thread_create(PlatformThread* thread, PlatformThreadFunc func, void* arg) {
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (!start) {
+        return FW_ERROR_MEMORY;
+    }
+    start->func = func;
+    start->arg = arg;
+
+    // Workers must not take the signals the main thread handles
+    sigset_t block, previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+    int rc = pthread_create(thread, NULL, thread_trampoline, start);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (rc != 0) {
+        free(start);
+        LOG_ERROR("platform", "pthread_create failed: %s", strerror(rc));
+        return FW_ERROR_GENERIC;
+    }
+    return FW_OK;
+}
+
+void platform_thread_join(PlatformThread thread) {
+    pthread_join(thread, NULL);
+}
+
+void platform_mutex_init(PlatformMutex* mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+void platform_mutex_destroy(PlatformMutex* mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+void platform_mutex_lock(PlatformMutex* mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+void platform_mutex_unlock(PlatformMutex* mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+int platform_pin_thread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        LOG_WARN("platform", "Failed to pin thread to CPU %d: %s", cpu, strerror(rc));
+        return FW_ERROR_GENERIC;
+    }
+    return FW_OK;
+}
+
+// Without pidfds, have SIGCHLD queued on a signalfd. It must be blocked in
+// every thread, so this runs before any thread is created; spawned tools
+// get a clean signal mask back.
+static void child_signal_init(void) {
+    int self = open_pidfd(getpid());
+    if (self >= 0) {
+        close(self);
+        pidfd_supported = true;
+        return;
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    child_signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (child_signal_fd < 0) {
+        LOG_WARN("platform", "No pidfd or signalfd, tool exits are found by polling: %s",
+                 strerror(errno));
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    } else {
+        LOG_INFO("platform", "pidfd_open unavailable, watching SIGCHLD instead");
+    }
+}
+
+int platform_init(void) {
+    memset(children, 0, sizeof(children));
+    for (int i = 0; i < PLATFORM_MAX_CHILDREN; i++) {
+        children[i].pidfd = -1;
+    }
+    child_signal_init();
+
+    // A tool closing its stdin must surface as EPIPE, not kill the framework
+    signal(SIGPIPE, SIG_IGN);
+
+    // Three pipes per tool: make sure MAX_TOOLS tools fit in the fd limit
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    LOG_INFO("platform", "Linux platform initialized");
+    return FW_OK;
+}
+
+void platform_shutdown(void) {
+    for (int i = 0; i < PLATFORM_MAX_CHILDREN; i++) {
+        if (children[i].pid > 0 && !children[i].exited) {
+            child_reap(&children[i]);
+        }
+        if (children[i].pidfd >= 0) {
+            close(children[i].pidfd);
+            children[i].pidfd = -1;
+        }
+    }
+    if (child_signal_fd >= 0) {
+        close(child_signal_fd);
+        child_signal_fd = -1;
+    }
+    LOG_INFO("platform", "Linux platform shutdown");
+}
+
+int platform_file_sync(int fd) {
+    return fdatasync(fd) == 0 ? FW_OK : FW_ERROR_IO;
+}
+
+int platform_make_dir(const char* path) {
+    if (mkdir(path, 0755) == 0 || errno == EEXIST) {
+        return FW_OK;
+    }
+    return FW_ERROR_IO;
+}
+
+int platform_replace_file(const char* from, const char* to) {
+    return rename(from, to) == 0 ? FW_OK : FW_ERROR_IO;
+}
+
+int platform_map_file(const char* path, const char** data, size_t* size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT ? FW_ERROR_NOT_FOUND : FW_ERROR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FW_ERROR_IO;
+    }
+    *data = NULL;
+    *size = (size_t)st.st_size;
+    if (*size > 0) {
+        void* map = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return FW_ERROR_IO;
+        }
+        *data = (const char*)map;
+    }
+    close(fd);  // The mapping keeps the file
+    return FW_OK;
+}
+
+void platform_unmap_file(const char* data, size_t size) {
+    if (data && size > 0) {
+        munmap((void*)data, size);
+    }
+}
+
+void platform_sleep_ms(int milliseconds) {
+    if (milliseconds <= 0) {
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = milliseconds / 1000;
+    ts.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+        // Sleep for the remaining time
+    }
+}
+
+void platform_sleep(int seconds) {
+    platform_sleep_ms(seconds * 1000);
+}
+
+uint64_t platform_monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+uint64_t platform_monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+ProcessHandle platform_spawn_process(const char* command, int* stdin_fd, int* stdout_fd, int* stderr_fd) {
+    if (!command || !stdin_fd || !stdout_fd || !stderr_fd) {
+        return INVALID_PROCESS_HANDLE;
+    }
+
+    PlatformChild* child = child_alloc();
+    if (!child) {
+        LOG_ERROR("platform", "Too many child processes");
+        return INVALID_PROCESS_HANDLE;
+    }
+
+    // All pipe ends are close-on-exec; posix_spawn's dup2 clears the flag
+    // on the child's 0/1/2 only
+    int in_pipe[2] = { -1, -1 };
+    int out_pipe[2] = { -1, -1 };
+    int err_pipe[2] = { -1, -1 };
+
+    if (pipe2(in_pipe, O_CLOEXEC) < 0) {
+        LOG_ERROR("platform", "Failed to create stdin pipe: %s", strerror(errno));
+        return INVALID_PROCESS_HANDLE;
+    }
+    if (pipe2(out_pipe, O_CLOEXEC) < 0) {
+        LOG_ERROR("platform", "Failed to create stdout pipe: %s", strerror(errno));
+        close_pipe(in_pipe);
+        return INVALID_PROCESS_HANDLE;
+    }
+    if (pipe2(err_pipe, O_CLOEXEC) < 0) {
+        LOG_ERROR("platform", "Failed to create stderr pipe: %s", strerror(errno));
+        close_pipe(in_pipe);
+        close_pipe(out_pipe);
+        return INVALID_PROCESS_HANDLE;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+    // Own process group, clean signal mask, default dispositions
+    // (SIGPIPE is ignored in the framework and would be inherited)
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK |
+                                    POSIX_SPAWN_SETSIGDEF);
+
+    char* argv[] = { "/bin/sh", "-c", (char*)command, NULL };
+    pid_t pid = 0;
+    int result = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    // Child-side ends are no longer needed in the parent
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    close(err_pipe[1]);
+
+    if (result != 0) {
+        LOG_ERROR("platform", "posix_spawn failed: %s", strerror(result));
+        close(in_pipe[1]);
+        close(out_pipe[0]);
+        close(err_pipe[0]);
+        return INVALID_PROCESS_HANDLE;
+    }
+
+    set_fd_flags(in_pipe[1], true);
+    set_fd_flags(out_pipe[0], true);
+    set_fd_flags(err_pipe[0], true);
+
+    if (child->pidfd >= 0) {
+        close(child->pidfd);
+    }
+    child->pid = pid;
+    child->pidfd = pidfd_supported ? open_pidfd(pid) : -1;
+    child->exited = false;
+    child->status = 0;
+    memset(&child->usage, 0, sizeof(child->usage));
+
+    *stdin_fd = in_pipe[1];
+    *stdout_fd = out_pipe[0];
+    *stderr_fd = err_pipe[0];
+
+    LOG_INFO("platform", "Process spawned with PID %d", (int)pid);
+
+    return pid;
+}
+
+int platform_kill_process(ProcessHandle handle, bool force) {
+    PlatformChild* child = child_find(handle);
+    if (!child) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    if (child_reap(child)) {
+        return FW_OK;  // Already gone
+    }
+
+    // Signal the whole process group (the shell and whatever it started)
+    if (!force) {
+        if (kill(-child->pid, SIGTERM) < 0 && errno != ESRCH) {
+            LOG_ERROR("platform", "kill(SIGTERM) failed for PID %d: %s",
+                      (int)child->pid, strerror(errno));
+            return FW_ERROR_PROCESS_FAILED;
+        }
+        if (child_wait(child, PLATFORM_KILL_GRACE_MS)) {
+            return FW_OK;
+        }
+        LOG_WARN("platform", "PID %d ignored SIGTERM, sending SIGKILL", (int)child->pid);
+    }
+
+    if (kill(-child->pid, SIGKILL) < 0 && errno != ESRCH) {
+        LOG_ERROR("platform", "kill(SIGKILL) failed for PID %d: %s",
+                  (int)child->pid, strerror(errno));
+        return FW_ERROR_PROCESS_FAILED;
+    }
+    child_wait(child, PLATFORM_KILL_GRACE_MS);
+    return FW_OK;
+}
+
+bool platform_is_process_running(ProcessHandle handle) {
+    PlatformChild* child = child_find(handle);
+    if (!child) {
+        return false;
+    }
+    return !child_reap(child);
+}
+
+int platform_wait_process(ProcessHandle handle, int timeout_ms) {
+    PlatformChild* child = child_find(handle);
+    if (!child) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    // Same convention as Windows: timeout_ms <= 0 waits forever
+    return child_wait(child, timeout_ms <= 0 ? -1 : timeout_ms) ? FW_OK : FW_ERROR_TIMEOUT;
+}
+
+ProcessID platform_get_process_id(ProcessHandle handle) {
+    return handle > 0 ? handle : 0;
+}
+
+int platform_process_exit_fd(ProcessHandle handle) {
+    PlatformChild* child = child_find(handle);
+    if (!child || child->exited) {
+        return -1;
+    }
+    return child->pidfd;
+}
+
+int platform_child_exit_fd(void) {
+    return child_signal_fd;
+}
+
+void platform_child_exit_drain(void) {
+    if (child_signal_fd < 0) {
+        return;
+    }
+    // SIGCHLD coalesces: one record may stand for several exits
+    struct signalfd_siginfo info[16];
+    while (read(child_signal_fd, info, sizeof(info)) > 0) {
+    }
+}
+
+static uint64_t timeval_ms(const struct timeval* tv) {
+    return (uint64_t)tv->tv_sec * 1000 + (uint64_t)tv->tv_usec / 1000;
+}
+
+bool platform_get_exit_info(ProcessHandle handle, PlatformExitInfo* info) {
+    PlatformChild* child = child_find(handle);
+    if (!child || !info || !child_reap(child)) {
+        return false;
+    }
+
+    memset(info, 0, sizeof(*info));
+    if (WIFSIGNALED(child->status)) {
+        info->exit_code = -1;
+        info->signal = WTERMSIG(child->status);
+    } else {
+        info->exit_code = WIFEXITED(child->status) ? WEXITSTATUS(child->status) : 0;
+    }
+    info->user_cpu_ms = timeval_ms(&child->usage.ru_utime);
+    info->system_cpu_ms = timeval_ms(&child->usage.ru_stime);
+    info->max_rss_kb = (uint64_t)child->usage.ru_maxrss;  // Already KiB on Linux
+    return true;
+}
+
+int platform_read_nonblocking(int fd, char* buffer, size_t size) {
+    if (fd < 0 || !buffer || size == 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    ssize_t n;
+    do {
+        n = read(fd, buffer, size);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;  // No data available
+        }
+        return FW_ERROR_IO;
+    }
+
+    return (int)n;  // 0 = pipe closed
+}
+
+int platform_write_nonblocking(int fd, const char* data, size_t size) {
+    if (fd < 0 || !data || size == 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    ssize_t n;
+    do {
+        n = write(fd, data, size);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;  // Pipe full
+        }
+        if (errno != EPIPE) {
+            LOG_ERROR("platform", "write failed: %s", strerror(errno));
+        }
+        return FW_ERROR_IO;
+    }
+
+    return (int)n;
+}
+
+int platform_writev_nonblocking(int fd, const PlatformIoVec* iov, int count) {
+    if (fd < 0 || !iov || count <= 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    // Linux's IOV_MAX; the caller gets a short count and resumes
+    struct iovec vec[1024];
+    int vec_count = count < 1024 ? count : 1024;
+    for (int i = 0; i < vec_count; i++) {
+        vec[i].iov_base = (void*)iov[i].data;
+        vec[i].iov_len = iov[i].size;
+    }
+
+    ssize_t n;
+    do {
+        n = writev(fd, vec, vec_count);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;  // Pipe full
+        }
+        if (errno != EPIPE) {
+            LOG_ERROR("platform", "writev failed: %s", strerror(errno));
+        }
+        return FW_ERROR_IO;
+    }
+
+    return (int)n;
+}
+
+int platform_write_all(int fd, const char* data, size_t size) {
+    if (fd < 0 || !data) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        int n = platform_write_nonblocking(fd, data + total, size - total);
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            // Pipe full: wait until the reader makes room
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                return FW_ERROR_IO;
+            }
+            continue;
+        }
+        total += (size_t)n;
+    }
+
+    return (int)total;
+}
+
+int platform_set_nonblocking(int fd) {
+    if (fd < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    return set_fd_flags(fd, true);
+}
+
+void platform_close_fd(int fd) {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/* ============================================================================
+ * Readiness polling (epoll or io_uring, eventfd wakeup)
+ *
+ * The io_uring backend keeps the poller's level-triggered contract with
+ * one-shot IORING_OP_POLL_ADD requests: a reported fd is re-armed on the
+ * next wait, and a poll armed on an fd that is still readable completes at
+ * once. Re-arms, registrations and the wait itself go to the kernel in a
+ * single io_uring_enter() per loop pass, where epoll needs an epoll_ctl()
+ * per change on top of epoll_wait(). Requests carry the fd and a per-fd
+ * generation, so completions of polls that were since removed are ignored.
+ * ============================================================================ */
+
+#define URING_ENTRIES 256
+#define URING_KEY_IGNORE UINT64_MAX     // user_data of POLL_REMOVE requests
+
+typedef struct {
+    void* user_data;
+    unsigned int events;        // PLATFORM_POLL_* wanted, 0 = not registered
+    uint32_t generation;        // Bumped on every remove/modify
+    bool armed;                 // A poll request is in flight
+    bool rearm;                 // Listed in rearm_fds: arm on the next wait
+} UringSlot;
+
+typedef struct {
+    int ring_fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;              // Same mapping as sq_ring with SINGLE_MMAP
+    size_t cq_ring_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    UringSlot* slots;           // Indexed by fd
+    int* rearm_fds;             // Reported, or not armed for want of a free entry
+    int rearm_count;
+
+    // Tool start/stop register pipes from the main thread while the shard
+    // thread waits: the submission ring and slots are shared
+    pthread_mutex_t lock;
+    pthread_t owner;            // Thread that waits on the ring
+    bool has_owner;
+} Uring;
+
+// An fd registered with epoll. The kernel hands it back in data.ptr, so the
+// waiting thread never indexes a table that add/remove may grow under it;
+// removed sources are freed by the waiting thread once it has copied out
+// what it was handed.
+typedef struct PollSource {
+    int fd;
+    void* user_data;            // NULL once removed
+    struct PollSource* next_retired;
+} PollSource;
+
+struct PlatformPoller {
+    int epoll_fd;               // -1 with io_uring
+    Uring* uring;               // NULL with epoll
+    int wakeup_fd;
+    PollSource** sources;       // Indexed by fd (epoll), guarded by lock
+    int table_size;             // Size of sources or uring->slots
+    pthread_mutex_t lock;       // Registration changes (epoll)
+    PollSource* retired;        // Removed sources not yet freed
+    struct epoll_event* ready;  // Scratch buffer for epoll_wait()
+    int ready_size;
+};
+
+static IoBackend io_backend = IO_BACKEND_DEFAULT;
+
+static uint32_t to_epoll_events(unsigned int events) {
+    uint32_t result = 0;
+    if (events & PLATFORM_POLL_READ) result |= EPOLLIN;
+    if (events & PLATFORM_POLL_WRITE) result |= EPOLLOUT;
+    return result;  // EPOLLHUP/EPOLLERR are always reported
+}
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags, void* arg, size_t arg_size) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+static void uring_destroy(Uring* ring) {
+    if (!ring) {
+        return;
+    }
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->ring_fd >= 0) close(ring->ring_fd);
+    pthread_mutex_destroy(&ring->lock);
+    free(ring->slots);
+    free(ring->rearm_fds);
+    free(ring);
+}
+
+static Uring* uring_create(void) {
+    Uring* ring = (Uring*)calloc(1, sizeof(Uring));
+    if (!ring) {
+        return NULL;
+    }
+    pthread_mutex_init(&ring->lock, NULL);
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+    if (ring->ring_fd < 0) {
+        uring_destroy(ring);
+        return NULL;
+    }
+    // Waits need a timeout without a timeout request (5.11+), and a full
+    // completion queue must not drop completions
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+        uring_destroy(ring);
+        return NULL;
+    }
+    fcntl(ring->ring_fd, F_SETFD, FD_CLOEXEC);
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        uring_destroy(ring);
+        return NULL;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            uring_destroy(ring);
+            return NULL;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                                            IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        uring_destroy(ring);
+        return NULL;
+    }
+
+    char* sq = (char*)ring->sq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+
+    char* cq = (char*)ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return ring;
+}
+
+// Requests queued but not yet taken by the kernel (lock held)
+static unsigned uring_unsubmitted(Uring* ring) {
+    return *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// Next free submission entry, submitting what is queued if the ring is
+// full (lock held)
+static struct io_uring_sqe* uring_get_sqe(Uring* ring) {
+    if (uring_unsubmitted(ring) >= ring->sq_entries) {
+        sys_io_uring_enter(ring->ring_fd, ring->sq_entries, 0, 0, NULL, 0);
+        if (uring_unsubmitted(ring) >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+static void uring_push_sqe(Uring* ring) {
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+static uint64_t uring_key(int fd, uint32_t generation) {
+    return ((uint64_t)generation << 32) | (uint32_t)fd;
+}
+
+// Arm again on the next wait (lock held)
+static void uring_defer_arm(Uring* ring, int fd) {
+    UringSlot* slot = &ring->slots[fd];
+    if (!slot->rearm) {
+        slot->rearm = true;
+        ring->rearm_fds[ring->rearm_count++] = fd;
+    }
+}
+
+static void uring_arm(Uring* ring, int fd) {
+    UringSlot* slot = &ring->slots[fd];
+    struct io_uring_sqe* sqe = uring_get_sqe(ring);
+    if (!sqe) {
+        uring_defer_arm(ring, fd);  // Submission ring still full
+        return;
+    }
+
+    uint32_t mask = POLLERR | POLLHUP;
+    if (slot->events & PLATFORM_POLL_READ) mask |= POLLIN;
+    if (slot->events & PLATFORM_POLL_WRITE) mask |= POLLOUT;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    mask = (mask << 16) | (mask >> 16);
+#endif
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = mask;
+    sqe->user_data = uring_key(fd, slot->generation);
+    uring_push_sqe(ring);
+    slot->armed = true;
+}
+
+// Cancel the poll in flight on fd, if any; its completion becomes stale
+static void uring_disarm(Uring* ring, int fd) {
+    UringSlot* slot = &ring->slots[fd];
+    if (slot->armed) {
+        struct io_uring_sqe* sqe = uring_get_sqe(ring);
+        if (sqe) {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = uring_key(fd, slot->generation);
+            sqe->user_data = URING_KEY_IGNORE;
+            uring_push_sqe(ring);
+        }
+        slot->armed = false;
+    }
+    slot->generation++;
+}
+
+// Changes made off the waiting thread reach the kernel on its next enter:
+// interrupt a wait in progress
+static void uring_nudge(PlatformPoller* poller) {
+    Uring* ring = poller->uring;
+    if (__atomic_load_n(&ring->has_owner, __ATOMIC_ACQUIRE) &&
+        !pthread_equal(ring->owner, pthread_self())) {
+        uint64_t one = 1;
+        ssize_t ignored = write(poller->wakeup_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+// Grow the fd-indexed table (poller or ring lock held; only registration
+// changes and the uring reap, which takes the same lock, read it)
+static int poller_grow(PlatformPoller* poller, int fd) {
+    if (fd < poller->table_size) {
+        return FW_OK;
+    }
+
+    int new_size = poller->table_size ? poller->table_size : 64;
+    while (new_size <= fd) {
+        new_size *= 2;
+    }
+
+    if (!poller->uring) {
+        PollSource** grown = (PollSource**)realloc(poller->sources,
+                                                   (size_t)new_size * sizeof(PollSource*));
+        if (!grown) {
+            return FW_ERROR_MEMORY;
+        }
+        memset(grown + poller->table_size, 0,
+               (size_t)(new_size - poller->table_size) * sizeof(PollSource*));
+        poller->sources = grown;
+    } else {
+        Uring* ring = poller->uring;
+        UringSlot* slots = (UringSlot*)realloc(ring->slots, (size_t)new_size * sizeof(UringSlot));
+        if (!slots) {
+            return FW_ERROR_MEMORY;
+        }
+        memset(slots + poller->table_size, 0,
+               (size_t)(new_size - poller->table_size) * sizeof(UringSlot));
+        ring->slots = slots;
+        int* rearm = (int*)realloc(ring->rearm_fds, (size_t)new_size * sizeof(int));
+        if (!rearm) {
+            return FW_ERROR_MEMORY;
+        }
+        ring->rearm_fds = rearm;
+    }
+
+    poller->table_size = new_size;
+    return FW_OK;
+}
+
+static int uring_poller_add(PlatformPoller* poller, int fd, unsigned int events, void* user_data) {
+    Uring* ring = poller->uring;
+    pthread_mutex_lock(&ring->lock);
+    int result = poller_grow(poller, fd);
+    if (result == FW_OK) {
+        UringSlot* slot = &ring->slots[fd];
+        if (slot->events) {
+            result = FW_ERROR_ALREADY_EXISTS;
+        } else {
+            slot->user_data = user_data;
+            slot->events = events ? events : PLATFORM_POLL_HANGUP;
+            uring_arm(ring, fd);
+        }
+    }
+    pthread_mutex_unlock(&ring->lock);
+
+    if (result == FW_OK) {
+        uring_nudge(poller);
+    }
+    return result;
+}
+
+static int uring_poller_modify(PlatformPoller* poller, int fd, unsigned int events) {
+    Uring* ring = poller->uring;
+    pthread_mutex_lock(&ring->lock);
+    int result = FW_ERROR_NOT_FOUND;
+    if (fd < poller->table_size && ring->slots[fd].events) {
+        UringSlot* slot = &ring->slots[fd];
+        uring_disarm(ring, fd);
+        slot->events = events ? events : PLATFORM_POLL_HANGUP;
+        uring_arm(ring, fd);
+        result = FW_OK;
+    }
+    pthread_mutex_unlock(&ring->lock);
+
+    if (result == FW_OK) {
+        uring_nudge(poller);
+    }
+    return result;
+}
+
+static int uring_poller_remove(PlatformPoller* poller, int fd) {
+    Uring* ring = poller->uring;
+    pthread_mutex_lock(&ring->lock);
+    int result = FW_ERROR_NOT_FOUND;
+    bool cancel = false;
+    if (fd < poller->table_size && ring->slots[fd].events) {
+        UringSlot* slot = &ring->slots[fd];
+        cancel = slot->armed;
+        uring_disarm(ring, fd);
+        slot->events = 0;
+        slot->user_data = NULL;
+        result = FW_OK;
+    }
+    pthread_mutex_unlock(&ring->lock);
+
+    // The kernel holds the file until the poll is cancelled
+    if (cancel) {
+        uring_nudge(poller);
+    }
+    return result;
+}
+
+static int uring_poller_wait(PlatformPoller* poller, PlatformPollEvent* events,
+                             int max_events, int timeout_ms) {
+    Uring* ring = poller->uring;
+
+    pthread_mutex_lock(&ring->lock);
+    if (!ring->has_owner || !pthread_equal(ring->owner, pthread_self())) {
+        ring->owner = pthread_self();
+        __atomic_store_n(&ring->has_owner, true, __ATOMIC_RELEASE);
+    }
+
+    // Re-arm what was reported last time and is still registered; an fd
+    // that finds the submission ring full stays listed for the next wait
+    int listed = ring->rearm_count;
+    ring->rearm_count = 0;
+    for (int i = 0; i < listed; i++) {
+        int fd = ring->rearm_fds[i];
+        UringSlot* slot = &ring->slots[fd];
+        slot->rearm = false;
+        if (slot->events && !slot->armed) {
+            uring_arm(ring, fd);
+        }
+    }
+    if (ring->rearm_count > 0 && (timeout_ms < 0 || timeout_ms > 1)) {
+        timeout_ms = 1;  // Unwatched fds: do not sleep long before retrying
+    }
+    unsigned to_submit = uring_unsubmitted(ring);
+    pthread_mutex_unlock(&ring->lock);
+
+    // Submit and wait in one call; skip it if nothing is queued and
+    // completions are already waiting
+    bool ready = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) != *ring->cq_head;
+    unsigned min_complete = (ready || timeout_ms == 0) ? 0 : 1;
+    if (to_submit > 0 || min_complete > 0) {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        if (timeout_ms >= 0 && min_complete > 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+        unsigned flags = IORING_ENTER_EXT_ARG | (min_complete ? IORING_ENTER_GETEVENTS : 0);
+        int rc = sys_io_uring_enter(ring->ring_fd, to_submit, min_complete, flags,
+                                    &arg, sizeof(arg));
+        if (rc < 0 && errno != EINTR && errno != ETIME && errno != EAGAIN && errno != EBUSY) {
+            return FW_ERROR_IO;
+        }
+    }
+
+    // Reap
+    pthread_mutex_lock(&ring->lock);
+    int count = 0;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && count < max_events) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+        head++;
+        if (cqe->user_data == URING_KEY_IGNORE) {
+            continue;
+        }
+
+        int fd = (int)(uint32_t)cqe->user_data;
+        uint32_t generation = (uint32_t)(cqe->user_data >> 32);
+        if (fd < 0 || fd >= poller->table_size) {
+            continue;
+        }
+        UringSlot* slot = &ring->slots[fd];
+        if (!slot->events || slot->generation != generation || !slot->armed) {
+            continue;  // Removed or modified since it was armed
+        }
+        slot->armed = false;
+        uring_defer_arm(ring, fd);
+
+        if (fd == poller->wakeup_fd) {
+            uint64_t value;
+            while (read(poller->wakeup_fd, &value, sizeof(value)) > 0) {
+                // Drain the counter
+            }
+            continue;
+        }
+
+        unsigned int ready_events = 0;
+        if (cqe->res < 0) {
+            ready_events = PLATFORM_POLL_HANGUP;
+        } else {
+            if (cqe->res & POLLIN) ready_events |= PLATFORM_POLL_READ;
+            if (cqe->res & POLLOUT) ready_events |= PLATFORM_POLL_WRITE;
+            if (cqe->res & (POLLHUP | POLLERR)) ready_events |= PLATFORM_POLL_HANGUP;
+        }
+        events[count].fd = fd;
+        events[count].events = ready_events;
+        events[count].user_data = slot->user_data;
+        count++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&ring->lock);
+
+    return count;
+}
+
+IoBackend platform_select_io_backend(IoBackend wanted) {
+    io_backend = IO_BACKEND_DEFAULT;
+    if (wanted == IO_BACKEND_DEFAULT) {
+        return io_backend;
+    }
+
+    Uring* probe = uring_create();
+    if (probe) {
+        uring_destroy(probe);
+        io_backend = IO_BACKEND_IO_URING;
+        LOG_INFO("platform", "Using io_uring for tool pipes");
+    } else if (wanted == IO_BACKEND_IO_URING) {
+        LOG_WARN("platform", "io_uring unavailable (needs Linux 5.11+), using epoll");
+    }
+    return io_backend;
+}
+
+PlatformPoller* platform_poller_create(void) {
+    PlatformPoller* poller = (PlatformPoller*)calloc(1, sizeof(PlatformPoller));
+    if (!poller) {
+        return NULL;
+    }
+    poller->epoll_fd = -1;
+    pthread_mutex_init(&poller->lock, NULL);
+
+    poller->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poller->wakeup_fd < 0) {
+        LOG_ERROR("platform", "Failed to create poller: %s", strerror(errno));
+        platform_poller_destroy(poller);
+        return NULL;
+    }
+
+    if (io_backend == IO_BACKEND_IO_URING) {
+        poller->uring = uring_create();
+        if (poller->uring) {
+            if (uring_poller_add(poller, poller->wakeup_fd, PLATFORM_POLL_READ, NULL) != FW_OK) {
+                LOG_ERROR("platform", "Failed to register wakeup fd");
+                platform_poller_destroy(poller);
+                return NULL;
+            }
+            return poller;
+        }
+        LOG_WARN("platform", "io_uring setup failed, using epoll for this poller");
+    }
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poller->epoll_fd < 0) {
+        LOG_ERROR("platform", "Failed to create poller: %s", strerror(errno));
+        platform_poller_destroy(poller);
+        return NULL;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;  // The only source without a PollSource
+    if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_ADD, poller->wakeup_fd, &ev) < 0) {
+        LOG_ERROR("platform", "Failed to register wakeup fd: %s", strerror(errno));
+        platform_poller_destroy(poller);
+        return NULL;
+    }
+
+    return poller;
+}
+
+static void free_retired(PollSource* source) {
+    while (source) {
+        PollSource* next = source->next_retired;
+        free(source);
+        source = next;
+    }
+}
+
+void platform_poller_destroy(PlatformPoller* poller) {
+    if (!poller) {
+        return;
+    }
+    uring_destroy(poller->uring);
+    if (poller->epoll_fd >= 0) close(poller->epoll_fd);
+    if (poller->wakeup_fd >= 0) close(poller->wakeup_fd);
+    for (int fd = 0; fd < poller->table_size && poller->sources; fd++) {
+        free(poller->sources[fd]);
+    }
+    free(poller->sources);
+    free_retired(poller->retired);
+    pthread_mutex_destroy(&poller->lock);
+    free(poller->ready);
+    free(poller);
+}
+
+int platform_poller_add(PlatformPoller* poller, int fd, unsigned int events, void* user_data) {
+    if (!poller || fd < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (poller->uring) {
+        return uring_poller_add(poller, fd, events, user_data);
+    }
+
+    PollSource* source = (PollSource*)calloc(1, sizeof(PollSource));
+    if (!source) {
+        return FW_ERROR_MEMORY;
+    }
+    source->fd = fd;
+    source->user_data = user_data;
+
+    pthread_mutex_lock(&poller->lock);
+    int result = poller_grow(poller, fd);
+    if (result == FW_OK) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = to_epoll_events(events);
+        ev.data.ptr = source;
+        if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LOG_ERROR("platform", "epoll_ctl(ADD, %d) failed: %s", fd, strerror(errno));
+            result = FW_ERROR_IO;
+        } else {
+            poller->sources[fd] = source;
+            source = NULL;
+        }
+    }
+    pthread_mutex_unlock(&poller->lock);
+
+    free(source);  // Not registered
+    return result;
+}
+
+int platform_poller_modify(PlatformPoller* poller, int fd, unsigned int events) {
+    if (!poller || fd < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (poller->uring) {
+        return uring_poller_modify(poller, fd, events);
+    }
+
+    pthread_mutex_lock(&poller->lock);
+    int result = FW_ERROR_INVALID_ARG;
+    if (fd < poller->table_size && poller->sources[fd]) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = to_epoll_events(events);
+        ev.data.ptr = poller->sources[fd];
+        result = epoll_ctl(poller->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0 ? FW_ERROR_IO : FW_OK;
+    }
+    pthread_mutex_unlock(&poller->lock);
+    return result;
+}
+
+int platform_poller_remove(PlatformPoller* poller, int fd) {
+    if (!poller || fd < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (poller->uring) {
+        return uring_poller_remove(poller, fd);
+    }
+
+    // Deregister before retiring: once retired, the next wait may free the
+    // source, and the kernel must not hand it out again after that
+    pthread_mutex_lock(&poller->lock);
+    int result = FW_OK;
+    if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_DEL, fd, NULL) < 0) {
+        result = FW_ERROR_NOT_FOUND;
+    }
+    PollSource* source = (fd < poller->table_size) ? poller->sources[fd] : NULL;
+    if (source) {
+        poller->sources[fd] = NULL;
+        __atomic_store_n(&source->user_data, NULL, __ATOMIC_RELEASE);
+        source->next_retired = poller->retired;
+        __atomic_store_n(&poller->retired, source, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&poller->lock);
+    return result;
+}
+
+int platform_poller_wait(PlatformPoller* poller, PlatformPollEvent* events, int max_events, int timeout_ms) {
+    if (!poller || !events || max_events <= 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (poller->uring) {
+        return uring_poller_wait(poller, events, max_events, timeout_ms);
+    }
+
+    if (max_events > poller->ready_size) {
+        struct epoll_event* grown = (struct epoll_event*)realloc(
+            poller->ready, (size_t)max_events * sizeof(struct epoll_event));
+        if (!grown) {
+            return FW_ERROR_MEMORY;
+        }
+        poller->ready = grown;
+        poller->ready_size = max_events;
+    }
+
+    int n = epoll_wait(poller->epoll_fd, poller->ready, max_events, timeout_ms);
+    if (n < 0) {
+        return (errno == EINTR) ? 0 : FW_ERROR_IO;
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        PollSource* source = (PollSource*)poller->ready[i].data.ptr;
+        uint32_t ev = poller->ready[i].events;
+
+        if (!source) {
+            uint64_t value;
+            while (read(poller->wakeup_fd, &value, sizeof(value)) > 0) {
+                // Drain the counter
+            }
+            continue;
+        }
+
+        events[count].fd = source->fd;
+        events[count].events = 0;
+        if (ev & EPOLLIN) events[count].events |= PLATFORM_POLL_READ;
+        if (ev & EPOLLOUT) events[count].events |= PLATFORM_POLL_WRITE;
+        if (ev & (EPOLLHUP | EPOLLERR)) events[count].events |= PLATFORM_POLL_HANGUP;
+        events[count].user_data = __atomic_load_n(&source->user_data, __ATOMIC_ACQUIRE);
+        count++;
+    }
+
+    // Sources removed so far are out of the kernel's set and out of this
+    // batch now; nothing else holds them
+    if (__atomic_load_n(&poller->retired, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&poller->lock);
+        PollSource* retired = poller->retired;
+        poller->retired = NULL;
+        pthread_mutex_unlock(&poller->lock);
+        free_retired(retired);
+    }
+
+    return count;
+}
+
+int platform_poller_wakeup(PlatformPoller* poller) {
+    if (!poller) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    uint64_t one = 1;
+    if (write(poller->wakeup_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        return FW_ERROR_IO;
+    }
+    return FW_OK;
+}
@@ -2,11 +2,80 @@
 #include "yuki_frame/logger.h"
 #include "yuki_frame/platform.h"
 #include <windows.h>
+#include <psapi.h>
 #include <io.h>
+#include <process.h>
+#include <direct.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// Largest single write platform_writev_nonblocking() builds
+#define WRITEV_COALESCE_SIZE (64 * 1024)
+
+typedef struct {
+    PlatformThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+static unsigned __stdcall thread_trampoline(void* param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+
+int platform_thread_create(PlatformThread* thread, PlatformThreadFunc func, void* arg) {
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (!start) {
+        return FW_ERROR_MEMORY;
+    }
+    start->func = func;
+    start->arg = arg;
+
+    *thread = (HANDLE)_beginthreadex(NULL, 0, thread_trampoline, start, 0, NULL);
+    if (*thread == 0) {
+        free(start);
+        LOG_ERROR("platform", "_beginthreadex failed");
+        return FW_ERROR_GENERIC;
+    }
+    return FW_OK;
+}
+
+void platform_thread_join(PlatformThread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void platform_mutex_init(PlatformMutex* mutex) {
+    InitializeCriticalSection(mutex);
+}
+
+void platform_mutex_destroy(PlatformMutex* mutex) {
+    DeleteCriticalSection(mutex);
+}
+
+void platform_mutex_lock(PlatformMutex* mutex) {
+    EnterCriticalSection(mutex);
+}
+
+void platform_mutex_unlock(PlatformMutex* mutex) {
+    LeaveCriticalSection(mutex);
+}
+
+int platform_pin_thread(int cpu) {
+    if (cpu < 0 || cpu >= (int)(sizeof(DWORD_PTR) * 8)) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) == 0) {
+        LOG_WARN("platform", "Failed to pin thread to CPU %d: error %lu", cpu, GetLastError());
+        return FW_ERROR_GENERIC;
+    }
+    return FW_OK;
+}
+
 int platform_init(void) {
     LOG_INFO("platform", "Windows platform initialized");
     return FW_OK;
@@ -16,6 +85,63 @@ void platform_shutdown(void) {
     LOG_INFO("platform", "Windows platform shutdown");
 }
 
+int platform_file_sync(int fd) {
+    return _commit(fd) == 0 ? FW_OK : FW_ERROR_IO;
+}
+
+int platform_make_dir(const char* path) {
+    if (_mkdir(path) == 0 || errno == EEXIST) {
+        return FW_OK;
+    }
+    return FW_ERROR_IO;
+}
+
+int platform_replace_file(const char* from, const char* to) {
+    if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        return FW_ERROR_IO;
+    }
+    return FW_OK;
+}
+
+int platform_map_file(const char* path, const char** data, size_t* size) {
+    // Share delete so the log can still drop a segment being read
+    HANDLE file = CreateFileA(path, GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        DWORD error = GetLastError();
+        return (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+            ? FW_ERROR_NOT_FOUND : FW_ERROR_IO;
+    }
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        CloseHandle(file);
+        return FW_ERROR_IO;
+    }
+    *data = NULL;
+    *size = (size_t)length.QuadPart;
+    if (*size > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping) {
+            CloseHandle(mapping);  // The view keeps it
+        }
+        if (!view) {
+            CloseHandle(file);
+            return FW_ERROR_IO;
+        }
+        *data = (const char*)view;
+    }
+    CloseHandle(file);
+    return FW_OK;
+}
+
+void platform_unmap_file(const char* data, size_t size) {
+    if (data && size > 0) {
+        UnmapViewOfFile(data);
+    }
+}
+
 void platform_sleep_ms(int milliseconds) {
     Sleep(milliseconds);
 }
@@ -24,6 +150,21 @@ void platform_sleep(int seconds) {
     Sleep(seconds * 1000);
 }
 
+uint64_t platform_monotonic_ms(void) {
+    return (uint64_t)GetTickCount64();
+}
+
+uint64_t platform_monotonic_us(void) {
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / (uint64_t)frequency.QuadPart;
+}
+
 ProcessHandle platform_spawn_process(const char* command, int* stdin_fd, int* stdout_fd, int* stderr_fd) {
     if (!command || !stdin_fd || !stdout_fd || !stderr_fd) {
         return INVALID_HANDLE_VALUE;
@@ -185,6 +326,53 @@ ProcessID platform_get_process_id(ProcessHandle handle) {
     return GetProcessId(handle);
 }
 
+// No waitable fd for a process handle here; exits are found by the
+// liveness sweep
+int platform_process_exit_fd(ProcessHandle handle) {
+    (void)handle;
+    return -1;
+}
+
+int platform_child_exit_fd(void) {
+    return -1;
+}
+
+void platform_child_exit_drain(void) {
+}
+
+static uint64_t filetime_ms(const FILETIME* ft) {
+    ULARGE_INTEGER value;
+    value.LowPart = ft->dwLowDateTime;
+    value.HighPart = ft->dwHighDateTime;
+    return value.QuadPart / 10000;  // 100 ns units
+}
+
+bool platform_get_exit_info(ProcessHandle handle, PlatformExitInfo* info) {
+    if (handle == INVALID_HANDLE_VALUE || !info) {
+        return false;
+    }
+    
+    DWORD exit_code;
+    if (!GetExitCodeProcess(handle, &exit_code) || exit_code == STILL_ACTIVE) {
+        return false;
+    }
+    
+    memset(info, 0, sizeof(*info));
+    info->exit_code = (int)exit_code;
+    
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(handle, &created, &exited, &kernel, &user)) {
+        info->user_cpu_ms = filetime_ms(&user);
+        info->system_cpu_ms = filetime_ms(&kernel);
+    }
+    
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(handle, &counters, sizeof(counters))) {
+        info->max_rss_kb = (uint64_t)counters.PeakWorkingSetSize / 1024;
+    }
+    return true;
+}
+
 int platform_read_nonblocking(int fd, char* buffer, size_t size) {
     if (fd < 0 || !buffer || size == 0) {
         return FW_ERROR_INVALID_ARG;
@@ -252,3 +440,245 @@ int platform_set_nonblocking(int fd) {
     (void)fd;
     return FW_OK;
 }
+
+int platform_writev_nonblocking(int fd, const PlatformIoVec* iov, int count) {
+    if (fd < 0 || !iov || count <= 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    // Anonymous pipes have no gather write: coalesce into one WriteFile
+    char buffer[WRITEV_COALESCE_SIZE];
+    size_t used = 0;
+    for (int i = 0; i < count && used < sizeof(buffer); i++) {
+        size_t n = iov[i].size;
+        if (n > sizeof(buffer) - used) {
+            n = sizeof(buffer) - used;
+        }
+        memcpy(buffer + used, iov[i].data, n);
+        used += n;
+    }
+
+    if (used == 0) {
+        return 0;
+    }
+    return platform_write_nonblocking(fd, buffer, used);
+}
+
+int platform_write_all(int fd, const char* data, size_t size) {
+    if (fd < 0 || !data) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    HANDLE handle = (HANDLE)_get_osfhandle(fd);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return FW_ERROR_IO;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        DWORD bytes_written = 0;
+        if (!WriteFile(handle, data + total, (DWORD)(size - total), &bytes_written, NULL)) {
+            DWORD error = GetLastError();
+            LOG_ERROR("platform", "WriteFile failed with error %lu", error);
+            return FW_ERROR_IO;
+        }
+        total += bytes_written;
+    }
+
+    return (int)total;
+}
+
+void platform_close_fd(int fd) {
+    if (fd >= 0) {
+        // Closes the underlying pipe HANDLE as well
+        _close(fd);
+    }
+}
+
+/* ============================================================================
+ * Readiness polling
+ *
+ * Anonymous pipes cannot be waited on with WaitForMultipleObjects, so the
+ * poller peeks every registered read pipe and sleeps on a wakeup event in
+ * short slices between scans. Writes go through WriteFile and are always
+ * reported as ready.
+ * ============================================================================ */
+
+#define POLLER_SCAN_INTERVAL_MS 5
+
+IoBackend platform_select_io_backend(IoBackend wanted) {
+    if (wanted == IO_BACKEND_IO_URING) {
+        LOG_WARN("platform", "io_uring is Linux only, using pipe peeking");
+    }
+    return IO_BACKEND_DEFAULT;
+}
+
+typedef struct {
+    int fd;
+    unsigned int events;
+    void* user_data;
+} PollerEntry;
+
+// Tools start and stop on the main thread while a shard scans: entries
+// are only touched under lock
+struct PlatformPoller {
+    PollerEntry* entries;
+    int count;
+    int capacity;
+    CRITICAL_SECTION lock;
+    HANDLE wakeup_event;
+};
+
+PlatformPoller* platform_poller_create(void) {
+    PlatformPoller* poller = (PlatformPoller*)calloc(1, sizeof(PlatformPoller));
+    if (!poller) {
+        return NULL;
+    }
+
+    poller->wakeup_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!poller->wakeup_event) {
+        LOG_ERROR("platform", "CreateEvent failed with error %lu", GetLastError());
+        free(poller);
+        return NULL;
+    }
+    InitializeCriticalSection(&poller->lock);
+    return poller;
+}
+
+void platform_poller_destroy(PlatformPoller* poller) {
+    if (!poller) {
+        return;
+    }
+    CloseHandle(poller->wakeup_event);
+    DeleteCriticalSection(&poller->lock);
+    free(poller->entries);
+    free(poller);
+}
+
+static PollerEntry* poller_find(PlatformPoller* poller, int fd) {
+    for (int i = 0; i < poller->count; i++) {
+        if (poller->entries[i].fd == fd) {
+            return &poller->entries[i];
+        }
+    }
+    return NULL;
+}
+
+int platform_poller_add(PlatformPoller* poller, int fd, unsigned int events, void* user_data) {
+    if (!poller || fd < 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    EnterCriticalSection(&poller->lock);
+    int result = FW_OK;
+    if (poller_find(poller, fd)) {
+        result = FW_ERROR_ALREADY_EXISTS;
+    } else if (poller->count == poller->capacity) {
+        int new_capacity = poller->capacity ? poller->capacity * 2 : 64;
+        PollerEntry* grown = (PollerEntry*)realloc(poller->entries,
+                                                   (size_t)new_capacity * sizeof(PollerEntry));
+        if (grown) {
+            poller->entries = grown;
+            poller->capacity = new_capacity;
+        } else {
+            result = FW_ERROR_MEMORY;
+        }
+    }
+    if (result == FW_OK) {
+        poller->entries[poller->count].fd = fd;
+        poller->entries[poller->count].events = events;
+        poller->entries[poller->count].user_data = user_data;
+        poller->count++;
+    }
+    LeaveCriticalSection(&poller->lock);
+    return result;
+}
+
+int platform_poller_modify(PlatformPoller* poller, int fd, unsigned int events) {
+    if (!poller) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    EnterCriticalSection(&poller->lock);
+    PollerEntry* entry = poller_find(poller, fd);
+    if (entry) {
+        entry->events = events;
+    }
+    LeaveCriticalSection(&poller->lock);
+    return entry ? FW_OK : FW_ERROR_NOT_FOUND;
+}
+
+int platform_poller_remove(PlatformPoller* poller, int fd) {
+    if (!poller) {
+        return FW_ERROR_NOT_FOUND;
+    }
+    EnterCriticalSection(&poller->lock);
+    PollerEntry* entry = poller_find(poller, fd);
+    if (entry) {
+        *entry = poller->entries[--poller->count];
+    }
+    LeaveCriticalSection(&poller->lock);
+    return entry ? FW_OK : FW_ERROR_NOT_FOUND;
+}
+
+int platform_poller_wait(PlatformPoller* poller, PlatformPollEvent* events, int max_events, int timeout_ms) {
+    if (!poller || !events || max_events <= 0) {
+        return FW_ERROR_INVALID_ARG;
+    }
+
+    uint64_t deadline = platform_monotonic_ms() + (uint64_t)(timeout_ms < 0 ? 0 : timeout_ms);
+
+    for (;;) {
+        int count = 0;
+        EnterCriticalSection(&poller->lock);
+        for (int i = 0; i < poller->count && count < max_events; i++) {
+            PollerEntry* entry = &poller->entries[i];
+            unsigned int ready = 0;
+
+            if (entry->events & PLATFORM_POLL_READ) {
+                HANDLE handle = (HANDLE)_get_osfhandle(entry->fd);
+                DWORD available = 0;
+                if (!PeekNamedPipe(handle, NULL, 0, NULL, &available, NULL)) {
+                    ready |= PLATFORM_POLL_HANGUP;
+                } else if (available > 0) {
+                    ready |= PLATFORM_POLL_READ;
+                }
+            }
+            if (entry->events & PLATFORM_POLL_WRITE) {
+                ready |= PLATFORM_POLL_WRITE;
+            }
+
+            if (ready) {
+                events[count].fd = entry->fd;
+                events[count].events = ready;
+                events[count].user_data = entry->user_data;
+                count++;
+            }
+        }
+        LeaveCriticalSection(&poller->lock);
+
+        if (count > 0) {
+            return count;
+        }
+
+        DWORD slice = POLLER_SCAN_INTERVAL_MS;
+        if (timeout_ms >= 0) {
+            uint64_t now = platform_monotonic_ms();
+            if (now >= deadline) {
+                return 0;
+            }
+            if (deadline - now < slice) {
+                slice = (DWORD)(deadline - now);
+            }
+        }
+        if (WaitForSingleObject(poller->wakeup_event, slice) == WAIT_OBJECT_0) {
+            return 0;
+        }
+    }
+}
+
+int platform_poller_wakeup(PlatformPoller* poller) {
+    if (!poller) {
+        return FW_ERROR_INVALID_ARG;
+    }
+    return SetEvent(poller->wakeup_event) ? FW_OK : FW_ERROR_IO;
+}
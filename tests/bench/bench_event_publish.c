@@ -0,0 +1,109 @@
+/**
+ * @file bench_event_publish.c
+ * @brief Producer throughput of event_publish() against thread count
+ *
+ * Producer threads publish off the I/O shards, so every event goes
+ * through the bus ring, while this thread routes like the main loop.
+ * Each run reports events/s for single publishes and for batches.
+ *
+ * Usage: bench_event_publish [events per thread] [max threads]
+ */
+
+#include "yuki_frame/event.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/framework.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+#define BATCH_SIZE 32
+
+typedef struct {
+    int events;
+    bool batched;
+} ProducerArgs;
+
+static atomic_int producers_done;
+
+static void producer_main(void* arg) {
+    ProducerArgs* args = (ProducerArgs*)arg;
+    EventView batch[BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        batch[i].type = "BENCH.tick";
+        batch[i].sender = "bench";
+        batch[i].data = "{\"value\": 42}";
+    }
+    
+    int sent = 0;
+    while (sent < args->events) {
+        int result;
+        int count = 1;
+        if (args->batched) {
+            count = args->events - sent < BATCH_SIZE ? args->events - sent : BATCH_SIZE;
+            result = event_publish_batch(batch, count);
+        } else {
+            result = event_publish("BENCH.tick", "bench", "{\"value\": 42}");
+        }
+        if (result == FW_OK) {
+            sent += count;
+        } else {
+            platform_sleep_ms(0);  // Ring full: let the router catch up
+        }
+    }
+    atomic_fetch_add(&producers_done, 1);
+}
+
+static double run(int threads, int events, bool batched) {
+    PlatformThread handles[64];
+    ProducerArgs args = { events, batched };
+    
+    event_bus_init();
+    atomic_store(&producers_done, 0);
+    uint64_t start = platform_monotonic_us();
+    for (int t = 0; t < threads; t++) {
+        platform_thread_create(&handles[t], producer_main, &args);
+    }
+    
+    // Route until every producer has finished and the ring is drained
+    while (atomic_load(&producers_done) < threads) {
+        event_process_queue();
+        platform_sleep_ms(0);
+    }
+    event_process_queue();
+    uint64_t elapsed = platform_monotonic_us() - start;
+    
+    for (int t = 0; t < threads; t++) {
+        platform_thread_join(handles[t]);
+    }
+    event_bus_shutdown();
+    
+    return (double)threads * events / ((double)elapsed / 1e6);
+}
+
+int main(int argc, char** argv) {
+    int events = argc > 1 ? atoi(argv[1]) : 100000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    if (max_threads > 64) {
+        max_threads = 64;
+    }
+    
+    logger_set_level(LOG_FATAL);
+    platform_init();
+    
+    printf("\n=== event_publish throughput (%d events per thread) ===\n\n", events);
+    printf("  threads   single (events/s)   batch of %d (events/s)\n", BATCH_SIZE);
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double single = run(threads, events, false);
+        double batch = run(threads, events, true);
+        printf("  %7d   %17.0f   %21.0f\n", threads, single, batch);
+    }
+    printf("\n");
+    
+    platform_shutdown();
+    return 0;
+}
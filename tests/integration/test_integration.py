@@ -193,7 +193,7 @@ def main():
     print("Yuki-Frame Integration Tests")
     print("="*50 + "\n")
     
-    # Find executable
+    # Find executable (CTest passes the built binary as the first argument)
     executable = None
     search_paths = [
         '../build/yuki-frame.exe',
@@ -203,6 +203,8 @@ def main():
         './yuki-frame.exe',
         './yuki-frame'
     ]
+    if len(sys.argv) > 1:
+        search_paths.insert(0, sys.argv[1])
     
     for path in search_paths:
         if os.path.exists(path):
@@ -5,6 +5,11 @@
 
 #include "yuki_frame/config.h"
 #include "yuki_frame/framework.h"
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/request.h"
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/dedup.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -172,6 +177,137 @@ TEST(config_get_tools_returns_tools) {
     remove("test_config.tmp");
 }
 
+TEST(config_priorities_section_sets_type_priority) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[priorities]\n");
+    fprintf(f, "ALERT = high\n");
+    fprintf(f, "TELEMETRY = low\n");
+    fprintf(f, "SENSOR.* = high\n");   // Patterns are not supported
+    fprintf(f, "TYPO = urgent\n");
+    fclose(f);
+    
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_EQ(event_type_priority(event_type_find("ALERT")), EVENT_PRIORITY_HIGH);
+    ASSERT_EQ(event_type_priority(event_type_find("TELEMETRY")), EVENT_PRIORITY_LOW);
+    ASSERT_EQ(event_type_find("SENSOR.*"), EVENT_TYPE_NONE);
+    ASSERT_EQ(event_type_priority(event_type_find("TYPO")), EVENT_PRIORITY_NORMAL);
+    ASSERT_EQ(event_type_priority(event_type_find("OTHER")), EVENT_PRIORITY_NORMAL);
+    
+    remove("test_config.tmp");
+}
+
+TEST(config_tool_conflate_policy) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[tool:dashboard]\n");
+    fprintf(f, "command = /bin/cat\n");
+    fprintf(f, "queue_policy = conflate\n");
+    fprintf(f, "conflate_key = sensor_id\n");
+    fclose(f);
+    
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ToolConfig* tools = NULL;
+    int count = 0;
+    ASSERT_EQ(config_get_tools(&tools, &count), FW_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(tools[0].queue_policy, QUEUE_POLICY_CONFLATE);
+    ASSERT_STR_EQ(tools[0].conflate_key, "sensor_id");
+    config_free_tools(tools, count);
+    
+    remove("test_config.tmp");
+}
+
+TEST(config_tool_sequencing) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[tool:orders]\n");
+    fprintf(f, "command = /bin/cat\n");
+    fprintf(f, "dedup_window = 4096\n");
+    fprintf(f, "sequence_numbers = yes\n");
+    fprintf(f, "[tool:audit]\n");
+    fprintf(f, "command = /bin/cat\n");
+    fclose(f);
+    
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ToolConfig* tools = NULL;
+    int count = 0;
+    ASSERT_EQ(config_get_tools(&tools, &count), FW_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(tools[0].dedup_window, 4096);
+    ASSERT(tools[0].sequence_numbers);
+    ASSERT_EQ(tools[1].dedup_window, DEDUP_DEFAULT_WINDOW);
+    ASSERT(!tools[1].sequence_numbers);
+    config_free_tools(tools, count);
+    
+    remove("test_config.tmp");
+}
+
+TEST(config_core_event_log) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\n");
+    fprintf(f, "event_log = /var/lib/yuki/events\n");
+    fprintf(f, "event_log_sync_ms = 0\n");
+    fprintf(f, "event_log_segment_size = 16M\n");
+    fclose(f);
+    
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_STR_EQ(g_config.event_log, "/var/lib/yuki/events");
+    ASSERT_EQ(g_config.event_log_sync_ms, 0);
+    ASSERT_EQ(g_config.event_log_segment_size, (size_t)16 << 20);
+    
+    // Off unless configured
+    f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\nlog_level = INFO\n");
+    fclose(f);
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_STR_EQ(g_config.event_log, "");
+    ASSERT_EQ(g_config.event_log_sync_ms, EVENT_LOG_DEFAULT_SYNC_MS);
+    
+    remove("test_config.tmp");
+}
+
+TEST(config_core_request_timeout) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\nrequest_timeout_ms = 250\n");
+    fclose(f);
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_EQ(g_config.request_timeout_ms, 250);
+    
+    f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\nrequest_timeout_ms = 0\n");
+    fclose(f);
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_EQ(g_config.request_timeout_ms, REQUEST_DEFAULT_TIMEOUT_MS);
+    
+    remove("test_config.tmp");
+}
+
+TEST(config_core_bus_memory) {
+    FILE* f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\nbus_memory_limit = 64M\nbus_high_watermark = 90\nbus_low_watermark = 70\n");
+    fclose(f);
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_EQ(g_config.bus_memory_limit, (size_t)64 << 20);
+    ASSERT_EQ(g_config.bus_high_watermark, 90);
+    ASSERT_EQ(g_config.bus_low_watermark, 70);
+    
+    f = fopen("test_config.tmp", "w");
+    ASSERT_NOT_NULL(f);
+    fprintf(f, "[core]\nbus_memory_limit = 0\n");
+    fclose(f);
+    ASSERT_EQ(config_load("test_config.tmp"), FW_OK);
+    ASSERT_EQ(g_config.bus_memory_limit, FLOW_DEFAULT_MEMORY_LIMIT);
+    ASSERT_EQ(g_config.bus_high_watermark, FLOW_DEFAULT_HIGH_WATERMARK);
+    
+    remove("test_config.tmp");
+}
+
 // Test runner
 int main(void) {
     printf("\n=== Config Module Unit Tests ===\n\n");
@@ -186,6 +322,12 @@ int main(void) {
     run_test_config_get_bool_false_value();
     run_test_config_get_bool_default_value();
     run_test_config_get_tools_returns_tools();
+    run_test_config_priorities_section_sets_type_priority();
+    run_test_config_tool_conflate_policy();
+    run_test_config_tool_sequencing();
+    run_test_config_core_event_log();
+    run_test_config_core_request_timeout();
+    run_test_config_core_bus_memory();
     
     printf("\n=== Test Summary ===\n");
     printf("  Total:  %d\n", tests_run);
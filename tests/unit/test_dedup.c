@@ -0,0 +1,209 @@
+/**
+ * @file test_dedup.c
+ * @brief Unit tests for message id windows and publisher sequence numbers
+ */
+
+#include "yuki_frame/dedup.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/framework.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+
+static bool seen(DedupWindow* window, const char* id) {
+    return dedup_seen(window, id, strlen(id));
+}
+
+TEST(dedup_remembers_recent_ids) {
+    DedupWindow* window = dedup_create(4);
+    ASSERT_NE(window, NULL);
+    ASSERT(!seen(window, "a"));
+    ASSERT(!seen(window, "b"));
+    ASSERT(!seen(window, "c"));
+    ASSERT(seen(window, "a"));
+    ASSERT(seen(window, "c"));
+    ASSERT_EQ(dedup_count(window), 3);
+
+    // The fifth id pushes out the first
+    ASSERT(!seen(window, "d"));
+    ASSERT(!seen(window, "e"));
+    ASSERT_EQ(dedup_count(window), 4);
+    ASSERT(!seen(window, "a"));
+    ASSERT(seen(window, "e"));
+    ASSERT(!seen(window, "ab"));
+    dedup_destroy(window);
+
+    ASSERT_EQ(dedup_create(0), NULL);
+}
+
+TEST(dedup_window_slides_over_many_ids) {
+    // Many evictions shift entries around the table; every id of the last
+    // window must still be found and none older
+    const int capacity = 64;
+    DedupWindow* window = dedup_create(capacity);
+    ASSERT_NE(window, NULL);
+    char id[32];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(id, sizeof(id), "msg-%d", i);
+        ASSERT(!seen(window, id));
+        if (i % 97 == 0) {
+            for (int back = 0; back < capacity && back <= i; back++) {
+                snprintf(id, sizeof(id), "msg-%d", i - back);
+                ASSERT(seen(window, id));
+            }
+        }
+    }
+    snprintf(id, sizeof(id), "msg-%d", 5000 - capacity - 1);
+    ASSERT(!seen(window, id));
+    dedup_destroy(window);
+}
+
+TEST(dedup_compares_long_ids_by_prefix) {
+    DedupWindow* window = dedup_create(8);
+    char long_id[DEDUP_MAX_ID + 16];
+    memset(long_id, 'x', sizeof(long_id) - 1);
+    long_id[sizeof(long_id) - 1] = '\0';
+    ASSERT(!seen(window, long_id));
+    long_id[sizeof(long_id) - 2] = 'y';
+    ASSERT(seen(window, long_id));
+    dedup_destroy(window);
+}
+
+static void reset(void) {
+    tool_registry_shutdown();
+    event_bus_shutdown();
+}
+
+TEST(sequence_numbers_reach_subscribers_that_ask) {
+    reset();
+    event_bus_init();
+    tool_registry_init();
+    tool_register("plain", "cat");
+    tool_register("numbered", "cat");
+    tool_find("plain")->status = TOOL_RUNNING;
+    tool_find("numbered")->status = TOOL_RUNNING;
+    tool_subscribe("plain", "PING");
+    tool_subscribe("numbered", "*");
+    ASSERT_EQ(tool_set_sequencing("numbered", DEDUP_DEFAULT_WINDOW, true), FW_OK);
+    ASSERT_EQ(tool_set_sequencing("missing", 0, true), FW_ERROR_NOT_FOUND);
+
+    ASSERT_EQ(event_publish_sequenced("PING", "sensor", "one", EVENT_PRIORITY_NORMAL, 41), FW_OK);
+    ASSERT_EQ(event_publish_sequenced("PING", "sensor", "two\nlines", EVENT_PRIORITY_NORMAL, 42),
+              FW_OK);
+    ASSERT_EQ(event_publish("PING", "framework", "three"), FW_OK);
+    event_process_queue();
+
+    ToolQueue* plain = tool_find("plain")->inbox;
+    ToolQueue* numbered = tool_find("numbered")->inbox;
+    ASSERT_EQ(tool_queue_count(plain), 3);
+    ASSERT_EQ(tool_queue_count(numbered), 3);
+    ASSERT_STR_EQ(tool_queue_peek_at(plain, 0), "PING|sensor|one\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(numbered, 0), "PING|sensor@41|one\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(numbered, 1), "#9|PING|sensor@42\ntwo\nlines\n");
+    // Events without a publisher's number arrive as they were
+    ASSERT_STR_EQ(tool_queue_peek_at(numbered, 2), "PING|framework|three\n");
+    reset();
+}
+
+TEST(dedup_remembers_only_when_asked) {
+    DedupWindow* window = dedup_create(4);
+    ASSERT(window != NULL);
+    ASSERT(!dedup_contains(window, "a", 1));
+    ASSERT_EQ(dedup_count(window), 0);
+    dedup_remember(window, "a", 1);
+    dedup_remember(window, "a", 1);
+    ASSERT(dedup_contains(window, "a", 1));
+    ASSERT_EQ(dedup_count(window), 1);
+    ASSERT(seen(window, "a"));
+    dedup_destroy(window);
+}
+
+TEST(tool_stdout_drops_repeated_ids) {
+    reset();
+    event_bus_init();
+    event_loop_init(1);
+    tool_registry_init();
+    ASSERT_EQ(tool_register("sensor",
+                            "printf 'PING|sensor@a|one\\nPING|sensor@a|again\\n"
+                            "PING|sensor@b|two\\n'; sleep 1"), FW_OK);
+    tool_register("numbered", "cat");
+    tool_subscribe("numbered", "PING");
+    ASSERT_EQ(tool_set_sequencing("numbered", DEDUP_DEFAULT_WINDOW, true), FW_OK);
+    ASSERT_EQ(tool_start("sensor"), FW_OK);
+
+    // Read by the shard as the I/O workers do; numbered is not running,
+    // so what it is sent stays in its inbox
+    Tool* sensor = tool_find("sensor");
+    ToolQueue* inbox = tool_find("numbered")->inbox;
+    for (int tries = 0; tries < 50 && tool_queue_count(inbox) < 2; tries++) {
+        io_worker_poll(0, 100);
+    }
+    ASSERT_EQ(tool_queue_count(inbox), 2);
+    // The repeat neither reaches anyone nor takes a number
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "PING|sensor@1|one\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 1), "PING|sensor@2|two\n");
+    ASSERT_EQ(atomic_load(&sensor->duplicates), 1);
+    ASSERT_EQ(atomic_load(&sensor->publish_seq), 2);
+    ASSERT_EQ(dedup_count(sensor->dedup), 2);
+
+    reset();
+    event_loop_shutdown();
+}
+
+int main(void) {
+    printf("\n=== Dedup Unit Tests ===\n\n");
+
+    run_test_dedup_remembers_recent_ids();
+    run_test_dedup_window_slides_over_many_ids();
+    run_test_dedup_compares_long_ids_by_prefix();
+    run_test_dedup_remembers_only_when_asked();
+    run_test_sequence_numbers_reach_subscribers_that_ask();
+    run_test_tool_stdout_drops_repeated_ids();
+    reset();
+
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return tests_failed == 0 ? 0 : 1;
+}
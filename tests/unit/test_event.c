@@ -4,7 +4,11 @@
  */
 
 #include "yuki_frame/event.h"
+#include "yuki_frame/event_type.h"
 #include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include "yuki_frame/platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -157,6 +161,307 @@ TEST(event_format_buffer_too_small) {
 }
 
 // Test runner
+static int inbox_count(const char* name) {
+    return tool_queue_count(tool_find(name)->inbox);
+}
+
+TEST(event_route_indexes_subscriptions) {
+    tool_registry_init();
+    tool_register("sensor_log", "cat");
+    tool_register("alarm", "cat");
+    tool_register("audit", "cat");
+    ASSERT_EQ(tool_subscribe("sensor_log", "SENSOR"), FW_OK);
+    ASSERT_EQ(tool_subscribe("sensor_log", " 'ALARM' "), FW_OK);  // Normalized
+    ASSERT_EQ(tool_subscribe("alarm", "ALARM"), FW_OK);
+    ASSERT_EQ(tool_subscribe("alarm", "\"ALARM\""), FW_OK);       // Duplicate
+    ASSERT_EQ(tool_find("alarm")->subscription_count, 1);
+    ASSERT_EQ(tool_subscribe("alarm", " "), FW_ERROR_INVALID_ARG);
+    
+    // A wildcard subscriber also subscribed by name gets each event once
+    ASSERT_EQ(tool_subscribe("audit", "*"), FW_OK);
+    ASSERT_EQ(tool_subscribe("audit", "SENSOR"), FW_OK);
+    
+    ASSERT_EQ(event_route("SENSOR", "probe", "21.5"), FW_OK);
+    ASSERT_EQ(event_route("ALARM", "probe", "high"), FW_OK);
+    ASSERT_EQ(event_route("OTHER", "probe", "x"), FW_OK);
+    
+    ASSERT_EQ(inbox_count("sensor_log"), 2);
+    ASSERT_EQ(inbox_count("alarm"), 1);
+    ASSERT_EQ(inbox_count("audit"), 3);
+    
+    // Counted per interned type
+    EventTypeStats stats;
+    event_type_get_stats(event_type_find("ALARM"), &stats);
+    ASSERT_EQ(stats.routed, 1u);
+    ASSERT_EQ(stats.delivered, 3u);
+    event_type_get_stats(event_type_find("OTHER"), &stats);
+    ASSERT_EQ(stats.routed, 1u);
+    ASSERT_EQ(stats.delivered, 1u);
+    
+    tool_registry_shutdown();
+}
+
+TEST(event_route_scales_to_many_types) {
+    tool_registry_init();
+    char name[MAX_TOOL_NAME];
+    char type[MAX_EVENT_TYPE];
+    for (int i = 0; i < 20; i++) {
+        snprintf(name, sizeof(name), "tool%d", i);
+        tool_register(name, "cat");
+        for (int j = 0; j < MAX_SUBSCRIPTIONS; j++) {
+            snprintf(type, sizeof(type), "T%d", (i * 7 + j) % 300);
+            tool_subscribe(name, type);
+        }
+    }
+    
+    // Every tool receives exactly the types it subscribed to
+    for (int t = 0; t < 300; t++) {
+        snprintf(type, sizeof(type), "T%d", t);
+        event_route(type, "gen", "");
+    }
+    for (int i = 0; i < 20; i++) {
+        snprintf(name, sizeof(name), "tool%d", i);
+        ASSERT_EQ(inbox_count(name), MAX_SUBSCRIPTIONS);
+    }
+    
+    tool_registry_shutdown();
+}
+
+TEST(event_pattern_validation) {
+    ASSERT(event_pattern_valid("SENSOR"));
+    ASSERT(event_pattern_valid("SENSOR.*.zone3"));
+    ASSERT(event_pattern_valid("SENSOR.#"));
+    ASSERT(event_pattern_valid("#"));
+    ASSERT(!event_pattern_valid(""));
+    ASSERT(!event_pattern_valid("SENSOR.#.zone3"));  // "#" only at the end
+    ASSERT(!event_pattern_valid("SENSOR.te*"));      // Whole segments only
+}
+
+TEST(event_route_matches_topic_patterns) {
+    tool_registry_init();
+    tool_register("zone3", "cat");
+    tool_register("temps", "cat");
+    tool_register("sensors", "cat");
+    tool_register("overlap", "cat");
+    ASSERT_EQ(tool_subscribe("zone3", "SENSOR.*.zone3"), FW_OK);
+    ASSERT_EQ(tool_subscribe("temps", "SENSOR.temp.*"), FW_OK);
+    ASSERT_EQ(tool_subscribe("sensors", "SENSOR.#"), FW_OK);
+    // Several matching subscriptions still deliver once
+    ASSERT_EQ(tool_subscribe("overlap", "SENSOR.temp.zone3"), FW_OK);
+    ASSERT_EQ(tool_subscribe("overlap", "SENSOR.*.*"), FW_OK);
+    ASSERT_EQ(tool_subscribe("overlap", "*.temp.#"), FW_OK);
+    ASSERT_EQ(tool_subscribe("overlap", "SENSOR.#.x"), FW_ERROR_INVALID_ARG);
+    
+    event_route("SENSOR.temp.zone3", "probe", "1");
+    event_route("SENSOR.humidity.zone3", "probe", "2");
+    event_route("SENSOR.temp.zone1", "probe", "3");
+    event_route("SENSOR", "probe", "4");
+    event_route("SENSOR.temp", "probe", "5");
+    event_route("SENSORS.temp.zone3", "probe", "6");
+    event_route("OTHER.temp.zone3.extra", "probe", "7");
+    
+    ASSERT_EQ(inbox_count("zone3"), 2);     // 1, 2
+    ASSERT_EQ(inbox_count("temps"), 2);     // 1, 3
+    ASSERT_EQ(inbox_count("sensors"), 5);   // 1-5
+    ASSERT_EQ(inbox_count("overlap"), 6);   // 1-3, then 5-7 through *.temp.#
+    
+    tool_registry_shutdown();
+}
+
+TEST(event_route_applies_content_filters) {
+    tool_registry_init();
+    tool_register("hot", "cat");
+    tool_register("zones", "cat");
+    tool_register("errors", "cat");
+    ASSERT_EQ(tool_subscribe("hot", "SENSOR[zone=3 && temp>80]"), FW_OK);
+    ASSERT_EQ(tool_subscribe("zones", "SENSOR.#[zone=1]"), FW_OK);
+    ASSERT_EQ(tool_subscribe("zones", "SENSOR.#[zone=2]"), FW_OK);   // Either zone
+    ASSERT_EQ(tool_find("zones")->subscription_count, 1);
+    ASSERT_EQ(tool_subscribe("errors", "*[level=error]"), FW_OK);
+    ASSERT_EQ(tool_subscribe("errors", "SENSOR[temp>"), FW_ERROR_PARSE_FAILED);
+    ASSERT_EQ(tool_subscribe("errors", "SENSOR[temp>90"), FW_ERROR_PARSE_FAILED);
+    
+    event_route("SENSOR", "probe", "zone=3 temp=85");
+    event_route("SENSOR", "probe", "zone=3 temp=70");
+    event_route("SENSOR", "probe", "{\"zone\": 1, \"temp\": 90}");
+    event_route("SENSOR", "probe", "zone=2 level=error");
+    event_route("LOG", "app", "level=error");
+    event_route("LOG", "app", "level=info");
+    
+    ASSERT_EQ(inbox_count("hot"), 1);
+    ASSERT_EQ(inbox_count("zones"), 2);
+    ASSERT_EQ(inbox_count("errors"), 2);
+    
+    // Without a filter the type is delivered in full again
+    ASSERT_EQ(tool_subscribe("hot", "SENSOR"), FW_OK);
+    event_route("SENSOR", "probe", "zone=1 temp=20");
+    ASSERT_EQ(inbox_count("hot"), 2);
+    
+    tool_registry_shutdown();
+}
+
+TEST(event_route_shares_one_buffer) {
+    tool_registry_init();
+    tool_register("first", "cat");
+    tool_register("second", "cat");
+    tool_register("third", "cat");
+    tool_subscribe("first", "DATA");
+    tool_subscribe("second", "DATA");
+    tool_subscribe("third", "*");
+    
+    ASSERT_EQ(event_route("DATA", "src", "payload"), FW_OK);
+    
+    // Formatted once: every inbox holds a reference to the same bytes
+    const EventBuffer* buffer = tool_queue_peek_buffer_at(tool_find("first")->inbox, 0);
+    ASSERT(buffer != NULL);
+    ASSERT_STR_EQ(buffer->data, "DATA|src|payload\n");
+    ASSERT_EQ(buffer->length, strlen("DATA|src|payload\n"));
+    ASSERT(tool_queue_peek_buffer_at(tool_find("second")->inbox, 0) == buffer);
+    ASSERT(tool_queue_peek_buffer_at(tool_find("third")->inbox, 0) == buffer);
+    ASSERT_EQ(atomic_load(&buffer->refs), 3);
+    
+    tool_queue_remove(tool_find("first")->inbox);
+    ASSERT_EQ(atomic_load(&buffer->refs), 2);
+    tool_queue_clear(tool_find("second")->inbox);
+    ASSERT_EQ(atomic_load(&buffer->refs), 1);
+    
+    tool_registry_shutdown();  // Releases the last reference
+}
+
+TEST(event_publish_queues_variable_size_events) {
+    event_bus_init();
+    tool_registry_init();
+    tool_register("sink", "cat");
+    tool_subscribe("sink", "*");
+    
+    // Payloads on either side of the old fixed 4 KB field
+    static char big[MAX_EVENT_DATA * 2];
+    memset(big, 'b', sizeof(big) - 1);
+    ASSERT_EQ(event_publish("SMALL", "src", "x"), FW_OK);
+    ASSERT_EQ(event_publish("EMPTY", "src", NULL), FW_OK);
+    ASSERT_EQ(event_publish("BIG", "src", big), FW_OK);
+    event_process_queue();
+    
+    ToolQueue* inbox = tool_find("sink")->inbox;
+    ASSERT_EQ(inbox_count("sink"), 3);
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "SMALL|src|x\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 1), "EMPTY|src|\n");
+    const EventBuffer* buffer = tool_queue_peek_buffer_at(inbox, 2);
+    ASSERT_EQ(buffer->length, strlen("BIG|src|\n") + strlen(big));
+    ASSERT_EQ(buffer->data[buffer->length - 2], 'b');
+    
+    tool_registry_shutdown();
+    event_bus_shutdown();
+}
+
+TEST(event_publish_routes_urgent_events_first) {
+    event_bus_init();
+    tool_registry_init();
+    tool_register("sink", "cat");
+    tool_subscribe("sink", "*");
+    event_type_set_priority(event_type_intern("ALERT"), EVENT_PRIORITY_HIGH);
+    event_type_set_priority(event_type_intern("TELEMETRY"), EVENT_PRIORITY_LOW);
+    
+    ASSERT_EQ(event_publish("TELEMETRY", "src", "1"), FW_OK);
+    ASSERT_EQ(event_publish("STATUS", "src", "2"), FW_OK);
+    ASSERT_EQ(event_publish("ALERT", "src", "3"), FW_OK);
+    ASSERT_EQ(event_publish_priority("STATUS", "src", "4", EVENT_PRIORITY_HIGH), FW_OK);
+    // The configured priority wins when it is higher
+    ASSERT_EQ(event_publish_priority("ALERT", "src", "5", EVENT_PRIORITY_LOW), FW_OK);
+    event_process_queue();
+    
+    ToolQueue* inbox = tool_find("sink")->inbox;
+    ASSERT_EQ(inbox_count("sink"), 5);
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "ALERT|src|3\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 1), "STATUS|src|4\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 2), "ALERT|src|5\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 3), "STATUS|src|2\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 4), "TELEMETRY|src|1\n");
+    ASSERT_EQ(tool_queue_peek_buffer_at(inbox, 0)->priority, EVENT_PRIORITY_HIGH);
+    ASSERT_EQ(tool_queue_lane_count(inbox, EVENT_PRIORITY_LOW), 1);
+    
+    tool_registry_shutdown();
+    event_bus_shutdown();
+}
+
+TEST(event_buffer_frames_multiline_data) {
+    EventBuffer* line = event_buffer_format("DOC", "src", "{\"a\": 1}");
+    ASSERT_STR_EQ(line->data, "DOC|src|{\"a\": 1}\n");
+    event_buffer_release(line);
+    
+    EventBuffer* frame = event_buffer_format("DOC", "src", "{\n\"a\": 1\n}");
+    ASSERT_STR_EQ(frame->data, "#10|DOC|src\n{\n\"a\": 1\n}\n");
+    ASSERT_EQ(frame->length, strlen(frame->data));
+    event_buffer_release(frame);
+}
+
+#define PUBLISHERS 4
+#define EVENTS_PER_PUBLISHER 1000
+
+static void publisher_main(void* arg) {
+    const char* sender = (const char*)arg;
+    char data[16];
+    EventView batch[10];
+    char batch_data[10][16];
+    
+    // Half single publishes, half batches of ten; retry while the ring is full
+    for (int i = 0; i < EVENTS_PER_PUBLISHER / 2; i++) {
+        snprintf(data, sizeof(data), "%d", i);
+        while (event_publish("SEQ", sender, data) != FW_OK) {
+            platform_sleep_ms(0);
+        }
+    }
+    for (int i = EVENTS_PER_PUBLISHER / 2; i < EVENTS_PER_PUBLISHER; i += 10) {
+        for (int j = 0; j < 10; j++) {
+            snprintf(batch_data[j], sizeof(batch_data[j]), "%d", i + j);
+            batch[j].type = "SEQ";
+            batch[j].sender = sender;
+            batch[j].data = batch_data[j];
+        }
+        while (event_publish_batch(batch, 10) != FW_OK) {
+            platform_sleep_ms(0);
+        }
+    }
+}
+
+TEST(event_publish_from_many_threads) {
+    static const char* senders[PUBLISHERS] = { "p0", "p1", "p2", "p3" };
+    event_bus_init();
+    tool_registry_init();
+    tool_register("sink", "cat");
+    tool_set_queue_config("sink", PUBLISHERS * EVENTS_PER_PUBLISHER, QUEUE_POLICY_DROP_NEWEST, 1);
+    tool_subscribe("sink", "SEQ");
+    
+    PlatformThread threads[PUBLISHERS];
+    for (int p = 0; p < PUBLISHERS; p++) {
+        platform_thread_create(&threads[p], publisher_main, (void*)senders[p]);
+    }
+    ToolQueue* inbox = tool_find("sink")->inbox;
+    while (tool_queue_count(inbox) < PUBLISHERS * EVENTS_PER_PUBLISHER) {
+        event_process_queue();
+        platform_sleep_ms(0);
+    }
+    for (int p = 0; p < PUBLISHERS; p++) {
+        platform_thread_join(threads[p]);
+    }
+    
+    // Every event arrived once, in each publisher's order
+    int next[PUBLISHERS] = { 0 };
+    bool ordered = true;
+    for (int i = 0; i < tool_queue_count(inbox); i++) {
+        int p, seq;
+        if (sscanf(tool_queue_peek_at(inbox, i), "SEQ|p%d|%d", &p, &seq) != 2 || seq != next[p]) {
+            ordered = false;
+            break;
+        }
+        next[p]++;
+    }
+    ASSERT(ordered);
+    
+    tool_registry_shutdown();
+    event_bus_shutdown();
+}
+
 int main(void) {
     printf("\n=== Event Module Unit Tests ===\n\n");
     
@@ -172,6 +477,16 @@ int main(void) {
     run_test_event_format_null_event_fails();
     run_test_event_format_null_buffer_fails();
     run_test_event_format_buffer_too_small();
+    run_test_event_route_indexes_subscriptions();
+    run_test_event_route_scales_to_many_types();
+    run_test_event_pattern_validation();
+    run_test_event_route_matches_topic_patterns();
+    run_test_event_route_applies_content_filters();
+    run_test_event_route_shares_one_buffer();
+    run_test_event_publish_queues_variable_size_events();
+    run_test_event_publish_routes_urgent_events_first();
+    run_test_event_buffer_frames_multiline_data();
+    run_test_event_publish_from_many_threads();
     
     printf("\n=== Test Summary ===\n");
     printf("  Total:  %d\n", tests_run);
@@ -0,0 +1,150 @@
+/**
+ * @file test_event_filter.c
+ * @brief Unit tests for subscription content filters
+ */
+
+#include "yuki_frame/event_filter.h"
+#include "yuki_frame/framework.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define TYPES_PER_THREAD 200
+
+
+static bool passes(const char* source, const char* data) {
+    EventFilter* filter = event_filter_compile(source, NULL, 0);
+    if (!filter) {
+        return false;
+    }
+    bool result = event_filter_match(filter, data, strlen(data));
+    event_filter_release(filter);
+    return result;
+}
+
+TEST(compares_numbers_and_strings) {
+    ASSERT(passes("temp>80", "zone=3 temp=85.5"));
+    ASSERT(!passes("temp>80", "zone=3 temp=80"));
+    ASSERT(passes("temp>=80", "temp=80"));
+    ASSERT(passes("temp<-5", "temp=-10"));
+    ASSERT(passes("zone=3", "zone=3.0"));           // Numerically equal
+    ASSERT(passes("zone == 3", "zone=3"));
+    ASSERT(passes("state=open", "state=open"));
+    ASSERT(!passes("state=open", "state=opened"));
+    ASSERT(passes("state!=open", "state=closed"));
+    ASSERT(passes("name=\"10\"", "name=10"));       // Quoted compares as text
+    ASSERT(!passes("name='9'", "name=10"));
+    ASSERT(passes("name<'9'", "name=10"));
+}
+
+TEST(reads_json_members) {
+    const char* json = "{\"zone\": 3, \"temp\": 91, \"state\": \"alarm\"}";
+    ASSERT(passes("zone=3 && temp>80", json));
+    ASSERT(passes("state=alarm", json));
+    ASSERT(!passes("state=ok", json));
+}
+
+TEST(missing_fields_fail_comparisons) {
+    ASSERT(!passes("temp>80", "zone=3"));
+    ASSERT(!passes("temp!=80", "zone=3"));
+    ASSERT(passes("zone", "zone=3"));               // Presence test
+    ASSERT(!passes("temp", "zone=3"));
+    ASSERT(passes("!temp", "zone=3"));
+    ASSERT(!passes("one", "zone=3"));               // Whole field names only
+}
+
+TEST(combines_with_and_or_not) {
+    ASSERT(passes("zone=3 && temp>80", "zone=3 temp=81"));
+    ASSERT(!passes("zone=3 && temp>80", "zone=4 temp=81"));
+    ASSERT(passes("zone=1 || zone=3", "zone=3"));
+    ASSERT(!passes("zone=1 || zone=2", "zone=3"));
+    // && binds tighter than ||
+    ASSERT(passes("zone=1 || zone=3 && temp>80", "zone=1 temp=0"));
+    ASSERT(!passes("(zone=1 || zone=3) && temp>80", "zone=1 temp=0"));
+    ASSERT(passes("!(zone=1 || zone=2) && !(temp<0)", "zone=3 temp=5"));
+    ASSERT(passes("a=1 && b=2 && c=3 || d=4", "d=4"));
+}
+
+TEST(rejects_malformed_filters) {
+    char error[128];
+    ASSERT_NULL(event_filter_compile("", error, sizeof(error)));
+    ASSERT_NULL(event_filter_compile("temp>", error, sizeof(error)));
+    ASSERT(strstr(error, "expected a value") != NULL);
+    ASSERT_NULL(event_filter_compile("(zone=3", error, sizeof(error)));
+    ASSERT_NULL(event_filter_compile("zone=3 &&", error, sizeof(error)));
+    ASSERT_NULL(event_filter_compile("zone=3 zone=4", error, sizeof(error)));
+    ASSERT_NULL(event_filter_compile("name=\"open", error, sizeof(error)));
+    ASSERT_NULL(event_filter_compile("a=1 && b=2 && c=3 && d=4 && e=5 && f=6 && g=7 && h=8 && i=9",
+                                     error, sizeof(error)));
+    ASSERT(strstr(error, "too many fields") != NULL);
+    
+    char deep[EVENT_FILTER_MAX_SOURCE];
+    memset(deep, '(', 100);
+    strcpy(deep + 100, "a");
+    ASSERT_NULL(event_filter_compile(deep, error, sizeof(error)));
+}
+
+TEST(keeps_source_and_references) {
+    EventFilter* filter = event_filter_compile("zone=3", NULL, 0);
+    ASSERT_NOT_NULL(filter);
+    ASSERT_STR_EQ(event_filter_source(filter), "zone=3");
+    event_filter_ref(filter);
+    event_filter_release(filter);
+    ASSERT(event_filter_match(filter, "zone=3", 6));   // Still held once
+    event_filter_release(filter);
+}
+
+int main(void) {
+    printf("\n=== Event Filter Unit Tests ===\n\n");
+    
+    run_test_compares_numbers_and_strings();
+    run_test_reads_json_members();
+    run_test_missing_fields_fail_comparisons();
+    run_test_combines_with_and_or_not();
+    run_test_rejects_malformed_filters();
+    run_test_keeps_source_and_references();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
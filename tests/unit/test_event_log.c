@@ -0,0 +1,367 @@
+/**
+ * @file test_event_log.c
+ * @brief Unit tests for the durable event log
+ */
+
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include "yuki_frame/platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+
+#define LOG_DIR "test_event_log.tmp"
+
+// Close whatever a failed test left open and delete the log directory
+static void reset_log(void) {
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+
+    char path[128];
+    for (int number = 1; number <= 200; number++) {
+        snprintf(path, sizeof(path), LOG_DIR "/events-%08d.log", number);
+        remove(path);
+    }
+    remove(LOG_DIR "/checkpoint");
+    remove(LOG_DIR "/checkpoint.tmp");
+    remove(LOG_DIR);
+}
+
+// Register the subscribers the tests route to (the log reads their offsets
+// when it opens)
+static void register_tools(void) {
+    event_bus_init();
+    tool_registry_init();
+    tool_register("behind", "cat");
+    tool_register("caught_up", "cat");
+    tool_subscribe("behind", "DATA");
+    tool_subscribe("caught_up", "DATA");
+}
+
+// Pretend count events were written to the tool's stdin
+static void write_events(const char* name, int count) {
+    Tool* tool = tool_find(name);
+    for (int i = 0; i < count; i++) {
+        tool_queue_remove(tool->inbox);
+    }
+    tool_update_log_offset(tool);
+}
+
+static void publish_events(int count) {
+    char data[16];
+    for (int i = 0; i < count; i++) {
+        snprintf(data, sizeof(data), "%d", i);
+        event_publish("DATA", "src", data);
+    }
+    event_process_queue();
+}
+
+TEST(event_log_continues_lsns_after_reopen) {
+    reset_log();
+    ASSERT_EQ(event_log_open(LOG_DIR, 0, 0), FW_OK);
+    ASSERT(event_log_is_open());
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "a"), 1);
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_HIGH, "DATA", "src", ""), 2);
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", NULL), 3);
+
+    // sync_ms 0: every append is on disk when it returns
+    EventLogStats stats;
+    event_log_get_stats(&stats);
+    ASSERT_EQ(stats.appended, 3);
+    ASSERT_EQ(stats.synced_lsn, 3);
+    ASSERT_EQ(stats.syncs, 3);
+    event_log_close();
+    ASSERT(!event_log_is_open());
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "a"), 0);
+
+    ASSERT_EQ(event_log_open(LOG_DIR, 1000, 0), FW_OK);
+    ASSERT_EQ(event_log_last_lsn(), 3);
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "b"), 4);
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "c"), 5);
+    event_log_flush();
+    event_log_get_stats(&stats);
+    ASSERT_EQ(stats.synced_lsn, 5);
+    ASSERT_EQ(stats.syncs, 1);       // One group commit for both
+    reset_log();
+}
+
+TEST(event_log_ignores_torn_tail) {
+    reset_log();
+    ASSERT_EQ(event_log_open(LOG_DIR, 0, 0), FW_OK);
+    for (int i = 0; i < 3; i++) {
+        event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "payload");
+    }
+    event_log_close();
+
+    // Cut the last record short, as a crash in the middle of a write would
+    FILE* file = fopen(LOG_DIR "/events-00000001.log", "rb");
+    ASSERT(file != NULL);
+    char bytes[1024];
+    size_t length = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    file = fopen(LOG_DIR "/events-00000001.log", "wb");
+    ASSERT(file != NULL);
+    fwrite(bytes, 1, length - 4, file);
+    fclose(file);
+
+    ASSERT_EQ(event_log_open(LOG_DIR, 0, 0), FW_OK);
+    ASSERT_EQ(event_log_last_lsn(), 2);
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "payload"), 3);
+    reset_log();
+}
+
+TEST(event_log_replays_unwritten_events) {
+    reset_log();
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+    publish_events(3);
+    ASSERT_EQ(tool_queue_count(tool_find("behind")->inbox), 3);
+    ASSERT_EQ(tool_queue_peek_buffer_at(tool_find("behind")->inbox, 2)->lsn, 3);
+    write_events("behind", 1);
+    write_events("caught_up", 3);
+    ASSERT_EQ(atomic_load(&tool_find("behind")->log_acked), 1);
+    ASSERT_EQ(atomic_load(&tool_find("caught_up")->log_acked), 3);
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+
+    // Restart: only what "behind" had not been written comes back
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+    ASSERT_EQ(event_log_replay(), 2);
+    ToolQueue* inbox = tool_find("behind")->inbox;
+    ASSERT_EQ(tool_queue_count(inbox), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "DATA|src|1\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 1), "DATA|src|2\n");
+    ASSERT_EQ(tool_queue_count(tool_find("caught_up")->inbox), 0);
+
+    // New events continue after the replayed ones
+    publish_events(1);
+    ASSERT_EQ(tool_queue_peek_buffer_at(inbox, 2)->lsn, 4);
+    reset_log();
+}
+
+TEST(event_log_deletes_segments_every_tool_is_past) {
+    reset_log();
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 40), FW_OK);   // A record per segment
+    publish_events(5);
+    event_log_flush();
+
+    EventLogStats stats;
+    event_log_get_stats(&stats);
+    ASSERT_EQ(stats.segments, 5);
+
+    // "behind" still has events 4 and 5 queued
+    write_events("caught_up", 5);
+    write_events("behind", 3);
+    event_log_checkpoint();
+    event_log_flush();
+    event_log_get_stats(&stats);
+    ASSERT_EQ(stats.segments, 2);
+    FILE* file = fopen(LOG_DIR "/events-00000001.log", "rb");
+    ASSERT(file == NULL);
+
+    write_events("behind", 2);
+    event_log_checkpoint();
+    event_log_flush();
+    event_log_get_stats(&stats);
+    ASSERT_EQ(stats.segments, 1);    // The one being written stays
+    reset_log();
+}
+
+TEST(event_log_checkpoint_stays_below_events_in_flight) {
+    reset_log();
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+
+    // LSN 1 is appended but its publisher has not routed it yet when LSN 2
+    // reaches both tools and is written
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "late"), 1);
+    publish_events(1);
+    write_events("behind", 1);
+    write_events("caught_up", 1);
+    ASSERT_EQ(atomic_load(&tool_find("caught_up")->log_acked), 2);
+    ASSERT_EQ(event_log_floor(), 1);
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+
+    // The checkpoint kept both tools before LSN 1: it comes back, with 2
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+    ASSERT_EQ(atomic_load(&tool_find("caught_up")->log_acked), 0);
+    ASSERT_EQ(event_log_replay(), 2);
+    write_events("behind", 2);
+    write_events("caught_up", 2);
+
+    // Once the late event is done with, checkpoints move past it
+    ASSERT_EQ(event_log_append(EVENT_PRIORITY_NORMAL, "DATA", "src", "late"), 3);
+    publish_events(1);
+    write_events("behind", 1);
+    write_events("caught_up", 1);
+    event_log_release(3);
+    ASSERT_EQ(event_log_floor(), 5);
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+    ASSERT_EQ(atomic_load(&tool_find("caught_up")->log_acked), 4);
+    ASSERT_EQ(atomic_load(&tool_find("behind")->log_acked), 4);
+    reset_log();
+}
+
+TEST(event_log_covers_batches_published_on_a_shard) {
+    reset_log();
+    ASSERT_EQ(event_loop_init(1), FW_OK);
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+
+    // As a tool's shard publishes: each event gets an LSN and is queued
+    EventView batch[3] = {
+        { "DATA", "src", "one" }, { "DATA", "src", "two" }, { "DATA", "src", NULL },
+    };
+    event_loop_lock(0);
+    event_routes_enter(0);
+    ASSERT_EQ(event_publish_batch(batch, 3), FW_OK);
+    event_routes_exit(0);
+    event_loop_unlock(0);
+    ASSERT_EQ(event_log_last_lsn(), 3);
+    ASSERT_EQ(event_log_floor(), 4);
+    ASSERT_EQ(tool_queue_count(tool_find("behind")->inbox), 3);
+    ASSERT_EQ(tool_queue_peek_buffer_at(tool_find("behind")->inbox, 2)->lsn, 3);
+
+    // One tool falls behind: the rest of the batch is replayed to it
+    write_events("behind", 1);
+    write_events("caught_up", 3);
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+    register_tools();
+    ASSERT_EQ(event_log_open(LOG_DIR, 10, 0), FW_OK);
+    ASSERT_EQ(event_log_replay(), 2);
+    ASSERT_EQ(tool_queue_count(tool_find("behind")->inbox), 2);
+    ASSERT_EQ(tool_queue_count(tool_find("caught_up")->inbox), 0);
+    reset_log();
+    event_loop_shutdown();
+}
+
+TEST(event_log_cursor_seeks_by_lsn_and_time) {
+    reset_log();
+    // Segments of a few index intervals each, so seeks use both
+    ASSERT_EQ(event_log_open(LOG_DIR, 1000, 3 * EVENT_LOG_INDEX_INTERVAL), FW_OK);
+    char data[256];
+    memset(data, 'x', sizeof(data) - 1);
+    data[sizeof(data) - 1] = '\0';
+    for (int batch = 0; batch < 3; batch++) {
+        for (int i = 0; i < 1000; i++) {
+            event_log_append(EVENT_PRIORITY_NORMAL, batch == 1 ? "B" : "A", "src", data);
+        }
+        platform_sleep_ms(5);   // Each batch has later timestamps
+    }
+    event_log_flush();
+    EventLogStats stats;
+    event_log_get_stats(&stats);
+    ASSERT(stats.segments > 3);
+    
+    EventLogRecord record;
+    EventLogCursor* cursor = event_log_seek_lsn(1500);
+    ASSERT(cursor != NULL);
+    ASSERT(event_log_cursor_next(cursor, &record));
+    ASSERT_EQ(record.lsn, 1500);
+    ASSERT_STR_EQ(record.type, "B");
+    ASSERT_STR_EQ(record.sender, "src");
+    ASSERT_STR_EQ(record.data, data);
+    int count = 1;
+    while (event_log_cursor_next(cursor, &record)) {
+        ASSERT_EQ(record.lsn, 1500 + (uint64_t)count);
+        count++;
+    }
+    ASSERT_EQ(count, 1501);
+    
+    // Sees what is written after it caught up
+    event_log_append(EVENT_PRIORITY_HIGH, "C", "src", "late");
+    event_log_flush();
+    ASSERT(event_log_cursor_next(cursor, &record));
+    ASSERT_EQ(record.lsn, 3001);
+    ASSERT_EQ(record.priority, EVENT_PRIORITY_HIGH);
+    ASSERT_STR_EQ(record.data, "late");
+    event_log_cursor_close(cursor);
+    
+    // The first event of the second batch by its time
+    cursor = event_log_seek_lsn(1001);
+    ASSERT(event_log_cursor_next(cursor, &record));
+    uint64_t batch_time = record.timestamp_ms;
+    event_log_cursor_close(cursor);
+    cursor = event_log_seek_time(batch_time);
+    ASSERT(event_log_cursor_next(cursor, &record));
+    ASSERT_EQ(record.lsn, 1001);
+    event_log_cursor_close(cursor);
+    
+    cursor = event_log_seek_time(event_log_time_ms() + 60000);
+    ASSERT(!event_log_cursor_next(cursor, &record));
+    event_log_cursor_close(cursor);
+    reset_log();
+}
+
+int main(void) {
+    printf("\n=== Event Log Unit Tests ===\n\n");
+
+    run_test_event_log_continues_lsns_after_reopen();
+    run_test_event_log_ignores_torn_tail();
+    run_test_event_log_replays_unwritten_events();
+    run_test_event_log_deletes_segments_every_tool_is_past();
+    run_test_event_log_checkpoint_stays_below_events_in_flight();
+    run_test_event_log_covers_batches_published_on_a_shard();
+    run_test_event_log_cursor_seeks_by_lsn_and_time();
+    reset_log();
+
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,368 @@
+/**
+ * @file test_event_loop.c
+ * @brief Unit tests for the readiness-driven event loop
+ */
+
+#include "yuki_frame/event_loop.h"
+#include "yuki_frame/io_worker.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/framework.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef PLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+// Tests
+TEST(event_loop_init_success) {
+    ASSERT_EQ(event_loop_init(1), FW_OK);
+    ASSERT_EQ(event_loop_shard_count(), 1);
+    ASSERT_EQ(event_loop_control(), 0);
+    event_loop_shutdown();
+}
+
+TEST(schedule_delivery_is_deduplicated) {
+    event_loop_init(1);
+    Tool tool;
+    memset(&tool, 0, sizeof(tool));
+    tool.shard = 0;
+    
+    event_loop_schedule_delivery(&tool);
+    event_loop_schedule_delivery(&tool);
+    ASSERT(tool.delivery_pending);
+    
+    Tool* ready[4];
+    ASSERT_EQ(event_loop_take_deliveries(0, ready, 4), 1);
+    ASSERT(ready[0] == &tool);
+    ASSERT(!tool.delivery_pending);
+    ASSERT_EQ(event_loop_take_deliveries(0, ready, 4), 0);
+    
+    event_loop_shutdown();
+}
+
+TEST(wait_times_out_without_work) {
+    event_loop_init(1);
+    LoopEvent events[4];
+    
+    uint64_t start = platform_monotonic_ms();
+    ASSERT_EQ(event_loop_wait(0, events, 4, 50), 0);
+    ASSERT(platform_monotonic_ms() - start >= 40);
+    
+    event_loop_shutdown();
+}
+
+TEST(wait_returns_immediately_with_pending_delivery) {
+    event_loop_init(1);
+    Tool tool;
+    memset(&tool, 0, sizeof(tool));
+    tool.shard = 0;
+    LoopEvent events[4];
+    
+    event_loop_schedule_delivery(&tool);
+    uint64_t start = platform_monotonic_ms();
+    ASSERT_EQ(event_loop_wait(0, events, 4, 5000), 0);
+    ASSERT(platform_monotonic_ms() - start < 1000);
+    
+    event_loop_shutdown();
+}
+
+TEST(wait_reports_readable_stdout) {
+    event_loop_init(1);
+    tool_registry_init();
+    ASSERT_EQ(tool_register("loop_tool", "echo PING"), FW_OK);
+    ASSERT_EQ(tool_start("loop_tool"), FW_OK);
+    Tool* tool = tool_find("loop_tool");
+    
+    LoopEvent events[4];
+    bool seen = false;
+    for (int tries = 0; tries < 20 && !seen; tries++) {
+        int n = event_loop_wait(0, events, 4, 100);
+        for (int i = 0; i < n; i++) {
+            LoopSource source;
+            if (events[i].tool == tool && event_loop_source(&events[i], &source) &&
+                source == LOOP_SOURCE_STDOUT) {
+                seen = true;
+            }
+        }
+    }
+    ASSERT(seen);
+    
+    tool_registry_shutdown();
+    event_loop_shutdown();
+}
+
+TEST(wait_reports_tool_exit) {
+    platform_init();
+    event_loop_init(1);
+    tool_registry_init();
+    ASSERT_EQ(tool_register("exit_tool", "sleep 0.1"), FW_OK);
+    ASSERT_EQ(tool_start("exit_tool"), FW_OK);
+    Tool* tool = tool_find("exit_tool");
+    if (tool->exit_fd < 0) {
+        printf("(no pidfd) ");  // Kernel before 5.3: SIGCHLD fallback instead
+        tool_registry_shutdown();
+        event_loop_shutdown();
+        return;
+    }
+    
+    LoopEvent events[4];
+    bool seen = false;
+    for (int tries = 0; tries < 20 && !seen; tries++) {
+        int n = event_loop_wait(0, events, 4, 100);
+        for (int i = 0; i < n; i++) {
+            LoopSource source;
+            if (events[i].tool != tool || !event_loop_source(&events[i], &source)) {
+                continue;
+            }
+            if (source == LOOP_SOURCE_EXIT) {
+                seen = true;
+            } else if (events[i].hangup) {
+                // As the I/O worker does; a closed pipe stays ready
+                event_loop_remove_source(tool, source);
+            }
+        }
+    }
+    ASSERT(seen);
+    ASSERT(!tool->exit_watched);  // Reported once
+    
+    tool_check_exit(tool);
+    ASSERT_EQ(tool->status, TOOL_CRASHED);
+    ASSERT(tool->has_exited);
+    ASSERT_EQ(tool->last_exit.exit_code, 0);
+    
+    tool_registry_shutdown();
+    event_loop_shutdown();
+    platform_shutdown();
+}
+
+TEST(post_wakes_waiting_shard) {
+    event_loop_init(2);
+    ASSERT_EQ(event_loop_shard_count(), 2);
+    ASSERT_EQ(event_loop_control(), 2);
+    LoopEvent events[4];
+    int item = 42;
+    
+    ASSERT(event_loop_post(1, &item));
+    uint64_t start = platform_monotonic_ms();
+    ASSERT_EQ(event_loop_wait(1, events, 4, 5000), 0);
+    ASSERT(platform_monotonic_ms() - start < 1000);
+    ASSERT(event_loop_take_posted(1) == &item);
+    ASSERT_NULL(event_loop_take_posted(1));
+    ASSERT_NULL(event_loop_take_posted(0));
+    
+    event_loop_shutdown();
+}
+
+static int posted_item = 7;
+
+static void post_later(void* arg) {
+    (void)arg;
+    platform_sleep_ms(50);
+    event_loop_post(0, &posted_item);
+}
+
+TEST(busy_poll_sees_post_without_wakeup) {
+    event_loop_init(1);
+    event_loop_set_mode(LOOP_MODE_BUSY_POLL, 0, -1);
+    LoopEvent events[4];
+    
+    PlatformThread thread;
+    ASSERT_EQ(platform_thread_create(&thread, post_later, NULL), FW_OK);
+    uint64_t start = platform_monotonic_ms();
+    ASSERT_EQ(event_loop_wait(0, events, 4, 5000), 0);
+    ASSERT(platform_monotonic_ms() - start < 1000);
+    platform_thread_join(thread);
+    ASSERT(event_loop_take_posted(0) == &posted_item);
+    
+    LoopStats stats;
+    event_loop_get_stats(0, &stats);
+    ASSERT_EQ(stats.waits, 1u);
+    ASSERT(stats.spins > 0);
+    ASSERT_EQ(stats.sleeps, 0u);
+    ASSERT_EQ(stats.wakeups, 0u);  // The poster never needed a syscall
+    
+    event_loop_set_mode(LOOP_MODE_BLOCKING, 0, -1);
+    event_loop_shutdown();
+}
+
+TEST(hybrid_sleeps_after_spinning) {
+    event_loop_init(1);
+    event_loop_set_mode(LOOP_MODE_HYBRID, 200, -1);
+    LoopEvent events[4];
+    
+    uint64_t start = platform_monotonic_ms();
+    ASSERT_EQ(event_loop_wait(0, events, 4, 30), 0);
+    ASSERT(platform_monotonic_ms() - start >= 25);
+    
+    LoopStats stats;
+    event_loop_get_stats(0, &stats);
+    ASSERT(stats.spins > 0);
+    ASSERT_EQ(stats.sleeps, 1u);
+    ASSERT_EQ(stats.empty_sleeps, 1u);
+    
+    event_loop_set_mode(LOOP_MODE_BLOCKING, 0, -1);
+    event_loop_shutdown();
+}
+
+TEST(tools_are_spread_over_shards) {
+    event_loop_init(3);
+    ASSERT_EQ(event_loop_assign_shard(), 0);
+    ASSERT_EQ(event_loop_assign_shard(), 1);
+    ASSERT_EQ(event_loop_assign_shard(), 2);
+    ASSERT_EQ(event_loop_assign_shard(), 0);
+    
+    // The lock marks the locking thread as on that shard
+    ASSERT_EQ(event_loop_current_shard(), -1);
+    event_loop_lock(1);
+    ASSERT_EQ(event_loop_current_shard(), 1);
+    event_loop_unlock(1);
+    ASSERT_EQ(event_loop_current_shard(), -1);
+    
+    event_loop_shutdown();
+}
+
+TEST(unregistered_tool_outlives_queued_deliveries) {
+    event_loop_init(2);
+    tool_registry_init();
+    ASSERT_EQ(tool_register("gone_tool", "echo PING"), FW_OK);
+    Tool* tool = tool_find("gone_tool");
+    int shard = tool->shard;
+    ASSERT(shard >= 0);
+    
+    // Routed before the tool is unregistered: still on its shard's ring
+    EventBuffer* buffer = event_buffer_create("PING|x|y", 8);
+    ASSERT_EQ(io_worker_deliver(tool, buffer), FW_OK);
+    ASSERT_EQ(tool_unregister("gone_tool"), FW_OK);
+    ASSERT_NULL(tool_find("gone_tool"));
+    ASSERT(tool->retired);
+    
+    // The shard refuses the delivery, then hands the tool to the control
+    // loop, which frees it
+    tool_reclaim();
+    ASSERT_NULL(io_worker_take_control());
+    io_worker_poll(shard, 0);
+    WorkItem* item = io_worker_take_control();
+    ASSERT_NOT_NULL(item);
+    ASSERT_EQ(item->type, WORK_RETIRE);
+    ASSERT(item->tool == tool);
+    io_worker_free(item);
+    ASSERT_NULL(io_worker_take_control());
+    
+    tool_registry_shutdown();
+    event_loop_shutdown();
+}
+
+#ifdef PLATFORM_LINUX
+TEST(io_uring_poller_is_level_triggered) {
+    PlatformPoller* poller = platform_poller_create();
+    ASSERT_NOT_NULL(poller);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    int marker = 1;
+    ASSERT_EQ(platform_poller_add(poller, fds[0], PLATFORM_POLL_READ, &marker), FW_OK);
+    
+    PlatformPollEvent events[4];
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 20), 0);
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 1000), 1);
+    ASSERT_EQ(events[0].fd, fds[0]);
+    ASSERT(events[0].events & PLATFORM_POLL_READ);
+    ASSERT(events[0].user_data == &marker);
+    
+    // Not read yet: reported again
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 1000), 1);
+    
+    // A removed fd is no longer reported, even if it stays readable
+    ASSERT_EQ(platform_poller_remove(poller, fds[0]), FW_OK);
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 20), 0);
+    ASSERT_EQ(platform_poller_add(poller, fds[0], PLATFORM_POLL_READ, &marker), FW_OK);
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 1000), 1);
+    
+    close(fds[1]);
+    char byte;
+    ASSERT_EQ(read(fds[0], &byte, 1), 1);
+    ASSERT_EQ(platform_poller_wait(poller, events, 4, 1000), 1);
+    ASSERT(events[0].events & PLATFORM_POLL_HANGUP);
+    
+    platform_poller_remove(poller, fds[0]);
+    close(fds[0]);
+    platform_poller_destroy(poller);
+}
+#endif
+
+int main(void) {
+    printf("\n=== Event Loop Unit Tests ===\n\n");
+    
+    run_test_event_loop_init_success();
+    run_test_schedule_delivery_is_deduplicated();
+    run_test_wait_times_out_without_work();
+    run_test_wait_returns_immediately_with_pending_delivery();
+    run_test_wait_reports_readable_stdout();
+    run_test_wait_reports_tool_exit();
+    run_test_post_wakes_waiting_shard();
+    run_test_busy_poll_sees_post_without_wakeup();
+    run_test_hybrid_sleeps_after_spinning();
+    run_test_tools_are_spread_over_shards();
+    run_test_unregistered_tool_outlives_queued_deliveries();
+    
+#ifdef PLATFORM_LINUX
+    if (platform_select_io_backend(IO_BACKEND_AUTO) == IO_BACKEND_IO_URING) {
+        printf("\n  io_uring backend:\n");
+        run_test_io_uring_poller_is_level_triggered();
+        run_test_wait_times_out_without_work();
+        run_test_wait_reports_readable_stdout();
+        run_test_wait_reports_tool_exit();
+        run_test_post_wakes_waiting_shard();
+        run_test_busy_poll_sees_post_without_wakeup();
+        platform_select_io_backend(IO_BACKEND_DEFAULT);
+    } else {
+        printf("\n  io_uring not supported, skipping its tests\n");
+    }
+#endif
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
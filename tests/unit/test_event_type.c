@@ -0,0 +1,173 @@
+/**
+ * @file test_event_type.c
+ * @brief Unit tests for the event type intern table
+ */
+
+#include "yuki_frame/event_type.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/framework.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define THREADS 4
+#define TYPES_PER_THREAD 200
+
+TEST(intern_returns_same_id_for_same_type) {
+    EventTypeId a = event_type_intern("SENSOR.temp");
+    EventTypeId b = event_type_intern("SENSOR.humidity");
+    ASSERT_NE(a, EVENT_TYPE_NONE);
+    ASSERT_NE(b, EVENT_TYPE_NONE);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(event_type_intern("SENSOR.temp"), a);
+    ASSERT_EQ(event_type_find("SENSOR.humidity"), b);
+    ASSERT_STR_EQ(event_type_name(a), "SENSOR.temp");
+    ASSERT_STR_EQ(event_type_name(b), "SENSOR.humidity");
+}
+
+TEST(find_does_not_intern) {
+    uint32_t count = event_type_count();
+    ASSERT_EQ(event_type_find("NEVER_SEEN"), EVENT_TYPE_NONE);
+    ASSERT_EQ(event_type_count(), count);
+    ASSERT_NULL(event_type_name(EVENT_TYPE_NONE));
+    ASSERT_NULL(event_type_name(count + 1));
+}
+
+TEST(intern_rejects_overlong_types) {
+    char type[MAX_EVENT_TYPE + 1];
+    memset(type, 'A', MAX_EVENT_TYPE);
+    type[MAX_EVENT_TYPE] = '\0';
+    ASSERT_EQ(event_type_intern(type), EVENT_TYPE_NONE);
+    
+    type[MAX_EVENT_TYPE - 1] = '\0';
+    EventTypeId id = event_type_intern(type);
+    ASSERT_NE(id, EVENT_TYPE_NONE);
+    ASSERT_EQ(strlen(event_type_name(id)), (size_t)MAX_EVENT_TYPE - 1);
+}
+
+TEST(counters_accumulate_per_type) {
+    EventTypeId id = event_type_intern("COUNTED");
+    event_type_count_routed(id, 3);
+    event_type_count_routed(id, 0);
+    
+    EventTypeStats stats;
+    event_type_get_stats(id, &stats);
+    ASSERT_EQ(stats.routed, 2u);
+    ASSERT_EQ(stats.delivered, 3u);
+    
+    event_type_get_stats(event_type_intern("NOT_COUNTED"), &stats);
+    ASSERT_EQ(stats.routed, 0u);
+}
+
+TEST(table_stops_at_max_ids) {
+    event_types_shutdown();
+    char type[32];
+    for (int i = 0; i < EVENT_TYPE_MAX_IDS; i++) {
+        snprintf(type, sizeof(type), "T%d", i);
+        ASSERT_EQ(event_type_intern(type), (EventTypeId)i + 1);
+    }
+    ASSERT_EQ(event_type_intern("ONE_TOO_MANY"), EVENT_TYPE_NONE);
+    ASSERT_EQ(event_type_intern("T17"), 18u);  // Existing types still resolve
+    ASSERT_STR_EQ(event_type_name(EVENT_TYPE_MAX_IDS), "T4095");
+    
+    event_types_shutdown();
+    ASSERT_EQ(event_type_count(), 0u);
+    ASSERT_EQ(event_type_find("T17"), EVENT_TYPE_NONE);
+}
+
+typedef struct {
+    int thread;
+    EventTypeId ids[TYPES_PER_THREAD];
+} InternArgs;
+
+// Every thread interns the same names, half of them in reverse order
+static void intern_main(void* arg) {
+    InternArgs* args = (InternArgs*)arg;
+    char type[32];
+    for (int i = 0; i < TYPES_PER_THREAD; i++) {
+        int n = (args->thread % 2) ? TYPES_PER_THREAD - 1 - i : i;
+        snprintf(type, sizeof(type), "RACE.%d", n);
+        args->ids[n] = event_type_intern(type);
+    }
+}
+
+TEST(concurrent_interning_agrees_on_ids) {
+    event_types_shutdown();
+    PlatformThread threads[THREADS];
+    InternArgs args[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        args[t].thread = t;
+        ASSERT_EQ(platform_thread_create(&threads[t], intern_main, &args[t]), FW_OK);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        platform_thread_join(threads[t]);
+    }
+    
+    ASSERT_EQ(event_type_count(), (uint32_t)TYPES_PER_THREAD);
+    char type[32];
+    for (int i = 0; i < TYPES_PER_THREAD; i++) {
+        ASSERT_NE(args[0].ids[i], EVENT_TYPE_NONE);
+        for (int t = 1; t < THREADS; t++) {
+            ASSERT_EQ(args[t].ids[i], args[0].ids[i]);
+        }
+        snprintf(type, sizeof(type), "RACE.%d", i);
+        ASSERT_STR_EQ(event_type_name(args[0].ids[i]), type);
+    }
+    event_types_shutdown();
+}
+
+int main(void) {
+    printf("\n=== Event Type Unit Tests ===\n\n");
+    
+    run_test_intern_returns_same_id_for_same_type();
+    run_test_find_does_not_intern();
+    run_test_intern_rejects_overlong_types();
+    run_test_counters_accumulate_per_type();
+    run_test_table_stops_at_max_ids();
+    run_test_concurrent_interning_agrees_on_ids();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file test_flow_control.c
+ * @brief Unit tests for the event memory budget and the elastic bus
+ */
+
+#include "yuki_frame/flow_control.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+
+static void reset(void) {
+    tool_registry_shutdown();
+    event_bus_shutdown();
+    g_config.message_queue_size = 0;
+}
+
+static size_t used_bytes(void) {
+    FlowStats stats;
+    flow_get_stats(&stats);
+    return stats.used;
+}
+
+// A publisher and a subscriber to everything, both running
+static void setup(size_t limit, int queue_size) {
+    reset();
+    g_config.message_queue_size = queue_size;
+    flow_init(limit, 80, 50);
+    event_bus_init();
+    tool_registry_init();
+    tool_register("pub", "cat");
+    tool_register("sub", "cat");
+    tool_find("pub")->status = TOOL_RUNNING;
+    tool_find("sub")->status = TOOL_RUNNING;
+    tool_subscribe("sub", "*");
+}
+
+TEST(flow_watermarks_have_hysteresis) {
+    flow_init(1000, 80, 50);
+    flow_charge(NULL, 700);
+    ASSERT(!flow_under_pressure());
+    flow_charge(NULL, 100);
+    ASSERT(flow_under_pressure());
+
+    // Still under pressure between the watermarks
+    flow_release(NULL, 200);
+    ASSERT(flow_under_pressure());
+    flow_charge(NULL, 150);
+    flow_release(NULL, 250);
+    ASSERT(!flow_under_pressure());
+
+    FlowStats stats;
+    flow_get_stats(&stats);
+    ASSERT_EQ(stats.pressure_count, 1);
+    ASSERT_EQ(stats.peak, 800);
+    ASSERT_EQ(stats.high_watermark, 800);
+    ASSERT_EQ(stats.low_watermark, 500);
+    flow_release(NULL, 500);
+    ASSERT_EQ(used_bytes(), 0);
+}
+
+TEST(flow_init_clamps_watermarks) {
+    flow_init(1000, 150, 90);
+    FlowStats stats;
+    flow_get_stats(&stats);
+    ASSERT_EQ(stats.high_watermark, 1000 / 100 * FLOW_DEFAULT_HIGH_WATERMARK);
+    ASSERT_EQ(stats.low_watermark, 1000 / 100 * FLOW_DEFAULT_LOW_WATERMARK);
+
+    flow_init(0, 40, 70);
+    flow_get_stats(&stats);
+    ASSERT_EQ(stats.limit, FLOW_DEFAULT_MEMORY_LIMIT);
+    ASSERT_EQ(stats.low_watermark, stats.high_watermark);
+}
+
+TEST(flow_reserve_refuses_past_budget) {
+    flow_init(1000, 80, 50);
+    ASSERT(flow_reserve(900));
+    ASSERT(!flow_reserve(200));
+    ASSERT(flow_reserve(100));
+
+    FlowStats stats;
+    flow_get_stats(&stats);
+    ASSERT_EQ(stats.rejected, 1);
+    ASSERT_EQ(stats.used, 1000);
+    flow_release(NULL, 1000);
+}
+
+TEST(flow_pauses_publishers_over_fair_share) {
+    setup(1000, 0);
+    Tool* pub = tool_find("pub");
+    Tool* sub = tool_find("sub");
+    flow_charge(pub->flow, 600);
+    flow_charge(sub->flow, 100);
+    ASSERT(!flow_should_pause(pub->flow));   // No pressure yet
+
+    flow_charge(sub->flow, 150);
+    ASSERT(flow_under_pressure());
+    ASSERT(flow_should_pause(pub->flow));
+    ASSERT(!flow_should_pause(sub->flow));
+
+    // With pub's events gone, sub holds all that is left
+    flow_release(pub->flow, 600);
+    ASSERT_EQ(flow_account_bytes(pub->flow), 0);
+    ASSERT(!flow_under_pressure());
+    flow_charge(NULL, 600);
+    ASSERT(flow_under_pressure());
+    ASSERT(!flow_should_pause(pub->flow));
+    ASSERT(flow_should_pause(sub->flow));
+
+    flow_release(sub->flow, 250);
+    flow_release(NULL, 600);
+    ASSERT_EQ(used_bytes(), 0);
+    reset();
+}
+
+TEST(routed_events_are_charged_to_publisher) {
+    setup(FLOW_DEFAULT_MEMORY_LIMIT, 0);
+    Tool* pub = tool_find("pub");
+    Tool* sub = tool_find("sub");
+
+    flow_set_publisher(pub);
+    ASSERT_EQ(event_route("PING", "pub", "one"), FW_OK);
+    ASSERT_EQ(event_route("PING", "pub", "two"), FW_OK);
+    flow_set_publisher(NULL);
+    ASSERT_EQ(tool_queue_count(sub->inbox), 2);
+    size_t charged = flow_account_bytes(pub->flow);
+    ASSERT(charged > 0);
+    ASSERT_EQ(used_bytes(), charged);
+
+    // Written out, the events are released
+    tool_queue_remove(sub->inbox);
+    ASSERT(flow_account_bytes(pub->flow) < charged);
+    tool_queue_remove(sub->inbox);
+    ASSERT_EQ(flow_account_bytes(pub->flow), 0);
+    ASSERT_EQ(used_bytes(), 0);
+    reset();
+}
+
+TEST(queued_events_outlive_their_publisher) {
+    setup(FLOW_DEFAULT_MEMORY_LIMIT, 0);
+    Tool* sub = tool_find("sub");
+
+    flow_set_publisher(tool_find("pub"));
+    ASSERT_EQ(event_route("PING", "pub", "one"), FW_OK);
+    ASSERT_EQ(event_route("PING", "pub", "two"), FW_OK);
+    flow_set_publisher(NULL);
+
+    // The publisher is freed with its events still queued; their release
+    // settles its account instead
+    ASSERT_EQ(tool_unregister("pub"), FW_OK);
+    ASSERT(used_bytes() > 0);
+    tool_queue_remove(sub->inbox);
+    tool_queue_remove(sub->inbox);
+    ASSERT_EQ(used_bytes(), 0);
+    reset();
+}
+
+TEST(bus_splits_long_batches) {
+    setup(FLOW_DEFAULT_MEMORY_LIMIT, 0);
+    enum { COUNT = MAX_EVENTS_QUEUE * 2 + 5 };
+    ASSERT_EQ(tool_set_queue_config("sub", COUNT, QUEUE_POLICY_DROP_NEWEST, 1), FW_OK);
+    static EventView batch[COUNT];
+    static char data[COUNT][16];
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(data[i], sizeof(data[i]), "%d", i);
+        batch[i].type = "TICK";
+        batch[i].sender = "framework";
+        batch[i].data = data[i];
+    }
+    ASSERT_EQ(event_publish_batch(batch, COUNT), FW_OK);
+    event_process_queue();
+
+    // Every chunk arrives, in order
+    ToolQueue* inbox = tool_find("sub")->inbox;
+    ASSERT_EQ(tool_queue_count(inbox), COUNT);
+    for (int i = 0; i < COUNT; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "TICK|framework|%d\n", i);
+        ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), expected);
+        tool_queue_remove(inbox);
+    }
+    ASSERT_EQ(used_bytes(), 0);
+    reset();
+}
+
+TEST(bus_overflows_ring_in_order) {
+    setup(FLOW_DEFAULT_MEMORY_LIMIT, 4);
+    char data[16];
+    for (int i = 0; i < 10; i++) {
+        snprintf(data, sizeof(data), "%d", i);
+        ASSERT_EQ(event_publish("TICK", "framework", data), FW_OK);
+    }
+
+    EventBusStats stats;
+    event_bus_get_stats(&stats);
+    ASSERT_EQ(stats.ring_capacity, 4);
+    ASSERT_EQ(stats.queued, 10);
+    ASSERT_EQ(stats.overflowed, 6);
+    ASSERT(used_bytes() > 0);
+
+    event_process_queue();
+    event_bus_get_stats(&stats);
+    ASSERT_EQ(stats.queued, 0);
+    ASSERT_EQ(stats.overflowed, 0);
+    ASSERT_EQ(stats.overflow_peak, 6);
+    ASSERT_EQ(stats.overflow_total, 6);
+
+    ToolQueue* inbox = tool_find("sub")->inbox;
+    ASSERT_EQ(tool_queue_count(inbox), 10);
+    for (int i = 0; i < 10; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "TICK|framework|%d\n", i);
+        ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), expected);
+        tool_queue_remove(inbox);
+    }
+    ASSERT_EQ(used_bytes(), 0);
+    reset();
+}
+
+TEST(bus_refuses_publishes_over_budget) {
+    setup(4096, 4);
+    char data[512];
+    memset(data, 'x', sizeof(data) - 1);
+    data[sizeof(data) - 1] = '\0';
+    int published = 0;
+    while (published < 100 && event_publish("BULK", "framework", data) == FW_OK) {
+        published++;
+    }
+    ASSERT(published > 4);          // Past the ring
+    ASSERT(published < 100);
+    ASSERT_EQ(event_publish("BULK", "framework", data), FW_ERROR_QUEUE_FULL);
+
+    FlowStats flow;
+    flow_get_stats(&flow);
+    ASSERT_EQ(flow.rejected, 2);
+    ASSERT(flow.used <= flow.limit);
+
+    // Draining makes room again
+    event_process_queue();
+    tool_queue_clear(tool_find("sub")->inbox);
+    ASSERT_EQ(used_bytes(), 0);
+    ASSERT_EQ(event_publish("BULK", "framework", data), FW_OK);
+    reset();
+}
+
+int main(void) {
+    printf("\n=== Flow Control Unit Tests ===\n\n");
+
+    run_test_flow_watermarks_have_hysteresis();
+    run_test_flow_init_clamps_watermarks();
+    run_test_flow_reserve_refuses_past_budget();
+    run_test_flow_pauses_publishers_over_fair_share();
+    run_test_routed_events_are_charged_to_publisher();
+    run_test_queued_events_outlive_their_publisher();
+    run_test_bus_splits_long_batches();
+    run_test_bus_overflows_ring_in_order();
+    run_test_bus_refuses_publishes_over_budget();
+    reset();
+
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return tests_failed == 0 ? 0 : 1;
+}
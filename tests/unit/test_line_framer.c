@@ -0,0 +1,241 @@
+/**
+ * @file test_line_framer.c
+ * @brief Unit tests for per-tool stdout line reassembly
+ */
+
+#include "yuki_frame/line_framer.h"
+#include "yuki_frame/framework.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+// Feed a string into the framer as if read from the pipe
+static void feed(LineFramer* framer, const char* text) {
+    size_t len = strlen(text);
+    while (len > 0) {
+        size_t available;
+        char* space = line_framer_prepare(framer, &available);
+        size_t n = len < available ? len : available;
+        memcpy(space, text, n);
+        line_framer_commit(framer, n);
+        text += n;
+        len -= n;
+    }
+}
+
+// Tests
+TEST(single_line_is_split) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    feed(&framer, "PING|sender|n=1\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "PING");
+    ASSERT_EQ(frame.type_len, 4);
+    ASSERT_STR_EQ(frame.sender, "sender");
+    ASSERT_STR_EQ(frame.data, "n=1");
+    ASSERT_EQ(frame.data_len, 3);
+    ASSERT(!line_framer_next(&framer, &frame));
+    
+    line_framer_free(&framer);
+}
+
+TEST(partial_line_waits_for_newline) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    feed(&framer, "SENSOR|th");
+    ASSERT(!line_framer_next(&framer, &frame));
+    feed(&framer, "ermo|temp=21");
+    ASSERT(!line_framer_next(&framer, &frame));
+    feed(&framer, ".5\nNEXT|a|b\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.sender, "thermo");
+    ASSERT_STR_EQ(frame.data, "temp=21.5");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "NEXT");
+    
+    line_framer_free(&framer);
+}
+
+TEST(data_keeps_extra_separators) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    // Long header so the vector scan sees both separators in one block
+    feed(&framer, "A_LONG_EVENT_TYPE_NAME|a_long_sender_name|x|y|z\r\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "A_LONG_EVENT_TYPE_NAME");
+    ASSERT_STR_EQ(frame.sender, "a_long_sender_name");
+    ASSERT_STR_EQ(frame.data, "x|y|z");
+    
+    line_framer_free(&framer);
+}
+
+TEST(malformed_lines_are_skipped) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    feed(&framer, "no separators here\n|nosender|x\nTYPE||x\n\nGOOD|s|d\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "GOOD");
+    ASSERT_EQ(framer.malformed_lines, 3);
+    
+    line_framer_free(&framer);
+}
+
+TEST(oversized_line_is_dropped) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    char* big = (char*)malloc(LINE_FRAMER_MAX_LINE * 2);
+    memset(big, 'x', LINE_FRAMER_MAX_LINE * 2 - 1);
+    big[LINE_FRAMER_MAX_LINE * 2 - 1] = '\0';
+    feed(&framer, "BIG|s|");
+    feed(&framer, big);
+    while (line_framer_next(&framer, &frame)) {
+    }
+    feed(&framer, "\nAFTER|s|ok\n");
+    free(big);
+    
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "AFTER");
+    ASSERT_EQ(framer.oversized_lines, 1);
+    
+    line_framer_free(&framer);
+}
+
+TEST(frame_carries_large_multiline_payload) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    // Several line buffers' worth of JSON with newlines, arriving in pieces
+    size_t size = LINE_FRAMER_MAX_LINE * 4;
+    char* payload = (char*)malloc(size + 1);
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = (i % 80 == 79) ? '\n' : '{';
+    }
+    payload[size] = '\0';
+    char header[64];
+    snprintf(header, sizeof(header), "#%zu|DOC|writer\n", size);
+    
+    feed(&framer, "BEFORE|s|1\n");
+    feed(&framer, header);
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "BEFORE");
+    ASSERT(!line_framer_next(&framer, &frame));
+    feed(&framer, payload);
+    ASSERT(!line_framer_next(&framer, &frame));
+    feed(&framer, "\nAFTER|s|2\n");
+    
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "DOC");
+    ASSERT_EQ(frame.type_len, 3);
+    ASSERT_STR_EQ(frame.sender, "writer");
+    ASSERT_EQ(frame.data_len, size);
+    ASSERT(memcmp(frame.data, payload, size) == 0);
+    ASSERT_EQ(frame.data[size], '\0');
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "AFTER");
+    ASSERT_EQ(framer.oversized_lines, 0);
+    free(payload);
+    
+    // The buffer shrinks back once the frame is handled
+    size_t available;
+    line_framer_prepare(&framer, &available);
+    ASSERT_EQ(framer.capacity, (size_t)LINE_FRAMER_MAX_LINE);
+    
+    line_framer_free(&framer);
+}
+
+TEST(frame_over_limit_is_skipped) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    framer.max_frame = 8;
+    LineFrame frame;
+    
+    feed(&framer, "#10|BIG|s\nline\nline\n\n#4|OK|s\nfits\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "OK");
+    ASSERT_STR_EQ(frame.data, "fits");
+    ASSERT_EQ(framer.oversized_frames, 1);
+    
+    line_framer_free(&framer);
+}
+
+TEST(malformed_frames_are_skipped) {
+    LineFramer framer;
+    line_framer_init(&framer);
+    LineFrame frame;
+    
+    // Bad length, no sender, and a payload without its closing newline
+    feed(&framer, "#x1|T|s\n#2|T|\n#3|T|s\nabcd\nGOOD|s|d\n");
+    ASSERT(line_framer_next(&framer, &frame));
+    ASSERT_STR_EQ(frame.type, "GOOD");
+    ASSERT_EQ(framer.malformed_lines, 3);
+    
+    line_framer_free(&framer);
+}
+
+int main(void) {
+    printf("\n=== Line Framer Unit Tests ===\n\n");
+    
+    run_test_single_line_is_split();
+    run_test_partial_line_waits_for_newline();
+    run_test_data_keeps_extra_separators();
+    run_test_malformed_lines_are_skipped();
+    run_test_oversized_line_is_dropped();
+    run_test_frame_carries_large_multiline_payload();
+    run_test_frame_over_limit_is_skipped();
+    run_test_malformed_frames_are_skipped();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
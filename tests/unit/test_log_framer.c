@@ -0,0 +1,169 @@
+/**
+ * @file test_log_framer.c
+ * @brief Unit tests for per-tool stderr log ingestion
+ */
+
+#include "yuki_frame/log_framer.h"
+#include "yuki_frame/logger.h"
+#include "yuki_frame/framework.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define LOG_PATH "test_log_framer.tmp"
+
+static char log_text[64 * 1024];
+
+// Run text through a framer into a fresh log file and load what was logged
+static void capture(LogFramer* framer, const char* const* chunks, int count, bool close) {
+    logger_init(LOG_PATH, LOG_TRACE);
+    for (int i = 0; i < count; i++) {
+        log_framer_write(framer, "tool", chunks[i], strlen(chunks[i]), 5000);
+    }
+    if (close) {
+        log_framer_flush(framer, "tool");
+    }
+    logger_shutdown();
+    
+    FILE* f = fopen(LOG_PATH, "r");
+    size_t n = f ? fread(log_text, 1, sizeof(log_text) - 1, f) : 0;
+    log_text[n] = '\0';
+    if (f) {
+        fclose(f);
+    }
+    remove(LOG_PATH);
+}
+
+static int count_of(const char* needle) {
+    int count = 0;
+    for (const char* p = strstr(log_text, needle); p; p = strstr(p + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+TEST(parse_level_strips_tag) {
+    const char* text = "[WARN] disk almost full";
+    size_t length = strlen(text);
+    ASSERT_EQ(log_framer_parse_level(&text, &length, LOG_INFO), LOG_WARN);
+    ASSERT_EQ(length, strlen("disk almost full"));
+    ASSERT(memcmp(text, "disk almost full", length) == 0);
+    
+    text = "[ERROR]no space";
+    length = strlen(text);
+    ASSERT_EQ(log_framer_parse_level(&text, &length, LOG_INFO), LOG_ERROR);
+    ASSERT(memcmp(text, "no space", length) == 0);
+}
+
+TEST(parse_level_keeps_untagged_line) {
+    const char* original = "[12:00] not a level";
+    const char* text = original;
+    size_t length = strlen(text);
+    ASSERT_EQ(log_framer_parse_level(&text, &length, LOG_INFO), LOG_INFO);
+    ASSERT(text == original);
+    ASSERT_EQ(length, strlen(original));
+}
+
+TEST(every_line_of_a_chunk_is_logged) {
+    LogFramer framer;
+    log_framer_init(&framer, 0);
+    const char* chunks[] = { "[INFO] one\n[ERROR] two\nthree\r\n\n" };
+    capture(&framer, chunks, 1, false);
+    
+    ASSERT_EQ(count_of("[INFO] [tool] one\n"), 1);
+    ASSERT_EQ(count_of("[ERROR] [tool] two\n"), 1);
+    ASSERT_EQ(count_of("[INFO] [tool] three\n"), 1);
+    ASSERT_EQ(count_of("[tool]"), 3);  // Empty line skipped
+}
+
+TEST(line_split_across_reads_is_joined) {
+    LogFramer framer;
+    log_framer_init(&framer, 0);
+    const char* chunks[] = { "[DEBUG] hel", "lo wor", "ld\ntail" };
+    capture(&framer, chunks, 3, false);
+    ASSERT_EQ(count_of("[DEBUG] [tool] hello world\n"), 1);
+    ASSERT_EQ(count_of("tail"), 0);
+    ASSERT_EQ(framer.partial_length, 4u);
+    
+    // Logged once the pipe closes
+    capture(&framer, NULL, 0, true);
+    ASSERT_EQ(count_of("[INFO] [tool] tail\n"), 1);
+    ASSERT_EQ(framer.partial_length, 0u);
+}
+
+TEST(long_line_is_split) {
+    LogFramer framer;
+    log_framer_init(&framer, 0);
+    static char line[LOG_FRAMER_MAX_LINE * 2 + 100];
+    memset(line, 'x', sizeof(line) - 2);
+    line[sizeof(line) - 2] = '\n';
+    line[sizeof(line) - 1] = '\0';
+    const char* chunks[] = { line };
+    capture(&framer, chunks, 1, false);
+    ASSERT_EQ(count_of("[tool]"), 3);
+}
+
+TEST(rate_cap_suppresses_and_reports) {
+    LogFramer framer;
+    log_framer_init(&framer, 5);
+    const char* chunks[] = { "a\nb\nc\nd\ne\nf\ng\nh\n" };
+    capture(&framer, chunks, 1, true);
+    ASSERT_EQ(count_of("[INFO] [tool]"), 5);
+    ASSERT_EQ(count_of("Suppressed 3 stderr lines"), 1);
+    ASSERT_EQ(framer.suppressed_total, 3u);
+}
+
+int main(void) {
+    printf("\n=== Log Framer Unit Tests ===\n\n");
+    
+    run_test_parse_level_strips_tag();
+    run_test_parse_level_keeps_untagged_line();
+    run_test_every_line_of_a_chunk_is_logged();
+    run_test_line_split_across_reads_is_joined();
+    run_test_long_line_is_split();
+    run_test_rate_cap_suppresses_and_reports();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
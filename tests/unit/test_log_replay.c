@@ -0,0 +1,214 @@
+/**
+ * @file test_log_replay.c
+ * @brief Unit tests for replaying the event log to a tool
+ */
+
+#include "yuki_frame/log_replay.h"
+#include "yuki_frame/event_log.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+
+#define LOG_DIR "test_log_replay.tmp"
+
+static void reset(void) {
+    log_replay_shutdown();
+    event_log_close();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+
+    char path[128];
+    for (int number = 1; number <= 10; number++) {
+        snprintf(path, sizeof(path), LOG_DIR "/events-%08d.log", number);
+        remove(path);
+    }
+    remove(LOG_DIR "/checkpoint");
+    remove(LOG_DIR "/checkpoint.tmp");
+    remove(LOG_DIR);
+}
+
+// A log holding count events, alternating types A and B, and a tool that
+// subscribes to neither
+static void setup(int count) {
+    reset();
+    event_bus_init();
+    tool_registry_init();
+    tool_register("analytics", "cat");
+    event_log_open(LOG_DIR, 1000, 0);
+    log_replay_init();
+
+    char data[16];
+    for (int i = 0; i < count; i++) {
+        snprintf(data, sizeof(data), "n=%d", i);
+        event_publish(i % 2 ? "B" : "A", "src", data);
+    }
+    event_process_queue();
+}
+
+static int inbox_count(void) {
+    return tool_queue_count(tool_find("analytics")->inbox);
+}
+
+TEST(log_replay_parses_options) {
+    LogReplayOptions options;
+    char error[64];
+    ASSERT_EQ(log_replay_parse("", &options, error, sizeof(error)), FW_OK);
+    ASSERT_EQ(options.from_lsn, 0);
+    ASSERT_EQ(options.type_count, 0);
+    ASSERT_EQ(options.rate, 0);
+
+    ASSERT_EQ(log_replay_parse(" --from 42  --types A,B --rate 500", &options,
+                               error, sizeof(error)), FW_OK);
+    ASSERT_EQ(options.from_lsn, 42);
+    ASSERT_EQ(options.from_time_ms, 0);
+    ASSERT_EQ(options.type_count, 2);
+    ASSERT_STR_EQ(options.types[0], "A");
+    ASSERT_STR_EQ(options.types[1], "B");
+    ASSERT_EQ(options.rate, 500);
+
+    uint64_t now = event_log_time_ms();
+    ASSERT_EQ(log_replay_parse("--from -5m", &options, error, sizeof(error)), FW_OK);
+    ASSERT(options.from_time_ms <= now - 5 * 60 * 1000 + 1000);
+    ASSERT(options.from_time_ms >= now - 5 * 60 * 1000 - 1000);
+    ASSERT_EQ(log_replay_parse("--from 2026-01-22T08:30", &options, error, sizeof(error)), FW_OK);
+    ASSERT(options.from_time_ms > 0);
+    uint64_t minute = options.from_time_ms;
+    ASSERT_EQ(log_replay_parse("--from 2026-01-22T08:30:15", &options, error, sizeof(error)), FW_OK);
+    ASSERT_EQ(options.from_time_ms, minute + 15000);
+
+    ASSERT_EQ(log_replay_parse("--from yesterday", &options, error, sizeof(error)),
+              FW_ERROR_PARSE_FAILED);
+    ASSERT_EQ(log_replay_parse("--from -5w", &options, error, sizeof(error)),
+              FW_ERROR_PARSE_FAILED);
+    ASSERT_EQ(log_replay_parse("--rate", &options, error, sizeof(error)), FW_ERROR_PARSE_FAILED);
+    ASSERT_EQ(log_replay_parse("--speed 2", &options, error, sizeof(error)),
+              FW_ERROR_PARSE_FAILED);
+    ASSERT_STR_EQ(error, "Unknown option '--speed'");
+}
+
+TEST(log_replay_sends_selected_types_to_one_tool) {
+    setup(20);
+    ASSERT_EQ(inbox_count(), 0);
+
+    LogReplayOptions options;
+    ASSERT_EQ(log_replay_parse("--from 5 --types A", &options, NULL, 0), FW_OK);
+    ASSERT_EQ(log_replay_start("analytics", &options), FW_OK);
+    ASSERT_EQ(log_replay_start("nobody", &options), FW_ERROR_NOT_FOUND);
+
+    // Live events published after the start are not part of the replay
+    event_publish("A", "src", "live");
+    event_process_queue();
+
+    ASSERT_EQ(log_replay_run(), -1);   // Done in one pass
+    ToolQueue* inbox = tool_find("analytics")->inbox;
+    ASSERT_EQ(tool_queue_count(inbox), 8);   // LSNs 5, 7, ... 19
+    ASSERT_EQ(tool_queue_lane_count(inbox, EVENT_PRIORITY_LOW), 8);
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "A|src|n=4\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 7), "A|src|n=18\n");
+
+    LogReplayStatus status[LOG_REPLAY_MAX];
+    ASSERT_EQ(log_replay_list(status, LOG_REPLAY_MAX), 0);
+    reset();
+}
+
+TEST(log_replay_keeps_to_its_rate) {
+    setup(20);
+    LogReplayOptions options;
+    ASSERT_EQ(log_replay_parse("--rate 10", &options, NULL, 0), FW_OK);
+    ASSERT_EQ(log_replay_start("analytics", &options), FW_OK);
+
+    // The first event at once, the next a tenth of a second later
+    int wait_ms = log_replay_run();
+    ASSERT_EQ(inbox_count(), 1);
+    ASSERT(wait_ms > 50 && wait_ms <= 101);
+    ASSERT(log_replay_run() <= wait_ms);
+    ASSERT_EQ(inbox_count(), 1);
+
+    LogReplayStatus status[LOG_REPLAY_MAX];
+    ASSERT_EQ(log_replay_list(status, LOG_REPLAY_MAX), 1);
+    ASSERT_STR_EQ(status[0].tool, "analytics");
+    ASSERT_EQ(status[0].sent, 1);
+    ASSERT_EQ(status[0].until_lsn, 20);
+
+    ASSERT_EQ(log_replay_stop("analytics"), FW_OK);
+    ASSERT_EQ(log_replay_stop("analytics"), FW_ERROR_NOT_FOUND);
+    ASSERT_EQ(log_replay_run(), -1);
+    reset();
+}
+
+TEST(log_replay_leaves_half_the_inbox_free) {
+    setup(300);
+    ASSERT_EQ(tool_set_queue_config("analytics", 100, QUEUE_POLICY_DROP_OLDEST, 10), FW_OK);
+    LogReplayOptions options;
+    memset(&options, 0, sizeof(options));
+    ASSERT_EQ(log_replay_start("analytics", &options), FW_OK);
+
+    ASSERT_EQ(log_replay_run(), 0);
+    ASSERT_EQ(inbox_count(), 50);
+    ASSERT_EQ(log_replay_run(), LOG_REPLAY_RETRY_MS);   // Waits for the tool
+    ASSERT_EQ(inbox_count(), 50);
+
+    // Once the tool has read them, the replay goes on where it stopped
+    ToolQueue* inbox = tool_find("analytics")->inbox;
+    tool_queue_clear(inbox);
+    log_replay_run();
+    ASSERT_EQ(inbox_count(), 50);
+    ASSERT_STR_EQ(tool_queue_peek_at(inbox, 0), "A|src|n=50\n");
+    reset();
+}
+
+int main(void) {
+    printf("\n=== Log Replay Unit Tests ===\n\n");
+
+    run_test_log_replay_parses_options();
+    run_test_log_replay_sends_selected_types_to_one_tool();
+    run_test_log_replay_keeps_to_its_rate();
+    run_test_log_replay_leaves_half_the_inbox_free();
+    reset();
+
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+/**
+ * @file test_request.c
+ * @brief Unit tests for request/reply routing
+ */
+
+#include "yuki_frame/request.h"
+#include "yuki_frame/event.h"
+#include "yuki_frame/framework.h"
+#include "yuki_frame/tool.h"
+#include "yuki_frame/tool_queue.h"
+#include "yuki_frame/platform.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+
+static void reset(void) {
+    request_shutdown();
+    tool_registry_shutdown();
+    event_bus_shutdown();
+}
+
+// A client, two database tools answering DB.QUERY and a logger that
+// subscribes to everything; all running
+static void setup(int timeout_ms) {
+    reset();
+    event_bus_init();
+    tool_registry_init();
+    request_init(timeout_ms);
+    const char* names[] = { "client", "db1", "db2", "logger" };
+    for (int i = 0; i < 4; i++) {
+        tool_register(names[i], "cat");
+        tool_find(names[i])->status = TOOL_RUNNING;
+    }
+    tool_subscribe("db1", "DB.QUERY");
+    tool_subscribe("db2", "DB.*");
+    tool_subscribe("logger", "*");
+}
+
+static int inbox_count(const char* name) {
+    return tool_queue_count(tool_find(name)->inbox);
+}
+
+// The core's reference for the request at the head of a responder's inbox
+static uint64_t take_ref(const char* name) {
+    ToolQueue* inbox = tool_find(name)->inbox;
+    uint64_t ref = 0;
+    if (tool_queue_count(inbox) > 0) {
+        sscanf(tool_queue_peek_at(inbox, 0), "REQUEST|client|%" SCNu64 "|", &ref);
+        tool_queue_remove(inbox);
+    }
+    return ref;
+}
+
+TEST(request_parse_splits_fields) {
+    char id[REQUEST_MAX_ID];
+    char type[MAX_EVENT_TYPE];
+    const char* payload;
+    ASSERT(request_parse("q1|DB.QUERY|select a|b", id, type, &payload));
+    ASSERT_STR_EQ(id, "q1");
+    ASSERT_STR_EQ(type, "DB.QUERY");
+    ASSERT_STR_EQ(payload, "select a|b");
+    ASSERT(request_parse("q2|PING", id, type, &payload));
+    ASSERT_STR_EQ(payload, "");
+
+    ASSERT(!request_parse("q3", id, type, &payload));
+    ASSERT(!request_parse("|PING|x", id, type, &payload));
+    ASSERT(!request_parse("q4||x", id, type, &payload));
+    ASSERT(!request_parse("q5|DB.*|x", id, type, &payload));
+}
+
+TEST(request_goes_to_one_responder_in_turn) {
+    setup(1000);
+    Tool* client = tool_find("client");
+    ASSERT_EQ(request_send(client, "q1|DB.QUERY|select 1", EVENT_PRIORITY_NORMAL), FW_OK);
+    ASSERT_EQ(request_send(client, "q2|DB.QUERY|select 2", EVENT_PRIORITY_HIGH), FW_OK);
+
+    // One each, never to the logger or back to the client
+    ASSERT_EQ(inbox_count("db1"), 1);
+    ASSERT_EQ(inbox_count("db2"), 1);
+    ASSERT_EQ(inbox_count("logger"), 0);
+    ASSERT_EQ(inbox_count("client"), 0);
+
+    // The responder sees the core's reference, not the client's id
+    const char* forwarded = tool_queue_peek_at(tool_find("db1")->inbox, 0);
+    ASSERT(strncmp(forwarded, "REQUEST|client|", 15) == 0);
+    ASSERT(strstr(forwarded, "|DB.QUERY|select ") != NULL);
+    ASSERT(strstr(forwarded, "|q1|") == NULL && strstr(forwarded, "|q2|") == NULL);
+
+    // A stopped responder is passed over
+    take_ref("db1");
+    take_ref("db2");
+    tool_find("db2")->status = TOOL_STOPPED;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(request_send(client, "q3|DB.QUERY|", EVENT_PRIORITY_NORMAL), FW_OK);
+    }
+    ASSERT_EQ(inbox_count("db1"), 3);
+    ASSERT_EQ(inbox_count("db2"), 0);
+
+    RequestStats stats;
+    request_get_stats(&stats);
+    ASSERT_EQ(stats.sent, 5);
+    ASSERT_EQ(stats.pending, 5);
+    reset();
+}
+
+TEST(request_reply_goes_only_to_requester) {
+    setup(1000);
+    Tool* client = tool_find("client");
+    Tool* db1 = tool_find("db1");
+    tool_find("db2")->status = TOOL_STOPPED;
+    ASSERT_EQ(request_send(client, "q1|DB.QUERY|select 1", EVENT_PRIORITY_NORMAL), FW_OK);
+    uint64_t ref = take_ref("db1");
+    ASSERT(ref != 0);
+
+    char reply[64];
+    snprintf(reply, sizeof(reply), "%" PRIu64 "|rows=1", ref);
+    // Only the tool it was sent to can answer it
+    ASSERT_EQ(request_reply(tool_find("db2"), reply, false, EVENT_PRIORITY_NORMAL),
+              FW_ERROR_NOT_FOUND);
+    ASSERT_EQ(request_reply(db1, reply, false, EVENT_PRIORITY_NORMAL), FW_OK);
+    ASSERT_EQ(inbox_count("client"), 1);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 0), "REPLY|db1|q1|rows=1\n");
+    ASSERT_EQ(inbox_count("logger"), 0);
+
+    // Answered once
+    ASSERT_EQ(request_reply(db1, reply, false, EVENT_PRIORITY_NORMAL), FW_ERROR_NOT_FOUND);
+    ASSERT_EQ(request_reply(db1, "bogus", false, EVENT_PRIORITY_NORMAL), FW_ERROR_NOT_FOUND);
+
+    // Errors from the responder come back as REPLY_ERROR
+    ASSERT_EQ(request_send(client, "q2|DB.QUERY|drop", EVENT_PRIORITY_NORMAL), FW_OK);
+    snprintf(reply, sizeof(reply), "%" PRIu64 "|denied", take_ref("db1"));
+    ASSERT_EQ(request_reply(db1, reply, true, EVENT_PRIORITY_NORMAL), FW_OK);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 1), "REPLY_ERROR|db1|q2|denied\n");
+
+    RequestStats stats;
+    request_get_stats(&stats);
+    ASSERT_EQ(stats.replied, 2);
+    ASSERT_EQ(stats.late, 3);
+    ASSERT_EQ(stats.pending, 0);
+    reset();
+}
+
+TEST(request_fails_without_responder) {
+    setup(1000);
+    Tool* client = tool_find("client");
+    ASSERT_EQ(request_send(client, "q1|CACHE.GET|key", EVENT_PRIORITY_NORMAL), FW_ERROR_NOT_FOUND);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 0),
+                  "REPLY_ERROR|framework|q1|no responder\n");
+    ASSERT_EQ(inbox_count("logger"), 0);
+
+    ASSERT_EQ(request_send(client, "q2", EVENT_PRIORITY_NORMAL), FW_ERROR_INVALID_ARG);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 1),
+                  "REPLY_ERROR|framework|q2|malformed request\n");
+
+    RequestStats stats;
+    request_get_stats(&stats);
+    ASSERT_EQ(stats.failed, 2);
+    ASSERT_EQ(stats.sent, 0);
+    reset();
+}
+
+TEST(request_times_out_with_error_reply) {
+    setup(20);
+    Tool* client = tool_find("client");
+    ASSERT_EQ(request_run(), -1);
+    ASSERT_EQ(request_send(client, "q1|DB.QUERY|slow", EVENT_PRIORITY_NORMAL), FW_OK);
+    uint64_t ref = take_ref("db1");
+    if (!ref) {
+        ref = take_ref("db2");
+    }
+    int wait_ms = request_run();
+    ASSERT(wait_ms >= 0 && wait_ms <= 20);
+    ASSERT_EQ(inbox_count("client"), 0);
+
+    platform_sleep_ms(30);
+    ASSERT_EQ(request_run(), -1);
+    ASSERT_EQ(inbox_count("client"), 1);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 0), "REPLY_ERROR|framework|q1|timeout\n");
+
+    // The answer arrives too late and goes nowhere
+    char reply[64];
+    snprintf(reply, sizeof(reply), "%" PRIu64 "|rows=1", ref);
+    ASSERT_EQ(request_reply(tool_find("db1"), reply, false, EVENT_PRIORITY_NORMAL),
+              FW_ERROR_NOT_FOUND);
+    ASSERT_EQ(inbox_count("client"), 1);
+
+    RequestStats stats;
+    request_get_stats(&stats);
+    ASSERT_EQ(stats.timed_out, 1);
+    ASSERT_EQ(stats.pending, 0);
+    reset();
+}
+
+TEST(request_dropped_with_unregistered_tool) {
+    setup(1000);
+    Tool* client = tool_find("client");
+    tool_find("db2")->status = TOOL_STOPPED;
+    ASSERT_EQ(request_send(client, "q1|DB.QUERY|select 1", EVENT_PRIORITY_NORMAL), FW_OK);
+    ASSERT_EQ(request_send(client, "q2|DB.QUERY|select 2", EVENT_PRIORITY_NORMAL), FW_OK);
+
+    // The client waiting on db1 hears at once that it is gone
+    ASSERT_EQ(tool_unregister("db1"), FW_OK);
+    ASSERT_EQ(inbox_count("client"), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 0),
+                  "REPLY_ERROR|framework|q1|responder gone\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(client->inbox, 1),
+                  "REPLY_ERROR|framework|q2|responder gone\n");
+
+    // A gone requester's requests are dropped without an answer
+    tool_find("db2")->status = TOOL_RUNNING;
+    ASSERT_EQ(request_send(client, "q3|DB.QUERY|select 3", EVENT_PRIORITY_NORMAL), FW_OK);
+    ASSERT_EQ(inbox_count("db2"), 1);
+    ASSERT_EQ(tool_unregister("client"), FW_OK);
+    ASSERT_EQ(inbox_count("db2"), 1);
+
+    RequestStats stats;
+    request_get_stats(&stats);
+    ASSERT_EQ(stats.pending, 0);
+    ASSERT_EQ(stats.failed, 2);
+    ASSERT_EQ(request_run(), -1);
+    reset();
+}
+
+int main(void) {
+    printf("\n=== Request/Reply Unit Tests ===\n\n");
+
+    run_test_request_parse_splits_fields();
+    run_test_request_goes_to_one_responder_in_turn();
+    run_test_request_reply_goes_only_to_requester();
+    run_test_request_fails_without_responder();
+    run_test_request_times_out_with_error_reply();
+    run_test_request_dropped_with_unregistered_tool();
+    reset();
+
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return tests_failed == 0 ? 0 : 1;
+}
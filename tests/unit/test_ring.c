@@ -0,0 +1,200 @@
+/**
+ * @file test_ring.c
+ * @brief Unit tests for the lock-free handoff ring
+ */
+
+#include "yuki_frame/ring.h"
+#include "yuki_frame/platform.h"
+#include "yuki_frame/framework.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 20000
+
+typedef struct {
+    Ring* ring;
+    int producer;
+} ProducerArgs;
+
+// Push (producer, sequence) pairs encoded as non-NULL pointers
+static void producer_main(void* arg) {
+    ProducerArgs* args = (ProducerArgs*)arg;
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        uintptr_t value = ((uintptr_t)args->producer << 24) | (uintptr_t)(i + 1);
+        while (!ring_push(args->ring, (void*)value)) {
+            platform_sleep_ms(0);
+        }
+    }
+}
+
+// Tests
+TEST(ring_rounds_capacity_up) {
+    Ring* ring = ring_create(5);
+    ASSERT_NOT_NULL(ring);
+    ASSERT_EQ(ring->mask, (size_t)7);
+    ring_destroy(ring);
+}
+
+TEST(ring_pops_in_push_order) {
+    Ring* ring = ring_create(8);
+    int items[3] = {1, 2, 3};
+    
+    ASSERT(ring_is_empty(ring));
+    ASSERT_NULL(ring_pop(ring));
+    for (int i = 0; i < 3; i++) {
+        ASSERT(ring_push(ring, &items[i]));
+    }
+    ASSERT(!ring_is_empty(ring));
+    for (int i = 0; i < 3; i++) {
+        ASSERT(ring_pop(ring) == &items[i]);
+    }
+    ASSERT(ring_is_empty(ring));
+    
+    ring_destroy(ring);
+}
+
+TEST(ring_rejects_push_when_full) {
+    Ring* ring = ring_create(4);
+    int items[5];
+    
+    for (int i = 0; i < 4; i++) {
+        ASSERT(ring_push(ring, &items[i]));
+    }
+    ASSERT(!ring_push(ring, &items[4]));
+    
+    // A slot frees up once the consumer catches up, across the wrap
+    ASSERT(ring_pop(ring) == &items[0]);
+    ASSERT(ring_push(ring, &items[4]));
+    for (int i = 1; i < 5; i++) {
+        ASSERT(ring_pop(ring) == &items[i]);
+    }
+    ASSERT_NULL(ring_pop(ring));
+    
+    ring_destroy(ring);
+}
+
+TEST(ring_keeps_per_producer_order_across_threads) {
+    Ring* ring = ring_create(1024);
+    PlatformThread threads[PRODUCERS];
+    ProducerArgs args[PRODUCERS];
+    int next[PRODUCERS];
+    
+    for (int p = 0; p < PRODUCERS; p++) {
+        args[p].ring = ring;
+        args[p].producer = p;
+        next[p] = 1;
+        ASSERT_EQ(platform_thread_create(&threads[p], producer_main, &args[p]), FW_OK);
+    }
+    
+    int received = 0;
+    bool ordered = true;
+    while (received < PRODUCERS * ITEMS_PER_PRODUCER) {
+        void* item = ring_pop(ring);
+        if (!item) {
+            continue;
+        }
+        uintptr_t value = (uintptr_t)item;
+        int producer = (int)(value >> 24);
+        int sequence = (int)(value & 0xFFFFFF);
+        if (producer >= PRODUCERS || sequence != next[producer]) {
+            ordered = false;
+        } else {
+            next[producer]++;
+        }
+        received++;
+    }
+    
+    for (int p = 0; p < PRODUCERS; p++) {
+        platform_thread_join(threads[p]);
+    }
+    ASSERT(ordered);
+    ASSERT(ring_is_empty(ring));
+    
+    ring_destroy(ring);
+}
+
+TEST(ring_push_batch_is_all_or_nothing) {
+    Ring* ring = ring_create(8);
+    void* items[6];
+    for (int i = 0; i < 6; i++) {
+        items[i] = (void*)(uintptr_t)(i + 1);
+    }
+    
+    ASSERT(ring_push(ring, (void*)(uintptr_t)100));
+    ASSERT(ring_push_batch(ring, items, 6));
+    ASSERT(!ring_push_batch(ring, items, 2));   // One cell left
+    ASSERT(ring_push_batch(ring, items, 1));
+    
+    ASSERT_EQ((uintptr_t)ring_pop(ring), (uintptr_t)100);
+    for (int i = 0; i < 6; i++) {
+        ASSERT_EQ((uintptr_t)ring_pop(ring), (uintptr_t)(i + 1));
+    }
+    ASSERT_EQ((uintptr_t)ring_pop(ring), (uintptr_t)1);
+    ASSERT(ring_is_empty(ring));
+    
+    // Wraps around the end of the cell array
+    ASSERT(ring_push_batch(ring, items, 6));
+    for (int i = 0; i < 6; i++) {
+        ASSERT_EQ((uintptr_t)ring_pop(ring), (uintptr_t)(i + 1));
+    }
+    
+    ring_destroy(ring);
+}
+
+int main(void) {
+    printf("\n=== Ring Unit Tests ===\n\n");
+    
+    run_test_ring_rounds_capacity_up();
+    run_test_ring_pops_in_push_order();
+    run_test_ring_rejects_push_when_full();
+    run_test_ring_keeps_per_producer_order_across_threads();
+    run_test_ring_push_batch_is_all_or_nothing();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file test_slab.c
+ * @brief Unit tests for the size-class slab allocator
+ */
+
+#include "yuki_frame/slab.h"
+#include "yuki_frame/framework.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+// Tests
+TEST(slab_recycles_blocks_of_a_class) {
+    SlabPool pool;
+    slab_pool_init(&pool);
+    
+    void* first = slab_alloc(&pool, 40);
+    ASSERT_NOT_NULL(first);
+    ASSERT_EQ(pool.reserved, (size_t)SLAB_SIZE);
+    ASSERT_EQ(pool.in_use, (size_t)64);     // Rounded up to its class
+    
+    slab_free(&pool, first, 40);
+    ASSERT_EQ(pool.in_use, (size_t)0);
+    // Any size in the same class gets the block back, from the same slab
+    ASSERT(slab_alloc(&pool, 64) == first);
+    ASSERT_EQ(pool.reserved, (size_t)SLAB_SIZE);
+    
+    slab_pool_destroy(&pool);
+    ASSERT_EQ(pool.reserved, (size_t)0);
+}
+
+TEST(slab_blocks_are_aligned_and_distinct) {
+    SlabPool pool;
+    slab_pool_init(&pool);
+    
+    // Enough 4 KB blocks to need several slabs
+    enum { COUNT = 40 };
+    char* blocks[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        blocks[i] = (char*)slab_alloc(&pool, SLAB_MAX_BLOCK);
+        ASSERT_NOT_NULL(blocks[i]);
+        ASSERT_EQ((uintptr_t)blocks[i] % 16, (uintptr_t)0);
+        memset(blocks[i], i, SLAB_MAX_BLOCK);
+    }
+    for (int i = 0; i < COUNT; i++) {
+        ASSERT_EQ(blocks[i][0], (char)i);
+        ASSERT_EQ(blocks[i][SLAB_MAX_BLOCK - 1], (char)i);
+    }
+    ASSERT(pool.reserved > (size_t)SLAB_SIZE);
+    ASSERT_EQ(pool.in_use, (size_t)COUNT * SLAB_MAX_BLOCK);
+    
+    for (int i = 0; i < COUNT; i++) {
+        slab_free(&pool, blocks[i], SLAB_MAX_BLOCK);
+    }
+    ASSERT_EQ(pool.in_use, (size_t)0);
+    slab_pool_destroy(&pool);
+}
+
+TEST(slab_sends_large_blocks_to_malloc) {
+    SlabPool pool;
+    slab_pool_init(&pool);
+    
+    size_t size = SLAB_MAX_BLOCK + 1;
+    char* block = (char*)slab_alloc(&pool, size);
+    ASSERT_NOT_NULL(block);
+    ASSERT_EQ(pool.reserved, size);
+    ASSERT_EQ(pool.in_use, size);
+    ASSERT_NULL(pool.slabs);
+    memset(block, 'x', size);
+    
+    slab_free(&pool, block, size);
+    ASSERT_EQ(pool.reserved, (size_t)0);
+    ASSERT_EQ(pool.in_use, (size_t)0);
+    slab_pool_destroy(&pool);
+}
+
+TEST(slab_reclaims_remote_frees) {
+    SlabPool pool;
+    slab_pool_init(&pool);
+    
+    void* small = slab_alloc(&pool, 100);
+    void* large = slab_alloc(&pool, SLAB_MAX_BLOCK * 2);
+    slab_free_remote(&pool, small, 100);
+    slab_free_remote(&pool, large, SLAB_MAX_BLOCK * 2);
+    ASSERT_EQ(pool.in_use, (size_t)128 + SLAB_MAX_BLOCK * 2);  // Until the owner reclaims
+    
+    // The owner's next allocation takes them back
+    ASSERT(slab_alloc(&pool, 100) == small);
+    ASSERT_EQ(pool.in_use, (size_t)128);
+    ASSERT_EQ(pool.reserved, (size_t)SLAB_SIZE);
+    
+    slab_pool_destroy(&pool);
+}
+
+int main(void) {
+    printf("\n=== Slab Unit Tests ===\n\n");
+    
+    run_test_slab_recycles_blocks_of_a_class();
+    run_test_slab_blocks_are_aligned_and_distinct();
+    run_test_slab_sends_large_blocks_to_malloc();
+    run_test_slab_reclaims_remote_frees();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_timer_wheel.c
+ * @brief Unit tests for the hierarchical timer wheel
+ */
+
+#include "yuki_frame/timer_wheel.h"
+#include "yuki_frame/framework.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Global state (required by framework modules)
+FrameworkConfig g_config;
+bool g_running = true;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) \
+    static void test_##name(void); \
+    static void run_test_##name(void) { \
+        printf("  Running: %s ... ", #name); \
+        tests_run++; \
+        test_##name(); \
+        tests_passed++; \
+        printf("PASS\n"); \
+    } \
+    static void test_##name(void)
+
+#define ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+                   #condition, __FILE__, __LINE__); \
+            tests_failed++; \
+            tests_passed--; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_STR_EQ(a, b) ASSERT(strcmp((a), (b)) == 0)
+#define ASSERT_NULL(ptr) ASSERT((ptr) == NULL)
+#define ASSERT_NOT_NULL(ptr) ASSERT((ptr) != NULL)
+
+// Records when each timer fired (in the wheel's time)
+typedef struct {
+    int fired;
+    uint64_t fired_at;
+    uint64_t* clock;
+} Probe;
+
+static void on_probe(Timer* timer, void* arg) {
+    (void)timer;
+    Probe* probe = (Probe*)arg;
+    probe->fired++;
+    probe->fired_at = *probe->clock;
+}
+
+// Advance the wheel in steps of step_ms until `until`
+static void run_until(TimerWheel* wheel, uint64_t* clock, uint64_t until, uint64_t step_ms) {
+    while (*clock < until) {
+        *clock += step_ms;
+        timer_wheel_advance(wheel, *clock);
+    }
+}
+
+// Tests
+TEST(timer_fires_at_deadline_not_before) {
+    TimerWheel wheel;
+    uint64_t clock = 1000;
+    timer_wheel_init(&wheel, clock);
+    Probe probe = {0, 0, &clock};
+    Timer timer;
+    timer_init(&timer, on_probe, &probe);
+    
+    timer_wheel_arm(&wheel, &timer, clock + 250);
+    ASSERT(timer_is_armed(&timer));
+    run_until(&wheel, &clock, 1240, TIMER_TICK_MS);
+    ASSERT_EQ(probe.fired, 0);
+    run_until(&wheel, &clock, 1300, TIMER_TICK_MS);
+    ASSERT_EQ(probe.fired, 1);
+    ASSERT_EQ(probe.fired_at, (uint64_t)1250);
+    ASSERT(!timer_is_armed(&timer));
+}
+
+TEST(cancelled_timer_does_not_fire) {
+    TimerWheel wheel;
+    uint64_t clock = 0;
+    timer_wheel_init(&wheel, clock);
+    Probe probe = {0, 0, &clock};
+    Timer timer;
+    timer_init(&timer, on_probe, &probe);
+    
+    timer_wheel_arm(&wheel, &timer, 100);
+    timer_wheel_cancel(&wheel, &timer);
+    timer_wheel_cancel(&wheel, &timer);  // Harmless when not armed
+    run_until(&wheel, &clock, 500, TIMER_TICK_MS);
+    ASSERT_EQ(probe.fired, 0);
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, clock), -1);
+}
+
+TEST(far_timers_cascade_to_their_deadline) {
+    TimerWheel wheel;
+    uint64_t clock = 5;
+    timer_wheel_init(&wheel, clock);
+    
+    // One per level, plus one beyond the whole wheel
+    uint64_t deadlines[] = {300, 30000, 2000000, 90000000, 200000000000ULL};
+    int count = (int)(sizeof(deadlines) / sizeof(deadlines[0]));
+    Probe probes[5];
+    Timer timers[5];
+    for (int i = 0; i < count; i++) {
+        probes[i].fired = 0;
+        probes[i].fired_at = 0;
+        probes[i].clock = &clock;
+        timer_init(&timers[i], on_probe, &probes[i]);
+        timer_wheel_arm(&wheel, &timers[i], deadlines[i]);
+    }
+    
+    // Jump from deadline to deadline as the main loop would
+    while (clock < deadlines[count - 1]) {
+        int timeout = timer_wheel_next_timeout(&wheel, clock);
+        ASSERT(timeout >= 0);
+        clock += (uint64_t)timeout;
+        timer_wheel_advance(&wheel, clock);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(probes[i].fired, 1);
+        ASSERT_EQ(probes[i].fired_at, deadlines[i]);
+    }
+}
+
+TEST(next_timeout_tracks_earliest_deadline) {
+    TimerWheel wheel;
+    uint64_t clock = 0;
+    timer_wheel_init(&wheel, clock);
+    Probe probe = {0, 0, &clock};
+    Timer near_timer, far_timer;
+    timer_init(&near_timer, on_probe, &probe);
+    timer_init(&far_timer, on_probe, &probe);
+    
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, clock), -1);
+    timer_wheel_arm(&wheel, &far_timer, 400);
+    timer_wheel_arm(&wheel, &near_timer, 120);
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, clock), 120);
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, 115), 5);
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, 130), 0);
+    
+    // Re-arming moves the deadline
+    timer_wheel_arm(&wheel, &near_timer, 500);
+    ASSERT_EQ(timer_wheel_next_timeout(&wheel, clock), 400);
+}
+
+// Re-arms itself from its own callback a fixed number of times
+typedef struct {
+    TimerWheel* wheel;
+    uint64_t* clock;
+    int remaining;
+} Repeater;
+
+static void on_repeat(Timer* timer, void* arg) {
+    Repeater* repeater = (Repeater*)arg;
+    if (--repeater->remaining > 0) {
+        timer_wheel_arm(repeater->wheel, timer, *repeater->clock + 100);
+    }
+}
+
+TEST(callback_can_rearm_its_timer) {
+    TimerWheel wheel;
+    uint64_t clock = 0;
+    timer_wheel_init(&wheel, clock);
+    Repeater repeater = {&wheel, &clock, 5};
+    Timer timer;
+    timer_init(&timer, on_repeat, &repeater);
+    
+    timer_wheel_arm(&wheel, &timer, 100);
+    run_until(&wheel, &clock, 2000, 30);
+    ASSERT_EQ(repeater.remaining, 0);
+    ASSERT(!timer_is_armed(&timer));
+}
+
+int main(void) {
+    printf("\n=== Timer Wheel Unit Tests ===\n\n");
+    
+    run_test_timer_fires_at_deadline_not_before();
+    run_test_cancelled_timer_does_not_fire();
+    run_test_far_timers_cascade_to_their_deadline();
+    run_test_next_timeout_tracks_earliest_deadline();
+    run_test_callback_can_rearm_its_timer();
+    
+    printf("\n=== Test Summary ===\n");
+    printf("  Total:  %d\n", tests_run);
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("\n");
+    
+    return tests_failed == 0 ? 0 : 1;
+}
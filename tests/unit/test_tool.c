@@ -5,6 +5,7 @@
 
 #include "yuki_frame/tool.h"
 #include "yuki_frame/framework.h"
+#include "yuki_frame/platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -155,6 +156,25 @@ TEST(tool_subscribe_nonexistent_tool_fails) {
     tool_registry_shutdown();
 }
 
+TEST(tool_subscribe_too_long_type_fails) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "echo test");
+    char type[MAX_EVENT_TYPE + 16];
+    memset(type, 'A', MAX_EVENT_TYPE);
+    type[MAX_EVENT_TYPE] = '\0';
+    ASSERT_EQ(tool_subscribe("test_tool", type), FW_ERROR_PARSE_FAILED);
+    strcat(type, "[zone=1]");
+    ASSERT_EQ(tool_subscribe("test_tool", type), FW_ERROR_PARSE_FAILED);
+    
+    // The longest type that fits is kept whole
+    type[MAX_EVENT_TYPE - 1] = '\0';
+    ASSERT_EQ(tool_subscribe("test_tool", type), FW_OK);
+    ASSERT_EQ(tool_find("test_tool")->subscription_count, 1);
+    
+    tool_registry_shutdown();
+}
+
 TEST(tool_is_running_stopped_tool) {
     tool_registry_init();
     
@@ -175,6 +195,274 @@ TEST(tool_is_running_nonexistent_tool) {
     tool_registry_shutdown();
 }
 
+TEST(tool_set_queue_config_clamps_batch_size) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "echo test");
+    ASSERT_EQ(tool_set_queue_config("test_tool", 10, QUEUE_POLICY_DROP_NEWEST, 100000), FW_OK);
+    
+    Tool* tool = tool_find("test_tool");
+    ASSERT_EQ(tool->max_batch_size, TOOL_MAX_BATCH_SIZE);
+    ASSERT_EQ(tool_queue_capacity(tool->inbox), 10);
+    ASSERT_EQ(tool->inbox->policy, QUEUE_POLICY_DROP_NEWEST);
+    
+    tool_registry_shutdown();
+}
+
+TEST(tool_queue_drop_oldest_keeps_partial_head) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 2, QUEUE_POLICY_DROP_OLDEST), FW_OK);
+    
+    tool_queue_add(queue, "A|s|1\n");
+    tool_queue_add(queue, "B|s|2\n");
+    queue->head_offset = 2;  // "A|" already written to the pipe
+    tool_queue_add(queue, "C|s|3\n");
+    
+    ASSERT_EQ(tool_queue_count(queue), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "A|s|1\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "C|s|3\n");
+    ASSERT_EQ(queue->head_offset, 2);
+    
+    tool_queue_remove(queue);
+    ASSERT_EQ(queue->head_offset, 0);
+    
+    tool_queue_shutdown(queue);
+}
+
+TEST(tool_queue_byte_budget_applies_policy) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 100, QUEUE_POLICY_DROP_OLDEST), FW_OK);
+    tool_queue_set_max_bytes(queue, 16);
+    
+    tool_queue_add(queue, "A|s|1\n");
+    tool_queue_add(queue, "B|s|2\n");
+    ASSERT_EQ(tool_queue_bytes(queue), 12);
+    tool_queue_add(queue, "C|s|3\n");      // 18 bytes: A is dropped
+    ASSERT_EQ(tool_queue_count(queue), 2);
+    ASSERT_STR_EQ(tool_queue_peek(queue), "B|s|2\n");
+    ASSERT_EQ(tool_queue_dropped(queue), 1);
+    
+    // Larger than the whole budget: it empties the queue but is kept
+    tool_queue_add(queue, "BIG|s|0123456789\n");
+    ASSERT_EQ(tool_queue_count(queue), 1);
+    ASSERT_EQ(tool_queue_bytes(queue), 17);
+    
+    queue->policy = QUEUE_POLICY_DROP_NEWEST;
+    ASSERT_EQ(tool_queue_add(queue, "D|s|4\n"), FW_ERROR_QUEUE_FULL);
+    tool_queue_remove(queue);
+    ASSERT_EQ(tool_queue_bytes(queue), 0);
+    
+    tool_queue_shutdown(queue);
+}
+
+static void add_with_priority(ToolQueue* queue, const char* line, EventPriority priority) {
+    EventBuffer* buffer = event_buffer_create(line, strlen(line));
+    buffer->priority = priority;
+    tool_queue_add_buffer(queue, buffer);
+}
+
+TEST(tool_queue_delivers_urgent_lanes_first) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 10, QUEUE_POLICY_DROP_OLDEST), FW_OK);
+    
+    add_with_priority(queue, "A|s|1\n", EVENT_PRIORITY_NORMAL);
+    add_with_priority(queue, "L|s|2\n", EVENT_PRIORITY_LOW);
+    add_with_priority(queue, "B|s|3\n", EVENT_PRIORITY_NORMAL);
+    add_with_priority(queue, "H|s|4\n", EVENT_PRIORITY_HIGH);
+    ASSERT_EQ(tool_queue_lane_count(queue, EVENT_PRIORITY_NORMAL), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "H|s|4\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "A|s|1\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 2), "B|s|3\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 3), "L|s|2\n");
+    ASSERT_NULL(tool_queue_peek_at(queue, 4));
+    
+    // A half written head is finished before a newly arrived urgent event
+    tool_queue_remove(queue);
+    queue->head_offset = 2;
+    add_with_priority(queue, "H2|s|5\n", EVENT_PRIORITY_HIGH);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "A|s|1\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "H2|s|5\n");
+    tool_queue_remove(queue);
+    ASSERT_STR_EQ(tool_queue_peek(queue), "H2|s|5\n");
+    ASSERT_EQ(tool_queue_count(queue), 3);
+    
+    tool_queue_shutdown(queue);
+}
+
+TEST(tool_queue_full_sheds_lower_priority_first) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 2, QUEUE_POLICY_DROP_NEWEST), FW_OK);
+    
+    add_with_priority(queue, "L1|s|1\n", EVENT_PRIORITY_LOW);
+    add_with_priority(queue, "L2|s|2\n", EVENT_PRIORITY_LOW);
+    // Whatever the policy, an urgent event displaces the oldest low one
+    add_with_priority(queue, "H|s|3\n", EVENT_PRIORITY_HIGH);
+    ASSERT_EQ(tool_queue_count(queue), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "H|s|3\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "L2|s|2\n");
+    ASSERT_EQ(tool_queue_dropped(queue), 1);
+    
+    // Among equals the policy decides
+    add_with_priority(queue, "L3|s|4\n", EVENT_PRIORITY_LOW);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "L2|s|2\n");
+    
+    // Never displaces a more urgent event
+    queue->policy = QUEUE_POLICY_DROP_OLDEST;
+    add_with_priority(queue, "H2|s|5\n", EVENT_PRIORITY_HIGH);
+    add_with_priority(queue, "N|s|6\n", EVENT_PRIORITY_NORMAL);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "H|s|3\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "H2|s|5\n");
+    ASSERT_EQ(tool_queue_dropped(queue), 4);
+    
+    tool_queue_shutdown(queue);
+}
+
+TEST(tool_queue_conflates_by_type_and_sender) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 10, QUEUE_POLICY_CONFLATE), FW_OK);
+    
+    tool_queue_add(queue, "TEMP|probe1|20\n");
+    tool_queue_add(queue, "TEMP|probe2|30\n");
+    tool_queue_add(queue, "HUMID|probe1|50\n");
+    tool_queue_add(queue, "TEMP|probe1|21\n");     // Replaces 20 in place
+    tool_queue_add(queue, "#5|TEMP|probe2\n3\n1.5\n");  // Frames are keyed too
+    
+    ASSERT_EQ(tool_queue_count(queue), 3);
+    ASSERT_EQ(tool_queue_conflated(queue), 2);
+    ASSERT_EQ(tool_queue_dropped(queue), 0);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "TEMP|probe1|21\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "#5|TEMP|probe2\n3\n1.5\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 2), "HUMID|probe1|50\n");
+    ASSERT_EQ(tool_queue_bytes(queue),
+              strlen("TEMP|probe1|21\n") + strlen("#5|TEMP|probe2\n3\n1.5\n") +
+              strlen("HUMID|probe1|50\n"));
+    
+    // A half written event is finished, so its update queues behind it
+    queue->head_offset = 3;
+    tool_queue_add(queue, "TEMP|probe1|22\n");
+    ASSERT_EQ(tool_queue_count(queue), 4);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 3), "TEMP|probe1|22\n");
+    
+    tool_queue_shutdown(queue);
+}
+
+TEST(tool_queue_conflates_by_data_field) {
+    ToolQueue* queue = NULL;
+    ASSERT_EQ(tool_queue_init(&queue, 2, QUEUE_POLICY_CONFLATE), FW_OK);
+    tool_queue_set_conflate_field(queue, "id");
+    
+    tool_queue_add(queue, "STATE|hub|id=7 valid=1 v=1\n");
+    tool_queue_add(queue, "STATE|hub|{\"id\": \"9\", \"v\": 1}\n");
+    tool_queue_add(queue, "STATE|hub|valid=0 id=7 v=2\n");      // Not "valid"
+    tool_queue_add(queue, "STATE|hub|{\"v\": 2, \"id\": \"9\"}\n");
+    ASSERT_EQ(tool_queue_count(queue), 2);
+    ASSERT_EQ(tool_queue_conflated(queue), 2);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 0), "STATE|hub|valid=0 id=7 v=2\n");
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "STATE|hub|{\"v\": 2, \"id\": \"9\"}\n");
+    
+    // A new key in a full queue drops the oldest
+    tool_queue_add(queue, "STATE|hub|id=8 v=1\n");
+    ASSERT_EQ(tool_queue_count(queue), 2);
+    ASSERT_EQ(tool_queue_dropped(queue), 1);
+    ASSERT_STR_EQ(tool_queue_peek_at(queue, 1), "STATE|hub|id=8 v=1\n");
+    
+    tool_queue_shutdown(queue);
+}
+
+TEST(tool_flush_inbox_delivers_batch) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "sort");
+    tool_set_queue_config("test_tool", 100, QUEUE_POLICY_DROP_OLDEST, 4);
+    ASSERT_EQ(tool_start("test_tool"), FW_OK);
+    
+    Tool* tool = tool_find("test_tool");
+    for (int i = 0; i < 10; i++) {
+        tool_queue_add(tool->inbox, "TICK|test|x\n");
+    }
+    
+    ASSERT_EQ(tool_flush_inbox(tool), FW_OK);
+    ASSERT(tool_queue_is_empty(tool->inbox));
+    ASSERT_EQ(tool->events_sent, 10);
+    
+    tool_registry_shutdown();
+}
+
+TEST(tool_crash_restarts_after_backoff) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "exit 1");
+    ASSERT_EQ(tool_set_restart_config("test_tool", RESTART_ALWAYS, true, 3, 60), FW_OK);
+    ASSERT_EQ(tool_start("test_tool"), FW_OK);
+    Tool* tool = tool_find("test_tool");
+    
+    for (int tries = 0; tries < 100 && tool->status == TOOL_RUNNING; tries++) {
+        platform_sleep_ms(10);
+        tool_check_health_one(tool);
+    }
+    ASSERT_EQ(tool->status, TOOL_CRASHED);
+    ASSERT(timer_is_armed(&tool->restart_timer));
+    ASSERT_EQ(tool->restart_count, 0);
+    
+    // Not restarted until the first backoff delay has passed
+    int timeout = tool_run_timers();
+    ASSERT(timeout > 0 && timeout <= TOOL_RESTART_BASE_DELAY_MS + TIMER_TICK_MS);
+    ASSERT_EQ(tool->status, TOOL_CRASHED);
+    
+    platform_sleep_ms(timeout);
+    tool_run_timers();
+    ASSERT_EQ(tool->restart_count, 1);
+    ASSERT(!timer_is_armed(&tool->restart_timer));
+    
+    tool_registry_shutdown();
+}
+
+TEST(tool_stop_cancels_pending_restart) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "exit 1");
+    tool_set_restart_config("test_tool", RESTART_ALWAYS, true, 3, 60);
+    ASSERT_EQ(tool_start("test_tool"), FW_OK);
+    Tool* tool = tool_find("test_tool");
+    
+    for (int tries = 0; tries < 100 && tool->status == TOOL_RUNNING; tries++) {
+        platform_sleep_ms(10);
+        tool_check_health_one(tool);
+    }
+    ASSERT(timer_is_armed(&tool->restart_timer));
+    
+    ASSERT_EQ(tool_stop("test_tool"), FW_OK);
+    ASSERT(!timer_is_armed(&tool->restart_timer));
+    
+    tool_registry_shutdown();
+}
+
+TEST(tool_crash_records_exit_status) {
+    tool_registry_init();
+    
+    tool_register("test_tool", "kill -9 $$");
+    tool_register("other_tool", "exit 7");
+    ASSERT_EQ(tool_start("test_tool"), FW_OK);
+    ASSERT_EQ(tool_start("other_tool"), FW_OK);
+    Tool* killed = tool_find("test_tool");
+    Tool* exited = tool_find("other_tool");
+    
+    for (int tries = 0; tries < 100 &&
+         (killed->status == TOOL_RUNNING || exited->status == TOOL_RUNNING); tries++) {
+        platform_sleep_ms(10);
+        tool_check_health();
+    }
+    ASSERT(killed->has_exited);
+    ASSERT_EQ(killed->last_exit.exit_code, -1);
+    ASSERT_EQ(killed->last_exit.signal, 9);
+    ASSERT(exited->has_exited);
+    ASSERT_EQ(exited->last_exit.exit_code, 7);
+    ASSERT_EQ(exited->last_exit.signal, 0);
+    ASSERT(exited->last_exit.max_rss_kb > 0);
+    
+    tool_registry_shutdown();
+}
+
 // Test runner
 int main(void) {
     printf("\n=== Tool Module Unit Tests ===\n\n");
@@ -190,8 +478,20 @@ int main(void) {
     run_test_tool_unregister_nonexistent_tool_fails();
     run_test_tool_subscribe_valid_event();
     run_test_tool_subscribe_nonexistent_tool_fails();
+    run_test_tool_subscribe_too_long_type_fails();
     run_test_tool_is_running_stopped_tool();
     run_test_tool_is_running_nonexistent_tool();
+    run_test_tool_set_queue_config_clamps_batch_size();
+    run_test_tool_queue_drop_oldest_keeps_partial_head();
+    run_test_tool_queue_byte_budget_applies_policy();
+    run_test_tool_queue_delivers_urgent_lanes_first();
+    run_test_tool_queue_full_sheds_lower_priority_first();
+    run_test_tool_queue_conflates_by_type_and_sender();
+    run_test_tool_queue_conflates_by_data_field();
+    run_test_tool_flush_inbox_delivers_batch();
+    run_test_tool_crash_restarts_after_backoff();
+    run_test_tool_stop_cancels_pending_restart();
+    run_test_tool_crash_records_exit_status();
     
     printf("\n=== Test Summary ===\n");
     printf("  Total:  %d\n", tests_run);